@@ -0,0 +1,106 @@
+/* ntarena.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+
+#define epicsExportSharedSymbols
+#include <pv/ntarena.h>
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+namespace {
+
+// alignment of allocations, enough for any pvData scalar type
+const size_t alignment = 16;
+
+struct ArrayDelete
+{
+    void operator()(uint8 * data)
+    {
+        delete [] data;
+    }
+};
+
+/*
+ * Deleter of an allocation, releasing its reference to the block.
+ */
+struct BlockReference
+{
+    std::tr1::shared_ptr<uint8> block;
+
+    BlockReference(std::tr1::shared_ptr<uint8> const & block) :
+        block(block)
+    {}
+
+    void operator()(uint8 *)
+    {
+        block.reset();
+    }
+};
+
+std::tr1::shared_ptr<uint8> allocateBlock(size_t size)
+{
+    return std::tr1::shared_ptr<uint8>(new uint8[size], ArrayDelete());
+}
+
+}
+
+NTArena::shared_pointer NTArena::create(size_t blockSize)
+{
+    return shared_pointer(new NTArena(blockSize));
+}
+
+NTArena::NTArena(size_t blockSize) :
+    blockSize((std::max(blockSize, alignment) + alignment - 1)/alignment*alignment),
+    current(0),
+    offset(0),
+    blockAllocations(0),
+    allocated(0)
+{}
+
+std::tr1::shared_ptr<uint8> NTArena::allocate(size_t size)
+{
+    size = (std::max(size, size_t(1)) + alignment - 1)/alignment*alignment;
+    allocated += size;
+
+    // large allocations would waste much of a block
+    if (size > blockSize/4)
+        return allocateBlock(size);
+
+    if (current < blocks.size() && offset + size > blockSize)
+    {
+        ++current;
+        offset = 0;
+    }
+    if (current == blocks.size())
+        blocks.push_back(std::tr1::shared_ptr<uint8>());
+    if (!blocks[current].get())
+    {
+        blocks[current] = allocateBlock(blockSize);
+        ++blockAllocations;
+    }
+
+    uint8 * data = blocks[current].get() + offset;
+    offset += size;
+    return std::tr1::shared_ptr<uint8>(data, BlockReference(blocks[current]));
+}
+
+void NTArena::release()
+{
+    // blocks still referenced by allocations are replaced when next used
+    for (size_t i = 0; i < blocks.size(); ++i)
+        if (!blocks[i].unique())
+            blocks[i].reset();
+    current = 0;
+    offset = 0;
+    allocated = 0;
+}
+
+}}
@@ -0,0 +1,199 @@
+/* ntchangeTracker.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <map>
+#include <vector>
+#include <stdexcept>
+
+#define epicsExportSharedSymbols
+#include <pv/ntchangeTracker.h>
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+namespace {
+
+/*
+ * PostHandler of a field, marking its offset as changed in the changes of
+ * the tracker it is bound to. pvData does not allow a PostHandler to be
+ * removed, so the handler stays installed once the tracker is gone or its
+ * creation failed, unbound, and is bound again by the next tracker.
+ */
+class ChangeHandler : public PostHandler
+{
+public:
+    POINTER_DEFINITIONS(ChangeHandler);
+
+    ChangeHandler(PVField const * pvField) :
+        pvField(pvField), offset(0)
+    {}
+
+    virtual ~ChangeHandler();
+
+    virtual void postPut()
+    {
+        std::tr1::shared_ptr<NTChangeTracker::Changes> bound;
+        uint32 boundOffset;
+        {
+            Lock xx(mutex);
+            bound = changes.lock();
+            boundOffset = offset;
+        }
+        if (!bound.get())
+            return;
+        Lock xx(bound->mutex);
+        bound->changed.set(boundOffset);
+    }
+
+    bool isBound()
+    {
+        Lock xx(mutex);
+        return !changes.expired();
+    }
+
+    void bind(std::tr1::shared_ptr<NTChangeTracker::Changes> const & newChanges,
+        uint32 newOffset)
+    {
+        Lock xx(mutex);
+        changes = newChanges;
+        offset = newOffset;
+    }
+
+    void unbind()
+    {
+        Lock xx(mutex);
+        changes.reset();
+    }
+
+private:
+    PVField const * pvField;
+    Mutex mutex;
+    std::tr1::weak_ptr<NTChangeTracker::Changes> changes;
+    uint32 offset;
+};
+
+/*
+ * The ChangeHandler installed on each field, since a PVField does not
+ * give access to its PostHandler. An entry is removed when its handler is
+ * destroyed together with the field.
+ */
+typedef std::map<PVField const *, ChangeHandler::weak_pointer> HandlerMap;
+
+Mutex handlersMutex;
+HandlerMap handlers;
+
+ChangeHandler::~ChangeHandler()
+{
+    Lock xx(handlersMutex);
+    HandlerMap::iterator it = handlers.find(pvField);
+    if (it != handlers.end() && it->second.expired())
+        handlers.erase(it);
+}
+
+void collectFields(PVFieldPtr const & pvField, PVFieldPtrArray & pvFields)
+{
+    pvFields.push_back(pvField);
+
+    PVStructurePtr pvSubStructure = std::tr1::dynamic_pointer_cast<PVStructure>(pvField);
+    if (!pvSubStructure.get())
+        return;
+    PVFieldPtrArray const & pvSubFields = pvSubStructure->getPVFields();
+    for (size_t i = 0; i < pvSubFields.size(); ++i)
+        collectFields(pvSubFields[i], pvFields);
+}
+
+}
+
+NTChangeTracker::shared_pointer NTChangeTracker::create(PVStructurePtr const & pvStructure)
+{
+    if (!pvStructure.get())
+        throw std::runtime_error("NTChangeTracker::create: null PVStructure");
+    return shared_pointer(new NTChangeTracker(pvStructure));
+}
+
+NTChangeTracker::NTChangeTracker(PVStructurePtr const & pvStructure) :
+    pvStructure(pvStructure),
+    baseOffset(pvStructure->getFieldOffset()),
+    changes(new Changes())
+{
+    track();
+}
+
+void NTChangeTracker::track()
+{
+    PVFieldPtrArray pvFields;
+    collectFields(pvStructure, pvFields);
+
+    Lock xx(handlersMutex);
+
+    // check the whole tree before installing anything
+    std::vector<ChangeHandler::shared_pointer> installed(pvFields.size());
+    for (size_t i = 0; i < pvFields.size(); ++i)
+    {
+        HandlerMap::iterator it = handlers.find(pvFields[i].get());
+        if (it == handlers.end())
+            continue;
+        installed[i] = it->second.lock();
+        if (installed[i].get() && installed[i]->isBound())
+            throw std::runtime_error("NTChangeTracker::create: field already tracked");
+    }
+
+    size_t bound = 0;
+    try {
+        for (; bound < pvFields.size(); ++bound)
+        {
+            PVFieldPtr const & pvField = pvFields[bound];
+            if (!installed[bound].get())
+            {
+                ChangeHandler::shared_pointer handler(new ChangeHandler(pvField.get()));
+                pvField->setPostHandler(handler);
+                handlers[pvField.get()] = handler;
+                installed[bound] = handler;
+            }
+            installed[bound]->bind(changes,
+                static_cast<uint32>(pvField->getFieldOffset() - baseOffset));
+        }
+    } catch (std::exception & e) {
+        // a field has a PostHandler of its own
+        for (size_t i = 0; i < bound; ++i)
+            installed[i]->unbind();
+        throw std::runtime_error(std::string("NTChangeTracker::create: ") + e.what());
+    }
+}
+
+bool NTChangeTracker::isChanged() const
+{
+    Lock xx(changes->mutex);
+    return !changes->changed.isEmpty();
+}
+
+bool NTChangeTracker::takeChanged(BitSet & changed)
+{
+    Lock xx(changes->mutex);
+    changed = changes->changed;
+    changes->changed.clear();
+    return !changed.isEmpty();
+}
+
+void NTChangeTracker::clear()
+{
+    Lock xx(changes->mutex);
+    changes->changed.clear();
+}
+
+void NTChangeTracker::markChanged(PVField const & pvField)
+{
+    size_t offset = pvField.getFieldOffset();
+    if (offset < baseOffset || offset >= pvStructure->getNextFieldOffset())
+        throw std::runtime_error("NTChangeTracker::markChanged: field not in NT value");
+    Lock xx(changes->mutex);
+    changes->changed.set(static_cast<uint32>(offset - baseOffset));
+}
+
+}}
@@ -0,0 +1,399 @@
+/* ntmatrixMath.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#define epicsExportSharedSymbols
+#include <pv/ntmatrixMath.h>
+#include <pv/ntparallel.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+using detail::blocks;
+using detail::sumOf;
+using detail::threadsFor;
+
+namespace {
+
+// rows or columns per work item
+const size_t rowBlock = 32;
+const size_t columnBlock = 256;
+
+// inner blocks of the matrix product: a kBlock x nBlock panel of the
+// right matrix (256 kB) is reused for every row of a row block
+const size_t kBlock = 128;
+const size_t nBlock = 256;
+
+NTMatrixPtr createMatrix(size_t rows, size_t columns, PVDoubleArray::svector & value)
+{
+    NTMatrixPtr matrix = NTMatrix::createBuilder()->addDim()->create();
+    matrix->getValue()->replace(freeze(value));
+    PVIntArray::svector dim;
+    dim.push_back(static_cast<int32>(rows));
+    dim.push_back(static_cast<int32>(columns));
+    matrix->getDim()->replace(freeze(dim));
+    return matrix;
+}
+
+// dot product with independent partial sums, so that it can be vectorized
+inline double dot(const double * a, const double * b, size_t n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        s0 += a[i]*b[i];
+        s1 += a[i + 1]*b[i + 1];
+        s2 += a[i + 2]*b[i + 2];
+        s3 += a[i + 3]*b[i + 3];
+    }
+    for (; i < n; ++i)
+        s0 += a[i]*b[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+// reduction of n elements with the specified stride
+double reduce(const double * a, size_t n, size_t stride, NTMatrixMath::Reduction reduction)
+{
+    if (n == 0)
+        return reduction == NTMatrixMath::sum ? 0 : std::numeric_limits<double>::quiet_NaN();
+
+    double result = a[0];
+    switch (reduction)
+    {
+    case NTMatrixMath::sum:
+    case NTMatrixMath::mean:
+        if (stride == 1)
+        {
+            result = sumOf(a, n);
+        }
+        else
+        {
+            for (size_t i = 1; i < n; ++i)
+                result += a[i*stride];
+        }
+        if (reduction == NTMatrixMath::mean)
+            result /= n;
+        break;
+    case NTMatrixMath::minimum:
+        for (size_t i = 1; i < n; ++i)
+            result = a[i*stride] < result ? a[i*stride] : result;
+        break;
+    case NTMatrixMath::maximum:
+        for (size_t i = 1; i < n; ++i)
+            result = a[i*stride] > result ? a[i*stride] : result;
+        break;
+    }
+    return result;
+}
+
+class TransposeTask : public NTParallel::Task
+{
+public:
+    TransposeTask(NTMatrixView const & transposed, double * dst) :
+        transposed(transposed), dst(dst)
+    {}
+
+    // one block of rows of the transpose, copied in tiles by the view
+    virtual void run(size_t index)
+    {
+        size_t r0 = index*rowBlock;
+        size_t rows = std::min(transposed.getRows() - r0, rowBlock);
+        transposed.block(r0, 0, rows, transposed.getColumns()).copyTo(
+            dst + r0*transposed.getColumns());
+    }
+
+private:
+    NTMatrixView const & transposed;
+    double * dst;
+};
+
+class MatrixVectorTask : public NTParallel::Task
+{
+public:
+    MatrixVectorTask(NTMatrixView const & a, const double * x, double * y) :
+        a(a), x(x), y(y)
+    {}
+
+    virtual void run(size_t index)
+    {
+        size_t rows = a.getRows(), columns = a.getColumns();
+        size_t rowStride = a.getRowStride(), columnStride = a.getColumnStride();
+        size_t r1 = std::min(rows, (index + 1)*rowBlock);
+        for (size_t r = index*rowBlock; r < r1; ++r)
+        {
+            const double * row = a.data() + r*rowStride;
+            if (columnStride == 1)
+            {
+                y[r] = dot(row, x, columns);
+            }
+            else
+            {
+                double sum = 0;
+                for (size_t c = 0; c < columns; ++c)
+                    sum += row[c*columnStride]*x[c];
+                y[r] = sum;
+            }
+        }
+    }
+
+private:
+    NTMatrixView const & a;
+    const double * x;
+    double * y;
+};
+
+class MatrixProductTask : public NTParallel::Task
+{
+public:
+    // b is dense in row order
+    MatrixProductTask(NTMatrixView const & a, const double * b, size_t n, double * c) :
+        a(a), b(b), n(n), c(c)
+    {}
+
+    // one block of rows of the product, accumulated panel by panel
+    virtual void run(size_t index)
+    {
+        size_t m = a.getRows(), k = a.getColumns();
+        size_t rowStride = a.getRowStride(), columnStride = a.getColumnStride();
+        size_t i0 = index*rowBlock;
+        size_t i1 = std::min(m, i0 + rowBlock);
+        std::fill(c + i0*n, c + i1*n, 0.0);
+
+        for (size_t k0 = 0; k0 < k; k0 += kBlock)
+        {
+            size_t k1 = std::min(k, k0 + kBlock);
+            for (size_t j0 = 0; j0 < n; j0 += nBlock)
+            {
+                size_t j1 = std::min(n, j0 + nBlock);
+                for (size_t i = i0; i < i1; ++i)
+                {
+                    double * cRow = c + i*n;
+                    const double * aRow = a.data() + i*rowStride;
+                    for (size_t p = k0; p < k1; ++p)
+                    {
+                        double aip = aRow[p*columnStride];
+                        const double * bRow = b + p*n;
+                        for (size_t j = j0; j < j1; ++j)
+                            cRow[j] += aip*bRow[j];
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    NTMatrixView const & a;
+    const double * b;
+    size_t n;
+    double * c;
+};
+
+class RowReductionTask : public NTParallel::Task
+{
+public:
+    RowReductionTask(NTMatrixView const & a, NTMatrixMath::Reduction reduction,
+        double * result) :
+        a(a), reduction(reduction), result(result)
+    {}
+
+    virtual void run(size_t index)
+    {
+        size_t r1 = std::min(a.getRows(), (index + 1)*rowBlock);
+        for (size_t r = index*rowBlock; r < r1; ++r)
+            result[r] = reduce(a.data() + r*a.getRowStride(), a.getColumns(),
+                a.getColumnStride(), reduction);
+    }
+
+private:
+    NTMatrixView const & a;
+    NTMatrixMath::Reduction reduction;
+    double * result;
+};
+
+class ColumnReductionTask : public NTParallel::Task
+{
+public:
+    ColumnReductionTask(NTMatrixView const & a, NTMatrixMath::Reduction reduction,
+        double * result) :
+        a(a), reduction(reduction), result(result)
+    {}
+
+    // one block of columns, accumulated row by row
+    virtual void run(size_t index)
+    {
+        size_t rows = a.getRows();
+        size_t rowStride = a.getRowStride(), columnStride = a.getColumnStride();
+        size_t c0 = index*columnBlock;
+        size_t n = std::min(a.getColumns(), c0 + columnBlock) - c0;
+        double * out = result + c0;
+
+        if (rows == 0)
+        {
+            std::fill(out, out + n, reduction == NTMatrixMath::sum ? 0 :
+                std::numeric_limits<double>::quiet_NaN());
+            return;
+        }
+
+        const double * first = a.data() + c0*columnStride;
+
+        for (size_t j = 0; j < n; ++j)
+            out[j] = first[j*columnStride];
+        for (size_t r = 1; r < rows; ++r)
+        {
+            const double * row = first + r*rowStride;
+            switch (reduction)
+            {
+            case NTMatrixMath::sum:
+            case NTMatrixMath::mean:
+                for (size_t j = 0; j < n; ++j)
+                    out[j] += row[j*columnStride];
+                break;
+            case NTMatrixMath::minimum:
+                for (size_t j = 0; j < n; ++j)
+                    out[j] = row[j*columnStride] < out[j] ? row[j*columnStride] : out[j];
+                break;
+            case NTMatrixMath::maximum:
+                for (size_t j = 0; j < n; ++j)
+                    out[j] = row[j*columnStride] > out[j] ? row[j*columnStride] : out[j];
+                break;
+            }
+        }
+
+        if (reduction == NTMatrixMath::mean)
+            for (size_t j = 0; j < n; ++j)
+                out[j] /= rows;
+    }
+
+private:
+    NTMatrixView const & a;
+    NTMatrixMath::Reduction reduction;
+    double * result;
+};
+
+}
+
+size_t NTMatrixMath::getRows(NTMatrixPtr const & matrix)
+{
+    return NTMatrixView(matrix).getRows();
+}
+
+size_t NTMatrixMath::getColumns(NTMatrixPtr const & matrix)
+{
+    return NTMatrixView(matrix).getColumns();
+}
+
+NTMatrixPtr NTMatrixMath::transpose(NTMatrixPtr const & matrix, size_t maxThreads)
+{
+    return transpose(NTMatrixView(matrix), maxThreads);
+}
+
+NTMatrixPtr NTMatrixMath::transpose(NTMatrixView const & view, size_t maxThreads)
+{
+    NTMatrixView transposed = view.transpose();
+
+    PVDoubleArray::svector value(transposed.getSize());
+    TransposeTask task(transposed, value.data());
+    NTParallel::forEach(blocks(transposed.getRows(), rowBlock), task,
+        threadsFor(transposed.getSize(), maxThreads));
+
+    return createMatrix(transposed.getRows(), transposed.getColumns(), value);
+}
+
+PVDoubleArray::const_svector NTMatrixMath::multiply(NTMatrixPtr const & matrix,
+    PVDoubleArray::const_svector const & vector, size_t maxThreads)
+{
+    return multiply(NTMatrixView(matrix), vector, maxThreads);
+}
+
+PVDoubleArray::const_svector NTMatrixMath::multiply(NTMatrixView const & view,
+    PVDoubleArray::const_svector const & vector, size_t maxThreads)
+{
+    if (vector.size() != view.getColumns())
+        throw std::runtime_error("vector size does not match the matrix columns");
+
+    PVDoubleArray::svector result(view.getRows());
+    MatrixVectorTask task(view, vector.data(), result.data());
+    NTParallel::forEach(blocks(view.getRows(), rowBlock), task,
+        threadsFor(view.getSize(), maxThreads));
+
+    return freeze(result);
+}
+
+NTMatrixPtr NTMatrixMath::multiply(NTMatrixPtr const & left,
+    NTMatrixPtr const & right, size_t maxThreads)
+{
+    return multiply(NTMatrixView(left), NTMatrixView(right), maxThreads);
+}
+
+NTMatrixPtr NTMatrixMath::multiply(NTMatrixView const & left,
+    NTMatrixView const & right, size_t maxThreads)
+{
+    if (left.getColumns() != right.getRows())
+        throw std::runtime_error("matrix sizes do not match");
+
+    size_t m = left.getRows(), k = left.getColumns(), n = right.getColumns();
+
+    // the inner loop runs along rows of the right operand
+    std::vector<double> packed;
+    const double * b = right.data();
+    if (!right.isContiguous())
+    {
+        packed.resize(right.getSize());
+        right.copyTo(&packed[0]);
+        b = &packed[0];
+    }
+
+    PVDoubleArray::svector value(m*n);
+    MatrixProductTask task(left, b, n, value.data());
+    NTParallel::forEach(blocks(m, rowBlock), task, threadsFor(m*k*n, maxThreads));
+
+    return createMatrix(m, n, value);
+}
+
+PVDoubleArray::const_svector NTMatrixMath::reduceRows(NTMatrixPtr const & matrix,
+    Reduction reduction, size_t maxThreads)
+{
+    return reduceRows(NTMatrixView(matrix), reduction, maxThreads);
+}
+
+PVDoubleArray::const_svector NTMatrixMath::reduceRows(NTMatrixView const & view,
+    Reduction reduction, size_t maxThreads)
+{
+    PVDoubleArray::svector result(view.getRows());
+    RowReductionTask task(view, reduction, result.data());
+    NTParallel::forEach(blocks(view.getRows(), rowBlock), task,
+        threadsFor(view.getSize(), maxThreads));
+
+    return freeze(result);
+}
+
+PVDoubleArray::const_svector NTMatrixMath::reduceColumns(NTMatrixPtr const & matrix,
+    Reduction reduction, size_t maxThreads)
+{
+    return reduceColumns(NTMatrixView(matrix), reduction, maxThreads);
+}
+
+PVDoubleArray::const_svector NTMatrixMath::reduceColumns(NTMatrixView const & view,
+    Reduction reduction, size_t maxThreads)
+{
+    PVDoubleArray::svector result(view.getColumns());
+    ColumnReductionTask task(view, reduction, result.data());
+    NTParallel::forEach(blocks(view.getColumns(), columnBlock), task,
+        threadsFor(view.getSize(), maxThreads));
+
+    return freeze(result);
+}
+
+}}
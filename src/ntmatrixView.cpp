@@ -0,0 +1,175 @@
+/* ntmatrixView.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#define epicsExportSharedSymbols
+#include <pv/ntmatrixView.h>
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+namespace {
+
+// rows and columns of the tiles in which strided views are copied
+const size_t tileSize = 32;
+
+}
+
+NTMatrixView::NTMatrixView() :
+    first(0), rows(0), columns(0), rowStride(0), columnStride(1)
+{
+}
+
+NTMatrixView::NTMatrixView(NTMatrixPtr const & matrix) :
+    storage(matrix->getValue()->view()),
+    first(storage.data()),
+    rowStride(0),
+    columnStride(1)
+{
+    if (!matrix->isValid())
+        throw std::runtime_error("NTMatrix is not valid");
+
+    PVIntArrayPtr pvDim = matrix->getDim();
+    PVIntArray::const_svector dim;
+    if (pvDim.get())
+        dim = pvDim->view();
+    for (size_t i = 0; i < dim.size(); ++i)
+        if (dim[i] < 0)
+            throw std::runtime_error("NTMatrix is not valid");
+
+    rows = dim.empty() ? storage.size() : dim[0];
+    columns = dim.size() == 2 ? dim[1] : 1;
+    rowStride = columns;
+}
+
+NTMatrixView::NTMatrixView(PVDoubleArray::const_svector const & value,
+    size_t rows, size_t columns) :
+    storage(value),
+    first(storage.data()),
+    rows(rows),
+    columns(columns),
+    rowStride(columns),
+    columnStride(1)
+{
+    if (rows*columns != storage.size())
+        throw std::runtime_error("array size does not match the matrix size");
+}
+
+bool NTMatrixView::isContiguous() const
+{
+    return (columns <= 1 || columnStride == 1) &&
+        (rows <= 1 || rowStride == columns);
+}
+
+NTMatrixView NTMatrixView::row(size_t row) const
+{
+    if (row >= rows)
+        throw std::runtime_error("row out of range");
+    return block(row, 0, 1, columns);
+}
+
+NTMatrixView NTMatrixView::column(size_t column) const
+{
+    if (column >= columns)
+        throw std::runtime_error("column out of range");
+    return block(0, column, rows, 1);
+}
+
+NTMatrixView NTMatrixView::block(size_t row, size_t column,
+    size_t rows, size_t columns) const
+{
+    if (row > this->rows || rows > this->rows - row ||
+        column > this->columns || columns > this->columns - column)
+        throw std::runtime_error("block out of range");
+
+    NTMatrixView view(*this);
+    view.rows = rows;
+    view.columns = columns;
+    if (rows*columns > 0)
+        view.first = first + row*rowStride + column*columnStride;
+    return view;
+}
+
+NTMatrixView NTMatrixView::transpose() const
+{
+    NTMatrixView view(*this);
+    std::swap(view.rows, view.columns);
+    std::swap(view.rowStride, view.columnStride);
+    return view;
+}
+
+void NTMatrixView::copyTo(double * destination) const
+{
+    if (columnStride == 1)
+    {
+        for (size_t r = 0; r < rows; ++r)
+            std::copy(first + r*rowStride, first + r*rowStride + columns,
+                destination + r*columns);
+        return;
+    }
+
+    // strided rows, e.g. of a transpose: copy in tiles that stay in cache
+    for (size_t r0 = 0; r0 < rows; r0 += tileSize)
+    {
+        size_t r1 = std::min(rows, r0 + tileSize);
+        for (size_t c0 = 0; c0 < columns; c0 += tileSize)
+        {
+            size_t c1 = std::min(columns, c0 + tileSize);
+            for (size_t r = r0; r < r1; ++r)
+            {
+                const double * src = first + r*rowStride;
+                double * dst = destination + r*columns;
+                for (size_t c = c0; c < c1; ++c)
+                    dst[c] = src[c*columnStride];
+            }
+        }
+    }
+}
+
+PVDoubleArray::const_svector NTMatrixView::toArray() const
+{
+    size_t size = getSize();
+    if (size == 0)
+        return PVDoubleArray::const_svector();
+
+    if (isContiguous())
+    {
+        PVDoubleArray::const_svector value(storage);
+        value.slice(first - storage.data(), size);
+        return value;
+    }
+
+    PVDoubleArray::svector value(size);
+    copyTo(value.data());
+    return freeze(value);
+}
+
+NTMatrixPtr NTMatrixView::toMatrix() const
+{
+    NTMatrixPtr matrix = NTMatrix::createBuilder()->addDim()->create();
+    matrix->getValue()->replace(toArray());
+
+    PVIntArray::svector dim;
+    dim.push_back(static_cast<int32>(rows));
+    dim.push_back(static_cast<int32>(columns));
+    matrix->getDim()->replace(freeze(dim));
+    return matrix;
+}
+
+NTScalarArrayPtr NTMatrixView::toScalarArray() const
+{
+    NTScalarArrayPtr scalarArray =
+        NTScalarArray::createBuilder()->value(pvDouble)->create();
+    scalarArray->getValue<PVDoubleArray>()->replace(toArray());
+    return scalarArray;
+}
+
+}}
@@ -0,0 +1,240 @@
+/* ntmultiChannelAlarm.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#define epicsExportSharedSymbols
+#include <pv/ntmultiChannelAlarm.h>
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+const size_t NTMultiChannelAlarm::SEVERITIES;
+
+namespace {
+
+typedef NTMultiChannelAlarm::Summary Summary;
+
+// channels counted at a time, small enough for the block to stay in cache
+const size_t blockSize = 256;
+
+inline int32 clampSeverity(int32 severity)
+{
+    severity = severity < noAlarm ? static_cast<int32>(noAlarm) : severity;
+    return severity > undefinedAlarm ? static_cast<int32>(undefinedAlarm) : severity;
+}
+
+/*
+ * Adds the number of each severity. The loop has no branches and no
+ * dependence between channels other than the sums, so it vectorizes.
+ */
+void countSeverities(const int32 * severity, size_t count, size_t * severityCount)
+{
+    uint32 none = 0, minor = 0, major = 0, invalid = 0, undefined = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        int32 s = clampSeverity(severity[i]);
+        none += s == noAlarm;
+        minor += s == minorAlarm;
+        major += s == majorAlarm;
+        invalid += s == invalidAlarm;
+        undefined += s == undefinedAlarm;
+    }
+    severityCount[noAlarm] += none;
+    severityCount[minorAlarm] += minor;
+    severityCount[majorAlarm] += major;
+    severityCount[invalidAlarm] += invalid;
+    severityCount[undefinedAlarm] += undefined;
+}
+
+/*
+ * Returns the severity of a channel, with disconnected channels and
+ * unknown severities as for counting.
+ */
+inline int32 channelSeverity(const int32 * severity, const boolean * isConnected,
+    int32 disconnectedSeverity, size_t index)
+{
+    if (isConnected && !isConnected[index])
+        return disconnectedSeverity;
+    return severity ? clampSeverity(severity[index]) : static_cast<int32>(noAlarm);
+}
+
+Summary summarizeChannels(const int32 * severity, const boolean * isConnected,
+    size_t count, AlarmSeverity disconnectedSeverity)
+{
+    Summary summary;
+    summary.severity = noAlarm;
+    summary.worstChannel = -1;
+    summary.disconnected = 0;
+    std::fill(summary.severityCount, summary.severityCount + NTMultiChannelAlarm::SEVERITIES, 0);
+
+    int32 disconnected = clampSeverity(disconnectedSeverity);
+    if (!isConnected)
+    {
+        if (severity)
+            countSeverities(severity, count, summary.severityCount);
+        else
+            summary.severityCount[noAlarm] = count;
+    }
+    else
+    {
+        // the severities of disconnected channels are replaced a block at
+        // a time, by selects rather than branches
+        int32 block[blockSize];
+        for (size_t start = 0; start < count; start += blockSize)
+        {
+            size_t length = std::min(blockSize, count - start);
+            const boolean * connected = isConnected + start;
+            uint32 down = 0;
+            if (severity)
+            {
+                const int32 * from = severity + start;
+                for (size_t i = 0; i < length; ++i)
+                {
+                    int32 up = -static_cast<int32>(connected[i] != 0);
+                    block[i] = (from[i] & up) | (disconnected & ~up);
+                    down += connected[i] == 0;
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < length; ++i)
+                {
+                    int32 up = -static_cast<int32>(connected[i] != 0);
+                    block[i] = disconnected & ~up;
+                    down += connected[i] == 0;
+                }
+            }
+            countSeverities(block, length, summary.severityCount);
+            summary.disconnected += down;
+        }
+    }
+
+    for (size_t s = NTMultiChannelAlarm::SEVERITIES; s-- > 0;)
+    {
+        if (summary.severityCount[s])
+        {
+            summary.severity = static_cast<AlarmSeverity>(s);
+            break;
+        }
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (channelSeverity(severity, isConnected, disconnected, i) == summary.severity)
+        {
+            summary.worstChannel = static_cast<int32>(i);
+            break;
+        }
+    }
+    return summary;
+}
+
+template<typename NT>
+Summary summarizeNT(NT & nt, AlarmSeverity disconnectedSeverity)
+{
+    PVIntArrayPtr pvSeverity = nt.getSeverity();
+    PVBooleanArrayPtr pvIsConnected = nt.getIsConnected();
+    shared_vector<const int32> severity;
+    shared_vector<const boolean> isConnected;
+    if (pvSeverity.get())
+        severity = pvSeverity->view();
+    if (pvIsConnected.get())
+        isConnected = pvIsConnected->view();
+
+    size_t count = nt.getChannelName()->getLength();
+    if ((pvSeverity.get() && severity.size() != count) ||
+        (pvIsConnected.get() && isConnected.size() != count))
+        throw std::runtime_error("multi-channel array lengths differ");
+    return summarizeChannels(pvSeverity.get() ? severity.data() : 0,
+        pvIsConnected.get() ? isConnected.data() : 0, count, disconnectedSeverity);
+}
+
+template<typename NT>
+Summary updateNTAlarm(NT & nt, AlarmSeverity disconnectedSeverity)
+{
+    PVStructurePtr pvAlarm = nt.getAlarm();
+    if (!pvAlarm.get())
+        throw std::runtime_error("multi-channel has no alarm field");
+    Summary summary = summarizeNT(nt, disconnectedSeverity);
+
+    AlarmStatus status = noStatus;
+    std::string message;
+    if (summary.severity != noAlarm)
+    {
+        size_t worst = static_cast<size_t>(summary.worstChannel);
+        message = nt.getChannelName()->view()[worst];
+
+        PVBooleanArrayPtr pvIsConnected = nt.getIsConnected();
+        PVIntArrayPtr pvStatus = nt.getStatus();
+        PVStringArrayPtr pvMessage = nt.getMessage();
+        if (pvIsConnected.get() && !pvIsConnected->view()[worst])
+        {
+            status = clientStatus;
+            message += ": disconnected";
+        }
+        else
+        {
+            if (pvStatus.get() && worst < pvStatus->getLength())
+            {
+                int32 channelStatus = pvStatus->view()[worst];
+                status = channelStatus >= noStatus && channelStatus <= clientStatus ?
+                    static_cast<AlarmStatus>(channelStatus) : undefinedStatus;
+            }
+            if (pvMessage.get() && worst < pvMessage->getLength() &&
+                !pvMessage->view()[worst].empty())
+                message += ": " + pvMessage->view()[worst];
+        }
+    }
+
+    pvAlarm->getSubField<PVInt>("severity")->put(summary.severity);
+    pvAlarm->getSubField<PVInt>("status")->put(status);
+    pvAlarm->getSubField<PVString>("message")->put(message);
+    return summary;
+}
+
+}
+
+Summary NTMultiChannelAlarm::summarize(
+    shared_vector<const int32> const & severity,
+    shared_vector<const boolean> const & isConnected,
+    AlarmSeverity disconnectedSeverity)
+{
+    if (!severity.empty() && !isConnected.empty() && severity.size() != isConnected.size())
+        throw std::runtime_error("multi-channel array lengths differ");
+    size_t count = std::max(severity.size(), isConnected.size());
+    return summarizeChannels(severity.empty() ? 0 : severity.data(),
+        isConnected.empty() ? 0 : isConnected.data(), count, disconnectedSeverity);
+}
+
+Summary NTMultiChannelAlarm::summarize(NTMultiChannelPtr const & ntMultiChannel,
+    AlarmSeverity disconnectedSeverity)
+{
+    return summarizeNT(*ntMultiChannel, disconnectedSeverity);
+}
+
+Summary NTMultiChannelAlarm::summarize(NTScalarMultiChannelPtr const & ntScalarMultiChannel,
+    AlarmSeverity disconnectedSeverity)
+{
+    return summarizeNT(*ntScalarMultiChannel, disconnectedSeverity);
+}
+
+Summary NTMultiChannelAlarm::updateAlarm(NTMultiChannelPtr const & ntMultiChannel,
+    AlarmSeverity disconnectedSeverity)
+{
+    return updateNTAlarm(*ntMultiChannel, disconnectedSeverity);
+}
+
+Summary NTMultiChannelAlarm::updateAlarm(NTScalarMultiChannelPtr const & ntScalarMultiChannel,
+    AlarmSeverity disconnectedSeverity)
+{
+    return updateNTAlarm(*ntScalarMultiChannel, disconnectedSeverity);
+}
+
+}}
@@ -0,0 +1,429 @@
+/* ntmultiChannelDelta.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#define epicsExportSharedSymbols
+#include <pv/ntmultiChannelDelta.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+const std::string NTMultiChannelDelta::CHANGED_INDEX("changedIndex");
+
+namespace {
+
+typedef shared_vector<const int32> Indices;
+
+// one element for each channel, non-zero if the channel changed
+typedef std::vector<uint8> ChangeMask;
+
+template<typename T>
+inline bool differs(T const & a, T const & b)
+{
+    // NaN values are equal to each other
+    return !(a == b) && (a == a || b == b);
+}
+
+inline bool differs(PVUnionPtr const & a, PVUnionPtr const & b)
+{
+    if (a.get() == b.get())
+        return false;
+    if (!a.get() || !b.get())
+        return true;
+    return !(*a == *b);
+}
+
+/*
+ * Marks the channels whose elements differ. All channels are marked if
+ * the previous snapshot does not have the array.
+ */
+template<typename PVT>
+void markChanged(std::tr1::shared_ptr<PVT> const & previous,
+    std::tr1::shared_ptr<PVT> const & current, ChangeMask & mask)
+{
+    if (!current.get())
+        return;
+    size_t count = mask.size();
+    typename PVT::const_svector before;
+    if (previous.get())
+        before = previous->view();
+    if (before.size() != count)
+    {
+        std::fill(mask.begin(), mask.end(), 1);
+        return;
+    }
+    typename PVT::const_svector after(current->view());
+
+    const typename PVT::value_type * a = before.data();
+    const typename PVT::value_type * b = after.data();
+    uint8 * changed = &mask[0];
+    for (size_t i = 0; i < count; ++i)
+        changed[i] |= differs(a[i], b[i]);
+}
+
+/*
+ * Copies the elements of the specified channels to an array of a delta.
+ */
+template<typename PVT>
+void gather(std::tr1::shared_ptr<PVT> const & source,
+    std::tr1::shared_ptr<PVT> const & target, Indices const & indices)
+{
+    if (!source.get() || !target.get())
+        return;
+    typename PVT::const_svector values(source->view());
+    typename PVT::svector result(indices.size());
+
+    const typename PVT::value_type * from = values.data();
+    const int32 * index = indices.data();
+    typename PVT::value_type * to = result.data();
+    for (size_t i = 0; i < indices.size(); ++i)
+        to[i] = from[index[i]];
+    target->replace(freeze(result));
+}
+
+/*
+ * Copies the elements of an array of a delta to the specified channels.
+ */
+template<typename PVT>
+void scatter(std::tr1::shared_ptr<PVT> const & source,
+    std::tr1::shared_ptr<PVT> const & target, Indices const & indices)
+{
+    if (!source.get() || !target.get())
+        return;
+    typename PVT::const_svector values(source->view());
+    typename PVT::svector result(target->reuse());
+
+    const typename PVT::value_type * from = values.data();
+    const int32 * index = indices.data();
+    typename PVT::value_type * to = result.data();
+    for (size_t i = 0; i < indices.size(); ++i)
+        to[index[i]] = from[i];
+    target->replace(freeze(result));
+}
+
+/*
+ * Applies markChanged(), gather() or scatter() to a scalar array value,
+ * by its element type.
+ */
+class ScalarArrayOp
+{
+public:
+    enum Operation { markOperation, gatherOperation, scatterOperation };
+
+    ScalarArrayOp(Operation operation, PVScalarArrayPtr const & source,
+        PVScalarArrayPtr const & target, Indices const & indices, ChangeMask * mask) :
+        operation(operation), source(source), target(target), indices(indices), mask(mask)
+    {
+        ScalarType elementType = target->getScalarArray()->getElementType();
+        if (elementType == pvString)
+            apply<PVStringArray>();
+        else
+            detail::dispatchNumericArray(elementType, *this);
+    }
+
+    template<typename PVT>
+    void apply()
+    {
+        std::tr1::shared_ptr<PVT> typedSource = std::tr1::dynamic_pointer_cast<PVT>(source);
+        std::tr1::shared_ptr<PVT> typedTarget = std::tr1::static_pointer_cast<PVT>(target);
+        switch (operation)
+        {
+        case markOperation:
+            markChanged(typedSource, typedTarget, *mask);
+            break;
+        case gatherOperation:
+            gather(typedSource, typedTarget, indices);
+            break;
+        case scatterOperation:
+            scatter(typedSource, typedTarget, indices);
+            break;
+        }
+    }
+
+private:
+    Operation operation;
+    PVScalarArrayPtr source;
+    PVScalarArrayPtr target;
+    Indices const & indices;
+    ChangeMask * mask;
+};
+
+void markChanged(PVScalarArrayPtr const & previous,
+    PVScalarArrayPtr const & current, ChangeMask & mask)
+{
+    ScalarArrayOp op(ScalarArrayOp::markOperation, previous, current, Indices(), &mask);
+}
+
+void gather(PVScalarArrayPtr const & source, PVScalarArrayPtr const & target,
+    Indices const & indices)
+{
+    ScalarArrayOp op(ScalarArrayOp::gatherOperation, source, target, indices, 0);
+}
+
+void scatter(PVScalarArrayPtr const & source, PVScalarArrayPtr const & target,
+    Indices const & indices)
+{
+    ScalarArrayOp op(ScalarArrayOp::scatterOperation, source, target, indices, 0);
+}
+
+void checkLength(PVArrayPtr const & pvArray, size_t length, const char * message)
+{
+    if (pvArray.get() && pvArray->getLength() != length)
+        throw std::runtime_error(message);
+}
+
+template<typename NT>
+void checkLengths(NT & snapshot, size_t length, const char * message)
+{
+    checkLength(snapshot.getValue(), length, message);
+    checkLength(snapshot.getChannelName(), length, message);
+    checkLength(snapshot.getIsConnected(), length, message);
+    checkLength(snapshot.getSeverity(), length, message);
+    checkLength(snapshot.getStatus(), length, message);
+    checkLength(snapshot.getMessage(), length, message);
+    checkLength(snapshot.getSecondsPastEpoch(), length, message);
+    checkLength(snapshot.getNanoseconds(), length, message);
+    checkLength(snapshot.getUserTag(), length, message);
+}
+
+/*
+ * Returns the number of channels, checking that all arrays have one
+ * element for each.
+ */
+template<typename NT>
+size_t channelCount(NT & snapshot)
+{
+    size_t count = snapshot.getChannelName()->getLength();
+    checkLengths(snapshot, count, "multi-channel snapshot not valid");
+    return count;
+}
+
+void checkIndices(Indices const & indices, size_t count)
+{
+    for (size_t i = 0; i < indices.size(); ++i)
+        if (indices[i] < 0 || static_cast<size_t>(indices[i]) >= count)
+            throw std::runtime_error("changed channel index out of range");
+}
+
+template<typename NT>
+Indices findChangedChannels(NT & previous, NT & current)
+{
+    size_t count = channelCount(current);
+    if (channelCount(previous) != count)
+        throw std::runtime_error("multi-channel snapshots have different numbers of channels");
+    if (count == 0)
+        return Indices();
+
+    ChangeMask mask(count, 0);
+    markChanged(previous.getValue(), current.getValue(), mask);
+    markChanged(previous.getChannelName(), current.getChannelName(), mask);
+    markChanged(previous.getIsConnected(), current.getIsConnected(), mask);
+    markChanged(previous.getSeverity(), current.getSeverity(), mask);
+    markChanged(previous.getStatus(), current.getStatus(), mask);
+    markChanged(previous.getMessage(), current.getMessage(), mask);
+    markChanged(previous.getSecondsPastEpoch(), current.getSecondsPastEpoch(), mask);
+    markChanged(previous.getNanoseconds(), current.getNanoseconds(), mask);
+    markChanged(previous.getUserTag(), current.getUserTag(), mask);
+
+    shared_vector<int32> indices(count - std::count(mask.begin(), mask.end(), 0));
+    size_t changed = 0;
+    for (size_t i = 0; i < count; ++i)
+        if (mask[i])
+            indices[changed++] = static_cast<int32>(i);
+    return freeze(indices);
+}
+
+NTScalarMultiChannelBuilderPtr createBuilder(NTScalarMultiChannel & current)
+{
+    return NTScalarMultiChannel::createBuilder()->
+        value(current.getValue()->getScalarArray()->getElementType());
+}
+
+NTMultiChannelBuilderPtr createBuilder(NTMultiChannel & current)
+{
+    return NTMultiChannel::createBuilder()->
+        value(current.getValue()->getUnionArray()->getUnion());
+}
+
+void copyMetadata(PVStructurePtr const & source, PVStructurePtr const & target)
+{
+    PVStringPtr sourceDescriptor = source->getSubField<PVString>("descriptor");
+    PVStringPtr targetDescriptor = target->getSubField<PVString>("descriptor");
+    if (sourceDescriptor.get() && targetDescriptor.get())
+        targetDescriptor->put(sourceDescriptor->get());
+
+    const char * names[] = { "alarm", "timeStamp" };
+    for (size_t i = 0; i < sizeof(names)/sizeof(names[0]); ++i)
+    {
+        PVStructurePtr from = source->getSubField<PVStructure>(names[i]);
+        PVStructurePtr to = target->getSubField<PVStructure>(names[i]);
+        if (from.get() && to.get())
+            to->copyUnchecked(*from);
+    }
+}
+
+template<typename NT, typename Builder>
+std::tr1::shared_ptr<NT> createDeltaOf(NT & current,
+    std::tr1::shared_ptr<Builder> const & builder, Indices const & indices)
+{
+    checkIndices(indices, channelCount(current));
+
+    if (current.getDescriptor().get())
+        builder->addDescriptor();
+    if (current.getAlarm().get())
+        builder->addAlarm();
+    if (current.getTimeStamp().get())
+        builder->addTimeStamp();
+    if (current.getSeverity().get())
+        builder->addSeverity();
+    if (current.getStatus().get())
+        builder->addStatus();
+    if (current.getMessage().get())
+        builder->addMessage();
+    if (current.getSecondsPastEpoch().get())
+        builder->addSecondsPastEpoch();
+    if (current.getNanoseconds().get())
+        builder->addNanoseconds();
+    if (current.getUserTag().get())
+        builder->addUserTag();
+    if (current.getIsConnected().get())
+        builder->addIsConnected();
+    builder->add(NTMultiChannelDelta::CHANGED_INDEX,
+        getFieldCreate()->createScalarArray(pvInt));
+    std::tr1::shared_ptr<NT> delta = builder->create();
+
+    gather(current.getValue(), delta->getValue(), indices);
+    gather(current.getChannelName(), delta->getChannelName(), indices);
+    gather(current.getIsConnected(), delta->getIsConnected(), indices);
+    gather(current.getSeverity(), delta->getSeverity(), indices);
+    gather(current.getStatus(), delta->getStatus(), indices);
+    gather(current.getMessage(), delta->getMessage(), indices);
+    gather(current.getSecondsPastEpoch(), delta->getSecondsPastEpoch(), indices);
+    gather(current.getNanoseconds(), delta->getNanoseconds(), indices);
+    gather(current.getUserTag(), delta->getUserTag(), indices);
+    delta->getPVStructure()->template getSubField<PVIntArray>(
+        NTMultiChannelDelta::CHANGED_INDEX)->replace(indices);
+    copyMetadata(current.getPVStructure(), delta->getPVStructure());
+    return delta;
+}
+
+void checkValueType(NTScalarMultiChannel & base, NTScalarMultiChannel & delta)
+{
+    if (base.getValue()->getScalarArray()->getElementType() !=
+        delta.getValue()->getScalarArray()->getElementType())
+        throw std::runtime_error("delta value type differs from snapshot");
+}
+
+void checkValueType(NTMultiChannel & base, NTMultiChannel & delta)
+{
+    if (!(*base.getValue()->getUnionArray()->getUnion() ==
+        *delta.getValue()->getUnionArray()->getUnion()))
+        throw std::runtime_error("delta value type differs from snapshot");
+}
+
+template<typename NT>
+void mergeDelta(NT & base, NT & delta)
+{
+    PVIntArrayPtr pvIndices = delta.getPVStructure()->template getSubField<PVIntArray>(
+        NTMultiChannelDelta::CHANGED_INDEX);
+    if (!pvIndices.get())
+        throw std::runtime_error("not a multi-channel delta");
+    Indices indices(pvIndices->view());
+
+    // check everything before changing the snapshot
+    checkIndices(indices, channelCount(base));
+    checkValueType(base, delta);
+    checkLengths(delta, indices.size(),
+        "delta array length differs from number of changed channels");
+
+    scatter(delta.getValue(), base.getValue(), indices);
+    scatter(delta.getChannelName(), base.getChannelName(), indices);
+    scatter(delta.getIsConnected(), base.getIsConnected(), indices);
+    scatter(delta.getSeverity(), base.getSeverity(), indices);
+    scatter(delta.getStatus(), base.getStatus(), indices);
+    scatter(delta.getMessage(), base.getMessage(), indices);
+    scatter(delta.getSecondsPastEpoch(), base.getSecondsPastEpoch(), indices);
+    scatter(delta.getNanoseconds(), base.getNanoseconds(), indices);
+    scatter(delta.getUserTag(), base.getUserTag(), indices);
+    copyMetadata(delta.getPVStructure(), base.getPVStructure());
+}
+
+}
+
+Indices NTMultiChannelDelta::findChanged(
+    NTScalarMultiChannelPtr const & previous,
+    NTScalarMultiChannelPtr const & current)
+{
+    return findChangedChannels(*previous, *current);
+}
+
+Indices NTMultiChannelDelta::findChanged(
+    NTMultiChannelPtr const & previous,
+    NTMultiChannelPtr const & current)
+{
+    return findChangedChannels(*previous, *current);
+}
+
+NTScalarMultiChannelPtr NTMultiChannelDelta::createDelta(
+    NTScalarMultiChannelPtr const & current, Indices const & changedIndex)
+{
+    return createDeltaOf(*current, createBuilder(*current), changedIndex);
+}
+
+NTMultiChannelPtr NTMultiChannelDelta::createDelta(
+    NTMultiChannelPtr const & current, Indices const & changedIndex)
+{
+    return createDeltaOf(*current, createBuilder(*current), changedIndex);
+}
+
+NTScalarMultiChannelPtr NTMultiChannelDelta::createDelta(
+    NTScalarMultiChannelPtr const & previous,
+    NTScalarMultiChannelPtr const & current)
+{
+    return createDelta(current, findChanged(previous, current));
+}
+
+NTMultiChannelPtr NTMultiChannelDelta::createDelta(
+    NTMultiChannelPtr const & previous,
+    NTMultiChannelPtr const & current)
+{
+    return createDelta(current, findChanged(previous, current));
+}
+
+void NTMultiChannelDelta::merge(NTScalarMultiChannelPtr const & base,
+    NTScalarMultiChannelPtr const & delta)
+{
+    mergeDelta(*base, *delta);
+}
+
+void NTMultiChannelDelta::merge(NTMultiChannelPtr const & base,
+    NTMultiChannelPtr const & delta)
+{
+    mergeDelta(*base, *delta);
+}
+
+bool NTMultiChannelDelta::isDelta(PVStructurePtr const & pvStructure)
+{
+    return pvStructure.get() &&
+        pvStructure->getSubField<PVIntArray>(CHANGED_INDEX).get() != 0;
+}
+
+Indices NTMultiChannelDelta::getChangedIndex(PVStructurePtr const & pvStructure)
+{
+    PVIntArrayPtr pvIndices;
+    if (pvStructure.get())
+        pvIndices = pvStructure->getSubField<PVIntArray>(CHANGED_INDEX);
+    return pvIndices.get() ? pvIndices->view() : Indices();
+}
+
+}}
@@ -388,17 +388,27 @@ bool NTNDArray::isCompatible(PVStructurePtr const & pvStructure)
 bool NTNDArray::isValid()
 {
     int64 valueSize = getValueSize();
-    int64 compressedSize = getCompressedDataSize()->get();
+    int64 compressedSize = pvCompressedSize->get();
     if (valueSize != compressedSize)
         return false;
 
-    long expectedUncompressed = getExpectedUncompressedSize();
-    long uncompressedSize = getUncompressedDataSize()->get();
+    int64 uncompressedSize = pvUncompressedSize->get();
+
+    // the element type of an encoded value is that of the codec's
+    // payload, so the uncompressed size can only be checked if the codec
+    // parameters give the element type of the decoded value
+    if (!pvCodecName->get().empty())
+    {
+        int64 elementSize = getCodecElementSize();
+        return elementSize == 0 ||
+            uncompressedSize == elementSize*getElementCount();
+    }
+
+    int64 expectedUncompressed = getExpectedUncompressedSize();
     if (uncompressedSize != expectedUncompressed)
         return false;
 
-    std::string codecName = getCodec()->getSubField<PVString>("name")->get();
-    if (codecName == "" && valueSize < uncompressedSize)
+    if (valueSize < uncompressedSize)
         return false;
 
     return true;
@@ -406,71 +416,113 @@ bool NTNDArray::isValid()
 
 int64 NTNDArray::getExpectedUncompressedSize()
 {
-    int64 size = 0;
-    PVStructureArrayPtr pvDim = getDimension();
+    return getValueTypeSize()*getElementCount();
+}
+
+int64 NTNDArray::getElementCount()
+{
+    PVStructureArray::const_svector data = pvDimension->view();
 
-    if (pvDim->getLength() != 0)
+    // resolve the size fields only when the dimension array is replaced
+    if (data.data() != cachedDim.data() || data.size() != cachedDim.size())
     {
-        PVStructureArray::const_svector data = pvDim->view();
-        size = getValueTypeSize();
+        cachedDimSizes.clear();
+        cachedDimSizes.reserve(data.size());
         for (PVStructureArray::const_svector::const_iterator it = data.begin();
         it != data.end(); ++it )
         {
-            PVStructurePtr dim = *it;
-            size *= dim->getSubField<PVInt>("size")->get();
+            cachedDimSizes.push_back((*it)->getSubField<PVInt>("size"));
         }
+        cachedDim = data;
     }
 
-    return size;
+    if (cachedDimSizes.empty())
+        return 0;
+
+    int64 count = 1;
+    for (std::vector<PVIntPtr>::const_iterator it = cachedDimSizes.begin();
+    it != cachedDimSizes.end(); ++it )
+    {
+        count *= (*it)->get();
+    }
+
+    return count;
+}
+
+int64 NTNDArray::getCodecElementSize()
+{
+    PVUnionPtr pvParameters = pvNTNDArray->getSubField<PVUnion>("codec.parameters");
+    if (!pvParameters.get())
+        return 0;
+
+    // the ScalarType as an int, as areaDetector codecs store it, or an
+    // elementType field of a structure
+    PVFieldPtr parameters = pvParameters->get();
+    PVIntPtr pvElementType = std::tr1::dynamic_pointer_cast<PVInt>(parameters);
+    PVStructurePtr pvStructure = std::tr1::dynamic_pointer_cast<PVStructure>(parameters);
+    if (!pvElementType.get() && pvStructure.get())
+        pvElementType = pvStructure->getSubField<PVInt>("elementType");
+    if (!pvElementType.get())
+        return 0;
+
+    int32 elementType = pvElementType->get();
+    if (elementType < pvBoolean || elementType > pvDouble)
+        return 0;
+    return ScalarTypeFunc::elementSize(static_cast<ScalarType>(elementType));
 }
 
 int64 NTNDArray::getValueSize()
 {
-    int64 size = 0;
-    PVScalarArrayPtr storedValue = getValue()->get<PVScalarArray>();
-    if (!storedValue.get())
-    {
-        size = storedValue->getLength()*getValueTypeSize();
-    }
-    return size;
+    int64 typeSize = getValueTypeSize();
+    if (typeSize == 0)
+        return 0;
+
+    return cachedValue->getLength()*typeSize;
 }
 
 int64 NTNDArray::getValueTypeSize()
 {
-    int64 typeSize = 0;
-    PVScalarArrayPtr storedValue = getValue()->get<PVScalarArray>();
-    if (storedValue.get())
+    PVFieldPtr selected = pvValue->get();
+
+    // the element size only changes when a different union member is set
+    if (selected.get() != cachedValueField.get())
     {
-        switch (storedValue->getScalarArray()->getElementType())
+        cachedValue = std::tr1::dynamic_pointer_cast<PVScalarArray>(selected);
+        cachedValueField = selected;
+        cachedValueTypeSize = 0;
+        if (cachedValue.get())
         {
-        case pvBoolean:
-        case pvByte:
-        case pvUByte:
-            typeSize = 1;
-            break;
-
-        case pvShort:
-        case pvUShort:
-            typeSize = 2;
-            break;
-
-        case pvInt:
-        case pvUInt:
-        case pvFloat:
-            typeSize = 4;
-            break;
-
-        case pvLong:
-        case pvULong:
-        case pvDouble:
-            typeSize = 8;
-            break;
-
-        default:
-            break;
+            switch (cachedValue->getScalarArray()->getElementType())
+            {
+            case pvBoolean:
+            case pvByte:
+            case pvUByte:
+                cachedValueTypeSize = 1;
+                break;
+
+            case pvShort:
+            case pvUShort:
+                cachedValueTypeSize = 2;
+                break;
+
+            case pvInt:
+            case pvUInt:
+            case pvFloat:
+                cachedValueTypeSize = 4;
+                break;
+
+            case pvLong:
+            case pvULong:
+            case pvDouble:
+                cachedValueTypeSize = 8;
+                break;
+
+            default:
+                break;
+            }
         }
     }
-    return typeSize;
+    return cachedValueTypeSize;
 }
 
 NTNDArrayBuilderPtr NTNDArray::createBuilder()
@@ -522,7 +574,7 @@ PVStructurePtr NTNDArray::getPVStructure() const
 
 PVUnionPtr NTNDArray::getValue() const
 {
-    return pvNTNDArray->getSubField<PVUnion>("value");
+    return pvValue;
 }
 
 PVStructurePtr NTNDArray::getCodec() const
@@ -532,17 +584,17 @@ PVStructurePtr NTNDArray::getCodec() const
 
 PVLongPtr NTNDArray::getCompressedDataSize() const
 {
-    return pvNTNDArray->getSubField<PVLong>("compressedSize");
+    return pvCompressedSize;
 }
 
 PVLongPtr NTNDArray::getUncompressedDataSize() const
 {
-    return pvNTNDArray->getSubField<PVLong>("uncompressedSize");
+    return pvUncompressedSize;
 }
 
 PVStructureArrayPtr NTNDArray::getDimension() const
 {
-    return pvNTNDArray->getSubField<PVStructureArray>("dimension");
+    return pvDimension;
 }
 
 PVIntPtr NTNDArray::getUniqueId() const
@@ -557,7 +609,55 @@ PVStructurePtr NTNDArray::getDataTimeStamp() const
 
 PVStructureArrayPtr NTNDArray::getAttribute() const
 {
-    return pvNTNDArray->getSubField<PVStructureArray>("attribute");
+    return pvAttribute;
+}
+
+PVStructurePtr NTNDArray::getAttribute(std::string const & name)
+{
+    const AttributeEntry * entry = findAttribute(name);
+    return entry ? entry->attribute : PVStructurePtr();
+}
+
+PVUnionPtr NTNDArray::getAttributeValue(std::string const & name)
+{
+    const AttributeEntry * entry = findAttribute(name);
+    return entry ? entry->value : PVUnionPtr();
+}
+
+const NTNDArray::AttributeEntry * NTNDArray::findAttribute(std::string const & name)
+{
+    PVStructureArray::const_svector data = pvAttribute->view();
+
+    if (data.data() != indexedAttributes.data() || data.size() != indexedAttributes.size())
+        indexAttributes(data);
+
+    // an attribute renamed in place no longer matches its indexed name
+    AttributeIndex::const_iterator it = attributeIndex.find(name);
+    return (it != attributeIndex.end() && it->second.name->get() == name) ?
+        &it->second : 0;
+}
+
+void NTNDArray::indexAttributes(PVStructureArray::const_svector const & data)
+{
+    attributeIndex.clear();
+    for (PVStructureArray::const_svector::const_iterator it = data.begin();
+    it != data.end(); ++it )
+    {
+        if (!it->get())
+            continue;
+
+        PVStringPtr pvName = (*it)->getSubField<PVString>("name");
+        if (!pvName.get())
+            continue;
+
+        AttributeEntry entry;
+        entry.attribute = *it;
+        entry.name = pvName;
+        entry.value = (*it)->getSubField<PVUnion>("value");
+        // insert() keeps the first attribute of a given name
+        attributeIndex.insert(AttributeIndex::value_type(pvName->get(), entry));
+    }
+    indexedAttributes = data;
 }
 
 PVStringPtr NTNDArray::getDescriptor() const
@@ -582,7 +682,14 @@ PVStructurePtr NTNDArray::getDisplay() const
 
 
 NTNDArray::NTNDArray(PVStructurePtr const & pvStructure) :
-    pvNTNDArray(pvStructure)
+    pvNTNDArray(pvStructure),
+    pvValue(pvStructure->getSubField<PVUnion>("value")),
+    pvCompressedSize(pvStructure->getSubField<PVLong>("compressedSize")),
+    pvUncompressedSize(pvStructure->getSubField<PVLong>("uncompressedSize")),
+    pvDimension(pvStructure->getSubField<PVStructureArray>("dimension")),
+    pvCodecName(pvStructure->getSubField<PVString>("codec.name")),
+    cachedValueTypeSize(0),
+    pvAttribute(pvStructure->getSubField<PVStructureArray>("attribute"))
 {}
 
 
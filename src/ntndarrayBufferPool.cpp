@@ -0,0 +1,128 @@
+/* ntndarrayBufferPool.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarrayBufferPool.h>
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+/*
+ * Deleter returning a buffer to its pool, or freeing it if the pool is gone.
+ */
+struct NTNDArrayBufferRelease
+{
+    NTNDArrayBufferPool::weak_pointer pool;
+    size_t capacity;
+
+    NTNDArrayBufferRelease(NTNDArrayBufferPool::shared_pointer const & pool,
+        size_t capacity) :
+        pool(pool), capacity(capacity)
+    {}
+
+    void operator()(uint8 * data)
+    {
+        NTNDArrayBufferPool::shared_pointer owner = pool.lock();
+        if (owner.get())
+            owner->release(data, capacity);
+        else
+            delete [] data;
+    }
+};
+
+NTNDArrayBufferPool::shared_pointer NTNDArrayBufferPool::create(size_t maxIdle)
+{
+    return shared_pointer(new NTNDArrayBufferPool(maxIdle));
+}
+
+NTNDArrayBufferPool::NTNDArrayBufferPool(size_t maxIdle) :
+    maxIdle(maxIdle),
+    allocations(0),
+    reuses(0)
+{}
+
+NTNDArrayBufferPool::~NTNDArrayBufferPool()
+{
+    clear();
+}
+
+std::tr1::shared_ptr<uint8> NTNDArrayBufferPool::allocate(size_t size)
+{
+    if (size == 0)
+        size = 1;
+
+    uint8 * data = 0;
+    size_t capacity = size;
+    {
+        Lock xx(mutex);
+        std::multimap<size_t, uint8 *>::iterator it = idle.lower_bound(size);
+        if (it != idle.end() && it->first/2 <= size)
+        {
+            capacity = it->first;
+            data = it->second;
+            idle.erase(it);
+            ++reuses;
+        }
+        else
+        {
+            ++allocations;
+        }
+    }
+
+    if (!data)
+        data = new uint8[capacity];
+
+    return std::tr1::shared_ptr<uint8>(data,
+        NTNDArrayBufferRelease(shared_from_this(), capacity));
+}
+
+void NTNDArrayBufferPool::release(uint8 * data, size_t capacity)
+{
+    {
+        Lock xx(mutex);
+        if (idle.size() < maxIdle)
+        {
+            idle.insert(std::make_pair(capacity, data));
+            return;
+        }
+    }
+    delete [] data;
+}
+
+void NTNDArrayBufferPool::clear()
+{
+    std::multimap<size_t, uint8 *> unused;
+    {
+        Lock xx(mutex);
+        unused.swap(idle);
+    }
+    for (std::multimap<size_t, uint8 *>::iterator it = unused.begin();
+        it != unused.end(); ++it)
+        delete [] it->second;
+}
+
+size_t NTNDArrayBufferPool::getAllocations() const
+{
+    Lock xx(mutex);
+    return allocations;
+}
+
+size_t NTNDArrayBufferPool::getReuses() const
+{
+    Lock xx(mutex);
+    return reuses;
+}
+
+size_t NTNDArrayBufferPool::getIdle() const
+{
+    Lock xx(mutex);
+    return idle.size();
+}
+
+}}
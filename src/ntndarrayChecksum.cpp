@@ -0,0 +1,225 @@
+/* ntndarrayChecksum.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include <epicsEndian.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#   define NT_CRC32C_SSE42
+#   define NT_CRC32C_TARGET __attribute__((target("sse4.2")))
+#   include <nmmintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   define NT_CRC32C_SSE42
+#   define NT_CRC32C_TARGET
+#   include <intrin.h>
+#   include <nmmintrin.h>
+#endif
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarrayChecksum.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+const std::string NTNDArrayChecksum::attributeName("ValueCRC32C");
+
+namespace {
+
+// reflected Castagnoli polynomial
+const uint32 polynomial = 0x82f63b78;
+
+/*
+ * Tables for processing eight bytes per step ("slicing-by-8"):
+ * table[k][b] is the CRC of byte b followed by k zero bytes.
+ */
+struct Crc32cTable
+{
+    uint32 table[8][256];
+
+    Crc32cTable()
+    {
+        for (uint32 b = 0; b < 256; ++b)
+        {
+            uint32 crc = b;
+            for (int bit = 0; bit < 8; ++bit)
+                crc = (crc & 1) ? (crc >> 1) ^ polynomial : crc >> 1;
+            table[0][b] = crc;
+        }
+        for (uint32 b = 0; b < 256; ++b)
+            for (int k = 1; k < 8; ++k)
+                table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xff];
+    }
+};
+
+const Crc32cTable crcTable;
+
+inline uint32 loadLittleEndian(const uint8 * p)
+{
+    return uint32(p[0]) | (uint32(p[1]) << 8) | (uint32(p[2]) << 16) | (uint32(p[3]) << 24);
+}
+
+uint32 crc32cSoftware(const uint8 * p, size_t size, uint32 crc)
+{
+    const uint32 (&t)[8][256] = crcTable.table;
+
+    for (; size && (reinterpret_cast<size_t>(p) & 7); --size)
+        crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        uint32 lo = loadLittleEndian(p) ^ crc;
+        uint32 hi = loadLittleEndian(p + 4);
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^
+            t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+            t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^
+            t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+    }
+
+    for (; size; --size)
+        crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef NT_CRC32C_SSE42
+
+NT_CRC32C_TARGET
+uint32 crc32cHardware(const uint8 * p, size_t size, uint32 crc)
+{
+    for (; size && (reinterpret_cast<size_t>(p) & 7); --size)
+        crc = _mm_crc32_u8(crc, *p++);
+
+#if defined(__x86_64__) || defined(_M_X64)
+    uint64 crc64 = crc;
+    for (; size >= 8; size -= 8, p += 8)
+    {
+        uint64 word;
+        memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<uint32>(crc64);
+#endif
+    for (; size >= 4; size -= 4, p += 4)
+    {
+        uint32 word;
+        memcpy(&word, p, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+    }
+
+    for (; size; --size)
+        crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+
+bool detectSSE42()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+const bool hardware = detectSSE42();
+
+#else
+
+const bool hardware = false;
+
+#endif
+
+/*
+ * The raw bytes of the value in little-endian order, in pieces.
+ * On big-endian hosts elements are byte swapped through a small buffer.
+ */
+uint32 crc32cLittleEndian(detail::RawArray const & raw)
+{
+#if EPICS_BYTE_ORDER == EPICS_ENDIAN_BIG
+    size_t elementSize = ScalarTypeFunc::elementSize(raw.elementType);
+    if (elementSize > 1)
+    {
+        uint8 buffer[4096];
+        uint32 crc = 0;
+        for (size_t offset = 0; offset < raw.size; offset += sizeof(buffer))
+        {
+            size_t chunk = std::min(sizeof(buffer), raw.size - offset);
+            const uint8 * src = raw.data + offset;
+            for (size_t i = 0; i < chunk; i += elementSize)
+                for (size_t b = 0; b < elementSize; ++b)
+                    buffer[i + b] = src[i + elementSize - 1 - b];
+            crc = NTNDArrayChecksum::crc32c(buffer, chunk, crc);
+        }
+        return crc;
+    }
+#endif
+    return NTNDArrayChecksum::crc32c(raw.data, raw.size);
+}
+
+}
+
+uint32 NTNDArrayChecksum::crc32c(const void * data, size_t size, uint32 crc)
+{
+    const uint8 * p = static_cast<const uint8 *>(data);
+#ifdef NT_CRC32C_SSE42
+    if (hardware)
+        return ~crc32cHardware(p, size, ~crc);
+#endif
+    return ~crc32cSoftware(p, size, ~crc);
+}
+
+bool NTNDArrayChecksum::isHardwareAccelerated()
+{
+    return hardware;
+}
+
+uint32 NTNDArrayChecksum::compute(NTNDArrayPtr const & ntndArray)
+{
+    detail::RawArray raw;
+    if (!detail::getRawValue(ntndArray->getValue(), raw))
+        throw std::runtime_error("NTNDArray value is not a numeric array");
+    return crc32cLittleEndian(raw);
+}
+
+uint32 NTNDArrayChecksum::attach(NTNDArrayPtr const & ntndArray)
+{
+    uint32 crc = compute(ntndArray);
+
+    PVUIntPtr pvValue = getPVDataCreate()->createPVScalar<PVUInt>();
+    pvValue->put(crc);
+    detail::setAttribute(ntndArray, attributeName, pvValue, "CRC32C of the value");
+
+    return crc;
+}
+
+bool NTNDArrayChecksum::hasChecksum(NTNDArrayPtr const & ntndArray)
+{
+    uint32 crc;
+    return ntndArray->getAttributeValue(attributeName, crc);
+}
+
+bool NTNDArrayChecksum::verify(NTNDArrayPtr const & ntndArray)
+{
+    uint32 expected;
+    if (!ntndArray->getAttributeValue(attributeName, expected))
+        return false;
+
+    detail::RawArray raw;
+    if (!detail::getRawValue(ntndArray->getValue(), raw))
+        return false;
+    return crc32cLittleEndian(raw) == expected;
+}
+
+}}
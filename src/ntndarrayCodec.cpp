@@ -0,0 +1,344 @@
+/* ntndarrayCodec.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <cstring>
+#include <stdexcept>
+
+#include <pv/lock.h>
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarrayCodec.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+using detail::RawArray;
+using detail::RawArrayWriter;
+
+const std::string NTNDArrayDeltaCodec::name("delta");
+
+// runs of unchanged bytes shorter than this are kept in the literal
+static const size_t minZeroRun = 8;
+
+static Mutex mutex;
+
+StructureConstPtr NTNDArrayDeltaCodec::getParametersStructure()
+{
+    Lock xx(mutex);
+
+    static StructureConstPtr parametersStruc;
+    if (!parametersStruc)
+    {
+        parametersStruc = getFieldCreate()->createFieldBuilder()->
+            add("elementType", pvInt)->
+            add("keyFrame", pvBoolean)->
+            add("referenceId", pvInt)->
+            createStructure();
+    }
+    return parametersStruc;
+}
+
+static inline uint64 load64(const uint8 * p)
+{
+    uint64 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline void putVarint(size_t value, vector<uint8> & out)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8>(value));
+}
+
+static inline bool getVarint(const uint8 * & p, const uint8 * end, size_t & value)
+{
+    value = 0;
+    for (unsigned shift = 0; p != end && shift < 8*sizeof(size_t); shift += 7)
+    {
+        uint8 b = *p++;
+        value |= static_cast<size_t>(b & 0x7f) << shift;
+        if (!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+/*
+ * The packed format is a sequence of records, each consisting of
+ *   varint  number of unchanged (zero XOR) bytes to skip
+ *   varint  number of literal bytes
+ *   literal bytes (data XOR reference)
+ * Unchanged bytes are found a word at a time.
+ */
+void NTNDArrayDeltaCodec::pack(const uint8 * data, const uint8 * reference,
+    size_t size, vector<uint8> & out)
+{
+    size_t i = 0;
+    while (i < size)
+    {
+        size_t zeroStart = i;
+        if (reference)
+        {
+            while (i + 8 <= size && load64(data + i) == load64(reference + i))
+                i += 8;
+            while (i < size && data[i] == reference[i])
+                ++i;
+        }
+        else
+        {
+            while (i + 8 <= size && load64(data + i) == 0)
+                i += 8;
+            while (i < size && data[i] == 0)
+                ++i;
+        }
+        size_t zeros = i - zeroStart;
+
+        size_t literalStart = i;
+        size_t literalEnd = size;
+        size_t equalRun = 0;
+        for (; i < size; ++i)
+        {
+            bool equal = reference ? (data[i] == reference[i]) : (data[i] == 0);
+            if (!equal)
+                equalRun = 0;
+            else if (++equalRun == minZeroRun)
+            {
+                literalEnd = i + 1 - minZeroRun;
+                break;
+            }
+        }
+        i = literalEnd;
+
+        // trailing unchanged bytes need no record
+        size_t literals = literalEnd - literalStart;
+        if (literals == 0)
+            break;
+
+        putVarint(zeros, out);
+        putVarint(literals, out);
+
+        size_t pos = out.size();
+        out.resize(pos + literals);
+        uint8 * dst = literals ? &out[pos] : 0;
+        const uint8 * src = data + literalStart;
+        if (reference)
+        {
+            const uint8 * ref = reference + literalStart;
+            for (size_t k = 0; k < literals; ++k)
+                dst[k] = src[k] ^ ref[k];
+        }
+        else if (literals)
+        {
+            memcpy(dst, src, literals);
+        }
+    }
+}
+
+bool NTNDArrayDeltaCodec::unpack(const uint8 * packed, size_t packedSize,
+    uint8 * data, size_t size)
+{
+    const uint8 * p = packed;
+    const uint8 * end = packed + packedSize;
+    size_t pos = 0;
+
+    while (p != end)
+    {
+        size_t zeros, literals;
+        if (!getVarint(p, end, zeros) || !getVarint(p, end, literals))
+            return false;
+
+        if (zeros > size - pos)
+            return false;
+        pos += zeros;
+
+        if (literals > size - pos || literals > static_cast<size_t>(end - p))
+            return false;
+
+        uint8 * dst = data + pos;
+        for (size_t k = 0; k < literals; ++k)
+            dst[k] ^= p[k];
+
+        p += literals;
+        pos += literals;
+    }
+    return true;
+}
+
+
+NTNDArrayDeltaEncoder::shared_pointer NTNDArrayDeltaEncoder::create(size_t keyFrameInterval)
+{
+    return shared_pointer(new NTNDArrayDeltaEncoder(keyFrameInterval));
+}
+
+NTNDArrayDeltaEncoder::NTNDArrayDeltaEncoder(size_t keyFrameInterval) :
+    keyFrameInterval(keyFrameInterval),
+    framesSinceKeyFrame(0),
+    keyFrameRequested(true),
+    referenceData(0),
+    referenceSize(0),
+    referenceType(pvUByte),
+    referenceId(0)
+{}
+
+void NTNDArrayDeltaEncoder::requestKeyFrame()
+{
+    keyFrameRequested = true;
+}
+
+void NTNDArrayDeltaEncoder::encode(NTNDArrayPtr const & ntndArray)
+{
+    PVStructurePtr pvCodec = ntndArray->getCodec();
+    PVStringPtr pvCodecName = pvCodec->getSubField<PVString>("name");
+    if (!pvCodecName->get().empty())
+        throw std::runtime_error("NTNDArray value is already encoded");
+
+    RawArray raw;
+    if (!detail::getRawValue(ntndArray->getValue(), raw))
+        throw std::runtime_error("NTNDArray value is not a numeric array");
+
+    ++framesSinceKeyFrame;
+    bool keyFrame = keyFrameRequested ||
+        (keyFrameInterval != 0 && framesSinceKeyFrame >= keyFrameInterval) ||
+        raw.elementType != referenceType || raw.size != referenceSize;
+
+    packed.clear();
+    NTNDArrayDeltaCodec::pack(raw.data, keyFrame ? 0 : referenceData, raw.size, packed);
+
+    PVUByteArray::svector payload(packed.size());
+    if (!packed.empty())
+        memcpy(payload.data(), &packed[0], packed.size());
+    detail::replaceValue<PVUByteArray>(ntndArray->getValue(), "ubyteValue",
+        freeze(payload));
+
+    int32 uniqueId = ntndArray->getUniqueId()->get();
+
+    PVStructurePtr parameters = getPVDataCreate()->createPVStructure(
+        NTNDArrayDeltaCodec::getParametersStructure());
+    parameters->getSubField<PVInt>("elementType")->put(raw.elementType);
+    parameters->getSubField<PVBoolean>("keyFrame")->put(keyFrame);
+    parameters->getSubField<PVInt>("referenceId")->put(keyFrame ? uniqueId : referenceId);
+
+    pvCodecName->put(NTNDArrayDeltaCodec::name);
+    pvCodec->getSubField<PVUnion>("parameters")->set(parameters);
+    ntndArray->getCompressedDataSize()->put(static_cast<int64>(packed.size()));
+    ntndArray->getUncompressedDataSize()->put(static_cast<int64>(raw.size));
+
+    if (keyFrame)
+    {
+        framesSinceKeyFrame = 0;
+        keyFrameRequested = false;
+    }
+
+    referenceStorage = raw.storage;
+    referenceData = raw.data;
+    referenceSize = raw.size;
+    referenceType = raw.elementType;
+    referenceId = uniqueId;
+}
+
+
+NTNDArrayDeltaDecoder::shared_pointer NTNDArrayDeltaDecoder::create()
+{
+    return shared_pointer(new NTNDArrayDeltaDecoder());
+}
+
+NTNDArrayDeltaDecoder::NTNDArrayDeltaDecoder()
+{
+    reset();
+}
+
+void NTNDArrayDeltaDecoder::reset()
+{
+    referenceStorage.reset();
+    referenceData = 0;
+    referenceSize = 0;
+    referenceType = pvUByte;
+    referenceId = 0;
+}
+
+bool NTNDArrayDeltaDecoder::decode(NTNDArrayPtr const & ntndArray)
+{
+    PVStructurePtr pvCodec = ntndArray->getCodec();
+    PVStringPtr pvCodecName = pvCodec->getSubField<PVString>("name");
+    std::string codecName = pvCodecName->get();
+    if (codecName.empty())
+        return true;
+    if (codecName != NTNDArrayDeltaCodec::name)
+        throw std::runtime_error("unsupported NTNDArray codec " + codecName);
+
+    PVUnionPtr pvParameters = pvCodec->getSubField<PVUnion>("parameters");
+    PVStructurePtr parameters = pvParameters->get<PVStructure>();
+    PVIntPtr pvElementType = parameters.get() ?
+        parameters->getSubField<PVInt>("elementType") : PVIntPtr();
+    PVBooleanPtr pvKeyFrame = parameters.get() ?
+        parameters->getSubField<PVBoolean>("keyFrame") : PVBooleanPtr();
+    PVIntPtr pvReferenceId = parameters.get() ?
+        parameters->getSubField<PVInt>("referenceId") : PVIntPtr();
+    if (!pvElementType.get() || !pvKeyFrame.get() || !pvReferenceId.get())
+        throw std::runtime_error("invalid delta codec parameters");
+
+    int32 elementType = pvElementType->get();
+    if (elementType < pvBoolean || elementType >= pvString)
+        throw std::runtime_error("invalid delta codec element type");
+    ScalarType type = static_cast<ScalarType>(elementType);
+
+    int64 uncompressedSize = ntndArray->getUncompressedDataSize()->get();
+    // checked against the dimension before it sizes the decoded value
+    if (uncompressedSize < 0 || uncompressedSize !=
+        static_cast<int64>(ScalarTypeFunc::elementSize(type))*ntndArray->getElementCount())
+        throw std::runtime_error("invalid delta codec uncompressedSize");
+    size_t size = static_cast<size_t>(uncompressedSize);
+
+    bool keyFrame = pvKeyFrame->get() != 0;
+    if (!keyFrame && (!referenceData || pvReferenceId->get() != referenceId ||
+        type != referenceType || size != referenceSize))
+        return false;
+
+    PVUByteArrayPtr pvPayload = ntndArray->getValue()->get<PVUByteArray>();
+    if (!pvPayload.get())
+        throw std::runtime_error("delta codec payload is not a ubyte array");
+    PVUByteArray::const_svector payload = pvPayload->view();
+
+    RawArrayWriter writer(type, size);
+    if (size != 0)
+    {
+        if (keyFrame)
+            memset(writer.data(), 0, size);
+        else
+            memcpy(writer.data(), referenceData, size);
+    }
+
+    if (!NTNDArrayDeltaCodec::unpack(payload.data(), payload.size(), writer.data(), size))
+        throw std::runtime_error("corrupt delta codec payload");
+
+    PVUnionPtr pvValue = ntndArray->getValue();
+    writer.put(pvValue);
+
+    pvCodecName->put("");
+    pvParameters->set(PVFieldPtr());
+    ntndArray->getCompressedDataSize()->put(uncompressedSize);
+
+    RawArray raw;
+    detail::getRawValue(pvValue, raw);
+    referenceStorage = raw.storage;
+    referenceData = raw.data;
+    referenceSize = raw.size;
+    referenceType = raw.elementType;
+    referenceId = ntndArray->getUniqueId()->get();
+
+    return true;
+}
+
+}}
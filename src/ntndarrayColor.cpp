@@ -0,0 +1,360 @@
+/* ntndarrayColor.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdexcept>
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarrayColor.h>
+#include <pv/ntparallel.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+using detail::RawArray;
+using detail::RawArrayWriter;
+
+const std::string NTNDArrayColor::colorModeAttribute("ColorMode");
+const std::string NTNDArrayColor::bayerPatternAttribute("BayerPattern");
+
+namespace {
+
+enum { red = 0, green = 1, blue = 2 };
+
+// index of the color dimension of each RGB layout, by color mode
+const int colorDimension[] = { -1, -1, 0, 1, 2 };
+
+/*
+ * Element strides of the color, x and y coordinates of an image.
+ */
+struct Strides
+{
+    size_t color, x, y;
+
+    Strides(NTNDArrayColor::ColorMode mode, size_t width, size_t height)
+    {
+        switch (mode)
+        {
+        case NTNDArrayColor::rgb1: color = 1; x = 3; y = 3*width; break;
+        case NTNDArrayColor::rgb2: color = width; x = 1; y = 3*width; break;
+        case NTNDArrayColor::rgb3: color = width*height; x = 1; y = width; break;
+        default: color = 0; x = 1; y = width; break;
+        }
+    }
+};
+
+template<typename T>
+class RearrangeTask : public NTParallel::Task
+{
+public:
+    RearrangeTask(const T * src, Strides const & srcStrides,
+        T * dst, Strides const & dstStrides, size_t width) :
+        src(src), srcStrides(srcStrides), dst(dst), dstStrides(dstStrides),
+        width(width)
+    {}
+
+    virtual void run(size_t y)
+    {
+        for (size_t c = 0; c < 3; ++c)
+        {
+            const T * s = src + y*srcStrides.y + c*srcStrides.color;
+            T * d = dst + y*dstStrides.y + c*dstStrides.color;
+            size_t sx = srcStrides.x;
+            size_t dx = dstStrides.x;
+            if (sx == 1 && dx == 1)
+            {
+                for (size_t x = 0; x < width; ++x)
+                    d[x] = s[x];
+            }
+            else
+            {
+                for (size_t x = 0; x < width; ++x)
+                    d[x*dx] = s[x*sx];
+            }
+        }
+    }
+
+private:
+    const T * src;
+    Strides srcStrides;
+    T * dst;
+    Strides dstStrides;
+    size_t width;
+};
+
+/*
+ * The neighbours of a pixel which are averaged for each color missing at
+ * the pixel, by the parity class (y&1)*2 + (x&1) of the pixel.
+ */
+struct BayerNeighbours
+{
+    int site[4];
+    int count[4][3];
+    int dx[4][3][4];
+    int dy[4][3][4];
+
+    BayerNeighbours(NTNDArrayColor::BayerPattern pattern)
+    {
+        static const int patterns[4][4] = {
+            { red, green, green, blue },
+            { green, blue, red, green },
+            { green, red, blue, green },
+            { blue, green, green, red }
+        };
+
+        for (int cls = 0; cls < 4; ++cls)
+        {
+            site[cls] = patterns[pattern][cls];
+            for (int c = 0; c < 3; ++c)
+            {
+                count[cls][c] = 0;
+                if (c == site[cls])
+                    continue;
+                for (int j = -1; j <= 1; ++j)
+                    for (int i = -1; i <= 1; ++i)
+                    {
+                        int neighbour = (((cls >> 1) + j) & 1)*2 + (((cls & 1) + i) & 1);
+                        if (patterns[pattern][neighbour] != c)
+                            continue;
+                        dx[cls][c][count[cls][c]] = i;
+                        dy[cls][c][count[cls][c]] = j;
+                        ++count[cls][c];
+                    }
+            }
+        }
+    }
+};
+
+template<typename T>
+class DemosaicTask : public NTParallel::Task
+{
+public:
+    DemosaicTask(const T * src, size_t width, size_t height,
+        BayerNeighbours const & neighbours, T * dst, Strides const & dstStrides) :
+        src(src), width(width), height(height), neighbours(neighbours),
+        dst(dst), dstStrides(dstStrides)
+    {}
+
+    virtual void run(size_t y)
+    {
+        bool innerRow = y > 0 && y + 1 < height;
+        for (size_t x = 0; x < width; ++x)
+        {
+            int cls = (y & 1)*2 + (x & 1);
+            bool inner = innerRow && x > 0 && x + 1 < width;
+            T * d = dst + y*dstStrides.y + x*dstStrides.x;
+            for (int c = 0; c < 3; ++c)
+            {
+                T value;
+                if (c == neighbours.site[cls])
+                    value = src[y*width + x];
+                else
+                    value = interpolate(x, y, cls, c, inner);
+                d[c*dstStrides.color] = value;
+            }
+        }
+    }
+
+private:
+    T interpolate(size_t x, size_t y, int cls, int c, bool inner) const
+    {
+        const int * dx = neighbours.dx[cls][c];
+        const int * dy = neighbours.dy[cls][c];
+        int count = neighbours.count[cls][c];
+
+        double sum = 0;
+        int used = 0;
+        for (int k = 0; k < count; ++k)
+        {
+            // neighbours outside the image are skipped at the edges
+            if (!inner && (
+                (dx[k] < 0 && x == 0) || (dx[k] > 0 && x + 1 >= width) ||
+                (dy[k] < 0 && y == 0) || (dy[k] > 0 && y + 1 >= height)))
+                continue;
+            sum += src[(y + dy[k])*width + (x + dx[k])];
+            ++used;
+        }
+        return used ? detail::roundTo<T>(sum/used) : T();
+    }
+
+    const T * src;
+    size_t width, height;
+    BayerNeighbours const & neighbours;
+    T * dst;
+    Strides dstStrides;
+};
+
+class Converter
+{
+public:
+    Converter(RawArray const & raw, NTNDArrayColor::ColorMode from,
+        NTNDArrayColor::ColorMode to, NTNDArrayColor::BayerPattern pattern,
+        size_t width, size_t height, uint8 * data, size_t maxThreads) :
+        raw(raw), from(from), to(to), pattern(pattern),
+        width(width), height(height), data(data), maxThreads(maxThreads)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+        const value_type * src = reinterpret_cast<const value_type *>(raw.data);
+        value_type * dst = reinterpret_cast<value_type *>(data);
+        Strides dstStrides(to, width, height);
+
+        if (from == NTNDArrayColor::bayer)
+        {
+            BayerNeighbours neighbours(pattern);
+            DemosaicTask<value_type> task(src, width, height, neighbours,
+                dst, dstStrides);
+            NTParallel::forEach(height, task, maxThreads);
+        }
+        else
+        {
+            RearrangeTask<value_type> task(src, Strides(from, width, height),
+                dst, dstStrides, width);
+            NTParallel::forEach(height, task, maxThreads);
+        }
+    }
+
+private:
+    RawArray const & raw;
+    NTNDArrayColor::ColorMode from, to;
+    NTNDArrayColor::BayerPattern pattern;
+    size_t width, height;
+    uint8 * data;
+    size_t maxThreads;
+};
+
+size_t getSize(PVStructureArray::const_svector const & dims, size_t index)
+{
+    PVIntPtr pvSize = index < dims.size() && dims[index].get() ?
+        dims[index]->getSubField<PVInt>("size") : PVIntPtr();
+    if (!pvSize.get() || pvSize->get() < 0)
+        throw std::runtime_error("invalid NTNDArray dimension");
+    return pvSize->get();
+}
+
+}
+
+NTNDArrayColor::ColorMode NTNDArrayColor::getColorMode(NTNDArrayPtr const & ntndArray)
+{
+    PVStructureArray::const_svector dims = ntndArray->getDimension()->view();
+
+    int32 mode;
+    if (!ntndArray->getAttributeValue(colorModeAttribute, mode))
+    {
+        if (dims.size() == 3)
+            for (size_t d = 0; d < 3; ++d)
+                if (getSize(dims, d) == 3)
+                    return static_cast<ColorMode>(rgb1 + d);
+        if (dims.size() <= 2)
+            return mono;
+        throw std::runtime_error("cannot determine the color mode of the NTNDArray");
+    }
+
+    if (mode < mono || mode > rgb3)
+        throw std::runtime_error("unsupported NTNDArray color mode");
+    if (mode == mono || mode == bayer)
+    {
+        if (dims.size() > 2)
+            throw std::runtime_error("NTNDArray dimensions do not match its color mode");
+    }
+    else if (dims.size() != 3 || getSize(dims, colorDimension[mode]) != 3)
+        throw std::runtime_error("NTNDArray dimensions do not match its color mode");
+    return static_cast<ColorMode>(mode);
+}
+
+NTNDArrayColor::BayerPattern NTNDArrayColor::getBayerPattern(NTNDArrayPtr const & ntndArray)
+{
+    int32 pattern;
+    if (!ntndArray->getAttributeValue(bayerPatternAttribute, pattern))
+        return rggb;
+    if (pattern < rggb || pattern > bggr)
+        throw std::runtime_error("invalid NTNDArray Bayer pattern");
+    return static_cast<BayerPattern>(pattern);
+}
+
+NTNDArrayPtr NTNDArrayColor::convert(NTNDArrayPtr const & ntndArray,
+    ColorMode colorMode, size_t maxThreads)
+{
+    if (colorMode != rgb1 && colorMode != rgb2 && colorMode != rgb3)
+        throw std::runtime_error("color conversion to a non-RGB color mode");
+    if (!ntndArray->getCodec()->getSubField<PVString>("name")->get().empty())
+        throw std::runtime_error("cannot convert a compressed NTNDArray");
+
+    ColorMode from = getColorMode(ntndArray);
+    if (from == mono)
+        throw std::runtime_error("cannot convert a mono NTNDArray to color");
+    if (from == colorMode)
+        return ntndArray;
+
+    RawArray raw;
+    if (!detail::getRawValue(ntndArray->getValue(), raw))
+        throw std::runtime_error("NTNDArray value is not a numeric array");
+
+    // the dimensions holding x and y
+    PVStructureArray::const_svector dims = ntndArray->getDimension()->view();
+    size_t xIndex = from == rgb1 ? 1 : 0;
+    size_t yIndex = from == rgb3 || from == bayer ? 1 : 2;
+    size_t width = getSize(dims, xIndex);
+    size_t height = getSize(dims, yIndex);
+
+    size_t elementSize = ScalarTypeFunc::elementSize(raw.elementType);
+    size_t inputCount = width*height*(from == bayer ? 1 : 3);
+    if (inputCount*elementSize != raw.size)
+        throw std::runtime_error("NTNDArray value does not match its dimensions");
+
+    size_t bytes = 3*width*height*elementSize;
+    RawArrayWriter writer(raw.elementType, bytes);
+    if (bytes > 0)
+    {
+        Converter converter(raw, from, colorMode,
+            from == bayer ? getBayerPattern(ntndArray) : rggb,
+            width, height, writer.data(), maxThreads);
+        detail::dispatchNumericArray(raw.elementType, converter);
+    }
+
+    // a copy of the image sharing its arrays, with the converted value
+    NTNDArrayPtr converted = NTNDArray::wrapUnsafe(
+        getPVDataCreate()->createPVStructure(ntndArray->getPVStructure()));
+    writer.put(converted->getValue());
+    converted->getCompressedDataSize()->put(static_cast<int64>(bytes));
+    converted->getUncompressedDataSize()->put(static_cast<int64>(bytes));
+
+    PVStructureArrayPtr pvDim = converted->getDimension();
+    StructureConstPtr dimStructure = pvDim->getStructureArray()->getStructure();
+    PVStructurePtr xDim = getPVDataCreate()->createPVStructure(dimStructure);
+    xDim->copyUnchecked(*dims[xIndex]);
+    PVStructurePtr yDim = getPVDataCreate()->createPVStructure(dimStructure);
+    yDim->copyUnchecked(*dims[yIndex]);
+    PVStructurePtr colorDim = getPVDataCreate()->createPVStructure(dimStructure);
+    colorDim->getSubField<PVInt>("size")->put(3);
+    colorDim->getSubField<PVInt>("fullSize")->put(3);
+    colorDim->getSubField<PVInt>("binning")->put(1);
+
+    PVStructureArray::svector convertedDims;
+    if (colorMode == rgb1)
+        convertedDims.push_back(colorDim);
+    convertedDims.push_back(xDim);
+    if (colorMode == rgb2)
+        convertedDims.push_back(colorDim);
+    convertedDims.push_back(yDim);
+    if (colorMode == rgb3)
+        convertedDims.push_back(colorDim);
+    pvDim->replace(freeze(convertedDims));
+
+    PVIntPtr pvColorMode = getPVDataCreate()->createPVScalar<PVInt>();
+    pvColorMode->put(colorMode);
+    detail::setAttribute(converted, colorModeAttribute, pvColorMode, "Color mode");
+
+    return converted;
+}
+
+}}
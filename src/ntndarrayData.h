@@ -0,0 +1,377 @@
+/* ntndarrayData.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYDATA_H
+#define NTNDARRAYDATA_H
+
+/*
+ * Helpers shared by the NTNDArray processing code for accessing the
+ * selected member of the value union, and by the array math code. Not
+ * installed.
+ */
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <stdexcept>
+
+#include <pv/pvData.h>
+
+#include <pv/ntndarray.h>
+#include <pv/ntndarrayBufferPool.h>
+#include <pv/ntscalarArray.h>
+
+namespace epics { namespace nt { namespace detail {
+
+/**
+ * Returns the name of the value union member holding arrays of the
+ * specified element type, e.g. "ushortValue".
+ */
+inline std::string valueFieldName(epics::pvData::ScalarType elementType)
+{
+    return std::string(epics::pvData::ScalarTypeFunc::name(elementType)) + "Value";
+}
+
+/**
+ * Selects a member of the value union and replaces its array.
+ * PVUnion::select() does not post a put of the union, so it is posted
+ * here for monitors and NTChangeTracker to see the new value.
+ */
+template<typename PVT>
+inline void replaceValue(epics::pvData::PVUnionPtr const & pvValue,
+    std::string const & fieldName, typename PVT::const_svector const & value)
+{
+    pvValue->select<PVT>(fieldName)->replace(value);
+    pvValue->postPut();
+}
+
+/**
+ * Converts a double to an array element type, rounding to the nearest
+ * integer for integer types.
+ */
+template<typename T>
+inline T roundTo(double value)
+{
+    if (std::numeric_limits<T>::is_integer)
+        return static_cast<T>(value < 0 ? std::ceil(value - 0.5) : std::floor(value + 0.5));
+    return static_cast<T>(value);
+}
+
+/**
+ * Calls op.template apply<PVT>() with PVT the PVValueArray type of the
+ * specified numeric element type.
+ * Throws std::runtime_error for pvString.
+ */
+template<typename Op>
+void dispatchNumericArray(epics::pvData::ScalarType elementType, Op & op)
+{
+    using namespace epics::pvData;
+
+    switch (elementType)
+    {
+    case pvBoolean: op.template apply<PVBooleanArray>(); break;
+    case pvByte:    op.template apply<PVByteArray>(); break;
+    case pvShort:   op.template apply<PVShortArray>(); break;
+    case pvInt:     op.template apply<PVIntArray>(); break;
+    case pvLong:    op.template apply<PVLongArray>(); break;
+    case pvUByte:   op.template apply<PVUByteArray>(); break;
+    case pvUShort:  op.template apply<PVUShortArray>(); break;
+    case pvUInt:    op.template apply<PVUIntArray>(); break;
+    case pvULong:   op.template apply<PVULongArray>(); break;
+    case pvFloat:   op.template apply<PVFloatArray>(); break;
+    case pvDouble:  op.template apply<PVDoubleArray>(); break;
+    default:
+        throw std::runtime_error("unsupported array element type");
+    }
+}
+
+/**
+ * Returns the value of an NTScalarArray.
+ * Throws std::runtime_error if it is not a numeric array.
+ */
+inline epics::pvData::PVScalarArrayPtr getNumericValue(NTScalarArrayPtr const & ntScalarArray)
+{
+    epics::pvData::PVScalarArrayPtr pvValue =
+        ntScalarArray->getValue<epics::pvData::PVScalarArray>();
+    if (!pvValue.get() || pvValue->getScalarArray()->getElementType() == epics::pvData::pvString)
+        throw std::runtime_error("NTScalarArray value is not a numeric array");
+    return pvValue;
+}
+
+/**
+ * Operations with less work than this, e.g. elements or multiply-adds,
+ * run on the calling thread.
+ */
+const size_t parallelWork = 1 << 16;
+
+/**
+ * Returns the maxThreads argument of NTParallel::forEach() for an
+ * operation with the specified amount of work.
+ */
+inline size_t threadsFor(size_t work, size_t maxThreads)
+{
+    return work < parallelWork ? 1 : maxThreads;
+}
+
+/**
+ * Returns the number of blocks of up to block items holding count items.
+ */
+inline size_t blocks(size_t count, size_t block)
+{
+    return (count + block - 1)/block;
+}
+
+/**
+ * Returns the sum of count elements, in double precision. Four independent
+ * partial sums let the compiler vectorize the loop.
+ */
+template<typename T>
+inline double sumOf(const T * p, size_t count)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        s0 += p[i];
+        s1 += p[i + 1];
+        s2 += p[i + 2];
+        s3 += p[i + 3];
+    }
+    for (; i < count; ++i)
+        s0 += p[i];
+    return (s0 + s1) + (s2 + s3);
+}
+
+/**
+ * Read-only byte view of a numeric array.
+ * storage keeps the viewed data alive.
+ */
+struct RawArray
+{
+    std::tr1::shared_ptr<const void> storage;
+    const epics::pvData::uint8 * data;
+    size_t size;
+    epics::pvData::ScalarType elementType;
+
+    RawArray() : data(0), size(0), elementType(epics::pvData::pvUByte) {}
+};
+
+class RawArrayGetter
+{
+public:
+    RawArrayGetter(epics::pvData::PVScalarArrayPtr const & pvArray, RawArray & raw) :
+        pvArray(pvArray), raw(raw)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typename PVT::const_svector data =
+            std::tr1::static_pointer_cast<PVT>(pvArray)->view();
+        raw.storage = data.dataPtr();
+        raw.data = reinterpret_cast<const epics::pvData::uint8 *>(data.data());
+        raw.size = data.size()*sizeof(typename PVT::value_type);
+    }
+
+private:
+    epics::pvData::PVScalarArrayPtr const & pvArray;
+    RawArray & raw;
+};
+
+/**
+ * Gets a byte view of the numeric array selected in an NTNDArray value union.
+ * @return false if no numeric array is selected.
+ */
+inline bool getRawValue(epics::pvData::PVUnionPtr const & pvValue, RawArray & raw)
+{
+    epics::pvData::PVScalarArrayPtr pvArray =
+        pvValue->get<epics::pvData::PVScalarArray>();
+    if (!pvArray.get())
+        return false;
+
+    raw.elementType = pvArray->getScalarArray()->getElementType();
+    if (raw.elementType == epics::pvData::pvString)
+        return false;
+
+    RawArrayGetter getter(pvArray, raw);
+    dispatchNumericArray(raw.elementType, getter);
+    return true;
+}
+
+/**
+ * Allocates a numeric array of the specified element type and size in
+ * bytes, from pool if specified, exposes it for writing as bytes and then
+ * selects it in an NTNDArray value union.
+ */
+class RawArrayWriter
+{
+public:
+    RawArrayWriter(epics::pvData::ScalarType elementType, size_t size,
+        NTNDArrayBufferPoolPtr const & pool = NTNDArrayBufferPoolPtr()) :
+        elementType(elementType), size(size), storage(0), pool(pool), mode(allocate)
+    {
+        dispatchNumericArray(elementType, *this);
+    }
+
+    /**
+     * Returns the writable storage.
+     */
+    epics::pvData::uint8 * data() { return storage; }
+
+    /**
+     * Freezes the storage and selects it in the value union.
+     * The writer must not be used afterwards.
+     */
+    void put(epics::pvData::PVUnionPtr const & pvValue)
+    {
+        target = pvValue;
+        mode = store;
+        dispatchNumericArray(elementType, *this);
+        target.reset();
+    }
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+        typedef typename PVT::svector svector;
+
+        if (mode == allocate)
+        {
+            svector data = pool.get() ?
+                pool->allocateArray<value_type>(size/sizeof(value_type)) :
+                svector(size/sizeof(value_type));
+            storage = reinterpret_cast<epics::pvData::uint8 *>(data.data());
+            holder = std::tr1::static_pointer_cast<void>(data.dataPtr());
+        }
+        else
+        {
+            std::tr1::shared_ptr<value_type> ptr =
+                std::tr1::static_pointer_cast<value_type>(holder);
+            svector data(ptr, 0, size/sizeof(value_type));
+            holder.reset();
+            replaceValue<PVT>(target, valueFieldName(elementType), freeze(data));
+        }
+    }
+
+private:
+    enum Mode { allocate, store };
+
+    epics::pvData::ScalarType elementType;
+    size_t size;
+    epics::pvData::uint8 * storage;
+    NTNDArrayBufferPoolPtr pool;
+    std::tr1::shared_ptr<void> holder;
+    epics::pvData::PVUnionPtr target;
+    Mode mode;
+};
+
+/**
+ * Shared pointer deleter which releases the owner of externally managed
+ * memory instead of freeing the memory.
+ */
+struct OwnerDeleter
+{
+    std::tr1::shared_ptr<const void> owner;
+
+    explicit OwnerDeleter(std::tr1::shared_ptr<const void> const & owner) :
+        owner(owner)
+    {}
+
+    template<typename T>
+    void operator()(T *) { owner.reset(); }
+};
+
+class RawArrayWrapper
+{
+public:
+    RawArrayWrapper(epics::pvData::PVUnionPtr const & pvValue,
+        epics::pvData::ScalarType elementType,
+        std::tr1::shared_ptr<const void> const & owner,
+        const epics::pvData::uint8 * data, size_t size) :
+        pvValue(pvValue), elementType(elementType), owner(owner),
+        data(data), size(size)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+
+        std::tr1::shared_ptr<const value_type> ptr(
+            reinterpret_cast<const value_type *>(data), OwnerDeleter(owner));
+        typename PVT::const_svector value(ptr, 0, size/sizeof(value_type));
+        replaceValue<PVT>(pvValue, valueFieldName(elementType), value);
+    }
+
+private:
+    epics::pvData::PVUnionPtr const & pvValue;
+    epics::pvData::ScalarType elementType;
+    std::tr1::shared_ptr<const void> const & owner;
+    const epics::pvData::uint8 * data;
+    size_t size;
+};
+
+/**
+ * Selects a numeric array backed by existing memory in an NTNDArray value
+ * union, without copying. data must be suitably aligned for the element
+ * type and owner must keep it alive; owner is released when the last
+ * reference to the array goes away.
+ */
+inline void wrapRawValue(epics::pvData::PVUnionPtr const & pvValue,
+    epics::pvData::ScalarType elementType,
+    std::tr1::shared_ptr<const void> const & owner,
+    const epics::pvData::uint8 * data, size_t size)
+{
+    RawArrayWrapper wrapper(pvValue, elementType, owner, data, size);
+    dispatchNumericArray(elementType, wrapper);
+}
+
+/**
+ * Sets an attribute of an NTNDArray to a scalar value, replacing the first
+ * attribute of that name or appending a new one. The attribute array is
+ * replaced rather than modified, since its elements may be shared with
+ * other frames.
+ */
+inline void setAttribute(NTNDArrayPtr const & ntndArray, std::string const & name,
+    epics::pvData::PVScalarPtr const & value, std::string const & descriptor)
+{
+    using namespace epics::pvData;
+
+    PVStructureArrayPtr pvAttribute = ntndArray->getAttribute();
+    PVStructureArray::const_svector attributes = pvAttribute->view();
+
+    PVStructurePtr attribute = getPVDataCreate()->createPVStructure(
+        pvAttribute->getStructureArray()->getStructure());
+    attribute->getSubField<PVString>("name")->put(name);
+    attribute->getSubField<PVUnion>("value")->set(value);
+    PVStringPtr pvDescriptor = attribute->getSubField<PVString>("descriptor");
+    if (pvDescriptor.get())
+        pvDescriptor->put(descriptor);
+
+    PVStructureArray::svector updated;
+    updated.reserve(attributes.size() + 1);
+    bool replaced = false;
+    for (size_t i = 0; i < attributes.size(); ++i)
+    {
+        PVStringPtr pvName = attributes[i].get() ?
+            attributes[i]->getSubField<PVString>("name") : PVStringPtr();
+        if (!replaced && pvName.get() && pvName->get() == name)
+        {
+            updated.push_back(attribute);
+            replaced = true;
+        }
+        else
+            updated.push_back(attributes[i]);
+    }
+    if (!replaced)
+        updated.push_back(attribute);
+    pvAttribute->replace(freeze(updated));
+}
+
+}}}
+
+#endif  /* NTNDARRAYDATA_H */
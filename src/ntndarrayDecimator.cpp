@@ -0,0 +1,328 @@
+/* ntndarrayDecimator.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <pv/pvTimeStamp.h>
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarrayDecimator.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+using detail::RawArray;
+using detail::RawArrayWriter;
+
+namespace {
+
+/*
+ * Adds the binned elements of an array to sum. The loops over the
+ * contiguous rows along dimension 0 carry no dependencies and are left
+ * to the compiler to vectorize.
+ */
+template<typename T>
+void accumulate(const T * in, std::vector<size_t> const & sizes,
+    std::vector<size_t> const & bins, std::vector<size_t> const & binned,
+    double * sum)
+{
+    size_t rank = sizes.size();
+    size_t rowLength = sizes[0];
+    size_t rows = 1;
+    for (size_t d = 1; d < rank; ++d)
+        rows *= sizes[d];
+
+    size_t bin0 = bins[0];
+    size_t binned0 = binned[0];
+    std::vector<size_t> coord(rank, 0);
+    for (size_t row = 0; row < rows; ++row, in += rowLength)
+    {
+        // offset of the row in the binned array, unless it is in a partial block
+        size_t out = 0;
+        size_t stride = binned0;
+        bool inside = true;
+        for (size_t d = 1; d < rank; ++d)
+        {
+            size_t c = coord[d]/bins[d];
+            if (c >= binned[d])
+            {
+                inside = false;
+                break;
+            }
+            out += c*stride;
+            stride *= binned[d];
+        }
+
+        if (inside)
+        {
+            double * s = sum + out;
+            if (bin0 == 1)
+            {
+                for (size_t x = 0; x < binned0; ++x)
+                    s[x] += in[x];
+            }
+            else
+            {
+                for (size_t x = 0; x < binned0; ++x)
+                {
+                    const T * p = in + x*bin0;
+                    double block = 0;
+                    for (size_t k = 0; k < bin0; ++k)
+                        block += p[k];
+                    s[x] += block;
+                }
+            }
+        }
+
+        for (size_t d = 1; d < rank && ++coord[d] == sizes[d]; ++d)
+            coord[d] = 0;
+    }
+}
+
+class Accumulator
+{
+public:
+    Accumulator(RawArray const & raw, std::vector<size_t> const & sizes,
+        std::vector<size_t> const & bins, std::vector<size_t> const & binned,
+        std::vector<double> & sum) :
+        raw(raw), sizes(sizes), bins(bins), binned(binned), sum(sum)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+        if (sum.empty())
+            return;
+        accumulate(reinterpret_cast<const value_type *>(raw.data),
+            sizes, bins, binned, &sum[0]);
+    }
+
+private:
+    RawArray const & raw;
+    std::vector<size_t> const & sizes;
+    std::vector<size_t> const & bins;
+    std::vector<size_t> const & binned;
+    std::vector<double> & sum;
+};
+
+class Scaler
+{
+public:
+    Scaler(std::vector<double> const & sum, double scale, uint8 * data) :
+        sum(sum), scale(scale), data(data)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+        value_type * out = reinterpret_cast<value_type *>(data);
+        for (size_t i = 0; i < sum.size(); ++i)
+            out[i] = detail::roundTo<value_type>(sum[i]*scale);
+    }
+
+private:
+    std::vector<double> const & sum;
+    double scale;
+    uint8 * data;
+};
+
+void getSizes(NTNDArrayPtr const & ntndArray, std::vector<size_t> & sizes)
+{
+    PVStructureArray::const_svector dims = ntndArray->getDimension()->view();
+    sizes.clear();
+    for (size_t i = 0; i < dims.size(); ++i)
+    {
+        PVIntPtr pvSize = dims[i].get() ?
+            dims[i]->getSubField<PVInt>("size") : PVIntPtr();
+        if (!pvSize.get() || pvSize->get() < 0)
+            throw std::runtime_error("invalid NTNDArray dimension");
+        sizes.push_back(pvSize->get());
+    }
+}
+
+}
+
+NTNDArrayDecimator::shared_pointer NTNDArrayDecimator::create(
+    size_t decimation, NTNDArrayBufferPoolPtr const & pool)
+{
+    return shared_pointer(new NTNDArrayDecimator(decimation,
+        pool.get() ? pool : NTNDArrayBufferPool::create(4)));
+}
+
+NTNDArrayDecimator::NTNDArrayDecimator(size_t decimation,
+    NTNDArrayBufferPoolPtr const & pool) :
+    decimation(std::max<size_t>(decimation, 1)),
+    minimumPeriod(0),
+    averaging(false),
+    pool(pool),
+    groupFrames(0),
+    emitted(false),
+    elementType(pvUByte)
+{}
+
+void NTNDArrayDecimator::setDecimation(size_t decimation)
+{
+    this->decimation = std::max<size_t>(decimation, 1);
+    groupFrames = 0;
+}
+
+void NTNDArrayDecimator::setMinimumPeriod(double seconds)
+{
+    minimumPeriod = seconds;
+    groupFrames = 0;
+}
+
+void NTNDArrayDecimator::setAveraging(bool averaging)
+{
+    this->averaging = averaging;
+    groupFrames = 0;
+}
+
+void NTNDArrayDecimator::setBinning(std::vector<size_t> const & binning)
+{
+    this->binning = binning;
+    sizes.clear();
+    groupFrames = 0;
+}
+
+void NTNDArrayDecimator::reset()
+{
+    groupFrames = 0;
+    emitted = false;
+}
+
+bool NTNDArrayDecimator::isBinning() const
+{
+    for (size_t d = 0; d < binning.size(); ++d)
+        if (binning[d] > 1)
+            return true;
+    return false;
+}
+
+NTNDArrayPtr NTNDArrayDecimator::process(NTNDArrayPtr const & ntndArray)
+{
+    if (!ntndArray->getCodec()->getSubField<PVString>("name")->get().empty())
+        throw std::runtime_error("cannot decimate a compressed NTNDArray");
+
+    RawArray raw;
+    if (!detail::getRawValue(ntndArray->getValue(), raw))
+        throw std::runtime_error("NTNDArray value is not a numeric array");
+
+    std::vector<size_t> frameSizes;
+    getSizes(ntndArray, frameSizes);
+    size_t count = frameSizes.empty() ? 0 : 1;
+    for (size_t d = 0; d < frameSizes.size(); ++d)
+        count *= frameSizes[d];
+    if (count*ScalarTypeFunc::elementSize(raw.elementType) != raw.size)
+        throw std::runtime_error("NTNDArray value does not match its dimensions");
+
+    bool reduce = averaging || isBinning();
+    if (reduce && (raw.elementType != elementType || frameSizes != sizes))
+    {
+        std::vector<size_t> frameBinned(frameSizes.size());
+        for (size_t d = 0; d < frameSizes.size(); ++d)
+        {
+            size_t bin = d < binning.size() && binning[d] ? binning[d] : 1;
+            if (bin > frameSizes[d] && frameSizes[d] > 0)
+                throw std::runtime_error("binning exceeds NTNDArray dimension size");
+            frameBinned[d] = frameSizes[d]/bin;
+        }
+
+        // a new layout starts a new group
+        elementType = raw.elementType;
+        sizes.swap(frameSizes);
+        binnedSizes.swap(frameBinned);
+        groupFrames = 0;
+    }
+
+    TimeStamp timeStamp;
+    PVTimeStamp pvTimeStamp;
+    if (ntndArray->attachDataTimeStamp(pvTimeStamp))
+        pvTimeStamp.get(timeStamp);
+
+    ++groupFrames;
+    bool due = groupFrames >= decimation;
+    if (due && minimumPeriod > 0 && emitted)
+    {
+        // a timestamp going backwards restarts the period
+        double elapsed = TimeStamp::diff(timeStamp, lastEmitted);
+        due = elapsed < 0 || elapsed >= minimumPeriod;
+    }
+
+    if (averaging || (due && reduce))
+    {
+        if (groupFrames == 1 || !averaging)
+        {
+            size_t binnedCount = binnedSizes.empty() ? 0 : 1;
+            for (size_t d = 0; d < binnedSizes.size(); ++d)
+                binnedCount *= binnedSizes[d];
+            sum.assign(binnedCount, 0.0);
+        }
+
+        std::vector<size_t> bins(sizes.size());
+        for (size_t d = 0; d < sizes.size(); ++d)
+            bins[d] = d < binning.size() && binning[d] ? binning[d] : 1;
+        Accumulator accumulator(raw, sizes, bins, binnedSizes, sum);
+        detail::dispatchNumericArray(elementType, accumulator);
+    }
+
+    if (!due)
+        return NTNDArrayPtr();
+
+    size_t frames = averaging ? groupFrames : 1;
+    groupFrames = 0;
+    emitted = true;
+    lastEmitted = timeStamp;
+
+    return reduce ? createReduced(ntndArray, frames) : ntndArray;
+}
+
+NTNDArrayPtr NTNDArrayDecimator::createReduced(NTNDArrayPtr const & ntndArray,
+    size_t frames)
+{
+    size_t binVolume = 1;
+    for (size_t d = 0; d < sizes.size(); ++d)
+        binVolume *= d < binning.size() && binning[d] ? binning[d] : 1;
+
+    size_t bytes = sum.size()*ScalarTypeFunc::elementSize(elementType);
+    RawArrayWriter writer(elementType, bytes, pool);
+    Scaler scaler(sum, 1.0/(static_cast<double>(frames)*binVolume), writer.data());
+    detail::dispatchNumericArray(elementType, scaler);
+
+    // a copy of the last frame sharing its arrays, with the reduced value
+    NTNDArrayPtr reduced = NTNDArray::wrapUnsafe(
+        getPVDataCreate()->createPVStructure(ntndArray->getPVStructure()));
+    writer.put(reduced->getValue());
+    reduced->getCompressedDataSize()->put(static_cast<int64>(bytes));
+    reduced->getUncompressedDataSize()->put(static_cast<int64>(bytes));
+
+    PVStructureArray::const_svector frameDims = ntndArray->getDimension()->view();
+    PVStructureArrayPtr pvDim = reduced->getDimension();
+    StructureConstPtr dimStructure = pvDim->getStructureArray()->getStructure();
+    PVStructureArray::svector dims;
+    for (size_t d = 0; d < frameDims.size(); ++d)
+    {
+        size_t bin = d < binning.size() && binning[d] ? binning[d] : 1;
+        PVStructurePtr dim = getPVDataCreate()->createPVStructure(dimStructure);
+        dim->copyUnchecked(*frameDims[d]);
+        PVIntPtr pvBinning = dim->getSubField<PVInt>("binning");
+        dim->getSubField<PVInt>("size")->put(static_cast<int32>(binnedSizes[d]));
+        pvBinning->put(std::max<int32>(pvBinning->get(), 1)*static_cast<int32>(bin));
+        dims.push_back(dim);
+    }
+    pvDim->replace(freeze(dims));
+
+    return reduced;
+}
+
+}}
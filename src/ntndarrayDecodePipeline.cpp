@@ -0,0 +1,304 @@
+/* ntndarrayDecodePipeline.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <epicsThread.h>
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarrayDecodePipeline.h>
+#include <pv/ntndarrayTiling.h>
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+namespace {
+
+class DefaultDecoder : public NTNDArrayDecodePipeline::Decoder
+{
+public:
+    virtual void decode(NTNDArrayPtr const & ntndArray,
+        NTNDArrayBufferPoolPtr const & pool)
+    {
+        std::string codec = ntndArray->getCodec()->getSubField<PVString>("name")->get();
+        if (codec.empty())
+            return;
+        if (codec == NTNDArrayTiledCodec::name)
+        {
+            // frames are decoded in parallel, one per worker
+            NTNDArrayTiledCodec::decode(ntndArray, 1, pool);
+            return;
+        }
+        throw std::runtime_error("unsupported NTNDArray codec " + codec);
+    }
+};
+
+}
+
+class NTNDArrayDecodePipeline::Worker : public epicsThreadRunable
+{
+public:
+    Worker(NTNDArrayDecodePipeline & pipeline) :
+        pipeline(pipeline),
+        thread(*this, "NTNDArrayDecode",
+            epicsThreadGetStackSize(epicsThreadStackMedium),
+            epicsThreadPriorityMedium)
+    {
+        thread.start();
+    }
+
+    virtual void run()
+    {
+        pipeline.work();
+    }
+
+    void join()
+    {
+        thread.exitWait();
+    }
+
+private:
+    NTNDArrayDecodePipeline & pipeline;
+    epicsThread thread;
+};
+
+NTNDArrayDecodePipeline::shared_pointer NTNDArrayDecodePipeline::create(
+    size_t threads, size_t capacity, Decoder::shared_pointer const & decoder)
+{
+    shared_pointer pipeline(new NTNDArrayDecodePipeline(
+        std::max<size_t>(capacity, 1),
+        decoder.get() ? decoder : Decoder::shared_pointer(new DefaultDecoder())));
+
+    threads = std::max<size_t>(threads, 1);
+    for (size_t i = 0; i < threads; ++i)
+        pipeline->workers.push_back(new Worker(*pipeline));
+    return pipeline;
+}
+
+NTNDArrayDecodePipeline::NTNDArrayDecodePipeline(size_t capacity,
+    Decoder::shared_pointer const & decoder) :
+    capacity(capacity),
+    decoder(decoder),
+    pool(NTNDArrayBufferPool::create(capacity)),
+    stopping(false),
+    claimed(0)
+{
+    resetStatistics();
+}
+
+NTNDArrayDecodePipeline::~NTNDArrayDecodePipeline()
+{
+    stop();
+    for (size_t i = 0; i < workers.size(); ++i)
+        delete workers[i];
+}
+
+bool NTNDArrayDecodePipeline::waitFor(Event & event, double timeout,
+    TimeStamp const & start)
+{
+    if (timeout < 0)
+    {
+        event.wait();
+        return true;
+    }
+
+    TimeStamp now;
+    now.getCurrent();
+    double remaining = timeout - TimeStamp::diff(now, start);
+    if (remaining <= 0)
+        return false;
+    event.wait(remaining);
+    return true;
+}
+
+bool NTNDArrayDecodePipeline::put(NTNDArrayPtr const & ntndArray, double timeout)
+{
+    TimeStamp start;
+    start.getCurrent();
+
+    Lock xx(mutex);
+    while (!stopping && entries.size() >= capacity)
+    {
+        xx.unlock();
+        bool waited = waitFor(notFull, timeout, start);
+        xx.lock();
+        if (!waited)
+            return false;
+    }
+    if (stopping)
+    {
+        notFull.signal();
+        return false;
+    }
+
+    Entry entry;
+    entry.frame = ntndArray;
+    entry.queued.getCurrent();
+    entry.done = false;
+    entry.failed = false;
+    entries.push_back(entry);
+
+    if (entries.size() < capacity)
+        notFull.signal();
+    notEmpty.signal();
+    return true;
+}
+
+void NTNDArrayDecodePipeline::work()
+{
+    while (true)
+    {
+        Entry * entry;
+        {
+            Lock xx(mutex);
+            while (!stopping && claimed == entries.size())
+            {
+                xx.unlock();
+                notEmpty.wait();
+                xx.lock();
+            }
+            if (stopping)
+            {
+                notEmpty.signal();
+                return;
+            }
+
+            // deque elements stay in place while others are added or removed
+            entry = &entries[claimed++];
+            if (claimed < entries.size())
+                notEmpty.signal();
+        }
+
+        TimeStamp start;
+        start.getCurrent();
+        bool ok = true;
+        try {
+            decoder->decode(entry->frame, pool);
+        } catch (...) {
+            ok = false;
+        }
+        TimeStamp end;
+        end.getCurrent();
+
+        Lock xx(mutex);
+        entry->done = true;
+        entry->failed = !ok;
+        entry->decoded = end;
+
+        double queueTime = TimeStamp::diff(start, entry->queued);
+        double decodeTime = TimeStamp::diff(end, start);
+        ++decoded;
+        totalQueueTime += queueTime;
+        maxQueueTime = std::max(maxQueueTime, queueTime);
+        totalDecodeTime += decodeTime;
+        maxDecodeTime = std::max(maxDecodeTime, decodeTime);
+
+        if (entry == &entries.front())
+            ready.signal();
+    }
+}
+
+NTNDArrayPtr NTNDArrayDecodePipeline::take(double timeout)
+{
+    TimeStamp start;
+    start.getCurrent();
+
+    Lock xx(mutex);
+    while (true)
+    {
+        while (!entries.empty() && entries.front().done)
+        {
+            Entry entry = entries.front();
+            entries.pop_front();
+            --claimed;
+            notFull.signal();
+
+            if (entry.failed)
+            {
+                ++failed;
+                continue;
+            }
+
+            TimeStamp now;
+            now.getCurrent();
+            double deliveryTime = TimeStamp::diff(now, entry.decoded);
+            ++frames;
+            totalDeliveryTime += deliveryTime;
+            maxDeliveryTime = std::max(maxDeliveryTime, deliveryTime);
+
+            if (!entries.empty() && entries.front().done)
+                ready.signal();
+            return entry.frame;
+        }
+
+        if (stopping)
+        {
+            ready.signal();
+            return NTNDArrayPtr();
+        }
+
+        xx.unlock();
+        bool waited = waitFor(ready, timeout, start);
+        xx.lock();
+        if (!waited)
+            return NTNDArrayPtr();
+    }
+}
+
+void NTNDArrayDecodePipeline::stop()
+{
+    {
+        Lock xx(mutex);
+        stopping = true;
+    }
+    notEmpty.signal();
+    notFull.signal();
+    ready.signal();
+
+    for (size_t i = 0; i < workers.size(); ++i)
+        workers[i]->join();
+
+    {
+        Lock xx(mutex);
+        entries.resize(claimed);
+    }
+    ready.signal();
+}
+
+NTNDArrayDecodePipeline::Statistics NTNDArrayDecodePipeline::getStatistics() const
+{
+    Lock xx(mutex);
+
+    Statistics statistics;
+    statistics.frames = frames;
+    statistics.failed = failed;
+    statistics.inProgress = entries.size();
+    statistics.meanQueueTime = decoded ? totalQueueTime/decoded : 0;
+    statistics.maxQueueTime = maxQueueTime;
+    statistics.meanDecodeTime = decoded ? totalDecodeTime/decoded : 0;
+    statistics.maxDecodeTime = maxDecodeTime;
+    statistics.meanDeliveryTime = frames ? totalDeliveryTime/frames : 0;
+    statistics.maxDeliveryTime = maxDeliveryTime;
+    return statistics;
+}
+
+void NTNDArrayDecodePipeline::resetStatistics()
+{
+    Lock xx(mutex);
+
+    frames = 0;
+    failed = 0;
+    decoded = 0;
+    totalQueueTime = maxQueueTime = 0;
+    totalDecodeTime = maxDecodeTime = 0;
+    totalDeliveryTime = maxDeliveryTime = 0;
+}
+
+}}
@@ -0,0 +1,522 @@
+/* ntndarrayFrameStore.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <cstring>
+#include <climits>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <unistd.h>
+#  if defined(_POSIX_MAPPED_FILES) && _POSIX_MAPPED_FILES > 0
+#    define NT_FRAMESTORE_MMAP
+#    include <sys/types.h>
+#    include <sys/stat.h>
+#    include <sys/mman.h>
+#  endif
+#endif
+
+#include <epicsAssert.h>
+#include <pv/byteBuffer.h>
+#include <pv/serialize.h>
+#include <pv/pvTimeStamp.h>
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarrayFrameStore.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+using detail::FrameRecordHeader;
+using detail::RawArray;
+using detail::RawArrayWriter;
+
+namespace {
+
+struct FileHeader
+{
+    char magic[8];
+    uint32 byteOrder;
+    uint32 version;
+    uint32 pageSize;
+    uint32 reserved;
+};
+
+STATIC_ASSERT(sizeof(FileHeader) == 24);
+STATIC_ASSERT(sizeof(FrameRecordHeader) == 72);
+
+const char fileMagic[8] = { 'N', 'T', 'N', 'D', 'A', 'R', 'R', 'S' };
+const uint32 byteOrderMark = 0x01020304;
+const uint32 fileVersion = 1;
+const uint32 recordMagic = 0x4e444652;   // "NDFR"
+
+// alignment of the value payloads and of the record headers
+const size_t pageSize = 4096;
+const size_t recordAlignment = 8;
+
+inline uint64 alignUp(uint64 offset, size_t alignment)
+{
+    return (offset + alignment - 1)/alignment*alignment;
+}
+
+/*
+ * Serializes fields into a vector through a small ByteBuffer.
+ */
+class MetadataSerializer : public SerializableControl
+{
+public:
+    MetadataSerializer(vector<char> & out) :
+        out(out), buffer(chunk, sizeof(chunk))
+    {}
+
+    ByteBuffer * getBuffer() { return &buffer; }
+
+    virtual void flushSerializeBuffer()
+    {
+        out.insert(out.end(), chunk, chunk + buffer.getPosition());
+        buffer.clear();
+    }
+
+    virtual void ensureBuffer(size_t size)
+    {
+        if (buffer.getRemaining() < size)
+            flushSerializeBuffer();
+    }
+
+    virtual void alignBuffer(size_t alignment)
+    {
+        size_t position = out.size() + buffer.getPosition();
+        size_t padding = alignUp(position, alignment) - position;
+        ensureBuffer(padding);
+        for (size_t i = 0; i < padding; ++i)
+            buffer.putByte(0);
+    }
+
+    virtual bool directSerialize(ByteBuffer *, const char *, size_t, size_t)
+    {
+        return false;
+    }
+
+    virtual void cachedSerialize(FieldConstPtr const & field, ByteBuffer * buffer)
+    {
+        field->serialize(buffer, this);
+    }
+
+private:
+    vector<char> & out;
+    char chunk[1024];
+    ByteBuffer buffer;
+};
+
+/*
+ * Deserializes fields from a buffer holding all their data.
+ */
+class MetadataDeserializer : public DeserializableControl
+{
+public:
+    MetadataDeserializer(ByteBuffer & buffer) : buffer(buffer) {}
+
+    virtual void ensureData(size_t size)
+    {
+        if (buffer.getRemaining() < size)
+            throw std::runtime_error("truncated frame store metadata");
+    }
+
+    virtual void alignData(size_t alignment)
+    {
+        size_t position = buffer.getPosition();
+        size_t aligned = alignUp(position, alignment);
+        ensureData(aligned - position);
+        buffer.setPosition(aligned);
+    }
+
+    virtual bool directDeserialize(ByteBuffer *, char *, size_t, size_t)
+    {
+        return false;
+    }
+
+    virtual FieldConstPtr cachedDeserialize(ByteBuffer * buffer)
+    {
+        return getFieldCreate()->deserialize(buffer, this);
+    }
+
+private:
+    ByteBuffer & buffer;
+};
+
+#ifdef NT_FRAMESTORE_MMAP
+struct Unmapper
+{
+    size_t size;
+
+    explicit Unmapper(size_t size) : size(size) {}
+
+    void operator()(const void * data)
+    {
+        munmap(const_cast<void *>(data), size);
+    }
+};
+#endif
+
+bool lessTime(FrameRecordHeader const & a, FrameRecordHeader const & b)
+{
+    return a.secondsPastEpoch < b.secondsPastEpoch ||
+        (a.secondsPastEpoch == b.secondsPastEpoch && a.nanoseconds < b.nanoseconds);
+}
+
+struct TimeOrder
+{
+    vector<FrameRecordHeader> const & records;
+
+    TimeOrder(vector<FrameRecordHeader> const & records) : records(records) {}
+
+    bool operator()(size_t a, size_t b) const
+    {
+        return lessTime(records[a], records[b]);
+    }
+
+    bool operator()(size_t a, FrameRecordHeader const & b) const
+    {
+        return lessTime(records[a], b);
+    }
+
+    bool operator()(FrameRecordHeader const & a, size_t b) const
+    {
+        return lessTime(a, records[b]);
+    }
+};
+
+}
+
+
+NTNDArrayFrameWriter::shared_pointer NTNDArrayFrameWriter::create(
+    std::string const & fileName)
+{
+    FILE * file = fopen(fileName.c_str(), "wb");
+    if (!file)
+        throw std::runtime_error("cannot create frame store " + fileName);
+
+    shared_pointer writer(new NTNDArrayFrameWriter(fileName, file));
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, fileMagic, sizeof(header.magic));
+    header.byteOrder = byteOrderMark;
+    header.version = fileVersion;
+    header.pageSize = pageSize;
+    writer->put(&header, sizeof(header));
+    writer->pad(recordAlignment);
+
+    return writer;
+}
+
+NTNDArrayFrameWriter::NTNDArrayFrameWriter(std::string const & fileName, FILE * file) :
+    fileName(fileName),
+    file(file),
+    offset(0),
+    frameCount(0)
+{}
+
+NTNDArrayFrameWriter::~NTNDArrayFrameWriter()
+{
+    if (file)
+        fclose(file);
+}
+
+void NTNDArrayFrameWriter::put(const void * data, size_t size)
+{
+    if (!file)
+        throw std::runtime_error("frame store " + fileName + " is closed");
+    if (size != 0 && fwrite(data, 1, size, file) != size)
+        throw std::runtime_error("error writing frame store " + fileName);
+    offset += size;
+}
+
+void NTNDArrayFrameWriter::pad(size_t alignment)
+{
+    static const char zeros[pageSize] = { 0 };
+
+    size_t padding = static_cast<size_t>(alignUp(offset, alignment) - offset);
+    while (padding != 0)
+    {
+        size_t n = std::min(padding, sizeof(zeros));
+        put(zeros, n);
+        padding -= n;
+    }
+}
+
+void NTNDArrayFrameWriter::write(NTNDArrayPtr const & ntndArray)
+{
+    PVUnionPtr pvValue = ntndArray->getValue();
+    RawArray raw;
+    int32 elementType = -1;
+    if (pvValue->get().get())
+    {
+        if (!detail::getRawValue(pvValue, raw))
+            throw std::runtime_error("NTNDArray value is not a numeric array");
+        elementType = raw.elementType;
+    }
+
+    metadata.clear();
+    MetadataSerializer serializer(metadata);
+    ntndArray->getDimension()->serialize(serializer.getBuffer(), &serializer);
+    ntndArray->getCodec()->serialize(serializer.getBuffer(), &serializer);
+    ntndArray->getAttribute()->serialize(serializer.getBuffer(), &serializer);
+    serializer.flushSerializeBuffer();
+
+    TimeStamp dataTimeStamp;
+    PVTimeStamp pvDataTimeStamp;
+    if (ntndArray->attachDataTimeStamp(pvDataTimeStamp))
+        pvDataTimeStamp.get(dataTimeStamp);
+
+    FrameRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = recordMagic;
+    header.metadataSize = static_cast<uint32>(metadata.size());
+    header.payloadOffset = offset + sizeof(header) + metadata.size();
+    if (raw.size != 0)
+        header.payloadOffset = alignUp(header.payloadOffset, pageSize);
+    header.payloadSize = raw.size;
+    header.nextRecord = alignUp(header.payloadOffset + raw.size, recordAlignment);
+    header.compressedSize = ntndArray->getCompressedDataSize()->get();
+    header.uncompressedSize = ntndArray->getUncompressedDataSize()->get();
+    header.secondsPastEpoch = dataTimeStamp.getSecondsPastEpoch();
+    header.nanoseconds = dataTimeStamp.getNanoseconds();
+    header.userTag = dataTimeStamp.getUserTag();
+    header.uniqueId = ntndArray->getUniqueId()->get();
+    header.elementType = elementType;
+
+    put(&header, sizeof(header));
+    put(metadata.empty() ? 0 : &metadata[0], metadata.size());
+    pad(raw.size != 0 ? pageSize : 1);
+    put(raw.data, raw.size);
+    pad(recordAlignment);
+
+    ++frameCount;
+}
+
+void NTNDArrayFrameWriter::flush()
+{
+    if (file && fflush(file) != 0)
+        throw std::runtime_error("error writing frame store " + fileName);
+}
+
+void NTNDArrayFrameWriter::close()
+{
+    if (!file)
+        return;
+    int status = fclose(file);
+    file = 0;
+    if (status != 0)
+        throw std::runtime_error("error writing frame store " + fileName);
+}
+
+
+NTNDArrayFrameReader::shared_pointer NTNDArrayFrameReader::create(
+    std::string const & fileName)
+{
+    FILE * file = fopen(fileName.c_str(), "rb");
+    if (!file)
+        throw std::runtime_error("cannot open frame store " + fileName);
+
+    shared_pointer reader(new NTNDArrayFrameReader(file));
+
+    uint64 fileSize = 0;
+#ifdef NT_FRAMESTORE_MMAP
+    struct stat status;
+    if (fstat(fileno(file), &status) == 0)
+        fileSize = status.st_size;
+    if (fileSize != 0 && fileSize <= static_cast<size_t>(-1))
+    {
+        void * data = mmap(0, fileSize, PROT_READ, MAP_PRIVATE,
+            fileno(file), 0);
+        if (data != MAP_FAILED)
+        {
+            reader->mapping.reset(static_cast<const void *>(data), Unmapper(fileSize));
+            reader->mappedData = static_cast<const uint8 *>(data);
+        }
+    }
+#else
+    if (fseek(file, 0, SEEK_END) == 0)
+    {
+        long size = ftell(file);
+        if (size > 0)
+            fileSize = size;
+    }
+#endif
+
+    FileHeader header;
+    if (fileSize < sizeof(header))
+        throw std::runtime_error(fileName + " is not a frame store");
+    reader->readAt(0, &header, sizeof(header));
+    if (memcmp(header.magic, fileMagic, sizeof(header.magic)) != 0)
+        throw std::runtime_error(fileName + " is not a frame store");
+    if (header.byteOrder != byteOrderMark)
+        throw std::runtime_error("frame store " + fileName + " has a foreign byte order");
+    if (header.version != fileVersion || header.pageSize != pageSize)
+        throw std::runtime_error("unsupported frame store version in " + fileName);
+
+    reader->buildIndex(fileSize);
+    return reader;
+}
+
+NTNDArrayFrameReader::NTNDArrayFrameReader(FILE * file) :
+    file(file),
+    mappedData(0),
+    structure(NTNDArray::createBuilder()->createStructure())
+{}
+
+NTNDArrayFrameReader::~NTNDArrayFrameReader()
+{
+    // the mapping may outlive the reader, it does not need the file
+    fclose(file);
+}
+
+void NTNDArrayFrameReader::readAt(uint64 offset, void * data, size_t size)
+{
+    if (mappedData)
+    {
+        memcpy(data, mappedData + offset, size);
+        return;
+    }
+
+    Lock xx(mutex);
+    if (offset > static_cast<uint64>(LONG_MAX) ||
+        fseek(file, static_cast<long>(offset), SEEK_SET) != 0 ||
+        fread(data, 1, size, file) != size)
+        throw std::runtime_error("error reading frame store");
+}
+
+void NTNDArrayFrameReader::buildIndex(uint64 fileSize)
+{
+    uint64 offset = alignUp(sizeof(FileHeader), recordAlignment);
+    while (fileSize - offset >= sizeof(FrameRecordHeader))
+    {
+        FrameRecordHeader header;
+        readAt(offset, &header, sizeof(header));
+
+        // stop at a truncated or corrupt record
+        uint64 metadataEnd = offset + sizeof(header) + header.metadataSize;
+        if (header.magic != recordMagic ||
+            header.payloadOffset < metadataEnd ||
+            header.payloadOffset > fileSize ||
+            header.payloadSize > fileSize - header.payloadOffset ||
+            header.nextRecord < header.payloadOffset + header.payloadSize ||
+            header.nextRecord > fileSize)
+            break;
+        if (header.elementType < 0)
+        {
+            if (header.payloadSize != 0)
+                break;
+        }
+        else if (header.elementType >= pvString ||
+            header.payloadSize % ScalarTypeFunc::elementSize(
+                static_cast<ScalarType>(header.elementType)) != 0 ||
+            (header.payloadSize != 0 && header.payloadOffset % pageSize != 0))
+            break;
+
+        records.push_back(header);
+        recordOffsets.push_back(offset);
+        offset = header.nextRecord;
+    }
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        uniqueIdIndex.insert(std::make_pair(records[i].uniqueId, i));
+        timeIndex.push_back(i);
+    }
+    std::stable_sort(timeIndex.begin(), timeIndex.end(), TimeOrder(records));
+}
+
+NTNDArrayPtr NTNDArrayFrameReader::read(size_t index)
+{
+    if (index >= records.size())
+        throw std::out_of_range("frame store index out of range");
+    FrameRecordHeader const & header = records[index];
+
+    NTNDArrayPtr ntndArray = NTNDArray::wrapUnsafe(
+        getPVDataCreate()->createPVStructure(structure));
+
+    // ByteBuffer needs writable storage, so the metadata is copied even from
+    // a mapped file; it is small compared with the payload
+    vector<char> metadata(header.metadataSize + 1);
+    readAt(recordOffsets[index] + sizeof(header), &metadata[0], header.metadataSize);
+
+    ByteBuffer buffer(&metadata[0], header.metadataSize);
+    MetadataDeserializer deserializer(buffer);
+    ntndArray->getDimension()->deserialize(&buffer, &deserializer);
+    ntndArray->getCodec()->deserialize(&buffer, &deserializer);
+    ntndArray->getAttribute()->deserialize(&buffer, &deserializer);
+
+    ntndArray->getCompressedDataSize()->put(header.compressedSize);
+    ntndArray->getUncompressedDataSize()->put(header.uncompressedSize);
+    ntndArray->getUniqueId()->put(header.uniqueId);
+
+    PVTimeStamp pvDataTimeStamp;
+    if (ntndArray->attachDataTimeStamp(pvDataTimeStamp))
+        pvDataTimeStamp.set(getDataTimeStamp(index));
+
+    if (header.elementType >= 0)
+    {
+        ScalarType elementType = static_cast<ScalarType>(header.elementType);
+        size_t size = static_cast<size_t>(header.payloadSize);
+        if (mappedData)
+        {
+            detail::wrapRawValue(ntndArray->getValue(), elementType, mapping,
+                mappedData + header.payloadOffset, size);
+        }
+        else
+        {
+            RawArrayWriter writer(elementType, size);
+            if (size != 0)
+                readAt(header.payloadOffset, writer.data(), size);
+            writer.put(ntndArray->getValue());
+        }
+    }
+
+    return ntndArray;
+}
+
+int32 NTNDArrayFrameReader::getUniqueId(size_t index) const
+{
+    return records.at(index).uniqueId;
+}
+
+TimeStamp NTNDArrayFrameReader::getDataTimeStamp(size_t index) const
+{
+    FrameRecordHeader const & header = records.at(index);
+    return TimeStamp(header.secondsPastEpoch, header.nanoseconds, header.userTag);
+}
+
+bool NTNDArrayFrameReader::findUniqueId(int32 uniqueId, size_t & index) const
+{
+    std::map<int32, size_t>::const_iterator it = uniqueIdIndex.find(uniqueId);
+    if (it == uniqueIdIndex.end())
+        return false;
+    index = it->second;
+    return true;
+}
+
+bool NTNDArrayFrameReader::findTime(TimeStamp const & time, size_t & index) const
+{
+    FrameRecordHeader key;
+    memset(&key, 0, sizeof(key));
+    key.secondsPastEpoch = time.getSecondsPastEpoch();
+    key.nanoseconds = time.getNanoseconds();
+
+    vector<size_t>::const_iterator it = std::lower_bound(
+        timeIndex.begin(), timeIndex.end(), key, TimeOrder(records));
+    if (it == timeIndex.end())
+        return false;
+    index = *it;
+    return true;
+}
+
+}}
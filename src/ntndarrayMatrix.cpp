@@ -0,0 +1,210 @@
+/* ntndarrayMatrix.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdexcept>
+#include <vector>
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarrayMatrix.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+namespace {
+
+/*
+ * Converts the numeric array selected in a value union to double.
+ */
+class DoubleConverter
+{
+public:
+    DoubleConverter(PVScalarArrayPtr const & pvArray) :
+        pvArray(pvArray)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typename PVT::const_svector data =
+            std::tr1::static_pointer_cast<PVT>(pvArray)->view();
+        const typename PVT::value_type * src = data.data();
+        size_t count = data.size();
+
+        PVDoubleArray::svector converted(count);
+        double * dst = converted.data();
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = static_cast<double>(src[i]);
+        result = freeze(converted);
+    }
+
+    PVDoubleArray::const_svector result;
+
+private:
+    PVScalarArrayPtr const & pvArray;
+};
+
+size_t elementCount(std::vector<int32> const & sizes)
+{
+    size_t count = 1;
+    for (size_t i = 0; i < sizes.size(); ++i)
+        count *= static_cast<size_t>(sizes[i]);
+    return count;
+}
+
+PVStructurePtr createDimension(StructureConstPtr const & dimStructure, int32 size)
+{
+    PVStructurePtr dim = getPVDataCreate()->createPVStructure(dimStructure);
+    dim->getSubField<PVInt>("size")->put(size);
+    dim->getSubField<PVInt>("fullSize")->put(size);
+    dim->getSubField<PVInt>("binning")->put(1);
+    return dim;
+}
+
+}
+
+bool NTNDArrayMatrix::isSharedValue(NTNDArrayPtr const & ntndArray)
+{
+    return ntndArray->getValue()->get<PVDoubleArray>().get() != 0;
+}
+
+NTMatrixPtr NTNDArrayMatrix::toMatrix(NTNDArrayPtr const & ntndArray)
+{
+    if (!ntndArray->getCodec()->getSubField<PVString>("name")->get().empty())
+        throw std::runtime_error("cannot convert a compressed NTNDArray to NTMatrix");
+
+    PVScalarArrayPtr pvArray = ntndArray->getValue()->get<PVScalarArray>();
+    if (!pvArray.get() || pvArray->getScalarArray()->getElementType() == pvString)
+        throw std::runtime_error("NTNDArray value is not a numeric array");
+
+    // [width] or [width, height], ignoring trailing dimensions of size 1
+    PVStructureArray::const_svector dims = ntndArray->getDimension()->view();
+    if (dims.empty())
+        throw std::runtime_error("NTNDArray has no dimensions");
+    std::vector<int32> sizes;
+    for (size_t i = 0; i < dims.size(); ++i)
+    {
+        PVIntPtr pvSize = dims[i].get() ?
+            dims[i]->getSubField<PVInt>("size") : PVIntPtr();
+        if (!pvSize.get())
+            throw std::runtime_error("invalid NTNDArray dimension");
+        int32 size = pvSize->get();
+        if (size < 0)
+            throw std::runtime_error("NTNDArray has a negative dimension size");
+        if (i < 2)
+            sizes.push_back(size);
+        else if (size != 1)
+            throw std::runtime_error("NTNDArray has more than two dimensions");
+    }
+
+    size_t count = elementCount(sizes);
+    if (count != pvArray->getLength())
+        throw std::runtime_error("NTNDArray value does not match its dimensions");
+
+    NTMatrixBuilderPtr builder = NTMatrix::createBuilder();
+    builder->addDim()->addTimeStamp();
+    if (ntndArray->getDescriptor().get())
+        builder->addDescriptor();
+    if (ntndArray->getAlarm().get())
+        builder->addAlarm();
+    NTMatrixPtr matrix = builder->create();
+
+    PVDoubleArrayPtr pvDouble = std::tr1::dynamic_pointer_cast<PVDoubleArray>(pvArray);
+    if (pvDouble.get())
+    {
+        matrix->getValue()->replace(pvDouble->view());
+    }
+    else
+    {
+        DoubleConverter converter(pvArray);
+        detail::dispatchNumericArray(pvArray->getScalarArray()->getElementType(),
+            converter);
+        matrix->getValue()->replace(converter.result);
+    }
+
+    // rows first
+    PVIntArray::svector dim;
+    if (sizes.size() > 1)
+        dim.push_back(sizes[1]);
+    dim.push_back(sizes[0]);
+    matrix->getDim()->replace(freeze(dim));
+
+    matrix->getTimeStamp()->copyUnchecked(*ntndArray->getDataTimeStamp());
+    if (ntndArray->getDescriptor().get())
+        matrix->getDescriptor()->put(ntndArray->getDescriptor()->get());
+    if (ntndArray->getAlarm().get())
+        matrix->getAlarm()->copyUnchecked(*ntndArray->getAlarm());
+
+    return matrix;
+}
+
+NTNDArrayPtr NTNDArrayMatrix::toNTNDArray(NTMatrixPtr const & matrix)
+{
+    PVDoubleArray::const_svector value = matrix->getValue()->view();
+
+    // columns first
+    std::vector<int32> sizes;
+    PVIntArrayPtr pvDim = matrix->getDim();
+    if (pvDim.get() && pvDim->getLength() > 0)
+    {
+        PVIntArray::const_svector dim = pvDim->view();
+        if (dim.size() > 2)
+            throw std::runtime_error("NTMatrix dim has more than two entries");
+        for (size_t i = dim.size(); i-- > 0; )
+        {
+            if (dim[i] < 0)
+                throw std::runtime_error("NTMatrix dim has a negative entry");
+            sizes.push_back(dim[i]);
+        }
+    }
+    else
+    {
+        sizes.push_back(static_cast<int32>(value.size()));
+    }
+
+    size_t count = elementCount(sizes);
+    if (count != value.size())
+        throw std::runtime_error("NTMatrix value does not match its dim");
+
+    NTNDArrayBuilderPtr builder = NTNDArray::createBuilder();
+    if (matrix->getDescriptor().get())
+        builder->addDescriptor();
+    if (matrix->getAlarm().get())
+        builder->addAlarm();
+    if (matrix->getTimeStamp().get())
+        builder->addTimeStamp();
+    NTNDArrayPtr ntndArray = builder->create();
+
+    detail::replaceValue<PVDoubleArray>(ntndArray->getValue(),
+        detail::valueFieldName(pvDouble), value);
+    int64 bytes = static_cast<int64>(value.size()*sizeof(double));
+    ntndArray->getCompressedDataSize()->put(bytes);
+    ntndArray->getUncompressedDataSize()->put(bytes);
+
+    PVStructureArrayPtr pvDimension = ntndArray->getDimension();
+    StructureConstPtr dimStructure = pvDimension->getStructureArray()->getStructure();
+    PVStructureArray::svector dimension;
+    for (size_t i = 0; i < sizes.size(); ++i)
+        dimension.push_back(createDimension(dimStructure, sizes[i]));
+    pvDimension->replace(freeze(dimension));
+
+    if (matrix->getTimeStamp().get())
+    {
+        ntndArray->getDataTimeStamp()->copyUnchecked(*matrix->getTimeStamp());
+        ntndArray->getTimeStamp()->copyUnchecked(*matrix->getTimeStamp());
+    }
+    if (matrix->getDescriptor().get())
+        ntndArray->getDescriptor()->put(matrix->getDescriptor()->get());
+    if (matrix->getAlarm().get())
+        ntndArray->getAlarm()->copyUnchecked(*matrix->getAlarm());
+
+    return ntndArray;
+}
+
+}}
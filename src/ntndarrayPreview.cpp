@@ -0,0 +1,239 @@
+/* ntndarrayPreview.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarrayPreview.h>
+#include <pv/ntndarrayTiling.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+using detail::RawArray;
+
+namespace {
+
+/*
+ * Averages factor x factor blocks of an image, streaming through its rows
+ * once. Blocks at the right and bottom edges may be smaller.
+ */
+template<typename T>
+void downscale(const T * in, size_t width, size_t height, size_t factor,
+    size_t outWidth, size_t outHeight, std::vector<double> & rowSum,
+    double * out)
+{
+    rowSum.resize(outWidth);
+    for (size_t oy = 0; oy < outHeight; ++oy)
+    {
+        std::fill(rowSum.begin(), rowSum.end(), 0.0);
+        size_t y0 = oy*factor;
+        size_t y1 = std::min(y0 + factor, height);
+        for (size_t y = y0; y < y1; ++y)
+        {
+            const T * row = in + y*width;
+            for (size_t ox = 0; ox < outWidth; ++ox)
+            {
+                size_t x0 = ox*factor;
+                size_t x1 = std::min(x0 + factor, width);
+                double block = 0;
+                for (size_t x = x0; x < x1; ++x)
+                    block += row[x];
+                rowSum[ox] += block;
+            }
+        }
+
+        for (size_t ox = 0; ox < outWidth; ++ox)
+        {
+            size_t x0 = ox*factor;
+            size_t x1 = std::min(x0 + factor, width);
+            out[oy*outWidth + ox] = rowSum[ox]/((x1 - x0)*(y1 - y0));
+        }
+    }
+}
+
+class Downscaler
+{
+public:
+    Downscaler(RawArray const & raw, size_t width, size_t height, size_t factor,
+        size_t outWidth, size_t outHeight, std::vector<double> & rowSum,
+        std::vector<double> & values) :
+        raw(raw), width(width), height(height), factor(factor),
+        outWidth(outWidth), outHeight(outHeight), rowSum(rowSum), values(values)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+        downscale(reinterpret_cast<const value_type *>(raw.data), width, height,
+            factor, outWidth, outHeight, rowSum, &values[0]);
+    }
+
+private:
+    RawArray const & raw;
+    size_t width, height, factor;
+    size_t outWidth, outHeight;
+    std::vector<double> & rowSum;
+    std::vector<double> & values;
+};
+
+double percentileOf(std::vector<double> & sorted, double percent)
+{
+    size_t index = static_cast<size_t>(percent/100*(sorted.size() - 1) + 0.5);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+}
+
+NTNDArrayPreview::shared_pointer NTNDArrayPreview::create(size_t maxWidth,
+    size_t maxHeight)
+{
+    if (maxWidth == 0 || maxHeight == 0)
+        throw std::runtime_error("preview size must be at least 1 x 1");
+    return shared_pointer(new NTNDArrayPreview(maxWidth, maxHeight));
+}
+
+NTNDArrayPreview::NTNDArrayPreview(size_t maxWidth, size_t maxHeight) :
+    maxWidth(maxWidth),
+    maxHeight(maxHeight),
+    percentile(false),
+    lowPercentile(0),
+    highPercentile(100),
+    compressed(false)
+{}
+
+void NTNDArrayPreview::setMinMaxWindow()
+{
+    percentile = false;
+}
+
+void NTNDArrayPreview::setPercentileWindow(double low, double high)
+{
+    if (!(low >= 0 && low <= high && high <= 100))
+        throw std::runtime_error("invalid preview percentiles");
+    percentile = true;
+    lowPercentile = low;
+    highPercentile = high;
+}
+
+NTNDArrayPtr NTNDArrayPreview::generate(NTNDArrayPtr const & ntndArray)
+{
+    if (!ntndArray->getCodec()->getSubField<PVString>("name")->get().empty())
+        throw std::runtime_error("cannot preview a compressed NTNDArray");
+
+    RawArray raw;
+    if (!detail::getRawValue(ntndArray->getValue(), raw))
+        throw std::runtime_error("NTNDArray value is not a numeric array");
+
+    PVStructureArray::const_svector dims = ntndArray->getDimension()->view();
+    std::vector<size_t> sizes;
+    for (size_t d = 0; d < dims.size(); ++d)
+    {
+        PVIntPtr pvSize = dims[d].get() ?
+            dims[d]->getSubField<PVInt>("size") : PVIntPtr();
+        if (!pvSize.get() || pvSize->get() < 0)
+            throw std::runtime_error("invalid NTNDArray dimension");
+        if (d >= 2 && pvSize->get() != 1)
+            throw std::runtime_error("NTNDArray preview requires a two-dimensional image");
+        sizes.push_back(pvSize->get());
+    }
+    if (sizes.empty())
+        throw std::runtime_error("NTNDArray preview requires a two-dimensional image");
+
+    size_t width = sizes[0];
+    size_t height = sizes.size() > 1 ? sizes[1] : 1;
+    if (width*height*ScalarTypeFunc::elementSize(raw.elementType) != raw.size)
+        throw std::runtime_error("NTNDArray value does not match its dimensions");
+
+    // the smallest integer factor fitting the preview size
+    size_t factor = std::max<size_t>(1, std::max(
+        (width + maxWidth - 1)/maxWidth, (height + maxHeight - 1)/maxHeight));
+    size_t outWidth = (width + factor - 1)/factor;
+    size_t outHeight = (height + factor - 1)/factor;
+    size_t count = outWidth*outHeight;
+
+    values.resize(count);
+    if (count > 0)
+    {
+        Downscaler downscaler(raw, width, height, factor, outWidth, outHeight,
+            rowSum, values);
+        detail::dispatchNumericArray(raw.elementType, downscaler);
+    }
+
+    double low = 0, high = 0;
+    if (count > 0 && percentile)
+    {
+        sorted.assign(values.begin(), values.end());
+        low = percentileOf(sorted, lowPercentile);
+        high = percentileOf(sorted, highPercentile);
+    }
+    else if (count > 0)
+    {
+        low = high = values[0];
+        for (size_t i = 1; i < count; ++i)
+        {
+            low = std::min(low, values[i]);
+            high = std::max(high, values[i]);
+        }
+    }
+
+    PVUByteArray::svector pixels(count);
+    double scale = high > low ? 255/(high - low) : 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        double v = (values[i] - low)*scale;
+        pixels[i] = static_cast<uint8>(v <= 0 ? 0 : v >= 255 ? 255 : v + 0.5);
+    }
+
+    NTNDArrayPtr preview = NTNDArray::createBuilder()->addDescriptor()->create();
+    detail::replaceValue<PVUByteArray>(preview->getValue(), "ubyteValue",
+        freeze(pixels));
+    preview->getCompressedDataSize()->put(static_cast<int64>(count));
+    preview->getUncompressedDataSize()->put(static_cast<int64>(count));
+
+    PVStructureArrayPtr pvDim = preview->getDimension();
+    StructureConstPtr dimStructure = pvDim->getStructureArray()->getStructure();
+    PVStructureArray::svector previewDims;
+    for (size_t d = 0; d < 2; ++d)
+    {
+        PVStructurePtr dim = getPVDataCreate()->createPVStructure(dimStructure);
+        if (d < dims.size())
+            dim->copyUnchecked(*dims[d]);
+        PVIntPtr pvBinning = dim->getSubField<PVInt>("binning");
+        dim->getSubField<PVInt>("size")->put(static_cast<int32>(d == 0 ? outWidth : outHeight));
+        if (d >= dims.size())
+            dim->getSubField<PVInt>("fullSize")->put(1);
+        pvBinning->put(std::max<int32>(pvBinning->get(), 1)*static_cast<int32>(factor));
+        previewDims.push_back(dim);
+    }
+    pvDim->replace(freeze(previewDims));
+
+    preview->getUniqueId()->put(ntndArray->getUniqueId()->get());
+    preview->getDataTimeStamp()->copyUnchecked(*ntndArray->getDataTimeStamp());
+
+    std::ostringstream descriptor;
+    descriptor << "preview binning=" << factor
+        << " type=" << ScalarTypeFunc::name(raw.elementType)
+        << " window=[" << low << "," << high << "]";
+    if (percentile)
+        descriptor << " percentile=[" << lowPercentile << "," << highPercentile << "]";
+    preview->getDescriptor()->put(descriptor.str());
+
+    if (compressed && count > 0)
+        NTNDArrayTiledCodec::encode(preview, std::vector<size_t>(), 1);
+
+    return preview;
+}
+
+}}
@@ -0,0 +1,183 @@
+/* ntndarraySequence.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsAtomic.h>
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarraySequence.h>
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+// number of uniqueIds remembered for duplicate/reorder detection
+static const uint32 historySize = 64;
+
+NTNDArraySequenceTracker::shared_pointer NTNDArraySequenceTracker::create()
+{
+    return shared_pointer(new NTNDArraySequenceTracker());
+}
+
+NTNDArraySequenceTracker::NTNDArraySequenceTracker()
+{
+    reset();
+}
+
+void NTNDArraySequenceTracker::reset()
+{
+    started = false;
+    lastId = 0;
+    history = 0;
+    tracked = 0;
+
+    epics::atomic::set(frames, 0);
+    epics::atomic::set(droppedFrames, 0);
+    epics::atomic::set(duplicatedFrames, 0);
+    epics::atomic::set(reorderedFrames, 0);
+    epics::atomic::set(restarts, 0);
+    epics::atomic::set(lastLatency, 0);
+    epics::atomic::set(minLatency, 0);
+    epics::atomic::set(maxLatency, 0);
+}
+
+NTNDArraySequenceTracker::Result NTNDArraySequenceTracker::update(
+    NTNDArrayPtr const & ntndArray)
+{
+    TimeStamp receiveTime;
+    receiveTime.getCurrent();
+    return update(ntndArray, receiveTime);
+}
+
+NTNDArraySequenceTracker::Result NTNDArraySequenceTracker::update(
+    NTNDArrayPtr const & ntndArray, TimeStamp const & receiveTime)
+{
+    TimeStamp dataTimeStamp;
+    PVTimeStamp pvDataTimeStamp;
+    if (ntndArray->attachDataTimeStamp(pvDataTimeStamp))
+        pvDataTimeStamp.get(dataTimeStamp);
+    else
+        dataTimeStamp = receiveTime;
+
+    return update(ntndArray->getUniqueId()->get(), dataTimeStamp, receiveTime);
+}
+
+NTNDArraySequenceTracker::Result NTNDArraySequenceTracker::update(
+    int32 uniqueId, TimeStamp const & dataTimeStamp, TimeStamp const & receiveTime)
+{
+    double latencySeconds = TimeStamp::diff(receiveTime, dataTimeStamp);
+    size_t latency = latencySeconds > 0.0 ?
+        static_cast<size_t>(latencySeconds*1e6 + 0.5) : 0;
+
+    size_t count = epics::atomic::increment(frames);
+    epics::atomic::set(lastLatency, latency);
+    if (count == 1 || latency < epics::atomic::get(minLatency))
+        epics::atomic::set(minLatency, latency);
+    if (latency > epics::atomic::get(maxLatency))
+        epics::atomic::set(maxLatency, latency);
+
+    uint32 id = static_cast<uint32>(uniqueId);
+    if (!started)
+    {
+        started = true;
+        lastId = id;
+        history = 1;
+        tracked = 1;
+        return first;
+    }
+
+    // modular difference handles wrap-around of the uniqueId
+    int32 delta = static_cast<int32>(id - lastId);
+
+    if (delta > 0)
+    {
+        history = (static_cast<uint32>(delta) >= historySize) ?
+            1 : ((history << delta) | 1);
+        tracked = (static_cast<uint32>(delta) >= historySize - tracked) ?
+            historySize : tracked + delta;
+        lastId = id;
+        if (delta == 1)
+            return inOrder;
+
+        epics::atomic::add(droppedFrames, static_cast<size_t>(delta - 1));
+        return dropped;
+    }
+
+    uint32 behind = static_cast<uint32>(-static_cast<int64>(delta));
+    if (behind >= historySize)
+    {
+        // a small uniqueId after a large one is a restart of the stream,
+        // anything else a frame too late to be checked against the history
+        if (id < behind)
+        {
+            epics::atomic::increment(restarts);
+            lastId = id;
+            history = 1;
+            tracked = 1;
+            return first;
+        }
+        epics::atomic::increment(reorderedFrames);
+        return reordered;
+    }
+
+    uint64 bit = static_cast<uint64>(1) << behind;
+    if (history & bit)
+    {
+        epics::atomic::increment(duplicatedFrames);
+        return duplicate;
+    }
+
+    history |= bit;
+    epics::atomic::increment(reorderedFrames);
+
+    // only frames skipped since the (re)start were counted as dropped
+    if (behind < tracked)
+        epics::atomic::decrement(droppedFrames);
+    return reordered;
+}
+
+size_t NTNDArraySequenceTracker::getFrames() const
+{
+    return epics::atomic::get(frames);
+}
+
+size_t NTNDArraySequenceTracker::getDropped() const
+{
+    return epics::atomic::get(droppedFrames);
+}
+
+size_t NTNDArraySequenceTracker::getDuplicated() const
+{
+    return epics::atomic::get(duplicatedFrames);
+}
+
+size_t NTNDArraySequenceTracker::getReordered() const
+{
+    return epics::atomic::get(reorderedFrames);
+}
+
+size_t NTNDArraySequenceTracker::getRestarts() const
+{
+    return epics::atomic::get(restarts);
+}
+
+size_t NTNDArraySequenceTracker::getLastLatency() const
+{
+    return epics::atomic::get(lastLatency);
+}
+
+size_t NTNDArraySequenceTracker::getMinLatency() const
+{
+    return epics::atomic::get(minLatency);
+}
+
+size_t NTNDArraySequenceTracker::getMaxLatency() const
+{
+    return epics::atomic::get(maxLatency);
+}
+
+}}
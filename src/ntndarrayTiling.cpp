@@ -0,0 +1,448 @@
+/* ntndarrayTiling.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include <pv/lock.h>
+
+#define epicsExportSharedSymbols
+#include <pv/ntndarrayTiling.h>
+#include <pv/ntndarrayCodec.h>
+#include <pv/ntparallel.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+using detail::RawArray;
+using detail::RawArrayWriter;
+
+NTNDArrayTiling::shared_pointer NTNDArrayTiling::create(
+    std::vector<size_t> const & sizes, std::vector<size_t> const & tileSizes)
+{
+    if (sizes.empty())
+        throw std::runtime_error("tiling of an array without dimensions");
+    return shared_pointer(new NTNDArrayTiling(sizes, tileSizes));
+}
+
+NTNDArrayTiling::shared_pointer NTNDArrayTiling::create(
+    NTNDArrayPtr const & ntndArray, std::vector<size_t> const & tileSizes)
+{
+    PVStructureArray::const_svector dims = ntndArray->getDimension()->view();
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < dims.size(); ++i)
+    {
+        PVIntPtr pvSize = dims[i].get() ?
+            dims[i]->getSubField<PVInt>("size") : PVIntPtr();
+        if (!pvSize.get() || pvSize->get() < 0)
+            throw std::runtime_error("invalid NTNDArray dimension");
+        sizes.push_back(pvSize->get());
+    }
+    return create(sizes, tileSizes);
+}
+
+NTNDArrayTiling::NTNDArrayTiling(std::vector<size_t> const & sizes,
+    std::vector<size_t> const & tileSizes) :
+    sizes(sizes),
+    tileSizes(sizes.size()),
+    tileCounts(sizes.size()),
+    elementCount(1),
+    tileCount(1)
+{
+    for (size_t d = 0; d < sizes.size(); ++d)
+    {
+        size_t tileSize = d < tileSizes.size() ? tileSizes[d] : 0;
+        if (tileSize == 0 || tileSize > sizes[d])
+            tileSize = sizes[d];
+        this->tileSizes[d] = tileSize;
+        tileCounts[d] = tileSize ? (sizes[d] + tileSize - 1)/tileSize : 0;
+        elementCount *= sizes[d];
+        tileCount *= tileCounts[d];
+    }
+}
+
+void NTNDArrayTiling::getTile(size_t index, std::vector<size_t> & offset,
+    std::vector<size_t> & size) const
+{
+    if (index >= tileCount)
+        throw std::out_of_range("tile index out of range");
+
+    offset.resize(sizes.size());
+    size.resize(sizes.size());
+    for (size_t d = 0; d < sizes.size(); ++d)
+    {
+        size_t position = index % tileCounts[d];
+        index /= tileCounts[d];
+        offset[d] = position*tileSizes[d];
+        size[d] = std::min(tileSizes[d], sizes[d] - offset[d]);
+    }
+}
+
+size_t NTNDArrayTiling::getTileElementCount(size_t index) const
+{
+    std::vector<size_t> offset, size;
+    getTile(index, offset, size);
+
+    size_t count = 1;
+    for (size_t d = 0; d < size.size(); ++d)
+        count *= size[d];
+    return count;
+}
+
+void NTNDArrayTiling::copy(size_t index, size_t elementSize, const uint8 * src,
+    uint8 * dst, bool toTile) const
+{
+    std::vector<size_t> offset, size;
+    getTile(index, offset, size);
+
+    size_t rank = sizes.size();
+    size_t rowBytes = size[0]*elementSize;
+    size_t rows = 1;
+    for (size_t d = 1; d < rank; ++d)
+        rows *= size[d];
+
+    // position of the current row within the tile
+    std::vector<size_t> position(rank, 0);
+    for (size_t row = 0; row < rows; ++row)
+    {
+        size_t arrayIndex = 0;
+        for (size_t d = rank; d-- > 0; )
+            arrayIndex = arrayIndex*sizes[d] + offset[d] + position[d];
+
+        if (toTile)
+            memcpy(dst + row*rowBytes, src + arrayIndex*elementSize, rowBytes);
+        else
+            memcpy(dst + arrayIndex*elementSize, src + row*rowBytes, rowBytes);
+
+        for (size_t d = 1; d < rank; ++d)
+        {
+            if (++position[d] < size[d])
+                break;
+            position[d] = 0;
+        }
+    }
+}
+
+void NTNDArrayTiling::extract(const void * array, size_t elementSize,
+    size_t index, void * tile) const
+{
+    copy(index, elementSize, static_cast<const uint8 *>(array),
+        static_cast<uint8 *>(tile), true);
+}
+
+void NTNDArrayTiling::insert(const void * tile, size_t elementSize,
+    size_t index, void * array) const
+{
+    copy(index, elementSize, static_cast<const uint8 *>(tile),
+        static_cast<uint8 *>(array), false);
+}
+
+
+const std::string NTNDArrayTiledCodec::name("tiled");
+
+static Mutex mutex;
+
+StructureConstPtr NTNDArrayTiledCodec::getParametersStructure()
+{
+    Lock xx(mutex);
+
+    static StructureConstPtr parametersStruc;
+    if (!parametersStruc)
+    {
+        parametersStruc = getFieldCreate()->createFieldBuilder()->
+            add("elementType", pvInt)->
+            addArray("tileSize", pvInt)->
+            addArray("tileOffset", pvLong)->
+            createStructure();
+    }
+    return parametersStruc;
+}
+
+namespace {
+
+// groups byte k of all elements together, for each k
+void shuffle(const uint8 * src, uint8 * dst, size_t count, size_t elementSize)
+{
+    for (size_t b = 0; b < elementSize; ++b)
+    {
+        const uint8 * s = src + b;
+        uint8 * d = dst + b*count;
+        for (size_t i = 0; i < count; ++i)
+            d[i] = s[i*elementSize];
+    }
+}
+
+void unshuffle(const uint8 * src, uint8 * dst, size_t count, size_t elementSize)
+{
+    for (size_t b = 0; b < elementSize; ++b)
+    {
+        const uint8 * s = src + b*count;
+        uint8 * d = dst + b;
+        for (size_t i = 0; i < count; ++i)
+            d[i*elementSize] = s[i];
+    }
+}
+
+class EncodeTask : public NTParallel::Task
+{
+public:
+    EncodeTask(NTNDArrayTiling const & tiling, RawArray const & raw,
+        std::vector<std::vector<uint8> > & packed) :
+        tiling(tiling), raw(raw), packed(packed),
+        elementSize(ScalarTypeFunc::elementSize(raw.elementType))
+    {}
+
+    virtual void run(size_t index)
+    {
+        size_t count = tiling.getTileElementCount(index);
+        size_t bytes = count*elementSize;
+        if (bytes == 0)
+            return;
+
+        std::vector<uint8> tile(bytes), shuffled(bytes);
+        tiling.extract(raw.data, elementSize, index, &tile[0]);
+        shuffle(&tile[0], &shuffled[0], count, elementSize);
+        NTNDArrayDeltaCodec::pack(&shuffled[0], 0, bytes, packed[index]);
+    }
+
+private:
+    NTNDArrayTiling const & tiling;
+    RawArray const & raw;
+    std::vector<std::vector<uint8> > & packed;
+    size_t elementSize;
+};
+
+/*
+ * An encoded frame, with its parameters checked.
+ */
+struct TiledFrame
+{
+    ScalarType elementType;
+    size_t elementSize;
+    NTNDArrayTilingPtr tiling;
+    PVUByteArray::const_svector payload;
+    PVLongArray::const_svector tileOffset;
+
+    void parse(NTNDArrayPtr const & ntndArray)
+    {
+        if (ntndArray->getCodec()->getSubField<PVString>("name")->get() !=
+            NTNDArrayTiledCodec::name)
+            throw std::runtime_error("NTNDArray is not encoded with the tiled codec");
+
+        PVStructurePtr parameters =
+            ntndArray->getCodec()->getSubField<PVUnion>("parameters")->get<PVStructure>();
+        PVIntPtr pvElementType = parameters.get() ?
+            parameters->getSubField<PVInt>("elementType") : PVIntPtr();
+        PVIntArrayPtr pvTileSize = parameters.get() ?
+            parameters->getSubField<PVIntArray>("tileSize") : PVIntArrayPtr();
+        PVLongArrayPtr pvTileOffset = parameters.get() ?
+            parameters->getSubField<PVLongArray>("tileOffset") : PVLongArrayPtr();
+        if (!pvElementType.get() || !pvTileSize.get() || !pvTileOffset.get())
+            throw std::runtime_error("invalid tiled codec parameters");
+
+        int32 type = pvElementType->get();
+        if (type < pvBoolean || type >= pvString)
+            throw std::runtime_error("invalid tiled codec element type");
+        elementType = static_cast<ScalarType>(type);
+        elementSize = ScalarTypeFunc::elementSize(elementType);
+
+        PVIntArray::const_svector tileSize = pvTileSize->view();
+        std::vector<size_t> tileSizes;
+        for (size_t i = 0; i < tileSize.size(); ++i)
+        {
+            if (tileSize[i] < 0)
+                throw std::runtime_error("invalid tiled codec tile size");
+            tileSizes.push_back(tileSize[i]);
+        }
+        tiling = NTNDArrayTiling::create(ntndArray, tileSizes);
+
+        PVUByteArrayPtr pvPayload = ntndArray->getValue()->get<PVUByteArray>();
+        if (!pvPayload.get())
+            throw std::runtime_error("tiled codec payload is not a ubyte array");
+        payload = pvPayload->view();
+
+        tileOffset = pvTileOffset->view();
+        if (tileOffset.size() != tiling->getTileCount() + 1 ||
+            tileOffset[0] != 0 ||
+            tileOffset[tileOffset.size() - 1] != static_cast<int64>(payload.size()))
+            throw std::runtime_error("invalid tiled codec tile offsets");
+        for (size_t i = 1; i < tileOffset.size(); ++i)
+            if (tileOffset[i] < tileOffset[i - 1])
+                throw std::runtime_error("invalid tiled codec tile offsets");
+    }
+
+    // decodes a tile into a contiguous buffer
+    void decode(size_t index, uint8 * tile) const
+    {
+        size_t count = tiling->getTileElementCount(index);
+        size_t bytes = count*elementSize;
+        if (bytes == 0)
+            return;
+
+        std::vector<uint8> shuffled(bytes, 0);
+        size_t start = static_cast<size_t>(tileOffset[index]);
+        size_t end = static_cast<size_t>(tileOffset[index + 1]);
+        if (!NTNDArrayDeltaCodec::unpack(payload.data() + start, end - start,
+            &shuffled[0], bytes))
+            throw std::runtime_error("corrupt tiled codec payload");
+        unshuffle(&shuffled[0], tile, count, elementSize);
+    }
+};
+
+class DecodeTask : public NTParallel::Task
+{
+public:
+    DecodeTask(TiledFrame const & frame, uint8 * data) :
+        frame(frame), data(data)
+    {}
+
+    virtual void run(size_t index)
+    {
+        size_t bytes = frame.tiling->getTileElementCount(index)*frame.elementSize;
+        if (bytes == 0)
+            return;
+
+        std::vector<uint8> tile(bytes);
+        frame.decode(index, &tile[0]);
+        frame.tiling->insert(&tile[0], frame.elementSize, index, data);
+    }
+
+private:
+    TiledFrame const & frame;
+    uint8 * data;
+};
+
+}
+
+void NTNDArrayTiledCodec::encode(NTNDArrayPtr const & ntndArray,
+    std::vector<size_t> const & tileSizes, size_t maxThreads)
+{
+    PVStructurePtr pvCodec = ntndArray->getCodec();
+    PVStringPtr pvCodecName = pvCodec->getSubField<PVString>("name");
+    if (!pvCodecName->get().empty())
+        throw std::runtime_error("NTNDArray value is already encoded");
+
+    RawArray raw;
+    if (!detail::getRawValue(ntndArray->getValue(), raw))
+        throw std::runtime_error("NTNDArray value is not a numeric array");
+
+    NTNDArrayTilingPtr tiling = NTNDArrayTiling::create(ntndArray, tileSizes);
+    if (tiling->getElementCount()*ScalarTypeFunc::elementSize(raw.elementType) != raw.size)
+        throw std::runtime_error("NTNDArray value does not match its dimension");
+
+    size_t tileCount = tiling->getTileCount();
+    std::vector<std::vector<uint8> > packed(tileCount);
+    EncodeTask task(*tiling, raw, packed);
+    NTParallel::forEach(tileCount, task, maxThreads);
+
+    PVLongArray::svector tileOffset(tileCount + 1);
+    tileOffset[0] = 0;
+    for (size_t i = 0; i < tileCount; ++i)
+        tileOffset[i + 1] = tileOffset[i] + packed[i].size();
+
+    PVUByteArray::svector payload(static_cast<size_t>(tileOffset[tileCount]));
+    for (size_t i = 0; i < tileCount; ++i)
+        if (!packed[i].empty())
+            memcpy(payload.data() + tileOffset[i], &packed[i][0], packed[i].size());
+
+    PVIntArray::svector tileSize;
+    for (size_t d = 0; d < tiling->getTileSizes().size(); ++d)
+        tileSize.push_back(static_cast<int32>(tiling->getTileSizes()[d]));
+
+    PVStructurePtr parameters = getPVDataCreate()->createPVStructure(
+        getParametersStructure());
+    parameters->getSubField<PVInt>("elementType")->put(raw.elementType);
+    parameters->getSubField<PVIntArray>("tileSize")->replace(freeze(tileSize));
+    parameters->getSubField<PVLongArray>("tileOffset")->replace(freeze(tileOffset));
+
+    int64 compressedSize = payload.size();
+    detail::replaceValue<PVUByteArray>(ntndArray->getValue(), "ubyteValue",
+        freeze(payload));
+    pvCodecName->put(name);
+    pvCodec->getSubField<PVUnion>("parameters")->set(parameters);
+    ntndArray->getCompressedDataSize()->put(compressedSize);
+    ntndArray->getUncompressedDataSize()->put(static_cast<int64>(raw.size));
+}
+
+void NTNDArrayTiledCodec::decode(NTNDArrayPtr const & ntndArray, size_t maxThreads,
+    NTNDArrayBufferPoolPtr const & pool)
+{
+    PVStructurePtr pvCodec = ntndArray->getCodec();
+    PVStringPtr pvCodecName = pvCodec->getSubField<PVString>("name");
+    if (pvCodecName->get().empty())
+        return;
+
+    TiledFrame frame;
+    frame.parse(ntndArray);
+
+    size_t size = frame.tiling->getElementCount()*frame.elementSize;
+    if (ntndArray->getUncompressedDataSize()->get() != static_cast<int64>(size))
+        throw std::runtime_error("invalid tiled codec uncompressedSize");
+
+    RawArrayWriter writer(frame.elementType, size, pool);
+    DecodeTask task(frame, writer.data());
+    NTParallel::forEach(frame.tiling->getTileCount(), task, maxThreads);
+
+    writer.put(ntndArray->getValue());
+    pvCodecName->put("");
+    pvCodec->getSubField<PVUnion>("parameters")->set(PVFieldPtr());
+    ntndArray->getCompressedDataSize()->put(static_cast<int64>(size));
+}
+
+NTNDArrayTilingPtr NTNDArrayTiledCodec::getTiling(NTNDArrayPtr const & ntndArray)
+{
+    TiledFrame frame;
+    frame.parse(ntndArray);
+    return frame.tiling;
+}
+
+NTNDArrayPtr NTNDArrayTiledCodec::decodeTile(NTNDArrayPtr const & ntndArray,
+    size_t index)
+{
+    TiledFrame frame;
+    frame.parse(ntndArray);
+
+    std::vector<size_t> offset, size;
+    frame.tiling->getTile(index, offset, size);
+    size_t bytes = frame.tiling->getTileElementCount(index)*frame.elementSize;
+
+    NTNDArrayPtr tile = NTNDArray::createBuilder()->create();
+
+    RawArrayWriter writer(frame.elementType, bytes);
+    frame.decode(index, writer.data());
+    writer.put(tile->getValue());
+    tile->getCompressedDataSize()->put(static_cast<int64>(bytes));
+    tile->getUncompressedDataSize()->put(static_cast<int64>(bytes));
+
+    // the tile's dimension is the frame's, restricted to the tile
+    PVStructureArray::const_svector frameDims = ntndArray->getDimension()->view();
+    PVStructureArrayPtr pvDim = tile->getDimension();
+    StructureConstPtr dimStructure = pvDim->getStructureArray()->getStructure();
+    PVStructureArray::svector dims;
+    for (size_t d = 0; d < frameDims.size(); ++d)
+    {
+        PVStructurePtr dim = getPVDataCreate()->createPVStructure(dimStructure);
+        dim->copyUnchecked(*frameDims[d]);
+        PVIntPtr pvOffset = dim->getSubField<PVInt>("offset");
+        dim->getSubField<PVInt>("size")->put(static_cast<int32>(size[d]));
+        pvOffset->put(pvOffset->get() + static_cast<int32>(offset[d]));
+        dims.push_back(dim);
+    }
+    pvDim->replace(freeze(dims));
+
+    tile->getUniqueId()->put(ntndArray->getUniqueId()->get());
+    tile->getDataTimeStamp()->copyUnchecked(*ntndArray->getDataTimeStamp());
+    tile->getAttribute()->replace(ntndArray->getAttribute()->view());
+
+    return tile;
+}
+
+}}
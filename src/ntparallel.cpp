@@ -0,0 +1,193 @@
+/* ntparallel.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include <epicsThread.h>
+#include <epicsAtomic.h>
+#include <pv/lock.h>
+#include <pv/event.h>
+
+#define epicsExportSharedSymbols
+#include <pv/ntparallel.h>
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+namespace {
+
+class Pool;
+
+class Worker : public epicsThreadRunable
+{
+public:
+    Worker(Pool & pool);
+    virtual void run();
+
+    Event wakeup;
+
+private:
+    Pool & pool;
+    epicsThread thread;
+};
+
+class Pool
+{
+public:
+    Pool(size_t threads) : busy(0)
+    {
+        for (size_t i = 0; i < threads; ++i)
+            workers.push_back(new Worker(*this));
+    }
+
+    // called by all threads taking part in a job
+    void work()
+    {
+        while (true)
+        {
+            size_t index = epics::atomic::increment(next) - 1;
+            if (index >= count)
+                break;
+
+            try {
+                task->run(index);
+            } catch (std::exception & e) {
+                fail(e.what());
+            } catch (...) {
+                fail("unknown exception");
+            }
+        }
+    }
+
+    void fail(const char * message)
+    {
+        Lock xx(errorMutex);
+        if (!failed)
+        {
+            failed = true;
+            error = message;
+        }
+        // skip the remaining items
+        epics::atomic::set(next, count);
+    }
+
+    void finished()
+    {
+        if (epics::atomic::decrement(active) == 0)
+            done.signal();
+    }
+
+    // set for the duration of a job; not a mutex, which the thread running
+    // a job could take again from within a task
+    int busy;
+    std::vector<Worker *> workers;
+
+    NTParallel::Task * task;
+    size_t count;
+    size_t next;
+    size_t active;
+    Event done;
+
+    Mutex errorMutex;
+    bool failed;
+    std::string error;
+};
+
+Worker::Worker(Pool & pool) :
+    pool(pool),
+    thread(*this, "NTParallel",
+        epicsThreadGetStackSize(epicsThreadStackMedium),
+        epicsThreadPriorityMedium)
+{
+    thread.start();
+}
+
+void Worker::run()
+{
+    while (true)
+    {
+        wakeup.wait();
+        pool.work();
+        pool.finished();
+    }
+}
+
+// created on first use and never destroyed
+Mutex poolMutex;
+Pool * sharedPool = 0;
+
+Pool & getPool()
+{
+    Lock xx(poolMutex);
+    if (!sharedPool)
+    {
+        int cpus = epicsThreadGetCPUs();
+        sharedPool = new Pool(cpus > 1 ? cpus - 1 : 0);
+    }
+    return *sharedPool;
+}
+
+}
+
+size_t NTParallel::getConcurrency()
+{
+    return getPool().workers.size() + 1;
+}
+
+void NTParallel::forEach(size_t count, Task & task, size_t maxThreads)
+{
+    if (count == 0)
+        return;
+
+    Pool & pool = getPool();
+    size_t threads = pool.workers.size() + 1;
+    if (maxThreads != 0 && maxThreads < threads)
+        threads = maxThreads;
+    if (count < threads)
+        threads = count;
+
+    if (threads <= 1 || epics::atomic::compareAndSwap(pool.busy, 0, 1) != 0)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            try {
+                task.run(i);
+            } catch (std::exception & e) {
+                throw std::runtime_error(e.what());
+            } catch (...) {
+                throw std::runtime_error("unknown exception");
+            }
+        }
+        return;
+    }
+
+    pool.task = &task;
+    pool.count = count;
+    pool.failed = false;
+    pool.error.clear();
+    epics::atomic::set(pool.next, 0);
+    epics::atomic::set(pool.active, threads - 1);
+    for (size_t i = 0; i < threads - 1; ++i)
+        pool.workers[i]->wakeup.signal();
+
+    pool.work();
+    pool.done.wait();
+
+    bool failed = pool.failed;
+    std::string error = pool.error;
+    pool.task = 0;
+    epics::atomic::set(pool.busy, 0);
+
+    if (failed)
+        throw std::runtime_error(error);
+}
+
+}}
@@ -104,6 +104,19 @@ NTScalarPtr NTScalarBuilder::create()
     return NTScalarPtr(new NTScalar(createPVStructure()));
 }
 
+std::vector<NTScalarPtr> NTScalarBuilder::create(size_t count)
+{
+    StructureConstPtr structure = createStructure();
+    PVDataCreatePtr pvDataCreate = getPVDataCreate();
+
+    std::vector<NTScalarPtr> instances;
+    instances.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        instances.push_back(NTScalarPtr(new NTScalar(
+            pvDataCreate->createPVStructure(structure))));
+    return instances;
+}
+
 NTScalarBuilder::NTScalarBuilder()
 {
     reset();
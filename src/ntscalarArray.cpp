@@ -114,6 +114,19 @@ NTScalarArrayPtr NTScalarArrayBuilder::create()
     return NTScalarArrayPtr(new NTScalarArray(createPVStructure()));
 }
 
+std::vector<NTScalarArrayPtr> NTScalarArrayBuilder::create(size_t count)
+{
+    StructureConstPtr structure = createStructure();
+    PVDataCreatePtr pvDataCreate = getPVDataCreate();
+
+    std::vector<NTScalarArrayPtr> instances;
+    instances.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        instances.push_back(NTScalarArrayPtr(new NTScalarArray(
+            pvDataCreate->createPVStructure(structure))));
+    return instances;
+}
+
 NTScalarArrayBuilder::NTScalarArrayBuilder()
 {
     reset();
@@ -0,0 +1,496 @@
+/* ntscalarArrayDecimation.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#define epicsExportSharedSymbols
+#include <pv/ntscalarArrayDecimation.h>
+#include <pv/ntparallel.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+using detail::blocks;
+using detail::getNumericValue;
+using detail::sumOf;
+using detail::threadsFor;
+
+namespace {
+
+// buckets or output points per work item
+const size_t bucketBlock = 64;
+const size_t pointBlock = 1024;
+
+// first element of a bucket, when count elements are split into equal buckets
+inline size_t bucketBegin(size_t bucket, size_t count, size_t buckets)
+{
+    return static_cast<size_t>(static_cast<uint64>(bucket)*count/buckets);
+}
+
+// adds the metadata fields of the source to the builder of a result
+template<typename Builder>
+void addMetadata(Builder const & builder, NTScalarArrayPtr const & source)
+{
+    if (source->getDescriptor().get())
+        builder->addDescriptor();
+    if (source->getAlarm().get())
+        builder->addAlarm();
+    if (source->getTimeStamp().get())
+        builder->addTimeStamp();
+}
+
+template<typename NT>
+void copyMetadata(NTScalarArrayPtr const & source, std::tr1::shared_ptr<NT> const & result)
+{
+    if (source->getDescriptor().get() && result->getDescriptor().get())
+        result->getDescriptor()->put(source->getDescriptor()->get());
+    if (source->getAlarm().get() && result->getAlarm().get())
+        result->getAlarm()->copyUnchecked(*source->getAlarm());
+    if (source->getTimeStamp().get() && result->getTimeStamp().get())
+        result->getTimeStamp()->copyUnchecked(*source->getTimeStamp());
+}
+
+NTScalarArrayPtr createScalarArray(NTScalarArrayPtr const & source, ScalarType elementType)
+{
+    NTScalarArrayBuilderPtr builder = NTScalarArray::createBuilder();
+    builder->value(elementType);
+    addMetadata(builder, source);
+    NTScalarArrayPtr result = builder->create();
+    copyMetadata(source, result);
+    return result;
+}
+
+NTTablePtr createTable(NTScalarArrayPtr const & source, const char * const * columns,
+    PVDoubleArray::svector * values, size_t count)
+{
+    NTTableBuilderPtr builder = NTTable::createBuilder();
+    for (size_t i = 0; i < count; ++i)
+        builder->addColumn(columns[i], pvDouble);
+    addMetadata(builder, source);
+    NTTablePtr table = builder->create();
+    copyMetadata(source, table);
+    for (size_t i = 0; i < count; ++i)
+        table->getColumn<PVDoubleArray>(columns[i])->replace(freeze(values[i]));
+    return table;
+}
+
+template<typename T>
+struct Extremes
+{
+    T low;
+    T high;
+    size_t lowIndex;
+    size_t highIndex;
+};
+
+// index of a value in [p, p + count); 0 for NaN, which equals nothing
+template<typename T>
+inline size_t indexOf(const T * p, size_t count, T value)
+{
+    return value == value ? std::find(p, p + count, value) - p : 0;
+}
+
+template<typename T>
+void findExtremes(const T * p, size_t count, Extremes<T> & extremes)
+{
+    typedef std::numeric_limits<T> limits;
+
+    // selects rather than branches and independent partial extremes, so
+    // that the loop can be vectorized; comparisons with NaN are false, so
+    // NaN is skipped
+    const T top = limits::has_infinity ? limits::infinity() : limits::max();
+    const T bottom = limits::has_infinity ? -limits::infinity() : limits::min();
+    T low0 = top, low1 = top, low2 = top, low3 = top;
+    T high0 = bottom, high1 = bottom, high2 = bottom, high3 = bottom;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        low0 = p[i] < low0 ? p[i] : low0;
+        low1 = p[i + 1] < low1 ? p[i + 1] : low1;
+        low2 = p[i + 2] < low2 ? p[i + 2] : low2;
+        low3 = p[i + 3] < low3 ? p[i + 3] : low3;
+        high0 = p[i] > high0 ? p[i] : high0;
+        high1 = p[i + 1] > high1 ? p[i + 1] : high1;
+        high2 = p[i + 2] > high2 ? p[i + 2] : high2;
+        high3 = p[i + 3] > high3 ? p[i + 3] : high3;
+    }
+    for (; i < count; ++i)
+    {
+        low0 = p[i] < low0 ? p[i] : low0;
+        high0 = p[i] > high0 ? p[i] : high0;
+    }
+    T low = std::min(std::min(low0, low1), std::min(low2, low3));
+    T high = std::max(std::max(high0, high1), std::max(high2, high3));
+    if (high < low)
+    {
+        // all NaN
+        low = high = p[0];
+    }
+    extremes.low = low;
+    extremes.high = high;
+    extremes.lowIndex = indexOf(p, count, low);
+    extremes.highIndex = indexOf(p, count, high);
+}
+
+template<typename T>
+class ExtremesTask : public NTParallel::Task
+{
+public:
+    ExtremesTask(const T * data, size_t count, size_t buckets, Extremes<T> * extremes) :
+        data(data), count(count), buckets(buckets), extremes(extremes)
+    {}
+
+    virtual void run(size_t index)
+    {
+        size_t b1 = std::min(buckets, (index + 1)*bucketBlock);
+        for (size_t b = index*bucketBlock; b < b1; ++b)
+        {
+            size_t begin = bucketBegin(b, count, buckets);
+            size_t end = bucketBegin(b + 1, count, buckets);
+            findExtremes(data + begin, end - begin, extremes[b]);
+            extremes[b].lowIndex += begin;
+            extremes[b].highIndex += begin;
+        }
+    }
+
+private:
+    const T * data;
+    size_t count;
+    size_t buckets;
+    Extremes<T> * extremes;
+};
+
+/*
+ * Finds the extremes of each bucket and stores them either interleaved in
+ * the value of an NTScalarArray, or as the columns of an envelope.
+ */
+class ExtremesDispatch
+{
+public:
+    ExtremesDispatch(PVScalarArrayPtr const & pvSource, size_t buckets, size_t maxThreads,
+        PVScalarArrayPtr const & pvResult) :
+        pvSource(pvSource), buckets(buckets), maxThreads(maxThreads), pvResult(pvResult)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+
+        typename PVT::const_svector data = static_cast<PVT *>(pvSource.get())->view();
+        size_t count = data.size();
+        PVT * pvInterleaved = static_cast<PVT *>(pvResult.get());
+        if (pvInterleaved && count <= 2*buckets)
+        {
+            pvInterleaved->replace(data);
+            return;
+        }
+
+        buckets = std::min(buckets, count);
+        if (buckets == 0)
+            return;
+
+        std::vector<Extremes<value_type> > extremes(buckets);
+        ExtremesTask<value_type> task(data.data(), count, buckets, &extremes[0]);
+        NTParallel::forEach(blocks(buckets, bucketBlock), task,
+            threadsFor(count, maxThreads));
+
+        if (pvInterleaved)
+        {
+            typename PVT::svector value(2*buckets);
+            for (size_t b = 0; b < buckets; ++b)
+            {
+                Extremes<value_type> const & e = extremes[b];
+                bool lowFirst = e.lowIndex <= e.highIndex;
+                value[2*b] = lowFirst ? e.low : e.high;
+                value[2*b + 1] = lowFirst ? e.high : e.low;
+            }
+            pvInterleaved->replace(freeze(value));
+            return;
+        }
+
+        for (size_t i = 0; i < 3; ++i)
+            columns[i].resize(buckets);
+        for (size_t b = 0; b < buckets; ++b)
+        {
+            size_t begin = bucketBegin(b, count, buckets);
+            size_t end = bucketBegin(b + 1, count, buckets);
+            columns[0][b] = 0.5*(begin + end - 1);
+            columns[1][b] = static_cast<double>(extremes[b].low);
+            columns[2][b] = static_cast<double>(extremes[b].high);
+        }
+    }
+
+    // x, min and max of the envelope
+    PVDoubleArray::svector columns[3];
+
+private:
+    PVScalarArrayPtr const & pvSource;
+    size_t buckets;
+    size_t maxThreads;
+    PVScalarArrayPtr pvResult;
+};
+
+template<typename T>
+class MeanTask : public NTParallel::Task
+{
+public:
+    MeanTask(const T * data, const size_t * bounds, size_t buckets, double * means) :
+        data(data), bounds(bounds), buckets(buckets), means(means)
+    {}
+
+    virtual void run(size_t index)
+    {
+        size_t b1 = std::min(buckets, (index + 1)*bucketBlock);
+        for (size_t b = index*bucketBlock; b < b1; ++b)
+            means[b] = sumOf(data + bounds[b], bounds[b + 1] - bounds[b])/
+                (bounds[b + 1] - bounds[b]);
+    }
+
+private:
+    const T * data;
+    const size_t * bounds;
+    size_t buckets;
+    double * means;
+};
+
+/*
+ * Largest-Triangle-Three-Buckets. The elements between the first and the
+ * last are split into points - 2 buckets; from each bucket the element
+ * forming the largest triangle with the element selected from the previous
+ * bucket and the mean of the next bucket is selected.
+ */
+class LttbDispatch
+{
+public:
+    LttbDispatch(PVScalarArrayPtr const & pvSource, size_t points, size_t maxThreads) :
+        pvSource(pvSource), points(points), maxThreads(maxThreads)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+
+        typename PVT::const_svector data = static_cast<PVT *>(pvSource.get())->view();
+        const value_type * p = data.data();
+        size_t count = data.size();
+        PVDoubleArray::svector & x = columns[0];
+        PVDoubleArray::svector & y = columns[1];
+
+        if (count <= points)
+        {
+            x.resize(count);
+            y.resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                x[i] = static_cast<double>(i);
+                y[i] = static_cast<double>(p[i]);
+            }
+            return;
+        }
+
+        // the last "bucket" is the last element
+        size_t buckets = points - 2;
+        std::vector<size_t> bounds(buckets + 2);
+        for (size_t b = 0; b <= buckets; ++b)
+            bounds[b] = 1 + bucketBegin(b, count - 2, buckets);
+        bounds[buckets + 1] = count;
+
+        std::vector<double> means(buckets + 1);
+        MeanTask<value_type> task(p, &bounds[0], buckets + 1, &means[0]);
+        NTParallel::forEach(blocks(buckets + 1, bucketBlock), task,
+            threadsFor(count, maxThreads));
+
+        x.resize(points);
+        y.resize(points);
+        x[0] = 0;
+        y[0] = static_cast<double>(p[0]);
+        size_t selected = 0;
+        for (size_t b = 0; b < buckets; ++b)
+        {
+            double ax = static_cast<double>(selected);
+            double ay = static_cast<double>(p[selected]);
+            double cx = 0.5*(bounds[b + 1] + bounds[b + 2] - 1);
+            double cy = means[b + 1];
+
+            // twice the area of the triangle is |dx*(y - ay) - (x - ax)*dy|
+            double dx = cx - ax;
+            double dy = cy - ay;
+            size_t best = bounds[b];
+            double bestArea = -1;
+            for (size_t i = bounds[b]; i < bounds[b + 1]; ++i)
+            {
+                double area = std::fabs(dx*(p[i] - ay) - (i - ax)*dy);
+                if (area > bestArea)
+                {
+                    bestArea = area;
+                    best = i;
+                }
+            }
+            selected = best;
+            x[b + 1] = static_cast<double>(selected);
+            y[b + 1] = static_cast<double>(p[selected]);
+        }
+        x[points - 1] = static_cast<double>(count - 1);
+        y[points - 1] = static_cast<double>(p[count - 1]);
+    }
+
+    // x and y of the selected elements
+    PVDoubleArray::svector columns[2];
+
+private:
+    PVScalarArrayPtr const & pvSource;
+    size_t points;
+    size_t maxThreads;
+};
+
+template<typename T>
+class ResampleTask : public NTParallel::Task
+{
+public:
+    ResampleTask(const T * data, size_t count, size_t points,
+        NTScalarArrayDecimation::Interpolation interpolation, double * result) :
+        data(data), count(count), points(points), interpolation(interpolation),
+        step(points > 1 ? double(count - 1)/(points - 1) : 0), result(result)
+    {}
+
+    virtual void run(size_t index)
+    {
+        size_t i1 = std::min(points, (index + 1)*pointBlock);
+        size_t last = count - 1;
+        for (size_t i = index*pointBlock; i < i1; ++i)
+        {
+            double position = i*step;
+            size_t k = static_cast<size_t>(position);
+            if (k >= last)
+            {
+                result[i] = static_cast<double>(data[last]);
+                continue;
+            }
+
+            double t = position - k;
+            double y1 = static_cast<double>(data[k]);
+            double y2 = static_cast<double>(data[k + 1]);
+            if (interpolation == NTScalarArrayDecimation::linear)
+            {
+                result[i] = y1 + t*(y2 - y1);
+                continue;
+            }
+
+            // Catmull-Rom, extrapolating linearly beyond the first and the
+            // last element
+            double y0 = k > 0 ? static_cast<double>(data[k - 1]) : 2*y1 - y2;
+            double y3 = k + 2 <= last ? static_cast<double>(data[k + 2]) : 2*y2 - y1;
+            result[i] = y1 + 0.5*t*(y2 - y0 + t*(2*y0 - 5*y1 + 4*y2 - y3 +
+                t*(3*(y1 - y2) + y3 - y0)));
+        }
+    }
+
+private:
+    const T * data;
+    size_t count;
+    size_t points;
+    NTScalarArrayDecimation::Interpolation interpolation;
+    double step;
+    double * result;
+};
+
+class ResampleDispatch
+{
+public:
+    ResampleDispatch(PVScalarArrayPtr const & pvSource, size_t points,
+        NTScalarArrayDecimation::Interpolation interpolation, size_t maxThreads) :
+        pvSource(pvSource), points(points), interpolation(interpolation),
+        maxThreads(maxThreads)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+
+        typename PVT::const_svector data = static_cast<PVT *>(pvSource.get())->view();
+        if (data.empty() || points == 0)
+            return;
+
+        result.resize(points);
+        ResampleTask<value_type> task(data.data(), data.size(), points,
+            interpolation, result.data());
+        NTParallel::forEach(blocks(points, pointBlock), task,
+            threadsFor(points, maxThreads));
+    }
+
+    PVDoubleArray::svector result;
+
+private:
+    PVScalarArrayPtr const & pvSource;
+    size_t points;
+    NTScalarArrayDecimation::Interpolation interpolation;
+    size_t maxThreads;
+};
+
+}
+
+NTTablePtr NTScalarArrayDecimation::envelope(NTScalarArrayPtr const & source,
+    size_t buckets, size_t maxThreads)
+{
+    PVScalarArrayPtr pvSource = getNumericValue(source);
+    ExtremesDispatch dispatch(pvSource, buckets, maxThreads, PVScalarArrayPtr());
+    detail::dispatchNumericArray(pvSource->getScalarArray()->getElementType(), dispatch);
+
+    static const char * const columns[] = { "x", "min", "max" };
+    return createTable(source, columns, dispatch.columns, 3);
+}
+
+NTScalarArrayPtr NTScalarArrayDecimation::minMax(NTScalarArrayPtr const & source,
+    size_t buckets, size_t maxThreads)
+{
+    PVScalarArrayPtr pvSource = getNumericValue(source);
+    ScalarType elementType = pvSource->getScalarArray()->getElementType();
+    NTScalarArrayPtr result = createScalarArray(source, elementType);
+
+    ExtremesDispatch dispatch(pvSource, buckets, maxThreads,
+        result->getValue<PVScalarArray>());
+    detail::dispatchNumericArray(elementType, dispatch);
+    return result;
+}
+
+NTTablePtr NTScalarArrayDecimation::lttb(NTScalarArrayPtr const & source,
+    size_t points, size_t maxThreads)
+{
+    PVScalarArrayPtr pvSource = getNumericValue(source);
+    if (points < 3)
+        throw std::runtime_error("LTTB needs at least 3 points");
+
+    LttbDispatch dispatch(pvSource, points, maxThreads);
+    detail::dispatchNumericArray(pvSource->getScalarArray()->getElementType(), dispatch);
+
+    static const char * const columns[] = { "x", "y" };
+    return createTable(source, columns, dispatch.columns, 2);
+}
+
+NTScalarArrayPtr NTScalarArrayDecimation::resample(NTScalarArrayPtr const & source,
+    size_t points, Interpolation interpolation, size_t maxThreads)
+{
+    PVScalarArrayPtr pvSource = getNumericValue(source);
+    ResampleDispatch dispatch(pvSource, points, interpolation, maxThreads);
+    detail::dispatchNumericArray(pvSource->getScalarArray()->getElementType(), dispatch);
+
+    NTScalarArrayPtr result = createScalarArray(source, pvDouble);
+    result->getValue<PVDoubleArray>()->replace(freeze(dispatch.result));
+    return result;
+}
+
+}}
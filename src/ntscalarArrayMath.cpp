@@ -0,0 +1,418 @@
+/* ntscalarArrayMath.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#define epicsExportSharedSymbols
+#include <pv/ntscalarArrayMath.h>
+#include "ntndarrayData.h"
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+using detail::getNumericValue;
+using detail::sumOf;
+
+namespace {
+
+enum Operation { linearOperation, clampOperation, castOperation };
+
+struct Parameters
+{
+    Operation operation;
+    double scale;
+    double offset;
+    double low;
+    double high;
+
+    Parameters(Operation operation) :
+        operation(operation), scale(1), offset(0), low(0), high(0)
+    {}
+
+    // the operation on a single value, also applied to limits
+    double operator()(double value) const
+    {
+        switch (operation)
+        {
+        case linearOperation: return scale*value + offset;
+        case clampOperation: return std::min(std::max(value, low), high);
+        default: return value;
+        }
+    }
+};
+
+/*
+ * Converts a double to an element type, rounding half away from zero and
+ * saturating for integer types. NaN converts to 0. Written with selects
+ * rather than branches so that loops over it can be vectorized.
+ */
+template<typename T>
+inline T convertTo(double value)
+{
+    typedef std::numeric_limits<T> limits;
+    if (!limits::is_integer)
+        return static_cast<T>(value);
+
+    const double low = static_cast<double>(limits::min());
+    const double high = static_cast<double>(limits::max());
+    value = value == value ? value : 0;
+    value = value < low ? low : value;
+    if (sizeof(T) < sizeof(int64))
+    {
+        value = value > high ? high : value;
+    }
+    else if (value >= high)
+    {
+        // the maximum of a 64-bit type is not a double
+        return limits::max();
+    }
+    return static_cast<T>(value + (value < 0 ? -0.5 : 0.5));
+}
+
+template<typename S, typename D>
+void transformElements(const S * src, D * dst, size_t count, Parameters const & parameters)
+{
+    switch (parameters.operation)
+    {
+    case linearOperation:
+    {
+        const double scale = parameters.scale;
+        const double offset = parameters.offset;
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = convertTo<D>(scale*src[i] + offset);
+        break;
+    }
+    case clampOperation:
+    {
+        const double low = parameters.low;
+        const double high = parameters.high;
+        for (size_t i = 0; i < count; ++i)
+        {
+            double value = src[i];
+            value = value < low ? low : value;
+            value = value > high ? high : value;
+            dst[i] = convertTo<D>(value);
+        }
+        break;
+    }
+    case castOperation:
+        for (size_t i = 0; i < count; ++i)
+            dst[i] = convertTo<D>(static_cast<double>(src[i]));
+        break;
+    }
+}
+
+// same element type: a cast is a copy
+template<typename T>
+void transformElements(const T * src, T * dst, size_t count, Parameters const & parameters)
+{
+    if (parameters.operation == castOperation)
+    {
+        std::copy(src, src + count, dst);
+        return;
+    }
+
+    transformElements<T, T>(src, dst, count, parameters);
+}
+
+// boolean result: any value other than 0 and NaN is true
+template<typename S>
+void transformToBoolean(const S * src, boolean * dst, size_t count, Parameters const & parameters)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        double value = parameters(static_cast<double>(src[i]));
+        dst[i] = static_cast<boolean>(value == value && value != 0);
+    }
+}
+
+// pvData's boolean is a char type distinct from int8 and uint8, and the
+// saturating conversion to it would not give 0 or 1
+template<typename S>
+void transformElements(const S * src, boolean * dst, size_t count, Parameters const & parameters)
+{
+    transformToBoolean(src, dst, count, parameters);
+}
+
+void transformElements(const boolean * src, boolean * dst, size_t count, Parameters const & parameters)
+{
+    transformToBoolean(src, dst, count, parameters);
+}
+
+template<typename S>
+class DestinationDispatch
+{
+public:
+    DestinationDispatch(const S * src, size_t count, Parameters const & parameters,
+        PVScalarArrayPtr const & pvResult) :
+        src(src), count(count), parameters(parameters), pvResult(pvResult)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        PVT * pvArray = static_cast<PVT *>(pvResult.get());
+        typename PVT::svector result(pvArray->reuse());
+        result.resize(count);
+        transformElements(src, result.data(), count, parameters);
+        pvArray->replace(freeze(result));
+    }
+
+private:
+    const S * src;
+    size_t count;
+    Parameters const & parameters;
+    PVScalarArrayPtr const & pvResult;
+};
+
+class SourceDispatch
+{
+public:
+    SourceDispatch(PVScalarArrayPtr const & pvSource, Parameters const & parameters,
+        PVScalarArrayPtr const & pvResult) :
+        pvSource(pvSource), parameters(parameters), pvResult(pvResult)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+
+        // the view keeps the source alive if it is also the result
+        typename PVT::const_svector data = static_cast<PVT *>(pvSource.get())->view();
+        DestinationDispatch<value_type> destination(data.data(), data.size(),
+            parameters, pvResult);
+        detail::dispatchNumericArray(pvResult->getScalarArray()->getElementType(),
+            destination);
+    }
+
+private:
+    PVScalarArrayPtr const & pvSource;
+    Parameters const & parameters;
+    PVScalarArrayPtr const & pvResult;
+};
+
+void transformLimits(PVStructurePtr const & limits, Parameters const & parameters)
+{
+    PVDoublePtr pvLow = limits->getSubField<PVDouble>("limitLow");
+    PVDoublePtr pvHigh = limits->getSubField<PVDouble>("limitHigh");
+    if (!pvLow.get() || !pvHigh.get())
+        return;
+
+    double low = parameters(pvLow->get());
+    double high = parameters(pvHigh->get());
+    pvLow->put(std::min(low, high));
+    pvHigh->put(std::max(low, high));
+
+    PVDoublePtr pvMinStep = limits->getSubField<PVDouble>("minStep");
+    if (pvMinStep.get() && parameters.operation == linearOperation)
+        pvMinStep->put(pvMinStep->get()*std::fabs(parameters.scale));
+}
+
+/*
+ * Copies the metadata fields present in both, transforming the limits.
+ * When transforming in place only the limits are updated.
+ */
+void copyMetadata(NTScalarArrayPtr const & source, NTScalarArrayPtr const & result,
+    Parameters const & parameters)
+{
+    bool copy = source->getPVStructure() != result->getPVStructure();
+
+    if (copy && source->getDescriptor().get() && result->getDescriptor().get())
+        result->getDescriptor()->put(source->getDescriptor()->get());
+    if (copy && source->getAlarm().get() && result->getAlarm().get())
+        result->getAlarm()->copyUnchecked(*source->getAlarm());
+    if (copy && source->getTimeStamp().get() && result->getTimeStamp().get())
+        result->getTimeStamp()->copyUnchecked(*source->getTimeStamp());
+    if (source->getDisplay().get() && result->getDisplay().get())
+    {
+        if (copy)
+            result->getDisplay()->copyUnchecked(*source->getDisplay());
+        transformLimits(result->getDisplay(), parameters);
+    }
+    if (source->getControl().get() && result->getControl().get())
+    {
+        if (copy)
+            result->getControl()->copyUnchecked(*source->getControl());
+        transformLimits(result->getControl(), parameters);
+    }
+}
+
+NTScalarArrayPtr apply(NTScalarArrayPtr const & source, ScalarType elementType,
+    Parameters const & parameters, NTScalarArrayPtr const & result)
+{
+    PVScalarArrayPtr pvSource = getNumericValue(source);
+    if (elementType == pvString)
+        throw std::runtime_error("result element type is not numeric");
+
+    NTScalarArrayPtr target = result;
+    if (!target.get())
+    {
+        NTScalarArrayBuilderPtr builder = NTScalarArray::createBuilder();
+        builder->value(elementType);
+        if (source->getDescriptor().get())
+            builder->addDescriptor();
+        if (source->getAlarm().get())
+            builder->addAlarm();
+        if (source->getTimeStamp().get())
+            builder->addTimeStamp();
+        if (source->getDisplay().get())
+            builder->addDisplay();
+        if (source->getControl().get())
+            builder->addControl();
+        target = builder->create();
+    }
+
+    PVScalarArrayPtr pvResult = target->getValue<PVScalarArray>();
+    if (!pvResult.get() || pvResult->getScalarArray()->getElementType() != elementType)
+        throw std::runtime_error("result value does not have the result element type");
+
+    SourceDispatch dispatch(pvSource, parameters, pvResult);
+    detail::dispatchNumericArray(pvSource->getScalarArray()->getElementType(), dispatch);
+
+    copyMetadata(source, target, parameters);
+    return target;
+}
+
+enum Reduction { sumReduction, minimumReduction, maximumReduction, argmaxReduction };
+
+class Reducer
+{
+public:
+    Reducer(PVScalarArrayPtr const & pvArray, Reduction reduction) :
+        pvArray(pvArray), reduction(reduction), result(0), index(0)
+    {}
+
+    template<typename PVT>
+    void apply()
+    {
+        typedef typename PVT::value_type value_type;
+
+        typename PVT::const_svector data = static_cast<PVT *>(pvArray.get())->view();
+        const value_type * p = data.data();
+        size_t count = data.size();
+
+        if (reduction == sumReduction)
+        {
+            result = sumOf(p, count);
+            return;
+        }
+
+        if (count == 0)
+        {
+            result = std::numeric_limits<double>::quiet_NaN();
+            return;
+        }
+
+        value_type extreme = p[0];
+        if (reduction == minimumReduction)
+        {
+            for (size_t i = 1; i < count; ++i)
+                extreme = p[i] < extreme ? p[i] : extreme;
+        }
+        else
+        {
+            for (size_t i = 1; i < count; ++i)
+                extreme = p[i] > extreme ? p[i] : extreme;
+        }
+        result = static_cast<double>(extreme);
+
+        // a NaN extreme can only be the first element and never compares equal
+        if (reduction == argmaxReduction && extreme == extreme)
+            index = std::find(p, p + count, extreme) - p;
+    }
+
+    PVScalarArrayPtr pvArray;
+    Reduction reduction;
+    double result;
+    size_t index;
+};
+
+Reducer reduce(NTScalarArrayPtr const & source, Reduction reduction)
+{
+    PVScalarArrayPtr pvValue = getNumericValue(source);
+    Reducer reducer(pvValue, reduction);
+    detail::dispatchNumericArray(pvValue->getScalarArray()->getElementType(), reducer);
+    return reducer;
+}
+
+}
+
+NTScalarArrayPtr NTScalarArrayMath::linear(NTScalarArrayPtr const & source,
+    double scale, double offset, ScalarType elementType,
+    NTScalarArrayPtr const & result)
+{
+    Parameters parameters(linearOperation);
+    parameters.scale = scale;
+    parameters.offset = offset;
+    return apply(source, elementType, parameters, result);
+}
+
+NTScalarArrayPtr NTScalarArrayMath::clamp(NTScalarArrayPtr const & source,
+    double low, double high, NTScalarArrayPtr const & result)
+{
+    if (high < low)
+        throw std::runtime_error("clamp range is empty");
+
+    ScalarType elementType = getNumericValue(source)->getScalarArray()->getElementType();
+    Parameters parameters(clampOperation);
+    parameters.low = low;
+    parameters.high = high;
+
+    // keep integer results within the range after rounding
+    if (ScalarTypeFunc::isInteger(elementType) || ScalarTypeFunc::isUInteger(elementType))
+    {
+        parameters.low = std::ceil(low);
+        parameters.high = std::floor(high);
+        if (parameters.high < parameters.low)
+            throw std::runtime_error("clamp range contains no integer");
+    }
+    return apply(source, elementType, parameters, result);
+}
+
+NTScalarArrayPtr NTScalarArrayMath::cast(NTScalarArrayPtr const & source,
+    ScalarType elementType, NTScalarArrayPtr const & result)
+{
+    return apply(source, elementType, Parameters(castOperation), result);
+}
+
+double NTScalarArrayMath::sum(NTScalarArrayPtr const & source)
+{
+    return reduce(source, sumReduction).result;
+}
+
+double NTScalarArrayMath::mean(NTScalarArrayPtr const & source)
+{
+    size_t count = getNumericValue(source)->getLength();
+    if (count == 0)
+        return std::numeric_limits<double>::quiet_NaN();
+    return reduce(source, sumReduction).result/count;
+}
+
+double NTScalarArrayMath::minimum(NTScalarArrayPtr const & source)
+{
+    return reduce(source, minimumReduction).result;
+}
+
+double NTScalarArrayMath::maximum(NTScalarArrayPtr const & source)
+{
+    return reduce(source, maximumReduction).result;
+}
+
+size_t NTScalarArrayMath::argmax(NTScalarArrayPtr const & source)
+{
+    if (getNumericValue(source)->getLength() == 0)
+        throw std::runtime_error("argmax of an empty array");
+    return reduce(source, argmaxReduction).index;
+}
+
+}}
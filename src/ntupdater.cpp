@@ -0,0 +1,106 @@
+/* ntupdater.cpp */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <stdexcept>
+
+#define epicsExportSharedSymbols
+#include <pv/ntupdater.h>
+
+using namespace std;
+using namespace epics::pvData;
+
+namespace epics { namespace nt {
+
+namespace {
+
+template<typename PVT>
+void setChanged(std::tr1::shared_ptr<PVT> const & pvField,
+    typename PVT::value_type const & value, BitSet & changed, uint32 offset)
+{
+    if (pvField->get() == value)
+        return;
+    pvField->put(value);
+    changed.set(offset);
+}
+
+}
+
+NTUpdater::shared_pointer NTUpdater::create(PVStructurePtr const & pvStructure)
+{
+    if (!pvStructure.get())
+        throw std::runtime_error("NTUpdater::create: null PVStructure");
+    return shared_pointer(new NTUpdater(pvStructure));
+}
+
+NTUpdater::NTUpdater(PVStructurePtr const & pvStructure) :
+    pvStructure(pvStructure),
+    changed(new BitSet(static_cast<uint32>(pvStructure->getNumberFields()))),
+    pvValue(pvStructure->getSubField<PVScalar>("value")),
+    pvValueArray(pvStructure->getSubField<PVScalarArray>("value")),
+    valueOffset(0)
+{
+    if (pvValue.get())
+        valueOffset = offsetOf(pvValue);
+    else if (pvValueArray.get())
+        valueOffset = offsetOf(pvValueArray);
+
+    PVStructurePtr pvAlarm = pvStructure->getSubField<PVStructure>("alarm");
+    if (pvAlarm.get())
+    {
+        pvSeverity = pvAlarm->getSubField<PVInt>("severity");
+        pvStatus = pvAlarm->getSubField<PVInt>("status");
+        pvMessage = pvAlarm->getSubField<PVString>("message");
+    }
+
+    PVStructurePtr pvTimeStamp = pvStructure->getSubField<PVStructure>("timeStamp");
+    if (pvTimeStamp.get())
+    {
+        pvSecondsPastEpoch = pvTimeStamp->getSubField<PVLong>("secondsPastEpoch");
+        pvNanoseconds = pvTimeStamp->getSubField<PVInt>("nanoseconds");
+        pvUserTag = pvTimeStamp->getSubField<PVInt>("userTag");
+    }
+}
+
+uint32 NTUpdater::offsetOf(PVFieldPtr const & pvField) const
+{
+    return static_cast<uint32>(pvField->getFieldOffset() - pvStructure->getFieldOffset());
+}
+
+bool NTUpdater::setAlarm(Alarm const & alarm)
+{
+    return setAlarm(alarm.getSeverity(), alarm.getStatus(), alarm.getMessage());
+}
+
+bool NTUpdater::setAlarm(AlarmSeverity severity, AlarmStatus status,
+    std::string const & message)
+{
+    if (!pvSeverity.get())
+        return false;
+    setChanged(pvSeverity, severity, *changed, offsetOf(pvSeverity));
+    if (pvStatus.get())
+        setChanged(pvStatus, status, *changed, offsetOf(pvStatus));
+    if (pvMessage.get())
+        setChanged(pvMessage, message, *changed, offsetOf(pvMessage));
+    return true;
+}
+
+bool NTUpdater::setTimeStamp(TimeStamp const & timeStamp)
+{
+    if (!pvSecondsPastEpoch.get())
+        return false;
+    setChanged(pvSecondsPastEpoch, timeStamp.getSecondsPastEpoch(),
+        *changed, offsetOf(pvSecondsPastEpoch));
+    if (pvNanoseconds.get())
+        setChanged(pvNanoseconds, timeStamp.getNanoseconds(),
+            *changed, offsetOf(pvNanoseconds));
+    if (pvUserTag.get())
+        setChanged(pvUserTag, timeStamp.getUserTag(),
+            *changed, offsetOf(pvUserTag));
+    return true;
+}
+
+}}
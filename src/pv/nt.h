@@ -13,12 +13,23 @@
 #include <pv/ntfield.h>
 #include <pv/ntscalar.h>
 #include <pv/ntscalarArray.h>
+#include <pv/ntscalarArrayMath.h>
+#include <pv/ntscalarArrayHistory.h>
+#include <pv/ntscalarArrayDecimation.h>
+#include <pv/ntscalarTyped.h>
+#include <pv/ntupdater.h>
+#include <pv/ntchangeTracker.h>
 #include <pv/ntnameValue.h>
 #include <pv/nttable.h>
 #include <pv/ntndarray.h>
 #include <pv/ntmultiChannel.h>
 #include <pv/ntscalarMultiChannel.h>
+#include <pv/ntscalarMultiChannelUpdater.h>
+#include <pv/ntmultiChannelDelta.h>
+#include <pv/ntmultiChannelAlarm.h>
 #include <pv/ntmatrix.h>
+#include <pv/ntmatrixMath.h>
+#include <pv/ntmatrixView.h>
 #include <pv/ntenum.h>
 #include <pv/ntunion.h>
 #include <pv/ntaggregate.h>
@@ -27,6 +38,19 @@
 #include <pv/nthistogram.h>
 #include <pv/nturi.h>
 #include <pv/ntndarrayAttribute.h>
+#include <pv/ntndarraySequence.h>
+#include <pv/ntndarrayCodec.h>
+#include <pv/ntndarrayFrameStore.h>
+#include <pv/ntndarrayTiling.h>
+#include <pv/ntparallel.h>
+#include <pv/ntndarrayBufferPool.h>
+#include <pv/ntarena.h>
+#include <pv/ntndarrayDecodePipeline.h>
+#include <pv/ntndarrayDecimator.h>
+#include <pv/ntndarrayPreview.h>
+#include <pv/ntndarrayChecksum.h>
+#include <pv/ntndarrayColor.h>
+#include <pv/ntndarrayMatrix.h>
 
 #endif  /* NT_H */
 
@@ -0,0 +1,135 @@
+/* ntarena.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTARENA_H
+#define NTARENA_H
+
+#include <cstddef>
+#include <vector>
+
+#ifdef epicsExportSharedSymbols
+#   define ntarenaEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/pvData.h>
+
+#ifdef ntarenaEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntarenaEpicsExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTArena;
+typedef std::tr1::shared_ptr<NTArena> NTArenaPtr;
+
+/**
+ * @brief Monotonic arena for the arrays of short-lived NT values.
+ *
+ * allocate() carves storage from large blocks by advancing an offset,
+ * instead of allocating each array separately. release() discards all
+ * allocations in one step, after which the blocks are reused, so a
+ * request/reply server building similar values for each request reaches
+ * a steady state without allocating array storage:
+ * <pre>
+ * PVDoubleArray::svector column(arena->allocateArray<double>(rows));
+ * ...
+ * table->getColumn<PVDoubleArray>("x")->replace(freeze(column));
+ * ...                    // serialise and discard the table
+ * arena->release();
+ * </pre>
+ * Each allocation holds a reference to its block. A block still referenced
+ * when the arena is released, e.g. by a value kept after the request, is
+ * left to its references and replaced by a new block, so allocations are
+ * never overwritten while in use.
+ * <p>
+ * The storage of an allocation is not allocated separately, but its
+ * reference is: each allocation still heap allocates a small shared_ptr
+ * control block, which is freed when the allocation is. This keeps the
+ * allocation unique, as freeze() requires; a reference sharing the control
+ * block of its block would not be.
+ * <p>
+ * Only arrays of numeric element types may be allocated, since elements
+ * are not constructed. The structures of NT values are allocated by
+ * pvData as usual.
+ * <p>
+ * An arena must only be used by one thread at a time. Allocations may be
+ * released by any thread.
+ */
+class epicsShareClass NTArena
+{
+public:
+    POINTER_DEFINITIONS(NTArena);
+
+    /**
+     * Creates an arena.
+     * @param blockSize the size of the blocks in bytes. Allocations larger
+     *        than a quarter of this are allocated separately.
+     * @return a new arena.
+     */
+    static shared_pointer create(size_t blockSize = 64*1024);
+
+    /**
+     * Allocates storage, suitably aligned for any pvData scalar type.
+     * @param size the size in bytes.
+     * @return the storage, uninitialised.
+     */
+    std::tr1::shared_ptr<epics::pvData::uint8> allocate(size_t size);
+
+    /**
+     * Allocates storage for an array of a numeric type.
+     * @param count the number of elements.
+     * @return a vector of count uninitialised elements.
+     */
+    template<typename T>
+    epics::pvData::shared_vector<T> allocateArray(size_t count)
+    {
+        std::tr1::shared_ptr<T> data = std::tr1::static_pointer_cast<T>(
+            std::tr1::static_pointer_cast<void>(allocate(count*sizeof(T))));
+        return epics::pvData::shared_vector<T>(data, 0, count);
+    }
+
+    /**
+     * Discards all allocations, so that their storage is reused.
+     */
+    void release();
+
+    /**
+     * Returns the size of the blocks.
+     * @return the block size in bytes.
+     */
+    size_t getBlockSize() const { return blockSize; }
+
+    /**
+     * Returns the number of blocks allocated, including blocks replaced
+     * because they were still referenced when the arena was released.
+     * @return the number of blocks allocated.
+     */
+    size_t getBlockAllocations() const { return blockAllocations; }
+
+    /**
+     * Returns the number of bytes allocated since the arena was last released.
+     * @return the number of bytes.
+     */
+    size_t getAllocated() const { return allocated; }
+
+private:
+    NTArena(size_t blockSize);
+
+    size_t blockSize;
+    std::vector<std::tr1::shared_ptr<epics::pvData::uint8> > blocks;
+    // the block allocated from, and the offset of its free space
+    size_t current;
+    size_t offset;
+    size_t blockAllocations;
+    size_t allocated;
+};
+
+}}
+#endif  /* NTARENA_H */
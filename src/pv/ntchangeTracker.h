@@ -0,0 +1,148 @@
+/* ntchangeTracker.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTCHANGETRACKER_H
+#define NTCHANGETRACKER_H
+
+#ifdef epicsExportSharedSymbols
+#   define ntchangeTrackerEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/pvData.h>
+#include <pv/bitSet.h>
+#include <pv/lock.h>
+
+#ifdef ntchangeTrackerEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntchangeTrackerEpicsExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTChangeTracker;
+typedef std::tr1::shared_ptr<NTChangeTracker> NTChangeTrackerPtr;
+
+/**
+ * @brief Records the fields of an NT value changed since it was last published.
+ *
+ * A PostHandler is installed on every field of the NT value, which sets
+ * the bit of the field's offset each time the field is put, e.g. through
+ * a PVScalarValue::put() or PVValueArray::replace() on a field returned by
+ * an NT wrapper. takeChanged() then gives the BitSet for posting a monitor
+ * and resets it, so that only the fields changed since the last monitor
+ * are sent:
+ * <pre>
+ * NTChangeTrackerPtr tracker = NTChangeTracker::create(ntMultiChannel);
+ * ...
+ * ntMultiChannel->getValue()->set(values);
+ * ntMultiChannel->getSeverity()->replace(severities);
+ * ...
+ * if (tracker->takeChanged(changed))
+ *     ...                // post the monitor with changed
+ * </pre>
+ * Any NT value may be tracked, e.g. NTScalar, NTScalarArray, NTEnum,
+ * NTTable, NTNDArray or NTMultiChannel.
+ * <p>
+ * Only puts which call PVField::postPut() are recorded, as pvData does for
+ * put(), replace() and the other methods changing a field, but not for
+ * writes to the storage of a shared_vector after it was put. A union is
+ * marked by PVUnion::set(), but not by PVUnion::select() followed by a put
+ * to the selected member, such as
+ * ntndArray->getValue()->select<PVUByteArray>("ubyteValue")->replace(data);
+ * writers doing so must call postPut() on the union, or markChanged(), as
+ * the NTNDArray processing classes of this library do.
+ * <p>
+ * Since pvData allows one PostHandler per field, a PVStructure can only be
+ * tracked by one tracker at a time. The PostHandlers cannot be removed;
+ * they stay installed, inactive, once the tracker is destroyed, and are
+ * reused by the next tracker of the PVStructure. A PVStructure with fields
+ * having other PostHandlers, such as a pvDatabase record, cannot be
+ * tracked.
+ * <p>
+ * Fields may be put and changes taken by different threads.
+ */
+class epicsShareClass NTChangeTracker
+{
+public:
+    POINTER_DEFINITIONS(NTChangeTracker);
+
+    /**
+     * Creates a tracker for an NT value.
+     * @param pvStructure the PVStructure of the NT value.
+     * @return a new tracker.
+     * @throws std::runtime_error if a field is tracked by another tracker
+     *         or has another PostHandler, in which case no field is tracked.
+     */
+    static shared_pointer create(epics::pvData::PVStructurePtr const & pvStructure);
+
+    /**
+     * Creates a tracker for an NT value.
+     * @param nt the NT wrapper, e.g. an NTTablePtr.
+     * @return a new tracker.
+     */
+    template<typename NT>
+    static shared_pointer create(std::tr1::shared_ptr<NT> const & nt)
+    {
+        return create(nt->getPVStructure());
+    }
+
+    /**
+     * Returns whether any field changed since changes were last taken.
+     * @return true if a field changed.
+     */
+    bool isChanged() const;
+
+    /**
+     * Returns the fields changed since changes were last taken, and resets
+     * them, e.g. when publishing the NT value.
+     * @param changed set to the changed fields, by their offset in the NT
+     *        value.
+     * @return true if a field changed.
+     */
+    bool takeChanged(epics::pvData::BitSet & changed);
+
+    /**
+     * Resets the changed fields.
+     */
+    void clear();
+
+    /**
+     * Marks a field as changed, e.g. one whose shared_vector storage was
+     * written after it was put.
+     * @param pvField the field of the NT value.
+     */
+    void markChanged(epics::pvData::PVField const & pvField);
+
+    /**
+     * Returns the PVStructure of the NT value.
+     * @return the PVStructure.
+     */
+    epics::pvData::PVStructurePtr const & getPVStructure() const { return pvStructure; }
+
+    /**
+     * State shared with the PostHandler of each field.
+     */
+    struct Changes
+    {
+        epics::pvData::Mutex mutex;
+        epics::pvData::BitSet changed;
+    };
+
+private:
+    NTChangeTracker(epics::pvData::PVStructurePtr const & pvStructure);
+
+    void track();
+
+    epics::pvData::PVStructurePtr pvStructure;
+    size_t baseOffset;
+    std::tr1::shared_ptr<Changes> changes;
+};
+
+}}
+#endif  /* NTCHANGETRACKER_H */
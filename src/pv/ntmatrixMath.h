@@ -0,0 +1,180 @@
+/* ntmatrixMath.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTMATRIXMATH_H
+#define NTMATRIXMATH_H
+
+#include <pv/ntmatrix.h>
+#include <pv/ntmatrixView.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief Linear algebra on NTMatrix values.
+ *
+ * The operations work directly on the row-major value of NTMatrix
+ * instances. A matrix has dim [rows, columns]; a matrix without dim or
+ * with a single dim entry n is treated as a column vector of n rows.
+ * <p>
+ * Each operation also accepts NTMatrixView operands, so that rows,
+ * columns, blocks and transposes of matrices can be used without copying
+ * them. Matrix operands are checked once, when they are viewed, and the
+ * operations then work on the raw storage. The loops are blocked so that the
+ * data being worked on stays in cache, and large operations are split
+ * into blocks of rows or columns run in parallel with NTParallel; small
+ * ones run on the calling thread. Results are new NTMatrix instances with
+ * the value and dim fields, or plain arrays for vector results.
+ */
+class epicsShareClass NTMatrixMath
+{
+public:
+    /**
+     * The reductions of rows or columns.
+     */
+    enum Reduction
+    {
+        sum,
+        mean,
+        minimum,
+        maximum
+    };
+
+    /**
+     * Returns the number of rows of a matrix.
+     * @param matrix the matrix.
+     * @return the number of rows.
+     * @throws std::runtime_error if the matrix is not valid.
+     */
+    static size_t getRows(NTMatrixPtr const & matrix);
+
+    /**
+     * Returns the number of columns of a matrix.
+     * @param matrix the matrix.
+     * @return the number of columns.
+     * @throws std::runtime_error if the matrix is not valid.
+     */
+    static size_t getColumns(NTMatrixPtr const & matrix);
+
+    /**
+     * Transposes a matrix.
+     * @param matrix the matrix.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return the transpose.
+     * @throws std::runtime_error if the matrix is not valid.
+     */
+    static NTMatrixPtr transpose(NTMatrixPtr const & matrix, size_t maxThreads = 0);
+
+    /**
+     * Transposes a view.
+     * @param view the view.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return the transpose.
+     */
+    static NTMatrixPtr transpose(NTMatrixView const & view, size_t maxThreads = 0);
+
+    /**
+     * Multiplies a matrix by a vector.
+     * @param matrix the matrix, with n columns.
+     * @param vector the vector, with n elements.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return the product, with one element per row of the matrix.
+     * @throws std::runtime_error if the matrix is not valid or the sizes
+     *         do not match.
+     */
+    static epics::pvData::PVDoubleArray::const_svector multiply(
+        NTMatrixPtr const & matrix,
+        epics::pvData::PVDoubleArray::const_svector const & vector,
+        size_t maxThreads = 0);
+
+    /**
+     * Multiplies a view by a vector.
+     * @param view the view, with n columns.
+     * @param vector the vector, with n elements.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return the product, with one element per row of the view.
+     * @throws std::runtime_error if the sizes do not match.
+     */
+    static epics::pvData::PVDoubleArray::const_svector multiply(
+        NTMatrixView const & view,
+        epics::pvData::PVDoubleArray::const_svector const & vector,
+        size_t maxThreads = 0);
+
+    /**
+     * Multiplies two matrices.
+     * @param left the left matrix, with n columns.
+     * @param right the right matrix, with n rows.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return the product.
+     * @throws std::runtime_error if a matrix is not valid or the sizes
+     *         do not match.
+     */
+    static NTMatrixPtr multiply(NTMatrixPtr const & left,
+        NTMatrixPtr const & right, size_t maxThreads = 0);
+
+    /**
+     * Multiplies two views.
+     * @param left the left view, with n columns.
+     * @param right the right view, with n rows.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return the product.
+     * @throws std::runtime_error if the sizes do not match.
+     */
+    static NTMatrixPtr multiply(NTMatrixView const & left,
+        NTMatrixView const & right, size_t maxThreads = 0);
+
+    /**
+     * Reduces each row of a matrix to a single value.
+     * @param matrix the matrix.
+     * @param reduction the reduction.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return one value per row.
+     * @throws std::runtime_error if the matrix is not valid.
+     */
+    static epics::pvData::PVDoubleArray::const_svector reduceRows(
+        NTMatrixPtr const & matrix, Reduction reduction, size_t maxThreads = 0);
+
+    /**
+     * Reduces each row of a view to a single value.
+     * @param view the view.
+     * @param reduction the reduction.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return one value per row; for a view without columns the sum is 0
+     *         and the other reductions are NaN.
+     */
+    static epics::pvData::PVDoubleArray::const_svector reduceRows(
+        NTMatrixView const & view, Reduction reduction, size_t maxThreads = 0);
+
+    /**
+     * Reduces each column of a matrix to a single value.
+     * @param matrix the matrix.
+     * @param reduction the reduction.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return one value per column.
+     * @throws std::runtime_error if the matrix is not valid.
+     */
+    static epics::pvData::PVDoubleArray::const_svector reduceColumns(
+        NTMatrixPtr const & matrix, Reduction reduction, size_t maxThreads = 0);
+
+    /**
+     * Reduces each column of a view to a single value.
+     * @param view the view.
+     * @param reduction the reduction.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return one value per column; for a view without rows the sum is 0
+     *         and the other reductions are NaN.
+     */
+    static epics::pvData::PVDoubleArray::const_svector reduceColumns(
+        NTMatrixView const & view, Reduction reduction, size_t maxThreads = 0);
+
+private:
+    // disable object creation
+    NTMatrixMath() {}
+};
+
+}}
+#endif  /* NTMATRIXMATH_H */
@@ -0,0 +1,183 @@
+/* ntmatrixView.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTMATRIXVIEW_H
+#define NTMATRIXVIEW_H
+
+#include <pv/ntmatrix.h>
+#include <pv/ntscalarArray.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief Strided read-only view of the value of an NTMatrix.
+ *
+ * A view refers to a rectangular selection of the elements of a matrix,
+ * described by a first element and the distances between consecutive rows
+ * and columns. Rows, columns, blocks and the transpose of a view are again
+ * views of the same storage, so slicing a matrix allocates and copies
+ * nothing. Views hold a reference to the storage and remain valid if the
+ * matrix's value is replaced.
+ * <p>
+ * Elements are only copied when a view is published with toArray(),
+ * toMatrix() or toScalarArray(), and not even then if the view selects
+ * consecutive elements in row order, e.g. a row or a block of full rows.
+ * <p>
+ * NTMatrixMath operations accept views as well as matrices.
+ */
+class epicsShareClass NTMatrixView
+{
+public:
+    /**
+     * Creates an empty view.
+     */
+    NTMatrixView();
+
+    /**
+     * Creates a view of a whole matrix.
+     * A matrix without dim, or with a single dim entry n, is viewed as a
+     * column vector of n rows.
+     * @param matrix the matrix.
+     * @throws std::runtime_error if the matrix is not valid.
+     */
+    explicit NTMatrixView(NTMatrixPtr const & matrix);
+
+    /**
+     * Creates a view of an array holding a matrix in row order.
+     * @param value the array.
+     * @param rows the number of rows.
+     * @param columns the number of columns.
+     * @throws std::runtime_error if the size of the array is not rows*columns.
+     */
+    NTMatrixView(epics::pvData::PVDoubleArray::const_svector const & value,
+        size_t rows, size_t columns);
+
+    /**
+     * Returns the number of rows.
+     * @return the number of rows.
+     */
+    size_t getRows() const { return rows; }
+
+    /**
+     * Returns the number of columns.
+     * @return the number of columns.
+     */
+    size_t getColumns() const { return columns; }
+
+    /**
+     * Returns the number of elements.
+     * @return the number of rows times the number of columns.
+     */
+    size_t getSize() const { return rows*columns; }
+
+    /**
+     * Returns the distance in elements between consecutive rows.
+     * @return the row stride.
+     */
+    size_t getRowStride() const { return rowStride; }
+
+    /**
+     * Returns the distance in elements between consecutive columns.
+     * @return the column stride.
+     */
+    size_t getColumnStride() const { return columnStride; }
+
+    /**
+     * Returns the first element; element (r, c) is at
+     * data()[r*getRowStride() + c*getColumnStride()].
+     * @return the first element, or null for an empty view.
+     */
+    const double * data() const { return first; }
+
+    /**
+     * Returns an element.
+     * @param row the row, less than getRows().
+     * @param column the column, less than getColumns().
+     * @return the element.
+     */
+    double operator()(size_t row, size_t column) const
+    {
+        return first[row*rowStride + column*columnStride];
+    }
+
+    /**
+     * Returns whether the view selects consecutive elements in row order.
+     * @return true if publishing the view does not copy.
+     */
+    bool isContiguous() const;
+
+    /**
+     * Returns a view of one row, with one row and getColumns() columns.
+     * @param row the row.
+     * @return the view.
+     * @throws std::runtime_error if row is out of range.
+     */
+    NTMatrixView row(size_t row) const;
+
+    /**
+     * Returns a view of one column, with getRows() rows and one column.
+     * @param column the column.
+     * @return the view.
+     * @throws std::runtime_error if column is out of range.
+     */
+    NTMatrixView column(size_t column) const;
+
+    /**
+     * Returns a view of a block.
+     * @param row the first row.
+     * @param column the first column.
+     * @param rows the number of rows.
+     * @param columns the number of columns.
+     * @return the view.
+     * @throws std::runtime_error if the block does not fit the view.
+     */
+    NTMatrixView block(size_t row, size_t column, size_t rows, size_t columns) const;
+
+    /**
+     * Returns a view of the transpose.
+     * @return the view, with rows and columns exchanged.
+     */
+    NTMatrixView transpose() const;
+
+    /**
+     * Copies the elements in row order.
+     * @param destination storage for getSize() elements.
+     */
+    void copyTo(double * destination) const;
+
+    /**
+     * Returns the elements in row order, sharing the storage if the view
+     * is contiguous.
+     * @return the elements.
+     */
+    epics::pvData::PVDoubleArray::const_svector toArray() const;
+
+    /**
+     * Publishes the view as a new NTMatrix with dim [rows, columns].
+     * @return the matrix.
+     */
+    NTMatrixPtr toMatrix() const;
+
+    /**
+     * Publishes the elements of the view, in row order, as a new
+     * NTScalarArray with a double value.
+     * @return the scalar array.
+     */
+    NTScalarArrayPtr toScalarArray() const;
+
+private:
+    epics::pvData::PVDoubleArray::const_svector storage;
+    const double * first;
+    size_t rows;
+    size_t columns;
+    size_t rowStride;
+    size_t columnStride;
+};
+
+}}
+#endif  /* NTMATRIXVIEW_H */
@@ -0,0 +1,133 @@
+/* ntmultiChannelAlarm.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTMULTICHANNELALARM_H
+#define NTMULTICHANNELALARM_H
+
+#ifdef epicsExportSharedSymbols
+#   define ntmultiChannelAlarmEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/pvData.h>
+#include <pv/alarm.h>
+
+#ifdef ntmultiChannelAlarmEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntmultiChannelAlarmEpicsExportSharedSymbols
+#endif
+
+#include <pv/ntmultiChannel.h>
+#include <pv/ntscalarMultiChannel.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief Overall alarm of an NTMultiChannel or NTScalarMultiChannel.
+ *
+ * Summarises the severity and isConnected arrays of the channels: the
+ * highest severity, the first channel with it and the number of channels
+ * of each severity. A disconnected channel counts with the severity given
+ * for disconnected channels, by default invalidAlarm; severities outside
+ * the range of AlarmSeverity are counted as the nearest one.
+ * <p>
+ * The counts are computed in blocks by branch-free loops which the
+ * compiler vectorizes, so that arrays of many thousands of channels are
+ * summarised in microseconds.
+ */
+class epicsShareClass NTMultiChannelAlarm
+{
+public:
+    /**
+     * The number of alarm severities, from noAlarm to undefinedAlarm.
+     */
+    static const size_t SEVERITIES = epics::pvData::undefinedAlarm + 1;
+
+    /**
+     * @brief Summary of the alarms of the channels.
+     */
+    struct Summary
+    {
+        /** The highest severity of the channels, noAlarm if there are none */
+        epics::pvData::AlarmSeverity severity;
+        /** The index of the first channel with the highest severity, -1 if there are none */
+        epics::pvData::int32 worstChannel;
+        /** The number of disconnected channels */
+        size_t disconnected;
+        /** The number of channels of each severity, indexed by AlarmSeverity */
+        size_t severityCount[SEVERITIES];
+    };
+
+    /**
+     * Summarises the alarms of the channels.
+     * @param severity the severity of each channel, or empty if unknown,
+     *        in which case connected channels have no alarm.
+     * @param isConnected whether each channel is connected, or empty if
+     *        all are.
+     * @param disconnectedSeverity the severity of disconnected channels.
+     * @return the summary.
+     * @throws std::runtime_error if both arrays are not empty and their
+     *         lengths differ.
+     */
+    static Summary summarize(
+        epics::pvData::shared_vector<const epics::pvData::int32> const & severity,
+        epics::pvData::shared_vector<const epics::pvData::boolean> const & isConnected,
+        epics::pvData::AlarmSeverity disconnectedSeverity = epics::pvData::invalidAlarm);
+
+    /**
+     * Summarises the alarms of the channels of an NTMultiChannel, from its
+     * severity and isConnected fields if present.
+     * @param ntMultiChannel the NTMultiChannel.
+     * @param disconnectedSeverity the severity of disconnected channels.
+     * @return the summary.
+     * @throws std::runtime_error if the lengths of the arrays differ.
+     */
+    static Summary summarize(NTMultiChannelPtr const & ntMultiChannel,
+        epics::pvData::AlarmSeverity disconnectedSeverity = epics::pvData::invalidAlarm);
+
+    /**
+     * Summarises the alarms of the channels of an NTScalarMultiChannel,
+     * from its severity and isConnected fields if present.
+     * @param ntScalarMultiChannel the NTScalarMultiChannel.
+     * @param disconnectedSeverity the severity of disconnected channels.
+     * @return the summary.
+     * @throws std::runtime_error if the lengths of the arrays differ.
+     */
+    static Summary summarize(NTScalarMultiChannelPtr const & ntScalarMultiChannel,
+        epics::pvData::AlarmSeverity disconnectedSeverity = epics::pvData::invalidAlarm);
+
+    /**
+     * Summarises the alarms of the channels of an NTMultiChannel and sets
+     * its alarm: the highest severity, with the status of the first
+     * channel with it and its channel name and message as message; the
+     * status is clientStatus and the message "disconnected" if the channel
+     * is disconnected. If no channel is in alarm the alarm is cleared.
+     * @param ntMultiChannel the NTMultiChannel.
+     * @param disconnectedSeverity the severity of disconnected channels.
+     * @return the summary.
+     * @throws std::runtime_error if the NTMultiChannel has no alarm field
+     *         or the lengths of the arrays differ.
+     */
+    static Summary updateAlarm(NTMultiChannelPtr const & ntMultiChannel,
+        epics::pvData::AlarmSeverity disconnectedSeverity = epics::pvData::invalidAlarm);
+
+    /**
+     * Summarises the alarms of the channels of an NTScalarMultiChannel and
+     * sets its alarm, as updateAlarm(NTMultiChannelPtr const &, AlarmSeverity).
+     * @param ntScalarMultiChannel the NTScalarMultiChannel.
+     * @param disconnectedSeverity the severity of disconnected channels.
+     * @return the summary.
+     * @throws std::runtime_error if the NTScalarMultiChannel has no alarm
+     *         field or the lengths of the arrays differ.
+     */
+    static Summary updateAlarm(NTScalarMultiChannelPtr const & ntScalarMultiChannel,
+        epics::pvData::AlarmSeverity disconnectedSeverity = epics::pvData::invalidAlarm);
+};
+
+}}
+#endif  /* NTMULTICHANNELALARM_H */
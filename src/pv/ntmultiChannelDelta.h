@@ -0,0 +1,174 @@
+/* ntmultiChannelDelta.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTMULTICHANNELDELTA_H
+#define NTMULTICHANNELDELTA_H
+
+#include <string>
+
+#ifdef epicsExportSharedSymbols
+#   define ntmultiChannelDeltaEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/pvData.h>
+
+#ifdef ntmultiChannelDeltaEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntmultiChannelDeltaEpicsExportSharedSymbols
+#endif
+
+#include <pv/ntmultiChannel.h>
+#include <pv/ntscalarMultiChannel.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief Delta snapshots of NTMultiChannel and NTScalarMultiChannel.
+ *
+ * A delta holds only the channels changed since a previous snapshot: it is
+ * an NTMultiChannel or NTScalarMultiChannel of the same type as the
+ * snapshot, whose arrays have one element for each changed channel, with
+ * an extra int array field, changedIndex, giving the index of each of
+ * those channels in the snapshot. When few channels change, publishing
+ * the delta instead of the snapshot sends only their values and metadata:
+ * <pre>
+ * NTScalarMultiChannelPtr delta =
+ *     NTMultiChannelDelta::createDelta(previous, current);
+ * ...                    // publish delta
+ * NTMultiChannelDelta::merge(base, delta);   // on the receiving side
+ * </pre>
+ * A channel has changed if its value or any of its metadata array
+ * elements differs; NaN values are equal to each other. The descriptor,
+ * alarm and timeStamp of the snapshot are copied to the delta, and by
+ * merge() from the delta. Extra fields of the snapshot are not copied.
+ * <p>
+ * Channels must not be added or removed between snapshots.
+ */
+class epicsShareClass NTMultiChannelDelta
+{
+public:
+    /**
+     * The name of the field giving the indices of the changed channels.
+     */
+    static const std::string CHANGED_INDEX;
+
+    /**
+     * Finds the channels changed between two snapshots.
+     * @param previous the previous snapshot.
+     * @param current the current snapshot.
+     * @return the indices of the changed channels, in increasing order.
+     * @throws std::runtime_error if either snapshot is not valid or they
+     *         have different numbers of channels.
+     */
+    static epics::pvData::shared_vector<const epics::pvData::int32> findChanged(
+        NTScalarMultiChannelPtr const & previous,
+        NTScalarMultiChannelPtr const & current);
+
+    /**
+     * Finds the channels changed between two snapshots.
+     * Values are compared as PVFields.
+     * @param previous the previous snapshot.
+     * @param current the current snapshot.
+     * @return the indices of the changed channels, in increasing order.
+     * @throws std::runtime_error if either snapshot is not valid or they
+     *         have different numbers of channels.
+     */
+    static epics::pvData::shared_vector<const epics::pvData::int32> findChanged(
+        NTMultiChannelPtr const & previous,
+        NTMultiChannelPtr const & current);
+
+    /**
+     * Creates a delta holding the specified channels of a snapshot.
+     * @param current the snapshot.
+     * @param changedIndex the indices of the channels.
+     * @return the delta.
+     * @throws std::runtime_error if the snapshot is not valid or an index
+     *         is out of range.
+     */
+    static NTScalarMultiChannelPtr createDelta(
+        NTScalarMultiChannelPtr const & current,
+        epics::pvData::shared_vector<const epics::pvData::int32> const & changedIndex);
+
+    /**
+     * Creates a delta holding the specified channels of a snapshot.
+     * The values of the channels are shared with the snapshot.
+     * @param current the snapshot.
+     * @param changedIndex the indices of the channels.
+     * @return the delta.
+     * @throws std::runtime_error if the snapshot is not valid or an index
+     *         is out of range.
+     */
+    static NTMultiChannelPtr createDelta(
+        NTMultiChannelPtr const & current,
+        epics::pvData::shared_vector<const epics::pvData::int32> const & changedIndex);
+
+    /**
+     * Creates a delta holding the channels changed between two snapshots.
+     * @param previous the previous snapshot.
+     * @param current the current snapshot.
+     * @return the delta.
+     * @throws std::runtime_error as findChanged().
+     */
+    static NTScalarMultiChannelPtr createDelta(
+        NTScalarMultiChannelPtr const & previous,
+        NTScalarMultiChannelPtr const & current);
+
+    /**
+     * Creates a delta holding the channels changed between two snapshots.
+     * @param previous the previous snapshot.
+     * @param current the current snapshot.
+     * @return the delta.
+     * @throws std::runtime_error as findChanged().
+     */
+    static NTMultiChannelPtr createDelta(
+        NTMultiChannelPtr const & previous,
+        NTMultiChannelPtr const & current);
+
+    /**
+     * Applies a delta to a snapshot, replacing the arrays of the snapshot.
+     * The storage of an array is reused if it is not shared.
+     * @param base the snapshot, updated.
+     * @param delta the delta.
+     * @throws std::runtime_error if delta is not a delta, the snapshot is
+     *         not valid or the delta does not fit it. The snapshot is not
+     *         changed in this case.
+     */
+    static void merge(NTScalarMultiChannelPtr const & base,
+        NTScalarMultiChannelPtr const & delta);
+
+    /**
+     * Applies a delta to a snapshot, replacing the arrays of the snapshot.
+     * The storage of an array is reused if it is not shared.
+     * @param base the snapshot, updated.
+     * @param delta the delta.
+     * @throws std::runtime_error if delta is not a delta, the snapshot is
+     *         not valid or the delta does not fit it. The snapshot is not
+     *         changed in this case.
+     */
+    static void merge(NTMultiChannelPtr const & base,
+        NTMultiChannelPtr const & delta);
+
+    /**
+     * Returns whether a PVStructure is a delta.
+     * @param pvStructure the PVStructure.
+     * @return true if it has a changedIndex field.
+     */
+    static bool isDelta(epics::pvData::PVStructurePtr const & pvStructure);
+
+    /**
+     * Returns the indices of the changed channels of a delta.
+     * @param pvStructure the PVStructure of the delta.
+     * @return the indices, empty if pvStructure is not a delta.
+     */
+    static epics::pvData::shared_vector<const epics::pvData::int32> getChangedIndex(
+        epics::pvData::PVStructurePtr const & pvStructure);
+};
+
+}}
+#endif  /* NTMULTICHANNELDELTA_H */
@@ -9,6 +9,8 @@
 
 #include <vector>
 #include <string>
+#include <map>
+#include <stdexcept>
 
 #ifdef epicsExportSharedSymbols
 #   define ntscalarArrayEpicsExportSharedSymbols
@@ -217,6 +219,16 @@ public:
      */
     bool isValid();
 
+    /**
+     * Returns the number of elements of the value given by the sizes of
+     * the dimension field, e.g. for checking the uncompressedSize of an
+     * encoded value before decoding it.
+     * The size fields are looked up again only when the dimension array
+     * is replaced.
+     * @return the product of the dimension sizes, 0 if there is no dimension.
+     */
+    epics::pvData::int64 getElementCount();
+
     /**
      * Creates an NTNDArrayBuilder instance
      * @return builder instance.
@@ -306,6 +318,56 @@ public:
      */
     epics::pvData::PVStructureArrayPtr getAttribute() const;
 
+    /**
+     * Returns the element of the attribute field with the specified name.
+     * <p>
+     * An index of the attribute names is built on the first lookup and
+     * reused until the attribute array is replaced. If several attributes
+     * have the same name the first one is returned. To rename an
+     * attribute the attribute array must be replaced, e.g. by a copy;
+     * an attribute renamed in place is not found by either name.
+     * @param name the name of the attribute.
+     * @return the attribute or null if there is no such attribute.
+     */
+    epics::pvData::PVStructurePtr getAttribute(std::string const & name);
+
+    /**
+     * Returns the value field of the attribute with the specified name.
+     * @param name the name of the attribute.
+     * @return the value field or null if there is no such attribute.
+     */
+    epics::pvData::PVUnionPtr getAttributeValue(std::string const & name);
+
+    /**
+     * Gets the value of the attribute with the specified name,
+     * converted to the requested type.
+     * @tparam T the requested type, e.g. double, int32 or std::string.
+     * @param name the name of the attribute.
+     * @param value the value, unchanged if false is returned.
+     * @return true if the attribute exists and holds a scalar convertible
+     *         to T, otherwise false.
+     */
+    template<typename T>
+    bool getAttributeValue(std::string const & name, T & value)
+    {
+        epics::pvData::PVUnionPtr pvAttributeValue = getAttributeValue(name);
+        if (!pvAttributeValue.get())
+            return false;
+
+        epics::pvData::PVScalarPtr pvScalar =
+            pvAttributeValue->get<epics::pvData::PVScalar>();
+        if (!pvScalar.get())
+            return false;
+
+        try {
+            value = pvScalar->getAs<T>();
+        } catch (std::exception &) {
+            // e.g. a string which is not a number
+            return false;
+        }
+        return true;
+    }
+
     /**
      * Returns the descriptor field.
      * @return the descriptor field or null if no descriptor field.
@@ -342,10 +404,40 @@ private:
     NTNDArray(epics::pvData::PVStructurePtr const & pvStructure);
 
     epics::pvData::int64 getExpectedUncompressedSize();
+    epics::pvData::int64 getCodecElementSize();
     epics::pvData::int64 getValueSize();
     epics::pvData::int64 getValueTypeSize();
 
     epics::pvData::PVStructurePtr pvNTNDArray;
+    epics::pvData::PVUnionPtr pvValue;
+    epics::pvData::PVLongPtr pvCompressedSize;
+    epics::pvData::PVLongPtr pvUncompressedSize;
+    epics::pvData::PVStructureArrayPtr pvDimension;
+    epics::pvData::PVStringPtr pvCodecName;
+
+    // isValid() caches, keyed on the identity of the selected value
+    // field and of the dimension array storage
+    epics::pvData::PVFieldPtr cachedValueField;
+    epics::pvData::PVScalarArrayPtr cachedValue;
+    epics::pvData::int64 cachedValueTypeSize;
+    epics::pvData::PVStructureArray::const_svector cachedDim;
+    std::vector<epics::pvData::PVIntPtr> cachedDimSizes;
+
+    // attribute name index, rebuilt when the attribute array is replaced
+    struct AttributeEntry
+    {
+        epics::pvData::PVStructurePtr attribute;
+        epics::pvData::PVStringPtr name;
+        epics::pvData::PVUnionPtr value;
+    };
+    typedef std::map<std::string, AttributeEntry> AttributeIndex;
+
+    const AttributeEntry * findAttribute(std::string const & name);
+    void indexAttributes(epics::pvData::PVStructureArray::const_svector const & data);
+
+    epics::pvData::PVStructureArrayPtr pvAttribute;
+    epics::pvData::PVStructureArray::const_svector indexedAttributes;
+    AttributeIndex attributeIndex;
 
     friend class detail::NTNDArrayBuilder;
 };
@@ -0,0 +1,124 @@
+/* ntndarrayBufferPool.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYBUFFERPOOL_H
+#define NTNDARRAYBUFFERPOOL_H
+
+#include <cstddef>
+#include <map>
+
+#ifdef epicsExportSharedSymbols
+#   define ntndarrayBufferPoolEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/lock.h>
+#include <pv/pvData.h>
+
+#ifdef ntndarrayBufferPoolEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntndarrayBufferPoolEpicsExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTNDArrayBufferPool;
+typedef std::tr1::shared_ptr<NTNDArrayBufferPool> NTNDArrayBufferPoolPtr;
+
+/**
+ * @brief Pool recycling the storage of NTNDArray values.
+ *
+ * allocate() returns storage which goes back to the pool, instead of
+ * being freed, when the last reference to it is released, typically
+ * when the NTNDArray value it backs is replaced or destroyed. A stream
+ * of equally sized frames therefore reaches a steady state without
+ * memory allocation.
+ * <p>
+ * Storage is reused for requests of up to twice its size. It may be
+ * released after the pool is destroyed, in which case it is freed.
+ * <p>
+ * All methods are thread safe.
+ */
+class epicsShareClass NTNDArrayBufferPool :
+    public std::tr1::enable_shared_from_this<NTNDArrayBufferPool>
+{
+public:
+    POINTER_DEFINITIONS(NTNDArrayBufferPool);
+
+    /**
+     * Creates a pool.
+     * @param maxIdle the maximum number of unused buffers kept; further
+     *        released buffers are freed.
+     * @return a new pool.
+     */
+    static shared_pointer create(size_t maxIdle);
+
+    /**
+     * Destructor. Frees the unused buffers.
+     */
+    ~NTNDArrayBufferPool();
+
+    /**
+     * Allocates storage, suitably aligned for any pvData scalar type.
+     * @param size the size in bytes.
+     * @return the storage, uninitialised.
+     */
+    std::tr1::shared_ptr<epics::pvData::uint8> allocate(size_t size);
+
+    /**
+     * Allocates storage for an array.
+     * @param count the number of elements.
+     * @return a vector of count uninitialised elements.
+     */
+    template<typename T>
+    epics::pvData::shared_vector<T> allocateArray(size_t count)
+    {
+        std::tr1::shared_ptr<T> data = std::tr1::static_pointer_cast<T>(
+            std::tr1::static_pointer_cast<void>(allocate(count*sizeof(T))));
+        return epics::pvData::shared_vector<T>(data, 0, count);
+    }
+
+    /**
+     * Frees all unused buffers.
+     */
+    void clear();
+
+    /**
+     * Returns the number of allocate() calls served by a new buffer.
+     * @return the number of allocations.
+     */
+    size_t getAllocations() const;
+
+    /**
+     * Returns the number of allocate() calls served by a recycled buffer.
+     * @return the number of reuses.
+     */
+    size_t getReuses() const;
+
+    /**
+     * Returns the number of unused buffers held by the pool.
+     * @return the number of unused buffers.
+     */
+    size_t getIdle() const;
+
+private:
+    NTNDArrayBufferPool(size_t maxIdle);
+    void release(epics::pvData::uint8 * data, size_t capacity);
+
+    friend struct NTNDArrayBufferRelease;
+
+    mutable epics::pvData::Mutex mutex;
+    size_t maxIdle;
+    size_t allocations;
+    size_t reuses;
+    // unused buffers by capacity
+    std::multimap<size_t, epics::pvData::uint8 *> idle;
+};
+
+}}
+#endif  /* NTNDARRAYBUFFERPOOL_H */
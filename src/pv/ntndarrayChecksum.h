@@ -0,0 +1,100 @@
+/* ntndarrayChecksum.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYCHECKSUM_H
+#define NTNDARRAYCHECKSUM_H
+
+#include <string>
+
+#include <pv/ntndarray.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief CRC32C integrity checksums of NTNDArray values.
+ *
+ * The checksum of a frame is the CRC32C (Castagnoli) of the bytes of the
+ * array selected in its value union, taken in little-endian byte order so
+ * that it does not depend on the byte order of the host. For a compressed
+ * frame this is the compressed payload, so frames can be checked without
+ * decoding them.
+ * <p>
+ * By convention the checksum is carried in an attribute named
+ * "ValueCRC32C" whose value holds a uint. attach() adds or updates the
+ * attribute and verify() checks it against the value, so the checksum
+ * can be attached where a frame is produced and verified at the end of
+ * a pipeline.
+ * <p>
+ * On x86 processors with SSE4.2 the CRC32 instruction is used, detected
+ * at run time; elsewhere a table-driven implementation processing eight
+ * bytes per step is used. Both produce the same checksums.
+ */
+class epicsShareClass NTNDArrayChecksum
+{
+public:
+    /**
+     * The name of the checksum attribute, "ValueCRC32C".
+     */
+    static const std::string attributeName;
+
+    /**
+     * Computes or continues a CRC32C.
+     * @param data the data.
+     * @param size the size of the data in bytes.
+     * @param crc the CRC32C of the preceding data, or 0 to start.
+     * @return the CRC32C of the preceding data followed by data.
+     */
+    static epics::pvData::uint32 crc32c(const void * data, size_t size,
+        epics::pvData::uint32 crc = 0);
+
+    /**
+     * Returns whether crc32c() uses the processor's CRC32 instruction.
+     * @return true if hardware accelerated.
+     */
+    static bool isHardwareAccelerated();
+
+    /**
+     * Computes the checksum of the value of a frame.
+     * @param ntndArray the frame.
+     * @return the checksum.
+     * @throws std::runtime_error if the value is not a numeric array.
+     */
+    static epics::pvData::uint32 compute(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Computes the checksum of the value of a frame and stores it in the
+     * checksum attribute, adding the attribute if necessary.
+     * The attribute array is replaced, not modified in place.
+     * @param ntndArray the frame.
+     * @return the checksum.
+     * @throws std::runtime_error if the value is not a numeric array.
+     */
+    static epics::pvData::uint32 attach(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Returns whether a frame has a checksum attribute.
+     * @param ntndArray the frame.
+     * @return true if it has a checksum attribute holding a scalar.
+     */
+    static bool hasChecksum(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Verifies the checksum attribute of a frame.
+     * @param ntndArray the frame.
+     * @return true if the frame has a checksum attribute matching its value;
+     *         false if the attribute is missing or does not match.
+     */
+    static bool verify(NTNDArrayPtr const & ntndArray);
+
+private:
+    // disable object creation
+    NTNDArrayChecksum() {}
+};
+
+}}
+#endif  /* NTNDARRAYCHECKSUM_H */
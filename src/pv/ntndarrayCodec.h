@@ -0,0 +1,199 @@
+/* ntndarrayCodec.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYCODEC_H
+#define NTNDARRAYCODEC_H
+
+#include <string>
+#include <vector>
+
+#include <pv/ntndarray.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTNDArrayDeltaEncoder;
+typedef std::tr1::shared_ptr<NTNDArrayDeltaEncoder> NTNDArrayDeltaEncoderPtr;
+
+class NTNDArrayDeltaDecoder;
+typedef std::tr1::shared_ptr<NTNDArrayDeltaDecoder> NTNDArrayDeltaDecoderPtr;
+
+/**
+ * @brief Inter-frame delta codec for NTNDArray.
+ *
+ * A frame is encoded as the bytewise XOR of its value with the value of
+ * a reference frame (the previously encoded frame), packed so that runs
+ * of unchanged bytes take only a few bytes. Key frames are encoded
+ * against an all-zero reference and can be decoded on their own.
+ * <p>
+ * The encoded payload is stored in the ubyteValue member of the value
+ * union and codec.name is set to "delta". codec.parameters holds a
+ * structure with the fields
+ * <ul>
+ *   <li>elementType (int): the ScalarType of the decoded value</li>
+ *   <li>keyFrame (boolean): whether the frame is a key frame</li>
+ *   <li>referenceId (int): the uniqueId of the reference frame</li>
+ * </ul>
+ * compressedSize and uncompressedSize are the sizes in bytes of the
+ * payload and of the decoded value.
+ */
+class epicsShareClass NTNDArrayDeltaCodec
+{
+public:
+    /**
+     * The codec name, "delta".
+     */
+    static const std::string name;
+
+    /**
+     * Returns the structure of the codec.parameters field of encoded frames.
+     * @return the parameters structure.
+     */
+    static epics::pvData::StructureConstPtr getParametersStructure();
+
+    /**
+     * Packs the bytewise XOR of data and reference.
+     * @param data the bytes to encode.
+     * @param reference the reference bytes, or null for an all-zero reference.
+     * @param size the number of bytes in data (and reference).
+     * @param out the vector the packed bytes are appended to.
+     */
+    static void pack(const epics::pvData::uint8 * data,
+        const epics::pvData::uint8 * reference, size_t size,
+        std::vector<epics::pvData::uint8> & out);
+
+    /**
+     * XORs packed bytes into a buffer.
+     * Initialising the buffer with the reference (or with zeros for a key
+     * frame) before calling reconstructs the encoded data.
+     * @param packed the packed bytes.
+     * @param packedSize the number of packed bytes.
+     * @param data the buffer to update.
+     * @param size the size of the buffer.
+     * @return false if the packed bytes are corrupt or do not fit the buffer.
+     */
+    static bool unpack(const epics::pvData::uint8 * packed, size_t packedSize,
+        epics::pvData::uint8 * data, size_t size);
+
+private:
+    // disable object creation
+    NTNDArrayDeltaCodec() {}
+};
+
+/**
+ * @brief Encodes a stream of NTNDArrays with the delta codec.
+ *
+ * See NTNDArrayDeltaCodec. The encoder keeps the previous frame as
+ * reference. A key frame is emitted for the first frame, after every
+ * keyFrameInterval frames, when the element type or size of the value
+ * changes and when requested with requestKeyFrame().
+ * <p>
+ * An instance must not be used concurrently.
+ */
+class epicsShareClass NTNDArrayDeltaEncoder
+{
+public:
+    POINTER_DEFINITIONS(NTNDArrayDeltaEncoder);
+
+    /**
+     * Creates an encoder.
+     * @param keyFrameInterval the number of frames from one key frame to
+     *        the next; 1 makes every frame a key frame and 0 emits key
+     *        frames only when required or requested.
+     * @return a new encoder.
+     */
+    static shared_pointer create(size_t keyFrameInterval);
+
+    /**
+     * Destructor.
+     */
+    ~NTNDArrayDeltaEncoder() {}
+
+    /**
+     * Encodes a frame in place.
+     * The value, codec, compressedSize and uncompressedSize fields are
+     * replaced; the other fields are left unchanged.
+     * @param ntndArray an uncompressed frame (empty codec.name) with a
+     *        numeric value.
+     * @throws std::runtime_error if the frame cannot be encoded.
+     */
+    void encode(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Makes the next encoded frame a key frame.
+     */
+    void requestKeyFrame();
+
+private:
+    NTNDArrayDeltaEncoder(size_t keyFrameInterval);
+
+    size_t keyFrameInterval;
+    size_t framesSinceKeyFrame;
+    bool keyFrameRequested;
+
+    // the previous frame's value, kept alive by its storage
+    std::tr1::shared_ptr<const void> referenceStorage;
+    const epics::pvData::uint8 * referenceData;
+    size_t referenceSize;
+    epics::pvData::ScalarType referenceType;
+    epics::pvData::int32 referenceId;
+
+    std::vector<epics::pvData::uint8> packed;
+};
+
+/**
+ * @brief Decodes a stream of NTNDArrays encoded with the delta codec.
+ *
+ * The decoder keeps the last decoded frame as reference for the next.
+ * Frames which do not reference it are rejected until the next key frame.
+ * <p>
+ * An instance must not be used concurrently.
+ */
+class epicsShareClass NTNDArrayDeltaDecoder
+{
+public:
+    POINTER_DEFINITIONS(NTNDArrayDeltaDecoder);
+
+    /**
+     * Creates a decoder.
+     * @return a new decoder.
+     */
+    static shared_pointer create();
+
+    /**
+     * Destructor.
+     */
+    ~NTNDArrayDeltaDecoder() {}
+
+    /**
+     * Decodes a frame in place.
+     * Frames with an empty codec.name are left unchanged.
+     * @param ntndArray the frame to decode.
+     * @return false if the reference frame of the frame is not available,
+     *         in which case the frame is left unchanged.
+     * @throws std::runtime_error for an unknown codec or a corrupt frame.
+     */
+    bool decode(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Discards the reference frame. Frames are rejected until the next key frame.
+     */
+    void reset();
+
+private:
+    NTNDArrayDeltaDecoder();
+
+    // the previous decoded value, kept alive by its storage
+    std::tr1::shared_ptr<const void> referenceStorage;
+    const epics::pvData::uint8 * referenceData;
+    size_t referenceSize;
+    epics::pvData::ScalarType referenceType;
+    epics::pvData::int32 referenceId;
+};
+
+}}
+#endif  /* NTNDARRAYCODEC_H */
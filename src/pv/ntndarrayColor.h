@@ -0,0 +1,114 @@
+/* ntndarrayColor.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYCOLOR_H
+#define NTNDARRAYCOLOR_H
+
+#include <string>
+
+#include <pv/ntndarray.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief Color layout conversion of NTNDArray images.
+ *
+ * Follows the areaDetector conventions: the layout of an image is given
+ * by the "ColorMode" attribute and, for Bayer images, the filter
+ * arrangement by the "BayerPattern" attribute. Color images have three
+ * dimensions, one of which has size 3 and holds the red, green and blue
+ * components:
+ * <ul>
+ *   <li>RGB1 (pixel interleaved): [3, width, height]</li>
+ *   <li>RGB2 (row interleaved): [width, 3, height]</li>
+ *   <li>RGB3 (plane interleaved): [width, height, 3]</li>
+ * </ul>
+ * Mono and Bayer images are [width, height].
+ * <p>
+ * convert() rearranges color images between the RGB layouts and
+ * demosaics Bayer images to any of them with bilinear interpolation.
+ * Rows are processed in parallel with NTParallel::forEach().
+ */
+class epicsShareClass NTNDArrayColor
+{
+public:
+    /**
+     * The values of the ColorMode attribute.
+     */
+    enum ColorMode
+    {
+        mono = 0,
+        bayer = 1,
+        rgb1 = 2,
+        rgb2 = 3,
+        rgb3 = 4
+    };
+
+    /**
+     * The values of the BayerPattern attribute, naming the colors of the
+     * first two pixels of the first two rows.
+     */
+    enum BayerPattern
+    {
+        rggb = 0,
+        gbrg = 1,
+        grbg = 2,
+        bggr = 3
+    };
+
+    /**
+     * The name of the color mode attribute, "ColorMode".
+     */
+    static const std::string colorModeAttribute;
+
+    /**
+     * The name of the Bayer pattern attribute, "BayerPattern".
+     */
+    static const std::string bayerPatternAttribute;
+
+    /**
+     * Returns the color mode of an image, from its ColorMode attribute or,
+     * if there is none, from its dimensions.
+     * @param ntndArray the image.
+     * @return the color mode.
+     * @throws std::runtime_error if the ColorMode attribute is not one of
+     *         the supported modes or the dimensions do not match it.
+     */
+    static ColorMode getColorMode(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Returns the Bayer pattern of an image from its BayerPattern attribute.
+     * @param ntndArray the image.
+     * @return the pattern; rggb if there is no attribute.
+     * @throws std::runtime_error if the attribute is not a valid pattern.
+     */
+    static BayerPattern getBayerPattern(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Converts an image to another color layout.
+     * The result is a new NTNDArray with the dimensions and ColorMode
+     * attribute of the requested layout and the other fields of the image;
+     * the image is returned as is if it already has the requested layout.
+     * @param ntndArray the image, uncompressed and with a numeric value.
+     * @param colorMode the requested layout: rgb1, rgb2 or rgb3.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return the converted image.
+     * @throws std::runtime_error if the image is compressed, is mono or
+     *         its value does not match its dimensions, or colorMode is
+     *         not an RGB layout.
+     */
+    static NTNDArrayPtr convert(NTNDArrayPtr const & ntndArray,
+        ColorMode colorMode, size_t maxThreads = 0);
+
+private:
+    // disable object creation
+    NTNDArrayColor() {}
+};
+
+}}
+#endif  /* NTNDARRAYCOLOR_H */
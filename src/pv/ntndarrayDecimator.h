@@ -0,0 +1,178 @@
+/* ntndarrayDecimator.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYDECIMATOR_H
+#define NTNDARRAYDECIMATOR_H
+
+#include <vector>
+
+#ifdef epicsExportSharedSymbols
+#   define ntndarrayDecimatorEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/timeStamp.h>
+
+#ifdef ntndarrayDecimatorEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntndarrayDecimatorEpicsExportSharedSymbols
+#endif
+
+#include <pv/ntndarray.h>
+#include <pv/ntndarrayBufferPool.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTNDArrayDecimator;
+typedef std::tr1::shared_ptr<NTNDArrayDecimator> NTNDArrayDecimatorPtr;
+
+/**
+ * @brief Reduces the frame rate and resolution of an NTNDArray stream.
+ *
+ * Frames are passed to process() in stream order. They are collected in
+ * groups; a group ends with the frame which is at least the decimation'th
+ * frame of the group and, if a minimum period is set, whose dataTimeStamp
+ * is at least the minimum period after that of the previously emitted frame.
+ * process() returns a frame for each group and null for the other frames.
+ * <p>
+ * Without averaging the returned frame is the last frame of the group;
+ * with averaging its value is the element-wise mean of all frames of the
+ * group. uniqueId, dataTimeStamp, attribute and the other fields are
+ * always those of the last frame.
+ * <p>
+ * Binning replaces each block of binning[0] x binning[1] x ... elements
+ * by their mean, keeping the element type. Elements at the upper edge of
+ * a dimension which do not fill a whole block are dropped. The size and
+ * binning of the dimension field are updated accordingly.
+ * <p>
+ * Reduced frames are new NTNDArrays with values allocated from a buffer
+ * pool. A frame which needs no reduction, i.e. without averaging or
+ * binning, is returned as is.
+ * <p>
+ * Only uncompressed frames (empty codec.name) are accepted.
+ * A decimator is not thread safe.
+ */
+class epicsShareClass NTNDArrayDecimator
+{
+public:
+    POINTER_DEFINITIONS(NTNDArrayDecimator);
+
+    /**
+     * Creates a decimator.
+     * @param decimation the minimum number of frames in a group; 1 keeps
+     *        every frame.
+     * @param pool the pool to allocate reduced values from, or null to
+     *        create one.
+     * @return a new decimator.
+     */
+    static shared_pointer create(size_t decimation = 1,
+        NTNDArrayBufferPoolPtr const & pool = NTNDArrayBufferPoolPtr());
+
+    /**
+     * Destructor.
+     */
+    ~NTNDArrayDecimator() {}
+
+    /**
+     * Sets the minimum number of frames in a group. Discards the current group.
+     * @param decimation the number of frames; 0 is treated as 1.
+     */
+    void setDecimation(size_t decimation);
+
+    /**
+     * Returns the minimum number of frames in a group.
+     * @return the number of frames.
+     */
+    size_t getDecimation() const { return decimation; }
+
+    /**
+     * Sets the minimum time between emitted frames, by dataTimeStamp.
+     * Discards the current group.
+     * @param seconds the minimum period; 0 for no limit.
+     */
+    void setMinimumPeriod(double seconds);
+
+    /**
+     * Returns the minimum time between emitted frames.
+     * @return the minimum period in seconds.
+     */
+    double getMinimumPeriod() const { return minimumPeriod; }
+
+    /**
+     * Sets whether emitted frames are the mean of their group.
+     * Discards the current group.
+     * @param averaging true to average.
+     */
+    void setAveraging(bool averaging);
+
+    /**
+     * Returns whether emitted frames are the mean of their group.
+     * @return true if averaging.
+     */
+    bool isAveraging() const { return averaging; }
+
+    /**
+     * Sets the binning factor of each dimension. Discards the current group.
+     * @param binning the factors; a missing or zero entry means 1.
+     */
+    void setBinning(std::vector<size_t> const & binning);
+
+    /**
+     * Returns the binning factor of each dimension.
+     * @return the factors.
+     */
+    std::vector<size_t> const & getBinning() const { return binning; }
+
+    /**
+     * Returns the pool reduced values are allocated from.
+     * @return the pool.
+     */
+    NTNDArrayBufferPoolPtr getBufferPool() const { return pool; }
+
+    /**
+     * Processes the next frame of the stream.
+     * A change of the element type or dimensions discards the current group.
+     * @param ntndArray the frame, which is not modified.
+     * @return the reduced frame ending the current group, or null.
+     * @throws std::runtime_error if the frame is compressed, its value is
+     *         not numeric or does not match its dimension field, or a
+     *         binning factor exceeds the size of its dimension.
+     */
+    NTNDArrayPtr process(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Discards the current group and forgets the time of the last emitted
+     * frame.
+     */
+    void reset();
+
+private:
+    NTNDArrayDecimator(size_t decimation, NTNDArrayBufferPoolPtr const & pool);
+    bool isBinning() const;
+    NTNDArrayPtr createReduced(NTNDArrayPtr const & ntndArray, size_t frames);
+
+    size_t decimation;
+    double minimumPeriod;
+    bool averaging;
+    std::vector<size_t> binning;
+    NTNDArrayBufferPoolPtr pool;
+
+    size_t groupFrames;
+    bool emitted;
+    epics::pvData::TimeStamp lastEmitted;
+
+    // layout of the frames in the current group
+    epics::pvData::ScalarType elementType;
+    std::vector<size_t> sizes;
+    std::vector<size_t> binnedSizes;
+    // sum of the binned values of the group
+    std::vector<double> sum;
+};
+
+}}
+#endif  /* NTNDARRAYDECIMATOR_H */
@@ -0,0 +1,198 @@
+/* ntndarrayDecodePipeline.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYDECODEPIPELINE_H
+#define NTNDARRAYDECODEPIPELINE_H
+
+#include <deque>
+#include <vector>
+
+#ifdef epicsExportSharedSymbols
+#   define ntndarrayDecodePipelineEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/lock.h>
+#include <pv/event.h>
+#include <pv/timeStamp.h>
+
+#ifdef ntndarrayDecodePipelineEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntndarrayDecodePipelineEpicsExportSharedSymbols
+#endif
+
+#include <pv/ntndarray.h>
+#include <pv/ntndarrayBufferPool.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTNDArrayDecodePipeline;
+typedef std::tr1::shared_ptr<NTNDArrayDecodePipeline> NTNDArrayDecodePipelinePtr;
+
+/**
+ * @brief Decodes compressed NTNDArrays on a pool of worker threads.
+ *
+ * Producers put() frames into a bounded pipeline, blocking while it is
+ * full, which pushes back on a producer outrunning the decoders. Worker
+ * threads decode the frames concurrently, allocating the decoded values
+ * from a buffer pool, and consumers take() the decoded frames in the
+ * order they were put. For a monitor stream this is uniqueId order.
+ * <p>
+ * Decoding is done by a Decoder; the default one handles uncompressed
+ * frames and frames encoded with NTNDArrayTiledCodec. Frames which fail
+ * to decode are dropped and counted.
+ * <p>
+ * put() and take() may be called concurrently from several threads.
+ */
+class epicsShareClass NTNDArrayDecodePipeline
+{
+public:
+    POINTER_DEFINITIONS(NTNDArrayDecodePipeline);
+
+    /**
+     * @brief Decodes single frames for the pipeline.
+     */
+    class epicsShareClass Decoder
+    {
+    public:
+        POINTER_DEFINITIONS(Decoder);
+
+        virtual ~Decoder() {}
+
+        /**
+         * Decodes a frame in place. Called concurrently for different frames.
+         * @param ntndArray the frame.
+         * @param pool the pool to allocate the decoded value from.
+         * @throws std::exception if the frame cannot be decoded.
+         */
+        virtual void decode(NTNDArrayPtr const & ntndArray,
+            NTNDArrayBufferPoolPtr const & pool) = 0;
+    };
+
+    /**
+     * @brief Pipeline statistics. Times are in seconds.
+     */
+    struct Statistics
+    {
+        /** Number of frames taken */
+        size_t frames;
+        /** Number of frames dropped because they failed to decode */
+        size_t failed;
+        /** Number of frames currently in the pipeline */
+        size_t inProgress;
+        /** Mean and maximum time from put() to the start of decoding */
+        double meanQueueTime, maxQueueTime;
+        /** Mean and maximum decoding time */
+        double meanDecodeTime, maxDecodeTime;
+        /** Mean and maximum time from the end of decoding to take() */
+        double meanDeliveryTime, maxDeliveryTime;
+    };
+
+    /**
+     * Creates a pipeline and starts its worker threads.
+     * @param threads the number of worker threads.
+     * @param capacity the maximum number of frames in the pipeline.
+     * @param decoder the decoder, or null for the default one.
+     * @return a new pipeline.
+     */
+    static shared_pointer create(size_t threads, size_t capacity,
+        Decoder::shared_pointer const & decoder = Decoder::shared_pointer());
+
+    /**
+     * Destructor. Stops the pipeline.
+     */
+    ~NTNDArrayDecodePipeline();
+
+    /**
+     * Puts a frame into the pipeline, waiting while it is full.
+     * The frame is decoded in place; the caller must not modify it afterwards.
+     * @param ntndArray the frame.
+     * @param timeout the maximum time to wait in seconds; negative to wait
+     *        for ever.
+     * @return false if the pipeline was still full after timeout or is stopped.
+     */
+    bool put(NTNDArrayPtr const & ntndArray, double timeout = -1.0);
+
+    /**
+     * Takes the next decoded frame, waiting until it is decoded.
+     * @param timeout the maximum time to wait in seconds; negative to wait
+     *        for ever.
+     * @return the frame, or null on timeout or when the pipeline is
+     *         stopped and no decoded frames are left.
+     */
+    NTNDArrayPtr take(double timeout = -1.0);
+
+    /**
+     * Stops the worker threads after the frames they are decoding.
+     * Frames not yet decoded are discarded; decoded frames can still be taken.
+     * Waiting put() and take() calls return.
+     */
+    void stop();
+
+    /**
+     * Returns the pool the decoded values are allocated from.
+     * @return the pool.
+     */
+    NTNDArrayBufferPoolPtr getBufferPool() const { return pool; }
+
+    /**
+     * Returns the statistics since creation or the last resetStatistics().
+     * @return the statistics.
+     */
+    Statistics getStatistics() const;
+
+    /**
+     * Resets the statistics.
+     */
+    void resetStatistics();
+
+private:
+    struct Entry
+    {
+        NTNDArrayPtr frame;
+        epics::pvData::TimeStamp queued;
+        epics::pvData::TimeStamp decoded;
+        bool done;
+        bool failed;
+    };
+
+    class Worker;
+    friend class Worker;
+
+    NTNDArrayDecodePipeline(size_t capacity, Decoder::shared_pointer const & decoder);
+    void work();
+    static bool waitFor(epics::pvData::Event & event, double timeout,
+        epics::pvData::TimeStamp const & start);
+
+    size_t capacity;
+    Decoder::shared_pointer decoder;
+    NTNDArrayBufferPoolPtr pool;
+
+    mutable epics::pvData::Mutex mutex;
+    epics::pvData::Event notFull;
+    epics::pvData::Event notEmpty;
+    epics::pvData::Event ready;
+    bool stopping;
+
+    // frames in the pipeline, in put() order
+    std::deque<Entry> entries;
+    // number of entries claimed by workers, counted from the front
+    size_t claimed;
+
+    std::vector<Worker *> workers;
+
+    size_t frames;
+    size_t failed;
+    size_t decoded;
+    double totalQueueTime, maxQueueTime;
+    double totalDecodeTime, maxDecodeTime;
+    double totalDeliveryTime, maxDeliveryTime;
+};
+
+}}
+#endif  /* NTNDARRAYDECODEPIPELINE_H */
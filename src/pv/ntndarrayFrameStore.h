@@ -0,0 +1,245 @@
+/* ntndarrayFrameStore.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYFRAMESTORE_H
+#define NTNDARRAYFRAMESTORE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+
+#ifdef epicsExportSharedSymbols
+#   define ntndarrayFrameStoreEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/lock.h>
+#include <pv/timeStamp.h>
+
+#ifdef ntndarrayFrameStoreEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntndarrayFrameStoreEpicsExportSharedSymbols
+#endif
+
+#include <pv/ntndarray.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTNDArrayFrameWriter;
+typedef std::tr1::shared_ptr<NTNDArrayFrameWriter> NTNDArrayFrameWriterPtr;
+
+class NTNDArrayFrameReader;
+typedef std::tr1::shared_ptr<NTNDArrayFrameReader> NTNDArrayFrameReaderPtr;
+
+namespace detail {
+
+/**
+ * Fixed size header preceding each frame in a frame store file.
+ * Written in the byte order of the host which wrote the file.
+ */
+struct FrameRecordHeader
+{
+    epics::pvData::uint32 magic;
+    epics::pvData::uint32 metadataSize;
+    epics::pvData::uint64 payloadOffset;
+    epics::pvData::uint64 payloadSize;
+    epics::pvData::uint64 nextRecord;
+    epics::pvData::int64 compressedSize;
+    epics::pvData::int64 uncompressedSize;
+    epics::pvData::int64 secondsPastEpoch;
+    epics::pvData::int32 nanoseconds;
+    epics::pvData::int32 userTag;
+    epics::pvData::int32 uniqueId;
+    epics::pvData::int32 elementType;
+};
+
+}
+
+/**
+ * @brief Records NTNDArrays to an append-only frame store file.
+ *
+ * Each frame is stored as a fixed size header holding uniqueId,
+ * dataTimeStamp, compressedSize, uncompressedSize and the element type
+ * of the value, followed by the serialized dimension, codec and
+ * attribute fields and finally the raw bytes of the value. The value is
+ * aligned to a 4096 byte page boundary in the file, so it can be mapped
+ * directly into memory by NTNDArrayFrameReader.
+ * Other optional fields (descriptor, alarm, timeStamp, display) are not
+ * stored.
+ * <p>
+ * Files are written in the byte order of the host and can only be read
+ * on hosts with the same byte order.
+ * <p>
+ * An instance must not be used concurrently.
+ */
+class epicsShareClass NTNDArrayFrameWriter
+{
+public:
+    POINTER_DEFINITIONS(NTNDArrayFrameWriter);
+
+    /**
+     * Creates a frame store file, replacing any existing file.
+     * @param fileName the name of the file.
+     * @return a new writer.
+     * @throws std::runtime_error if the file cannot be created.
+     */
+    static shared_pointer create(std::string const & fileName);
+
+    /**
+     * Destructor. Closes the file.
+     */
+    ~NTNDArrayFrameWriter();
+
+    /**
+     * Appends a frame.
+     * @param ntndArray the frame; its value must be empty or a numeric array.
+     * @throws std::runtime_error if the frame cannot be written.
+     */
+    void write(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Flushes buffered frames to the file.
+     * @throws std::runtime_error on a write error.
+     */
+    void flush();
+
+    /**
+     * Flushes and closes the file. Further writes throw.
+     * @throws std::runtime_error on a write error.
+     */
+    void close();
+
+    /**
+     * Returns the number of frames written.
+     * @return the number of frames.
+     */
+    size_t getFrameCount() const { return frameCount; }
+
+private:
+    NTNDArrayFrameWriter(std::string const & fileName, FILE * file);
+    void put(const void * data, size_t size);
+    void pad(size_t alignment);
+
+    std::string fileName;
+    FILE * file;
+    epics::pvData::uint64 offset;
+    size_t frameCount;
+    std::vector<char> metadata;
+};
+
+/**
+ * @brief Reads NTNDArrays from a frame store file.
+ *
+ * See NTNDArrayFrameWriter. On hosts supporting memory mapped files the
+ * file is mapped and the values of the frames returned by read() refer
+ * to the mapping instead of being copied; the mapping stays alive as
+ * long as any of these values is referenced. The mapping is read-only, so
+ * such a value must be copied rather than modified in place, e.g. through
+ * reuse() or thaw() of its only reference. Elsewhere values are read into
+ * newly allocated arrays.
+ * <p>
+ * The frames are indexed when the file is opened, so they can be looked
+ * up by position, uniqueId or dataTimeStamp. Frames appended after that
+ * are not seen. A truncated last frame, e.g. after a crash of the writer,
+ * is ignored.
+ * <p>
+ * Frames may be read concurrently from several threads.
+ */
+class epicsShareClass NTNDArrayFrameReader
+{
+public:
+    POINTER_DEFINITIONS(NTNDArrayFrameReader);
+
+    /**
+     * Opens a frame store file and indexes its frames.
+     * @param fileName the name of the file.
+     * @return a new reader.
+     * @throws std::runtime_error if the file cannot be opened or is not
+     *         a frame store file.
+     */
+    static shared_pointer create(std::string const & fileName);
+
+    /**
+     * Destructor. Closes the file.
+     */
+    ~NTNDArrayFrameReader();
+
+    /**
+     * Returns the number of frames in the file.
+     * @return the number of frames.
+     */
+    size_t getFrameCount() const { return records.size(); }
+
+    /**
+     * Reads a frame.
+     * @param index the position of the frame in the file.
+     * @return a new NTNDArray.
+     * @throws std::out_of_range if index is not less than getFrameCount().
+     * @throws std::runtime_error if the frame cannot be read.
+     */
+    NTNDArrayPtr read(size_t index);
+
+    /**
+     * Returns the uniqueId of a frame without reading it.
+     * @param index the position of the frame in the file.
+     * @return the uniqueId.
+     */
+    epics::pvData::int32 getUniqueId(size_t index) const;
+
+    /**
+     * Returns the dataTimeStamp of a frame without reading it.
+     * @param index the position of the frame in the file.
+     * @return the dataTimeStamp.
+     */
+    epics::pvData::TimeStamp getDataTimeStamp(size_t index) const;
+
+    /**
+     * Finds the frame with the specified uniqueId.
+     * If several frames have that uniqueId the first is found.
+     * @param uniqueId the uniqueId.
+     * @param index set to the position of the frame.
+     * @return false if there is no such frame.
+     */
+    bool findUniqueId(epics::pvData::int32 uniqueId, size_t & index) const;
+
+    /**
+     * Finds the earliest frame with a dataTimeStamp at or after the
+     * specified time.
+     * @param time the time.
+     * @param index set to the position of the frame.
+     * @return false if all frames are older than time.
+     */
+    bool findTime(epics::pvData::TimeStamp const & time, size_t & index) const;
+
+    /**
+     * Returns whether the file is memory mapped.
+     * @return true if values are read without copying.
+     */
+    bool isMapped() const { return mapping.get() != 0; }
+
+private:
+    NTNDArrayFrameReader(FILE * file);
+    void readAt(epics::pvData::uint64 offset, void * data, size_t size);
+    void buildIndex(epics::pvData::uint64 fileSize);
+
+    FILE * file;
+    epics::pvData::Mutex mutex;
+    std::tr1::shared_ptr<const void> mapping;
+    const epics::pvData::uint8 * mappedData;
+
+    std::vector<detail::FrameRecordHeader> records;
+    std::vector<epics::pvData::uint64> recordOffsets;
+    std::map<epics::pvData::int32, size_t> uniqueIdIndex;
+    // positions of the frames, ordered by dataTimeStamp
+    std::vector<size_t> timeIndex;
+    epics::pvData::StructureConstPtr structure;
+};
+
+}}
+#endif  /* NTNDARRAYFRAMESTORE_H */
@@ -0,0 +1,79 @@
+/* ntndarrayMatrix.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYMATRIX_H
+#define NTNDARRAYMATRIX_H
+
+#include <pv/ntndarray.h>
+#include <pv/ntmatrix.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief Conversion between NTNDArray frames and NTMatrix.
+ *
+ * NTNDArray dimensions are listed fastest varying first, whereas NTMatrix
+ * values are stored row by row with dim [rows, columns]. A frame with
+ * dimensions [width, height] therefore corresponds to a matrix with
+ * dim [height, width] and the same element order, so no rearrangement of
+ * the values is needed in either direction.
+ * <p>
+ * When the frame's value is a doubleValue array, toMatrix() shares it with
+ * the matrix instead of copying it; other element types are converted to
+ * double. toNTNDArray() always shares the matrix's value. As pvData arrays
+ * are immutable once frozen, sharing is safe: replacing the value of one
+ * structure does not affect the other.
+ * <p>
+ * The descriptor and alarm are taken over when both structures have them.
+ * The matrix's timeStamp corresponds to the frame's dataTimeStamp.
+ */
+class epicsShareClass NTNDArrayMatrix
+{
+public:
+    /**
+     * Creates an NTMatrix from a one or two-dimensional frame.
+     * The matrix has the dim field and, if the frame has them, descriptor
+     * and alarm fields; it always has a timeStamp holding the frame's
+     * dataTimeStamp.
+     * @param ntndArray the frame, uncompressed and with a numeric value.
+     *        Dimensions after the second must have size 1.
+     * @return the matrix.
+     * @throws std::runtime_error if the frame is compressed, does not have
+     *         a numeric value, has more than two dimensions of size other
+     *         than 1 or its value does not match its dimensions.
+     */
+    static NTMatrixPtr toMatrix(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Returns whether toMatrix() shares the value of a frame rather than
+     * converting it.
+     * @param ntndArray the frame.
+     * @return true if the value is a doubleValue array.
+     */
+    static bool isSharedValue(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Creates an NTNDArray from a matrix, sharing its value as doubleValue.
+     * A matrix with dim [rows, columns] gives dimensions [columns, rows];
+     * one without dim, or with a single dim entry, gives a single
+     * dimension. The frame has descriptor and alarm fields if the matrix
+     * does, and its dataTimeStamp and timeStamp are set from the matrix's
+     * timeStamp if there is one.
+     * @param matrix the matrix.
+     * @return the frame.
+     * @throws std::runtime_error if the matrix's value does not match its dim.
+     */
+    static NTNDArrayPtr toNTNDArray(NTMatrixPtr const & matrix);
+
+private:
+    // disable object creation
+    NTNDArrayMatrix() {}
+};
+
+}}
+#endif  /* NTNDARRAYMATRIX_H */
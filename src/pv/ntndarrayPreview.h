@@ -0,0 +1,114 @@
+/* ntndarrayPreview.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYPREVIEW_H
+#define NTNDARRAYPREVIEW_H
+
+#include <vector>
+
+#include <pv/ntndarray.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTNDArrayPreview;
+typedef std::tr1::shared_ptr<NTNDArrayPreview> NTNDArrayPreviewPtr;
+
+/**
+ * @brief Generates small 8-bit previews of NTNDArray images.
+ *
+ * generate() reads the image once, downscaling it by an integer factor
+ * with area averaging so that it fits the maximum preview size, then
+ * maps the downscaled values to 0..255 through a window and stores them
+ * in the ubyteValue member of a new NTNDArray.
+ * <p>
+ * The window is either the minimum and maximum of the downscaled values
+ * or a pair of their percentiles, which ignores hot pixels. Values below
+ * the window map to 0, values above it to 255.
+ * <p>
+ * The preview's dimension field holds the downscaled size, with binning
+ * multiplied by the downscaling factor; uniqueId and dataTimeStamp are
+ * taken over from the image. Its descriptor records the scaling, e.g.
+ * "preview binning=4 type=ushort window=[112,3971]", followed by
+ * " percentile=[1,99]" for a percentile window. The preview can be
+ * compressed with NTNDArrayTiledCodec.
+ * <p>
+ * The image must be uncompressed and have a numeric value. Dimension 0 is
+ * the width, dimension 1, if present, the height; further dimensions must
+ * have size 1. A generator is not thread safe.
+ */
+class epicsShareClass NTNDArrayPreview
+{
+public:
+    POINTER_DEFINITIONS(NTNDArrayPreview);
+
+    /**
+     * Creates a preview generator.
+     * @param maxWidth the maximum width of previews.
+     * @param maxHeight the maximum height of previews.
+     * @return a new generator.
+     * @throws std::runtime_error if a maximum size is 0.
+     */
+    static shared_pointer create(size_t maxWidth, size_t maxHeight);
+
+    /**
+     * Destructor.
+     */
+    ~NTNDArrayPreview() {}
+
+    /**
+     * Uses the minimum and maximum values as the window. This is the default.
+     */
+    void setMinMaxWindow();
+
+    /**
+     * Uses percentiles of the values as the window.
+     * @param low the percentile mapped to 0, from 0 to 100.
+     * @param high the percentile mapped to 255, from low to 100.
+     * @throws std::runtime_error if the percentiles are out of range.
+     */
+    void setPercentileWindow(double low, double high);
+
+    /**
+     * Sets whether previews are compressed with NTNDArrayTiledCodec.
+     * @param compressed true to compress.
+     */
+    void setCompressed(bool compressed) { this->compressed = compressed; }
+
+    /**
+     * Returns whether previews are compressed.
+     * @return true if compressed.
+     */
+    bool isCompressed() const { return compressed; }
+
+    /**
+     * Generates the preview of an image.
+     * @param ntndArray the image, which is not modified.
+     * @return a new NTNDArray with a ubyte value and a descriptor.
+     * @throws std::runtime_error if the image is compressed, not numeric
+     *         or not two-dimensional.
+     */
+    NTNDArrayPtr generate(NTNDArrayPtr const & ntndArray);
+
+private:
+    NTNDArrayPreview(size_t maxWidth, size_t maxHeight);
+
+    size_t maxWidth;
+    size_t maxHeight;
+    bool percentile;
+    double lowPercentile;
+    double highPercentile;
+    bool compressed;
+
+    // downscaled values and scratch space, kept between calls
+    std::vector<double> values;
+    std::vector<double> rowSum;
+    std::vector<double> sorted;
+};
+
+}}
+#endif  /* NTNDARRAYPREVIEW_H */
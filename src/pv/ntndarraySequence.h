@@ -0,0 +1,190 @@
+/* ntndarraySequence.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYSEQUENCE_H
+#define NTNDARRAYSEQUENCE_H
+
+#include <cstddef>
+
+#ifdef epicsExportSharedSymbols
+#   define ntndarraySequenceEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/timeStamp.h>
+
+#ifdef ntndarraySequenceEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntndarraySequenceEpicsExportSharedSymbols
+#endif
+
+#include <pv/ntndarray.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTNDArraySequenceTracker;
+typedef std::tr1::shared_ptr<NTNDArraySequenceTracker> NTNDArraySequenceTrackerPtr;
+
+/**
+ * @brief Tracks the uniqueId sequence of a stream of NTNDArrays.
+ *
+ * Each frame passed to update() is classified as in order, following
+ * a gap (dropped frames), a duplicate or a late (reordered) frame.
+ * The latency between the dataTimeStamp of each frame and its receive
+ * time is also recorded.
+ * <p>
+ * update() must only be called by one thread at a time (the consumer
+ * of the stream). The counters are updated atomically and may be read
+ * from any thread without locking, e.g. by monitoring code.
+ * <p>
+ * The last 64 uniqueIds are remembered, so a late frame is recognised
+ * as reordered (and removed from the dropped count) or as a duplicate.
+ * A uniqueId further behind than this is treated as a restart of the
+ * stream if it is closer to 0 than to the last uniqueId, and otherwise
+ * counted as reordered, without being checked for duplication.
+ */
+class epicsShareClass NTNDArraySequenceTracker
+{
+public:
+    POINTER_DEFINITIONS(NTNDArraySequenceTracker);
+
+    /**
+     * Classification of a frame passed to update().
+     */
+    enum Result {
+        /** First frame, or first frame after a restart of the stream */
+        first,
+        /** uniqueId follows the previous one */
+        inOrder,
+        /** uniqueId is ahead of the expected one, frames were dropped */
+        dropped,
+        /** uniqueId has already been received */
+        duplicate,
+        /** uniqueId is behind the last one but has not been received */
+        reordered
+    };
+
+    /**
+     * Creates a tracker instance.
+     * @return a new tracker instance.
+     */
+    static shared_pointer create();
+
+    /**
+     * Destructor.
+     */
+    ~NTNDArraySequenceTracker() {}
+
+    /**
+     * Records a received frame, using the current time as receive time.
+     * @param ntndArray the received frame.
+     * @return the classification of the frame.
+     */
+    Result update(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Records a received frame.
+     * @param ntndArray the received frame.
+     * @param receiveTime the time at which the frame was received.
+     * @return the classification of the frame.
+     */
+    Result update(NTNDArrayPtr const & ntndArray,
+        epics::pvData::TimeStamp const & receiveTime);
+
+    /**
+     * Records a received frame given by its uniqueId and dataTimeStamp.
+     * @param uniqueId the uniqueId of the frame.
+     * @param dataTimeStamp the dataTimeStamp of the frame.
+     * @param receiveTime the time at which the frame was received.
+     * @return the classification of the frame.
+     */
+    Result update(epics::pvData::int32 uniqueId,
+        epics::pvData::TimeStamp const & dataTimeStamp,
+        epics::pvData::TimeStamp const & receiveTime);
+
+    /**
+     * Clears all counters and the sequence state.
+     * Must not be called concurrently with update().
+     */
+    void reset();
+
+    /**
+     * Returns the number of frames passed to update().
+     * @return the number of frames.
+     */
+    size_t getFrames() const;
+
+    /**
+     * Returns the number of frames missing from the sequence.
+     * Frames arriving late are subtracted again.
+     * @return the number of dropped frames.
+     */
+    size_t getDropped() const;
+
+    /**
+     * Returns the number of frames whose uniqueId had already been received.
+     * @return the number of duplicated frames.
+     */
+    size_t getDuplicated() const;
+
+    /**
+     * Returns the number of frames that arrived after a later uniqueId.
+     * @return the number of reordered frames.
+     */
+    size_t getReordered() const;
+
+    /**
+     * Returns the number of times the stream restarted,
+     * i.e. the uniqueId went back beyond the reorder window to a small
+     * value.
+     * @return the number of restarts.
+     */
+    size_t getRestarts() const;
+
+    /**
+     * Returns the latency of the last frame, i.e. the time between its
+     * dataTimeStamp and its receive time.
+     * Negative latencies (clock skew) are reported as 0.
+     * @return the latency in microseconds.
+     */
+    size_t getLastLatency() const;
+
+    /**
+     * Returns the smallest latency since creation or the last reset.
+     * @return the latency in microseconds.
+     */
+    size_t getMinLatency() const;
+
+    /**
+     * Returns the largest latency since creation or the last reset.
+     * @return the latency in microseconds.
+     */
+    size_t getMaxLatency() const;
+
+private:
+    NTNDArraySequenceTracker();
+
+    // consumer state, only accessed by update() and reset()
+    bool started;
+    epics::pvData::uint32 lastId;
+    epics::pvData::uint64 history;
+    epics::pvData::uint32 tracked;
+
+    // counters, accessed atomically
+    size_t frames;
+    size_t droppedFrames;
+    size_t duplicatedFrames;
+    size_t reorderedFrames;
+    size_t restarts;
+    size_t lastLatency;
+    size_t minLatency;
+    size_t maxLatency;
+};
+
+}}
+#endif  /* NTNDARRAYSEQUENCE_H */
@@ -0,0 +1,228 @@
+/* ntndarrayTiling.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYTILING_H
+#define NTNDARRAYTILING_H
+
+#include <string>
+#include <vector>
+
+#include <pv/ntndarray.h>
+#include <pv/ntndarrayBufferPool.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTNDArrayTiling;
+typedef std::tr1::shared_ptr<NTNDArrayTiling> NTNDArrayTilingPtr;
+
+/**
+ * @brief Division of an N-dimensional array into fixed size tiles.
+ *
+ * The array layout follows the NTNDArray dimension field: dimension 0
+ * varies fastest. Tiles are numbered in the same order, i.e. the tile
+ * index increases fastest along dimension 0. Tiles at the upper edge of
+ * a dimension are smaller if the tile size does not divide the size of
+ * the dimension.
+ * <p>
+ * Tiles can be processed in parallel with NTParallel::forEach(), copying
+ * them out of and back into the array with extract() and insert().
+ */
+class epicsShareClass NTNDArrayTiling
+{
+public:
+    POINTER_DEFINITIONS(NTNDArrayTiling);
+
+    /**
+     * Creates a tiling of an array.
+     * @param sizes the size of each dimension of the array.
+     * @param tileSizes the tile size in each dimension; a missing or zero
+     *        entry spans the whole dimension.
+     * @return a new tiling.
+     * @throws std::runtime_error if sizes is empty.
+     */
+    static shared_pointer create(std::vector<size_t> const & sizes,
+        std::vector<size_t> const & tileSizes);
+
+    /**
+     * Creates a tiling of the value of an NTNDArray, using the sizes in
+     * its dimension field.
+     * @param ntndArray the NTNDArray.
+     * @param tileSizes the tile size in each dimension; a missing or zero
+     *        entry spans the whole dimension.
+     * @return a new tiling.
+     * @throws std::runtime_error if the dimension field is empty or invalid.
+     */
+    static shared_pointer create(NTNDArrayPtr const & ntndArray,
+        std::vector<size_t> const & tileSizes);
+
+    /**
+     * Destructor.
+     */
+    ~NTNDArrayTiling() {}
+
+    /**
+     * Returns the size of each dimension of the array.
+     * @return the sizes.
+     */
+    std::vector<size_t> const & getSizes() const { return sizes; }
+
+    /**
+     * Returns the tile size in each dimension.
+     * @return the tile sizes.
+     */
+    std::vector<size_t> const & getTileSizes() const { return tileSizes; }
+
+    /**
+     * Returns the number of elements of the array.
+     * @return the number of elements.
+     */
+    size_t getElementCount() const { return elementCount; }
+
+    /**
+     * Returns the number of tiles.
+     * @return the number of tiles.
+     */
+    size_t getTileCount() const { return tileCount; }
+
+    /**
+     * Returns the position and size of a tile.
+     * @param index the index of the tile.
+     * @param offset set to the offset of the tile in each dimension.
+     * @param size set to the size of the tile in each dimension.
+     */
+    void getTile(size_t index, std::vector<size_t> & offset,
+        std::vector<size_t> & size) const;
+
+    /**
+     * Returns the number of elements of a tile.
+     * @param index the index of the tile.
+     * @return the number of elements.
+     */
+    size_t getTileElementCount(size_t index) const;
+
+    /**
+     * Copies a tile out of an array into a contiguous buffer, in which the
+     * tile is laid out as an array of the tile's size.
+     * @param array the array data.
+     * @param elementSize the size of an array element in bytes.
+     * @param index the index of the tile.
+     * @param tile the buffer, getTileElementCount(index) elements long.
+     */
+    void extract(const void * array, size_t elementSize, size_t index,
+        void * tile) const;
+
+    /**
+     * Copies a contiguous tile buffer into an array.
+     * The reverse of extract().
+     * @param tile the buffer.
+     * @param elementSize the size of an array element in bytes.
+     * @param index the index of the tile.
+     * @param array the array data.
+     */
+    void insert(const void * tile, size_t elementSize, size_t index,
+        void * array) const;
+
+private:
+    NTNDArrayTiling(std::vector<size_t> const & sizes,
+        std::vector<size_t> const & tileSizes);
+    void copy(size_t index, size_t elementSize, const epics::pvData::uint8 * src,
+        epics::pvData::uint8 * dst, bool toTile) const;
+
+    std::vector<size_t> sizes;
+    std::vector<size_t> tileSizes;
+    std::vector<size_t> tileCounts;
+    size_t elementCount;
+    size_t tileCount;
+};
+
+/**
+ * @brief Codec compressing the tiles of an NTNDArray independently.
+ *
+ * Each tile of the value is byte shuffled (the first bytes of all
+ * elements, then the second bytes, ...) and packed with the zero-run
+ * packing of NTNDArrayDeltaCodec against a zero reference. This suits
+ * images in which most pixels use few significant bits. Since tiles are
+ * independent they are encoded and decoded in parallel and single tiles
+ * can be decoded without decoding the whole frame.
+ * <p>
+ * The encoded payload is stored in the ubyteValue member of the value
+ * union and codec.name is set to "tiled". codec.parameters holds a
+ * structure with the fields
+ * <ul>
+ *   <li>elementType (int): the ScalarType of the decoded value</li>
+ *   <li>tileSize (int[]): the tile size in each dimension</li>
+ *   <li>tileOffset (long[]): the offset of each tile in the payload,
+ *       followed by the payload size</li>
+ * </ul>
+ * The dimension field is left unchanged.
+ */
+class epicsShareClass NTNDArrayTiledCodec
+{
+public:
+    /**
+     * The codec name, "tiled".
+     */
+    static const std::string name;
+
+    /**
+     * Returns the structure of the codec.parameters field of encoded frames.
+     * @return the parameters structure.
+     */
+    static epics::pvData::StructureConstPtr getParametersStructure();
+
+    /**
+     * Encodes a frame in place.
+     * @param ntndArray an uncompressed frame (empty codec.name) with a
+     *        numeric value matching its dimension field.
+     * @param tileSizes the tile size in each dimension; a missing or zero
+     *        entry spans the whole dimension.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @throws std::runtime_error if the frame cannot be encoded.
+     */
+    static void encode(NTNDArrayPtr const & ntndArray,
+        std::vector<size_t> const & tileSizes, size_t maxThreads = 0);
+
+    /**
+     * Decodes a frame in place.
+     * Frames with an empty codec.name are left unchanged.
+     * @param ntndArray the frame.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @param pool the pool to allocate the decoded value from, or null.
+     * @throws std::runtime_error for another codec or a corrupt frame.
+     */
+    static void decode(NTNDArrayPtr const & ntndArray, size_t maxThreads = 0,
+        NTNDArrayBufferPoolPtr const & pool = NTNDArrayBufferPoolPtr());
+
+    /**
+     * Returns the tiling of an encoded frame.
+     * @param ntndArray the frame.
+     * @return the tiling.
+     * @throws std::runtime_error if the frame is not encoded with this codec.
+     */
+    static NTNDArrayTilingPtr getTiling(NTNDArrayPtr const & ntndArray);
+
+    /**
+     * Decodes a single tile of an encoded frame.
+     * The result is an uncompressed NTNDArray holding the tile, with the
+     * offset in its dimension field set to the position of the tile.
+     * uniqueId, dataTimeStamp and attribute are taken over from the frame.
+     * @param ntndArray the frame.
+     * @param index the index of the tile.
+     * @return a new NTNDArray.
+     * @throws std::runtime_error if the frame is not encoded with this
+     *         codec or is corrupt.
+     */
+    static NTNDArrayPtr decodeTile(NTNDArrayPtr const & ntndArray, size_t index);
+
+private:
+    // disable object creation
+    NTNDArrayTiledCodec() {}
+};
+
+}}
+#endif  /* NTNDARRAYTILING_H */
@@ -0,0 +1,70 @@
+/* ntparallel.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTPARALLEL_H
+#define NTPARALLEL_H
+
+#include <cstddef>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief Data parallel execution of work items on a shared thread pool.
+ *
+ * The pool is created on first use with one thread less than the number
+ * of CPUs; the calling thread takes part in the work. Only one forEach()
+ * runs on the pool at a time. A forEach() called while the pool is busy,
+ * from another thread or from within a task, runs its items on the
+ * calling thread.
+ */
+class epicsShareClass NTParallel {
+public:
+
+    /**
+     * @brief Work executed by forEach().
+     */
+    class epicsShareClass Task {
+    public:
+        virtual ~Task() {}
+
+        /**
+         * Processes one work item. Called concurrently for different
+         * items, each exactly once.
+         * @param index the index of the item.
+         */
+        virtual void run(size_t index) = 0;
+    };
+
+    /**
+     * Runs task.run(i) for each i from 0 to count - 1 and waits for
+     * completion.
+     * If an item throws, remaining items are skipped and, once all threads
+     * have finished, a std::runtime_error with the message of the first
+     * exception is thrown.
+     * @param count the number of work items.
+     * @param task the work.
+     * @param maxThreads the maximum number of threads to use, including
+     *        the calling thread; 0 for no limit.
+     */
+    static void forEach(size_t count, Task & task, size_t maxThreads = 0);
+
+    /**
+     * Returns the number of threads forEach() can use, including the
+     * calling thread.
+     * @return the number of threads.
+     */
+    static size_t getConcurrency();
+
+private:
+    // disable object creation
+    NTParallel() {}
+};
+
+}}
+
+#endif  /* NTPARALLEL_H */
@@ -7,6 +7,8 @@
 #ifndef NTSCALAR_H
 #define NTSCALAR_H
 
+#include <vector>
+
 #ifdef epicsExportSharedSymbols
 #   define ntscalarEpicsExportSharedSymbols
 #   undef epicsExportSharedSymbols
@@ -102,6 +104,15 @@ namespace detail {
          */
         NTScalarPtr create();
 
+        /**
+         * Creates a number of <b>NTScalar</b> instances of the same type.
+         * The type is built once, rather than once for each instance.
+         * This resets this instance state and allows new instance to be created.
+         * @param count the number of instances.
+         * @return the new instances.
+         */
+        std::vector<NTScalarPtr> create(size_t count);
+
         /**
          * Adds extra <b>Field</b> to the type.
          * @param name the name of the field.
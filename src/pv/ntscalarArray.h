@@ -7,6 +7,8 @@
 #ifndef NTSCALARARRAY_H
 #define NTSCALARARRAY_H
 
+#include <vector>
+
 #ifdef epicsExportSharedSymbols
 #   define ntscalarArrayEpicsExportSharedSymbols
 #   undef epicsExportSharedSymbols
@@ -111,6 +113,15 @@ namespace detail {
          */
         NTScalarArrayPtr create();
 
+        /**
+         * Creates a number of <b>NTScalarArray</b> instances of the same type.
+         * The type is built once, rather than once for each instance.
+         * This resets this instance state and allows new instance to be created.
+         * @param count the number of instances.
+         * @return the new instances.
+         */
+        std::vector<NTScalarArrayPtr> create(size_t count);
+
         /**
          * Adds extra <b>Field</b> to the type.
          * @param name the name of the field.
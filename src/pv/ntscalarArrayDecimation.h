@@ -0,0 +1,105 @@
+/* ntscalarArrayDecimation.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTSCALARARRAYDECIMATION_H
+#define NTSCALARARRAYDECIMATION_H
+
+#include <pv/ntscalarArray.h>
+#include <pv/nttable.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief Decimation and resampling of NTScalarArray waveforms for display.
+ *
+ * Each operation reduces a waveform of any length to about the number of
+ * points a client plots. The x coordinate of a sample is its index in
+ * the source array.
+ * <p>
+ * The descriptor, alarm and timeStamp of the source are copied to the
+ * result where present. Large waveforms are processed in parallel; the
+ * maxThreads argument limits the number of threads used, 0 for no limit.
+ * <p>
+ * The value of the source must be a numeric array.
+ */
+class epicsShareClass NTScalarArrayDecimation
+{
+public:
+    /**
+     * Interpolation used by resample().
+     */
+    enum Interpolation {
+        /** Straight line between neighbouring samples */
+        linear,
+        /** Catmull-Rom cubic through the four nearest samples */
+        cubic
+    };
+
+    /**
+     * Computes the minimum and maximum of each of a number of buckets of
+     * equal size.
+     * @param source the source.
+     * @param buckets the number of buckets; the number of elements is used
+     *        if this is larger.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return an NTTable with double columns x (the centre of the bucket),
+     *         min and max.
+     * @throws std::runtime_error if the value is not numeric.
+     */
+    static NTTablePtr envelope(NTScalarArrayPtr const & source, size_t buckets,
+        size_t maxThreads = 0);
+
+    /**
+     * Keeps the minimum and the maximum of each of a number of buckets of
+     * equal size, in the order in which they occur, so that a line through
+     * the result looks like a line through the source.
+     * @param source the source.
+     * @param buckets the number of buckets.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return an NTScalarArray with 2*buckets values of the source's element
+     *         type, or the values of the source if there are not more of them.
+     * @throws std::runtime_error if the value is not numeric.
+     */
+    static NTScalarArrayPtr minMax(NTScalarArrayPtr const & source, size_t buckets,
+        size_t maxThreads = 0);
+
+    /**
+     * Selects the samples that best preserve the shape of the waveform,
+     * using the Largest-Triangle-Three-Buckets algorithm. The first and
+     * the last sample are always selected.
+     * @param source the source.
+     * @param points the number of samples to select, at least 3.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return an NTTable with double columns x and y of the selected
+     *         samples, all samples if there are not more than points.
+     * @throws std::runtime_error if the value is not numeric or points < 3.
+     */
+    static NTTablePtr lttb(NTScalarArrayPtr const & source, size_t points,
+        size_t maxThreads = 0);
+
+    /**
+     * Samples the waveform at equally spaced positions from the first to
+     * the last element.
+     * @param source the source.
+     * @param points the number of points.
+     * @param interpolation the interpolation between elements.
+     * @param maxThreads the maximum number of threads to use; 0 for no limit.
+     * @return an NTScalarArray with a double value of points elements;
+     *         empty if the source is empty.
+     * @throws std::runtime_error if the value is not numeric.
+     */
+    static NTScalarArrayPtr resample(NTScalarArrayPtr const & source, size_t points,
+        Interpolation interpolation = linear, size_t maxThreads = 0);
+
+private:
+    // disable object creation
+    NTScalarArrayDecimation() {}
+};
+
+}}
+#endif  /* NTSCALARARRAYDECIMATION_H */
@@ -0,0 +1,283 @@
+/* ntscalarArrayHistory.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTSCALARARRAYHISTORY_H
+#define NTSCALARARRAYHISTORY_H
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef epicsExportSharedSymbols
+#   define ntscalarArrayHistoryEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/pvData.h>
+#include <pv/timeStamp.h>
+#include <pv/pvTimeStamp.h>
+
+#ifdef ntscalarArrayHistoryEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntscalarArrayHistoryEpicsExportSharedSymbols
+#endif
+
+#include <pv/ntscalarArray.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief History of the last samples of a scalar, published as NTScalarArray.
+ *
+ * Samples are pushed one at a time; once the capacity is reached each
+ * push discards the oldest sample. getValues() and publish() return the
+ * samples, oldest first, without copying: the published array shares the
+ * storage of the history.
+ * <p>
+ * The storage holds twice the capacity, so that the samples kept are
+ * always contiguous. When the end of the storage is reached the samples
+ * are moved to its start, a single copy every capacity pushes. The
+ * history never writes to storage visible in a published array: if a
+ * published array still shares the storage it is moved to new storage
+ * instead. Published arrays therefore never change and may be handed to
+ * other threads without locking.
+ * <p>
+ * Optionally, the timeStamp of each sample is kept in arrays parallel to
+ * the values.
+ * <p>
+ * A history must only be used by one thread at a time, typically the
+ * one receiving the samples.
+ *
+ * @tparam PVT the numeric PVScalarArray type of the value, e.g.
+ *         PVDoubleArray.
+ */
+template<typename PVT>
+class NTScalarArrayHistory
+{
+public:
+    POINTER_DEFINITIONS(NTScalarArrayHistory);
+
+    typedef typename PVT::value_type value_type;
+    typedef typename PVT::svector svector;
+    typedef typename PVT::const_svector const_svector;
+
+    /**
+     * Creates a history.
+     * @param capacity the number of samples kept.
+     * @param trackTimeStamps whether to keep the timeStamp of each sample.
+     * @return a new history.
+     * @throws std::runtime_error if capacity is 0.
+     */
+    static shared_pointer create(size_t capacity, bool trackTimeStamps = false)
+    {
+        if (capacity == 0)
+            throw std::runtime_error("history capacity must not be 0");
+        return shared_pointer(new NTScalarArrayHistory(capacity, trackTimeStamps));
+    }
+
+    /**
+     * Appends a sample. If timeStamps are tracked the sample is stamped
+     * with the current time.
+     * @param value the value.
+     */
+    void push(value_type value)
+    {
+        if (trackTimeStamps)
+        {
+            epics::pvData::TimeStamp timeStamp;
+            timeStamp.getCurrent();
+            push(value, timeStamp);
+            return;
+        }
+
+        if (end == values.size())
+            shift();
+        values[end] = value;
+        advance();
+    }
+
+    /**
+     * Appends a sample.
+     * @param value the value.
+     * @param timeStamp the timeStamp of the sample. It is kept for each
+     *        sample if timeStamps are tracked, and published as the
+     *        timeStamp of the history otherwise.
+     */
+    void push(value_type value, epics::pvData::TimeStamp const & timeStamp)
+    {
+        if (end == values.size())
+            shift();
+        values[end] = value;
+        if (trackTimeStamps)
+        {
+            secondsPastEpoch[end] = timeStamp.getSecondsPastEpoch();
+            nanoseconds[end] = timeStamp.getNanoseconds();
+        }
+        latest = timeStamp;
+        stamped = true;
+        advance();
+    }
+
+    /**
+     * Discards all samples.
+     */
+    void clear()
+    {
+        // replaces storage still shared with published arrays
+        first = end;
+        shift();
+        stamped = false;
+    }
+
+    /**
+     * Returns the number of samples kept when the history is full.
+     * @return the capacity.
+     */
+    size_t getCapacity() const { return capacity; }
+
+    /**
+     * Returns the number of samples held.
+     * @return the number of samples, at most the capacity.
+     */
+    size_t getSize() const { return end - first; }
+
+    /**
+     * Returns whether the timeStamp of each sample is kept.
+     * @return true if timeStamps are tracked.
+     */
+    bool isTrackingTimeStamps() const { return trackTimeStamps; }
+
+    /**
+     * Returns the values of the samples, oldest first, without copying.
+     * @return the values.
+     */
+    const_svector getValues() const
+    {
+        return window(values);
+    }
+
+    /**
+     * Returns the seconds of the timeStamps of the samples, parallel to
+     * getValues().
+     * @return the secondsPastEpoch; empty unless timeStamps are tracked.
+     */
+    epics::pvData::PVLongArray::const_svector getSecondsPastEpoch() const
+    {
+        return window(secondsPastEpoch);
+    }
+
+    /**
+     * Returns the nanoseconds of the timeStamps of the samples, parallel
+     * to getValues().
+     * @return the nanoseconds; empty unless timeStamps are tracked.
+     */
+    epics::pvData::PVIntArray::const_svector getNanoseconds() const
+    {
+        return window(nanoseconds);
+    }
+
+    /**
+     * Creates an NTScalarArray suitable for publish(), with a value of
+     * the history's type and a timeStamp.
+     * @return a new NTScalarArray.
+     */
+    NTScalarArrayPtr createNTScalarArray() const
+    {
+        return NTScalarArray::createBuilder()->
+            value(PVT::typeCode)->
+            addTimeStamp()->
+            create();
+    }
+
+    /**
+     * Publishes the samples as the value of an NTScalarArray, without
+     * copying. If the NTScalarArray has a timeStamp it is set to the
+     * timeStamp of the newest sample pushed with one.
+     * @param ntScalarArray the NTScalarArray.
+     * @throws std::runtime_error if its value is not of the history's type.
+     */
+    void publish(NTScalarArrayPtr const & ntScalarArray) const
+    {
+        std::tr1::shared_ptr<PVT> pvValue = ntScalarArray->getValue<PVT>();
+        if (!pvValue.get())
+            throw std::runtime_error("NTScalarArray value does not have the history's type");
+        pvValue->replace(getValues());
+
+        epics::pvData::PVTimeStamp pvTimeStamp;
+        if (stamped && ntScalarArray->attachTimeStamp(pvTimeStamp))
+            pvTimeStamp.set(latest);
+    }
+
+private:
+    NTScalarArrayHistory(size_t capacity, bool trackTimeStamps) :
+        capacity(capacity),
+        trackTimeStamps(trackTimeStamps),
+        first(0),
+        end(0),
+        stamped(false)
+    {
+        shift();
+    }
+
+    void advance()
+    {
+        ++end;
+        if (end - first > capacity)
+            ++first;
+    }
+
+    // moves the samples to the start of the storage, or to new storage
+    void shift()
+    {
+        move(values);
+        if (trackTimeStamps)
+        {
+            move(secondsPastEpoch);
+            move(nanoseconds);
+        }
+        end -= first;
+        first = 0;
+    }
+
+    template<typename T>
+    void move(epics::pvData::shared_vector<T> & data) const
+    {
+        if (data.empty() || !data.unique())
+        {
+            epics::pvData::shared_vector<T> storage(2*capacity);
+            if (!data.empty())
+                std::copy(data.begin() + first, data.begin() + end, storage.begin());
+            data.swap(storage);
+        }
+        else if (first > 0)
+        {
+            std::copy(data.begin() + first, data.begin() + end, data.begin());
+        }
+    }
+
+    template<typename T>
+    epics::pvData::shared_vector<const T> window(
+        epics::pvData::shared_vector<T> const & data) const
+    {
+        if (data.empty() || end == first)
+            return epics::pvData::shared_vector<const T>();
+        return epics::pvData::shared_vector<const T>(data.dataPtr(),
+            data.dataOffset() + first, end - first);
+    }
+
+    size_t capacity;
+    bool trackTimeStamps;
+    svector values;
+    epics::pvData::PVLongArray::svector secondsPastEpoch;
+    epics::pvData::PVIntArray::svector nanoseconds;
+    // the samples are [first, end) of the storage
+    size_t first;
+    size_t end;
+    epics::pvData::TimeStamp latest;
+    bool stamped;
+};
+
+}}
+#endif  /* NTSCALARARRAYHISTORY_H */
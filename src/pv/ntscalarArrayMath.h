@@ -0,0 +1,129 @@
+/* ntscalarArrayMath.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTSCALARARRAYMATH_H
+#define NTSCALARARRAYMATH_H
+
+#include <pv/ntscalarArray.h>
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief Element-wise transforms and reductions of NTScalarArray values.
+ *
+ * The element types of the source and the result are dispatched once per
+ * call, so that each combination runs a loop specialized for its types
+ * which the compiler can vectorize. Values are transformed in double
+ * precision; results of integer type are rounded to the nearest integer
+ * and saturated to the range of the type, and results of pvBoolean are
+ * true for any value other than 0 and NaN.
+ * <p>
+ * A transform writes its result to a new NTScalarArray or, if one is
+ * specified, to an existing one whose value array is recycled when it is
+ * not shared. The descriptor, alarm, timeStamp, display and control fields
+ * of the source are copied to the result where both have them. The
+ * display and control limits pass through the same transform as the
+ * values, so that they remain meaningful, e.g. after a unit conversion.
+ * <p>
+ * The value of the source must be a numeric array.
+ */
+class epicsShareClass NTScalarArrayMath
+{
+public:
+    /**
+     * Computes scale*x + offset for each element x.
+     * @param source the source.
+     * @param scale the scale.
+     * @param offset the offset.
+     * @param elementType the element type of the result.
+     * @param result an NTScalarArray with a value of elementType to
+     *        recycle, or null to create a new one.
+     * @return the result.
+     * @throws std::runtime_error if a value is not numeric or the value of
+     *         result is not of elementType.
+     */
+    static NTScalarArrayPtr linear(NTScalarArrayPtr const & source,
+        double scale, double offset, epics::pvData::ScalarType elementType,
+        NTScalarArrayPtr const & result = NTScalarArrayPtr());
+
+    /**
+     * Limits each element to a range, keeping the element type.
+     * @param source the source.
+     * @param low the lower limit.
+     * @param high the upper limit, not less than low.
+     * @param result an NTScalarArray with a value of the source's element
+     *        type to recycle, or null to create a new one.
+     * @return the result.
+     * @throws std::runtime_error if a value is not numeric, the value of
+     *         result is not of the source's element type or high < low.
+     */
+    static NTScalarArrayPtr clamp(NTScalarArrayPtr const & source,
+        double low, double high,
+        NTScalarArrayPtr const & result = NTScalarArrayPtr());
+
+    /**
+     * Converts each element to another element type.
+     * @param source the source.
+     * @param elementType the element type of the result.
+     * @param result an NTScalarArray with a value of elementType to
+     *        recycle, or null to create a new one.
+     * @return the result.
+     * @throws std::runtime_error if a value is not numeric or the value of
+     *         result is not of elementType.
+     */
+    static NTScalarArrayPtr cast(NTScalarArrayPtr const & source,
+        epics::pvData::ScalarType elementType,
+        NTScalarArrayPtr const & result = NTScalarArrayPtr());
+
+    /**
+     * Returns the sum of the elements.
+     * @param source the source.
+     * @return the sum; 0 for an empty array.
+     * @throws std::runtime_error if the value is not numeric.
+     */
+    static double sum(NTScalarArrayPtr const & source);
+
+    /**
+     * Returns the mean of the elements.
+     * @param source the source.
+     * @return the mean; NaN for an empty array.
+     * @throws std::runtime_error if the value is not numeric.
+     */
+    static double mean(NTScalarArrayPtr const & source);
+
+    /**
+     * Returns the smallest element.
+     * @param source the source.
+     * @return the smallest element; NaN for an empty array.
+     * @throws std::runtime_error if the value is not numeric.
+     */
+    static double minimum(NTScalarArrayPtr const & source);
+
+    /**
+     * Returns the largest element.
+     * @param source the source.
+     * @return the largest element; NaN for an empty array.
+     * @throws std::runtime_error if the value is not numeric.
+     */
+    static double maximum(NTScalarArrayPtr const & source);
+
+    /**
+     * Returns the index of the largest element.
+     * @param source the source.
+     * @return the index of the first occurrence of the largest element.
+     * @throws std::runtime_error if the value is not numeric or is empty.
+     */
+    static size_t argmax(NTScalarArrayPtr const & source);
+
+private:
+    // disable object creation
+    NTScalarArrayMath() {}
+};
+
+}}
+#endif  /* NTSCALARARRAYMATH_H */
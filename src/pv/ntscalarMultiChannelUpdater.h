@@ -0,0 +1,264 @@
+/* ntscalarMultiChannelUpdater.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTSCALARMULTICHANNELUPDATER_H
+#define NTSCALARMULTICHANNELUPDATER_H
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef epicsExportSharedSymbols
+#   define ntscalarMultiChannelUpdaterEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/pvData.h>
+#include <pv/alarm.h>
+#include <pv/timeStamp.h>
+
+#ifdef ntscalarMultiChannelUpdaterEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntscalarMultiChannelUpdaterEpicsExportSharedSymbols
+#endif
+
+#include <pv/ntscalarMultiChannel.h>
+
+namespace epics { namespace nt {
+
+namespace detail {
+
+    /**
+     * @brief Staging buffer of one array field of an NTScalarMultiChannel.
+     *
+     * commit() copies the staged elements to the buffer published two
+     * commits before, if no longer referenced, so that in the steady state
+     * no storage is allocated.
+     */
+    template<typename PVT>
+    class NTMultiChannelColumn
+    {
+    public:
+        typedef typename PVT::value_type value_type;
+        typedef typename PVT::svector svector;
+        typedef typename PVT::const_svector const_svector;
+
+        void attach(std::tr1::shared_ptr<PVT> const & pvArray, size_t count)
+        {
+            this->pvArray = pvArray;
+            if (!pvArray.get())
+                return;
+            published = pvArray->view();
+            staging = svector(count, value_type());
+            if (published.size() == count)
+                std::copy(published.begin(), published.end(), staging.begin());
+        }
+
+        bool isPresent() const { return pvArray.get() != 0; }
+
+        value_type & operator[](size_t index) { return staging[index]; }
+
+        void commit()
+        {
+            if (!pvArray.get())
+                return;
+            svector next;
+            if (spare.unique() && spare.size() == staging.size())
+                next = thaw(spare);
+            else
+                next = svector(staging.size());
+            std::copy(staging.begin(), staging.end(), next.begin());
+            const_svector frozen(freeze(next));
+            pvArray->replace(frozen);
+            spare.swap(published);
+            published.swap(frozen);
+        }
+
+    private:
+        std::tr1::shared_ptr<PVT> pvArray;
+        svector staging;
+        // the last buffer published, and the one published before it
+        const_svector published;
+        const_svector spare;
+    };
+
+}
+
+/**
+ * @brief Bulk updater of the channels of an NTScalarMultiChannel.
+ *
+ * Updating one channel of an NTScalarMultiChannel directly requires a
+ * copy of each of its arrays, since published arrays must not change.
+ * The updater instead stages the value, alarm, timeStamp and isConnected
+ * of every channel in mutable arrays, one for each field, and commit()
+ * publishes all of them in one step, with the length of channelName, so
+ * that isValid() holds:
+ * <pre>
+ * NTScalarMultiChannelUpdater<PVDoubleArray>::shared_pointer updater =
+ *     NTScalarMultiChannelUpdater<PVDoubleArray>::create(ntScalarMultiChannel);
+ * ...
+ * updater->update(channel, value, alarm, timeStamp);  // for each update
+ * ...
+ * updater->commit();     // e.g. periodically, then post the monitor
+ * </pre>
+ * Each update writes only the elements of its channel, so different
+ * channels may be updated by different threads without locking, e.g. one
+ * thread per group of channels. commit() must not run concurrently with
+ * updates, and the threads must be synchronised with it, e.g. by the lock
+ * held when posting the monitor.
+ * <p>
+ * Fields the NTScalarMultiChannel does not have are not updated. The
+ * arrays are initialised from the NTScalarMultiChannel if they already
+ * have the length of channelName.
+ *
+ * @tparam PVT the PVScalarArray type of the value, e.g. PVDoubleArray.
+ */
+template<typename PVT>
+class NTScalarMultiChannelUpdater
+{
+public:
+    POINTER_DEFINITIONS(NTScalarMultiChannelUpdater);
+
+    typedef typename PVT::value_type value_type;
+
+    /**
+     * Creates an updater.
+     * @param ntScalarMultiChannel the NTScalarMultiChannel; its channelName
+     *        gives the channels updated.
+     * @return a new updater.
+     * @throws std::runtime_error if the value is not of type PVT.
+     */
+    static shared_pointer create(NTScalarMultiChannelPtr const & ntScalarMultiChannel)
+    {
+        if (!ntScalarMultiChannel->getValue<PVT>().get())
+            throw std::runtime_error("NTScalarMultiChannel value type does not match updater");
+        return shared_pointer(new NTScalarMultiChannelUpdater(ntScalarMultiChannel));
+    }
+
+    /**
+     * Sets the value of a channel.
+     * @param index the index of the channel, less than getCount().
+     * @param value the value.
+     */
+    void setValue(size_t index, value_type value)
+    {
+        values[index] = value;
+    }
+
+    /**
+     * Sets the alarm of a channel.
+     * @param index the index of the channel, less than getCount().
+     * @param alarm the alarm.
+     */
+    void setAlarm(size_t index, epics::pvData::Alarm const & alarm)
+    {
+        if (severity.isPresent())
+            severity[index] = alarm.getSeverity();
+        if (status.isPresent())
+            status[index] = alarm.getStatus();
+        if (message.isPresent())
+            message[index] = alarm.getMessage();
+    }
+
+    /**
+     * Sets the timeStamp of a channel.
+     * @param index the index of the channel, less than getCount().
+     * @param timeStamp the timeStamp.
+     */
+    void setTimeStamp(size_t index, epics::pvData::TimeStamp const & timeStamp)
+    {
+        if (secondsPastEpoch.isPresent())
+            secondsPastEpoch[index] = timeStamp.getSecondsPastEpoch();
+        if (nanoseconds.isPresent())
+            nanoseconds[index] = timeStamp.getNanoseconds();
+        if (userTag.isPresent())
+            userTag[index] = timeStamp.getUserTag();
+    }
+
+    /**
+     * Sets whether a channel is connected.
+     * @param index the index of the channel, less than getCount().
+     * @param connected whether the channel is connected.
+     */
+    void setConnected(size_t index, bool connected)
+    {
+        if (isConnected.isPresent())
+            isConnected[index] = connected;
+    }
+
+    /**
+     * Sets the value, alarm and timeStamp of a channel.
+     * @param index the index of the channel, less than getCount().
+     * @param value the value.
+     * @param alarm the alarm.
+     * @param timeStamp the timeStamp.
+     */
+    void update(size_t index, value_type value,
+        epics::pvData::Alarm const & alarm,
+        epics::pvData::TimeStamp const & timeStamp)
+    {
+        setValue(index, value);
+        setAlarm(index, alarm);
+        setTimeStamp(index, timeStamp);
+    }
+
+    /**
+     * Publishes the staged channels to the NTScalarMultiChannel, replacing
+     * all of its arrays.
+     */
+    void commit()
+    {
+        values.commit();
+        severity.commit();
+        status.commit();
+        message.commit();
+        secondsPastEpoch.commit();
+        nanoseconds.commit();
+        userTag.commit();
+        isConnected.commit();
+    }
+
+    /**
+     * Returns the number of channels.
+     * @return the length of channelName.
+     */
+    size_t getCount() const { return count; }
+
+    /**
+     * Returns the NTScalarMultiChannel updated.
+     * @return the NTScalarMultiChannel.
+     */
+    NTScalarMultiChannelPtr const & getNTScalarMultiChannel() const { return ntScalarMultiChannel; }
+
+private:
+    NTScalarMultiChannelUpdater(NTScalarMultiChannelPtr const & ntScalarMultiChannel) :
+        ntScalarMultiChannel(ntScalarMultiChannel),
+        count(ntScalarMultiChannel->getChannelName()->getLength())
+    {
+        values.attach(ntScalarMultiChannel->getValue<PVT>(), count);
+        severity.attach(ntScalarMultiChannel->getSeverity(), count);
+        status.attach(ntScalarMultiChannel->getStatus(), count);
+        message.attach(ntScalarMultiChannel->getMessage(), count);
+        secondsPastEpoch.attach(ntScalarMultiChannel->getSecondsPastEpoch(), count);
+        nanoseconds.attach(ntScalarMultiChannel->getNanoseconds(), count);
+        userTag.attach(ntScalarMultiChannel->getUserTag(), count);
+        isConnected.attach(ntScalarMultiChannel->getIsConnected(), count);
+    }
+
+    NTScalarMultiChannelPtr ntScalarMultiChannel;
+    size_t count;
+
+    detail::NTMultiChannelColumn<PVT> values;
+    detail::NTMultiChannelColumn<epics::pvData::PVIntArray> severity;
+    detail::NTMultiChannelColumn<epics::pvData::PVIntArray> status;
+    detail::NTMultiChannelColumn<epics::pvData::PVStringArray> message;
+    detail::NTMultiChannelColumn<epics::pvData::PVLongArray> secondsPastEpoch;
+    detail::NTMultiChannelColumn<epics::pvData::PVIntArray> nanoseconds;
+    detail::NTMultiChannelColumn<epics::pvData::PVIntArray> userTag;
+    detail::NTMultiChannelColumn<epics::pvData::PVBooleanArray> isConnected;
+};
+
+}}
+#endif  /* NTSCALARMULTICHANNELUPDATER_H */
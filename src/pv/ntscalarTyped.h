@@ -0,0 +1,214 @@
+/* ntscalarTyped.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTSCALARTYPED_H
+#define NTSCALARTYPED_H
+
+#include <pv/ntscalar.h>
+#include <pv/ntscalarArray.h>
+
+namespace epics { namespace nt {
+
+/**
+ * @brief NTScalar with a value of a type known at compile time.
+ *
+ * The type of the value is checked once, when an NTScalar is wrapped;
+ * get() and put() then access the value directly, without the cast of
+ * NTScalar::getValue<PVT>() on every access.
+ *
+ * @tparam T the type of the value, one of the pvData scalar types,
+ *         e.g. double or std::string.
+ */
+template<typename T>
+class NTScalarT
+{
+public:
+    POINTER_DEFINITIONS(NTScalarT);
+
+    typedef T value_type;
+    typedef epics::pvData::PVScalarValue<T> PVValueType;
+
+    /**
+     * Creates an NTScalar with a value of type T.
+     * @param builder a builder with the other fields of the NTScalar
+     *        added; its value type is set to T.
+     * @return the new NTScalar.
+     */
+    static shared_pointer create(NTScalarBuilderPtr const & builder = NTScalar::createBuilder())
+    {
+        return wrap(builder->value(PVValueType::typeCode)->create());
+    }
+
+    /**
+     * Wraps an NTScalar.
+     * @param ntScalar the NTScalar.
+     * @return the typed NTScalar, or null if ntScalar is null or its value
+     *         is not of type T.
+     */
+    static shared_pointer wrap(NTScalarPtr const & ntScalar)
+    {
+        if (!ntScalar.get())
+            return shared_pointer();
+        std::tr1::shared_ptr<PVValueType> pvValue = ntScalar->getValue<PVValueType>();
+        if (!pvValue.get())
+            return shared_pointer();
+        return shared_pointer(new NTScalarT(ntScalar, pvValue));
+    }
+
+    /**
+     * Wraps a PVStructure.
+     * @param pvStructure the PVStructure.
+     * @return the typed NTScalar, or null if pvStructure is not compatible
+     *         with NTScalar or its value is not of type T.
+     */
+    static shared_pointer wrap(epics::pvData::PVStructurePtr const & pvStructure)
+    {
+        return wrap(NTScalar::wrap(pvStructure));
+    }
+
+    /**
+     * Returns the value.
+     * @return the value.
+     */
+    T get() const { return pvValue->get(); }
+
+    /**
+     * Sets the value.
+     * @param value the value.
+     */
+    void put(T const & value) { pvValue->put(value); }
+
+    /**
+     * Returns the value field.
+     * @return the value field.
+     */
+    std::tr1::shared_ptr<PVValueType> const & getValue() const { return pvValue; }
+
+    /**
+     * Returns the wrapped NTScalar, e.g. to access its other fields.
+     * @return the NTScalar.
+     */
+    NTScalarPtr const & getNTScalar() const { return ntScalar; }
+
+    /**
+     * Returns the PVStructure of the NTScalar.
+     * @return the PVStructure.
+     */
+    epics::pvData::PVStructurePtr getPVStructure() const { return ntScalar->getPVStructure(); }
+
+private:
+    NTScalarT(NTScalarPtr const & ntScalar,
+        std::tr1::shared_ptr<PVValueType> const & pvValue) :
+        ntScalar(ntScalar), pvValue(pvValue)
+    {}
+
+    NTScalarPtr ntScalar;
+    std::tr1::shared_ptr<PVValueType> pvValue;
+};
+
+/**
+ * @brief NTScalarArray with a value of an element type known at compile time.
+ *
+ * The type of the value is checked once, when an NTScalarArray is wrapped;
+ * get() and put() then access the value directly, without the cast of
+ * NTScalarArray::getValue<PVT>() on every access.
+ *
+ * @tparam T the element type of the value, one of the pvData scalar types,
+ *         e.g. double or std::string.
+ */
+template<typename T>
+class NTScalarArrayT
+{
+public:
+    POINTER_DEFINITIONS(NTScalarArrayT);
+
+    typedef T value_type;
+    typedef epics::pvData::PVValueArray<T> PVValueType;
+    typedef typename PVValueType::svector svector;
+    typedef typename PVValueType::const_svector const_svector;
+
+    /**
+     * Creates an NTScalarArray with a value of element type T.
+     * @param builder a builder with the other fields of the NTScalarArray
+     *        added; its value type is set to T.
+     * @return the new NTScalarArray.
+     */
+    static shared_pointer create(
+        NTScalarArrayBuilderPtr const & builder = NTScalarArray::createBuilder())
+    {
+        return wrap(builder->value(PVValueType::typeCode)->create());
+    }
+
+    /**
+     * Wraps an NTScalarArray.
+     * @param ntScalarArray the NTScalarArray.
+     * @return the typed NTScalarArray, or null if ntScalarArray is null or
+     *         its value is not of element type T.
+     */
+    static shared_pointer wrap(NTScalarArrayPtr const & ntScalarArray)
+    {
+        if (!ntScalarArray.get())
+            return shared_pointer();
+        std::tr1::shared_ptr<PVValueType> pvValue = ntScalarArray->getValue<PVValueType>();
+        if (!pvValue.get())
+            return shared_pointer();
+        return shared_pointer(new NTScalarArrayT(ntScalarArray, pvValue));
+    }
+
+    /**
+     * Wraps a PVStructure.
+     * @param pvStructure the PVStructure.
+     * @return the typed NTScalarArray, or null if pvStructure is not
+     *         compatible with NTScalarArray or its value is not of element
+     *         type T.
+     */
+    static shared_pointer wrap(epics::pvData::PVStructurePtr const & pvStructure)
+    {
+        return wrap(NTScalarArray::wrap(pvStructure));
+    }
+
+    /**
+     * Returns the value, without copying.
+     * @return the value.
+     */
+    const_svector get() const { return pvValue->view(); }
+
+    /**
+     * Sets the value, without copying.
+     * @param value the value.
+     */
+    void put(const_svector const & value) { pvValue->replace(value); }
+
+    /**
+     * Returns the value field.
+     * @return the value field.
+     */
+    std::tr1::shared_ptr<PVValueType> const & getValue() const { return pvValue; }
+
+    /**
+     * Returns the wrapped NTScalarArray, e.g. to access its other fields.
+     * @return the NTScalarArray.
+     */
+    NTScalarArrayPtr const & getNTScalarArray() const { return ntScalarArray; }
+
+    /**
+     * Returns the PVStructure of the NTScalarArray.
+     * @return the PVStructure.
+     */
+    epics::pvData::PVStructurePtr getPVStructure() const { return ntScalarArray->getPVStructure(); }
+
+private:
+    NTScalarArrayT(NTScalarArrayPtr const & ntScalarArray,
+        std::tr1::shared_ptr<PVValueType> const & pvValue) :
+        ntScalarArray(ntScalarArray), pvValue(pvValue)
+    {}
+
+    NTScalarArrayPtr ntScalarArray;
+    std::tr1::shared_ptr<PVValueType> pvValue;
+};
+
+}}
+#endif  /* NTSCALARTYPED_H */
@@ -0,0 +1,213 @@
+/* ntupdater.h */
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTUPDATER_H
+#define NTUPDATER_H
+
+#include <string>
+
+#ifdef epicsExportSharedSymbols
+#   define ntupdaterEpicsExportSharedSymbols
+#   undef epicsExportSharedSymbols
+#endif
+
+#include <pv/pvData.h>
+#include <pv/bitSet.h>
+#include <pv/alarm.h>
+#include <pv/timeStamp.h>
+
+#ifdef ntupdaterEpicsExportSharedSymbols
+#   define epicsExportSharedSymbols
+#	undef ntupdaterEpicsExportSharedSymbols
+#endif
+
+#include <shareLib.h>
+
+namespace epics { namespace nt {
+
+class NTUpdater;
+typedef std::tr1::shared_ptr<NTUpdater> NTUpdaterPtr;
+
+/**
+ * @brief Fast update of the value, alarm and timeStamp of an NT value.
+ *
+ * The value field and the scalar fields of the alarm and timeStamp
+ * structures are looked up once, when the updater is created, instead of
+ * by attaching a PVAlarm and PVTimeStamp for each update. Each update
+ * records the offsets of the fields it changed, so that a monitor can be
+ * posted with only those fields:
+ * <pre>
+ * NTUpdaterPtr updater = NTUpdater::create(ntScalar);
+ * ...
+ * BitSet const & changed = updater->update(value, alarm, timeStamp);
+ * ...                    // post the monitor with changed
+ * updater->clearChanged();
+ * </pre>
+ * Any NT value with a top-level value, alarm or timeStamp field may be
+ * updated, e.g. NTScalar, NTScalarArray, NTEnum or NTNDArray; fields it
+ * does not have are not updated.
+ * <p>
+ * The value is always marked as changed when put. The fields of the alarm
+ * and timeStamp are only set, and marked as changed, when they differ, so
+ * an unchanged alarm is not sent again.
+ * <p>
+ * An updater must only be used by one thread at a time.
+ */
+class epicsShareClass NTUpdater
+{
+public:
+    POINTER_DEFINITIONS(NTUpdater);
+
+    /**
+     * Creates an updater for an NT value.
+     * @param pvStructure the PVStructure of the NT value.
+     * @return a new updater.
+     */
+    static shared_pointer create(epics::pvData::PVStructurePtr const & pvStructure);
+
+    /**
+     * Creates an updater for an NT value.
+     * @param nt the NT wrapper, e.g. an NTScalarPtr.
+     * @return a new updater.
+     */
+    template<typename NT>
+    static shared_pointer create(std::tr1::shared_ptr<NT> const & nt)
+    {
+        return create(nt->getPVStructure());
+    }
+
+    /**
+     * Puts a scalar value, converting it to the type of the value field.
+     * @param value the value.
+     * @return false if the NT value has no scalar value field.
+     */
+    template<typename T>
+    bool putValue(T value)
+    {
+        if (!pvValue.get())
+            return false;
+        pvValue->putFrom<T>(value);
+        changed->set(valueOffset);
+        return true;
+    }
+
+    /**
+     * Puts an array value, converting it to the element type of the value
+     * field if it differs. The value is not copied if it does not.
+     * @param value the value.
+     * @return false if the NT value has no scalar array value field.
+     */
+    template<typename T>
+    bool putValue(epics::pvData::shared_vector<const T> const & value)
+    {
+        if (!pvValueArray.get())
+            return false;
+        pvValueArray->putFrom<T>(value);
+        changed->set(valueOffset);
+        return true;
+    }
+
+    /**
+     * Sets the alarm.
+     * @param alarm the alarm.
+     * @return false if the NT value has no alarm field.
+     */
+    bool setAlarm(epics::pvData::Alarm const & alarm);
+
+    /**
+     * Sets the alarm.
+     * @param severity the alarm severity.
+     * @param status the alarm status.
+     * @param message the alarm message.
+     * @return false if the NT value has no alarm field.
+     */
+    bool setAlarm(epics::pvData::AlarmSeverity severity,
+        epics::pvData::AlarmStatus status, std::string const & message);
+
+    /**
+     * Sets the timeStamp.
+     * @param timeStamp the timeStamp.
+     * @return false if the NT value has no timeStamp field.
+     */
+    bool setTimeStamp(epics::pvData::TimeStamp const & timeStamp);
+
+    /**
+     * Puts the value and sets the alarm and timeStamp.
+     * @param value the value, a scalar or a frozen shared_vector.
+     * @param alarm the alarm.
+     * @param timeStamp the timeStamp.
+     * @return the fields changed since changes were last cleared.
+     */
+    template<typename T>
+    epics::pvData::BitSet const & update(T const & value,
+        epics::pvData::Alarm const & alarm,
+        epics::pvData::TimeStamp const & timeStamp)
+    {
+        putValue(value);
+        setAlarm(alarm);
+        setTimeStamp(timeStamp);
+        return *changed;
+    }
+
+    /**
+     * Returns the fields changed since changes were last cleared, by their
+     * offset in the NT value.
+     * @return the changed fields.
+     */
+    epics::pvData::BitSetPtr const & getChanged() const { return changed; }
+
+    /**
+     * Clears the changed fields, e.g. after a monitor was posted.
+     */
+    void clearChanged() { changed->clear(); }
+
+    /**
+     * Returns whether the NT value has a scalar or scalar array value field.
+     * @return true if it has.
+     */
+    bool hasValue() const { return pvValue.get() || pvValueArray.get(); }
+
+    /**
+     * Returns whether the NT value has an alarm field.
+     * @return true if it has.
+     */
+    bool hasAlarm() const { return pvSeverity.get() != 0; }
+
+    /**
+     * Returns whether the NT value has a timeStamp field.
+     * @return true if it has.
+     */
+    bool hasTimeStamp() const { return pvSecondsPastEpoch.get() != 0; }
+
+    /**
+     * Returns the PVStructure of the NT value.
+     * @return the PVStructure.
+     */
+    epics::pvData::PVStructurePtr const & getPVStructure() const { return pvStructure; }
+
+private:
+    NTUpdater(epics::pvData::PVStructurePtr const & pvStructure);
+
+    epics::pvData::uint32 offsetOf(epics::pvData::PVFieldPtr const & pvField) const;
+
+    epics::pvData::PVStructurePtr pvStructure;
+    epics::pvData::BitSetPtr changed;
+
+    epics::pvData::PVScalarPtr pvValue;
+    epics::pvData::PVScalarArrayPtr pvValueArray;
+    epics::pvData::uint32 valueOffset;
+
+    epics::pvData::PVIntPtr pvSeverity;
+    epics::pvData::PVIntPtr pvStatus;
+    epics::pvData::PVStringPtr pvMessage;
+
+    epics::pvData::PVLongPtr pvSecondsPastEpoch;
+    epics::pvData::PVIntPtr pvNanoseconds;
+    epics::pvData::PVIntPtr pvUserTag;
+};
+
+}}
+#endif  /* NTUPDATER_H */
@@ -0,0 +1,110 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntarena.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+void test_allocate()
+{
+    testDiag("test_allocate");
+
+    NTArenaPtr arena = NTArena::create(1024);
+    testOk1(arena.get() != 0 && arena->getBlockSize() == 1024);
+
+    std::tr1::shared_ptr<uint8> a = arena->allocate(10);
+    std::tr1::shared_ptr<uint8> b = arena->allocate(100);
+    testOk1(a.get() != 0 && b.get() != 0);
+    testOk(b.get() - a.get() == 16, "allocations adjacent and aligned");
+    testOk1(arena->getBlockAllocations() == 1);
+    testOk1(arena->getAllocated() == 16 + 112);
+
+    // fill the first block
+    for (int i = 0; i < 5; ++i)
+        arena->allocate(200);
+    testOk(arena->getBlockAllocations() == 2, "new block when full");
+
+    std::tr1::shared_ptr<uint8> large = arena->allocate(1000);
+    testOk(large.get() != 0 && arena->getBlockAllocations() == 2,
+        "large allocation not taken from a block");
+
+    PVDoubleArray::svector values = arena->allocateArray<double>(20);
+    testOk1(values.size() == 20);
+    testOk(reinterpret_cast<size_t>(values.data()) % 16 == 0, "array aligned");
+}
+
+void test_release()
+{
+    testDiag("test_release");
+
+    NTArenaPtr arena = NTArena::create(1024);
+    uint8 * first = 0;
+    {
+        std::tr1::shared_ptr<uint8> a = arena->allocate(64);
+        first = a.get();
+    }
+    arena->release();
+    testOk1(arena->getAllocated() == 0);
+
+    std::tr1::shared_ptr<uint8> b = arena->allocate(64);
+    testOk(b.get() == first, "block reused after release");
+    testOk1(arena->getBlockAllocations() == 1);
+
+    PVIntArray::svector kept = arena->allocateArray<int32>(4);
+    for (size_t i = 0; i < kept.size(); ++i)
+        kept[i] = static_cast<int32>(i + 1);
+    PVIntArray::const_svector frozen = freeze(kept);
+
+    // the block is still referenced, so it is replaced
+    arena->release();
+    PVIntArray::svector reused = arena->allocateArray<int32>(64);
+    for (size_t i = 0; i < reused.size(); ++i)
+        reused[i] = -1;
+    testOk(arena->getBlockAllocations() == 2, "referenced block replaced");
+    testOk(frozen[0] == 1 && frozen[3] == 4, "value kept after release");
+}
+
+void test_table()
+{
+    testDiag("test_table");
+
+    NTArenaPtr arena = NTArena::create();
+    for (int request = 0; request < 3; ++request)
+    {
+        NTTablePtr table = NTTable::createBuilder()->
+            addColumn("x", pvDouble)->
+            addColumn("count", pvInt)->
+            create();
+
+        PVDoubleArray::svector x(arena->allocateArray<double>(100));
+        PVIntArray::svector count(arena->allocateArray<int32>(100));
+        for (size_t i = 0; i < 100; ++i)
+        {
+            x[i] = 0.5*i;
+            count[i] = static_cast<int32>(i);
+        }
+        table->getColumn<PVDoubleArray>("x")->replace(freeze(x));
+        table->getColumn<PVIntArray>("count")->replace(freeze(count));
+        testOk1(table->getColumn<PVDoubleArray>("x")->view()[99] == 49.5);
+
+        table.reset();
+        arena->release();
+    }
+    testOk(arena->getBlockAllocations() == 1, "steady state without block allocation");
+}
+
+MAIN(testNTArena) {
+    testPlan(18);
+    test_allocate();
+    test_release();
+    test_table();
+    return testDone();
+}
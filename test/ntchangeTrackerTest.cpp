@@ -0,0 +1,210 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntchangeTracker.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+void test_ntscalar()
+{
+    testDiag("test_ntscalar");
+
+    NTScalarPtr ntScalar = NTScalar::createBuilder()->
+        value(pvDouble)->addAlarm()->addTimeStamp()->create();
+    NTChangeTrackerPtr tracker = NTChangeTracker::create(ntScalar);
+    testOk1(tracker.get() != 0);
+    testOk1(!tracker->isChanged());
+
+    ntScalar->getValue<PVDouble>()->put(1.0);
+    ntScalar->getAlarm()->getSubField<PVInt>("severity")->put(2);
+    testOk1(tracker->isChanged());
+
+    BitSet changed;
+    testOk1(tracker->takeChanged(changed));
+    testOk1(changed.cardinality() == 2);
+    testOk1(changed.get(ntScalar->getValue()->getFieldOffset()));
+    testOk1(changed.get(ntScalar->getAlarm()->getSubField("severity")->getFieldOffset()));
+
+    testOk(!tracker->isChanged(), "changes reset when taken");
+    testOk1(!tracker->takeChanged(changed) && changed.isEmpty());
+
+    NTUpdaterPtr updater = NTUpdater::create(ntScalar);
+    updater->setTimeStamp(TimeStamp(10, 20));
+    tracker->takeChanged(changed);
+    testOk(changed.cardinality() == 2, "NTUpdater changes tracked");
+
+    try {
+        NTChangeTracker::create(ntScalar);
+        testFail("no exception for second tracker");
+    } catch (std::exception &) {
+        testPass("exception for second tracker");
+    }
+}
+
+void test_ntscalarArray()
+{
+    testDiag("test_ntscalarArray");
+
+    NTScalarArrayPtr ntScalarArray = NTScalarArray::createBuilder()->
+        value(pvDouble)->create();
+    NTChangeTrackerPtr tracker = NTChangeTracker::create(ntScalarArray);
+
+    PVDoubleArrayPtr pvValue = ntScalarArray->getValue<PVDoubleArray>();
+    PVDoubleArray::svector values(5, 1.0);
+    pvValue->replace(freeze(values));
+    BitSet changed;
+    testOk1(tracker->takeChanged(changed) && changed.get(pvValue->getFieldOffset()));
+
+    tracker->markChanged(*pvValue);
+    testOk(tracker->isChanged(), "field marked as changed");
+    tracker->clear();
+    testOk1(!tracker->isChanged());
+
+    NTScalarPtr other = NTScalar::createBuilder()->value(pvDouble)->addDescriptor()->create();
+    try {
+        tracker->markChanged(*other->getDescriptor());
+        testFail("no exception for field of another value");
+    } catch (std::runtime_error &) {
+        testPass("exception for field of another value");
+    }
+}
+
+void test_ntenum()
+{
+    testDiag("test_ntenum");
+
+    NTEnumPtr ntEnum = NTEnum::createBuilder()->addDescriptor()->create();
+    NTChangeTrackerPtr tracker = NTChangeTracker::create(ntEnum);
+
+    PVIntPtr pvIndex = ntEnum->getValue()->getSubField<PVInt>("index");
+    pvIndex->put(1);
+    BitSet changed;
+    tracker->takeChanged(changed);
+    testOk1(changed.cardinality() == 1 && changed.get(pvIndex->getFieldOffset()));
+}
+
+void test_nttable()
+{
+    testDiag("test_nttable");
+
+    NTTablePtr ntTable = NTTable::createBuilder()->
+        addColumn("x", pvDouble)->
+        addColumn("y", pvDouble)->
+        create();
+    NTChangeTrackerPtr tracker = NTChangeTracker::create(ntTable);
+
+    PVDoubleArray::svector y(3, 2.0);
+    ntTable->getColumn<PVDoubleArray>("y")->replace(freeze(y));
+    BitSet changed;
+    tracker->takeChanged(changed);
+    testOk1(changed.cardinality() == 1);
+    testOk(changed.get(ntTable->getColumn("y")->getFieldOffset()), "only changed column marked");
+}
+
+void test_ntndarray()
+{
+    testDiag("test_ntndarray");
+
+    NTNDArrayPtr ntNDArray = NTNDArray::createBuilder()->create();
+    NTChangeTrackerPtr tracker = NTChangeTracker::create(ntNDArray);
+
+    PVUByteArray::svector data(16, 0);
+    PVUByteArrayPtr pvBytes = getPVDataCreate()->createPVScalarArray<PVUByteArray>();
+    pvBytes->replace(freeze(data));
+    ntNDArray->getValue()->set("ubyteValue", pvBytes);
+    ntNDArray->getUniqueId()->put(7);
+
+    BitSet changed;
+    tracker->takeChanged(changed);
+    testOk1(changed.cardinality() == 2);
+    testOk1(changed.get(ntNDArray->getValue()->getFieldOffset()));
+    testOk1(changed.get(ntNDArray->getUniqueId()->getFieldOffset()));
+
+    NTNDArrayDeltaEncoderPtr encoder = NTNDArrayDeltaEncoder::create(0);
+    encoder->encode(ntNDArray);
+    tracker->takeChanged(changed);
+    testOk(changed.get(ntNDArray->getValue()->getFieldOffset()),
+        "value selected by the encoder marked");
+
+    PVUByteArray::svector other(8, 1);
+    ntNDArray->getValue()->select<PVUByteArray>("ubyteValue")->replace(freeze(other));
+    ntNDArray->getValue()->postPut();
+    tracker->takeChanged(changed);
+    testOk(changed.cardinality() == 1 && changed.get(ntNDArray->getValue()->getFieldOffset()),
+        "selected value marked after postPut");
+}
+
+void test_ntmultiChannel()
+{
+    testDiag("test_ntmultiChannel");
+
+    NTMultiChannelPtr ntMultiChannel = NTMultiChannel::createBuilder()->
+        addSeverity()->addStatus()->addMessage()->create();
+    NTChangeTrackerPtr tracker = NTChangeTracker::create(ntMultiChannel);
+
+    PVIntArray::svector severity(100, 0);
+    severity[50] = 2;
+    ntMultiChannel->getSeverity()->replace(freeze(severity));
+
+    BitSet changed;
+    testOk1(tracker->takeChanged(changed));
+    testOk(changed.cardinality() == 1 &&
+        changed.get(ntMultiChannel->getSeverity()->getFieldOffset()),
+        "only changed array marked");
+}
+
+class CountingHandler : public PostHandler
+{
+public:
+    CountingHandler() : count(0) {}
+    virtual void postPut() { ++count; }
+    int count;
+};
+
+void test_retrack()
+{
+    testDiag("test_retrack");
+
+    NTScalarPtr ntScalar = NTScalar::createBuilder()->
+        value(pvDouble)->addAlarm()->addTimeStamp()->create();
+    NTChangeTracker::create(ntScalar);
+    NTChangeTrackerPtr tracker = NTChangeTracker::create(ntScalar);
+    ntScalar->getValue<PVDouble>()->put(1.0);
+    BitSet changed;
+    testOk(tracker->takeChanged(changed) && changed.cardinality() == 1,
+        "tracked again once the previous tracker is destroyed");
+    tracker.reset();
+
+    std::tr1::shared_ptr<CountingHandler> handler(new CountingHandler());
+    ntScalar->getTimeStamp()->getSubField("userTag")->setPostHandler(handler);
+    try {
+        NTChangeTracker::create(ntScalar);
+        testFail("no exception for field with another PostHandler");
+    } catch (std::runtime_error &) {
+        testPass("exception for field with another PostHandler");
+    }
+    tracker = NTChangeTracker::create(ntScalar->getAlarm());
+    ntScalar->getAlarm()->getSubField<PVInt>("severity")->put(1);
+    testOk(tracker->takeChanged(changed) && changed.cardinality() == 1,
+        "fields released after failed creation");
+}
+
+MAIN(testNTChangeTracker) {
+    testPlan(28);
+    test_ntscalar();
+    test_ntscalarArray();
+    test_ntenum();
+    test_nttable();
+    test_ntndarray();
+    test_ntmultiChannel();
+    test_retrack();
+    return testDone();
+}
@@ -0,0 +1,192 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntmatrixMath.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static NTMatrixPtr createMatrix(size_t rows, size_t columns, double scale)
+{
+    NTMatrixPtr matrix = NTMatrix::createBuilder()->addDim()->create();
+    PVDoubleArray::svector value(rows*columns);
+    for (size_t i = 0; i < value.size(); ++i)
+        value[i] = scale*std::sin(0.37*i);
+    matrix->getValue()->replace(freeze(value));
+    PVIntArray::svector dim;
+    dim.push_back(static_cast<int32>(rows));
+    dim.push_back(static_cast<int32>(columns));
+    matrix->getDim()->replace(freeze(dim));
+    return matrix;
+}
+
+static double at(NTMatrixPtr const & matrix, size_t row, size_t column)
+{
+    return matrix->getValue()->view()[row*NTMatrixMath::getColumns(matrix) + column];
+}
+
+void test_shape()
+{
+    testDiag("test_shape");
+
+    NTMatrixPtr matrix = createMatrix(3, 5, 1.0);
+    testOk1(NTMatrixMath::getRows(matrix) == 3);
+    testOk1(NTMatrixMath::getColumns(matrix) == 5);
+
+    // no dim: a column vector
+    NTMatrixPtr vector = NTMatrix::createBuilder()->create();
+    PVDoubleArray::svector value(4);
+    vector->getValue()->replace(freeze(value));
+    testOk1(NTMatrixMath::getRows(vector) == 4);
+    testOk1(NTMatrixMath::getColumns(vector) == 1);
+
+    NTMatrixPtr empty = NTMatrix::createBuilder()->addDim()->create();
+    try {
+        NTMatrixMath::getRows(empty);
+        testFail("invalid matrix accepted");
+    } catch (std::runtime_error &) {
+        testPass("invalid matrix rejected");
+    }
+}
+
+void test_transpose()
+{
+    testDiag("test_transpose");
+
+    // larger than a block in both directions
+    NTMatrixPtr matrix = createMatrix(70, 45, 1.0);
+    NTMatrixPtr transposed = NTMatrixMath::transpose(matrix);
+    testOk1(transposed->isValid());
+    testOk1(NTMatrixMath::getRows(transposed) == 45);
+    testOk1(NTMatrixMath::getColumns(transposed) == 70);
+
+    bool same = true;
+    for (size_t r = 0; r < 70; ++r)
+        for (size_t c = 0; c < 45; ++c)
+            same = same && at(transposed, c, r) == at(matrix, r, c);
+    testOk(same, "transposed values");
+
+    NTMatrixPtr back = NTMatrixMath::transpose(transposed, 1);
+    PVDoubleArray::const_svector original = matrix->getValue()->view();
+    PVDoubleArray::const_svector roundTrip = back->getValue()->view();
+    testOk(std::equal(original.begin(), original.end(), roundTrip.begin()),
+        "transposed twice");
+}
+
+void test_multiply()
+{
+    testDiag("test_multiply");
+
+    const size_t m = 67, k = 150, n = 33;
+    NTMatrixPtr a = createMatrix(m, k, 1.0);
+    NTMatrixPtr b = createMatrix(k, n, 0.5);
+
+    NTMatrixPtr c = NTMatrixMath::multiply(a, b);
+    testOk1(NTMatrixMath::getRows(c) == m);
+    testOk1(NTMatrixMath::getColumns(c) == n);
+
+    double maxError = 0;
+    for (size_t i = 0; i < m; ++i)
+        for (size_t j = 0; j < n; ++j)
+        {
+            double expected = 0;
+            for (size_t p = 0; p < k; ++p)
+                expected += at(a, i, p)*at(b, p, j);
+            maxError = std::max(maxError, std::fabs(at(c, i, j) - expected));
+        }
+    testOk(maxError < 1e-9, "matrix product, maximum error %g", maxError);
+
+    PVDoubleArray::svector x(k);
+    for (size_t p = 0; p < k; ++p)
+        x[p] = 0.25*p - 3.0;
+    PVDoubleArray::const_svector vector(freeze(x));
+    PVDoubleArray::const_svector y = NTMatrixMath::multiply(a, vector, 1);
+    testOk1(y.size() == m);
+
+    maxError = 0;
+    for (size_t i = 0; i < m && i < y.size(); ++i)
+    {
+        double expected = 0;
+        for (size_t p = 0; p < k; ++p)
+            expected += at(a, i, p)*vector[p];
+        maxError = std::max(maxError, std::fabs(y[i] - expected));
+    }
+    testOk(maxError < 1e-9, "matrix vector product, maximum error %g", maxError);
+
+    try {
+        NTMatrixMath::multiply(a, a);
+        testFail("product of mismatched matrices computed");
+    } catch (std::runtime_error &) {
+        testPass("product of mismatched matrices rejected");
+    }
+
+    try {
+        NTMatrixMath::multiply(b, vector);
+        testFail("product with mismatched vector computed");
+    } catch (std::runtime_error &) {
+        testPass("product with mismatched vector rejected");
+    }
+}
+
+void test_reductions()
+{
+    testDiag("test_reductions");
+
+    // element (r, c) is (r + 1)*(c + 1)
+    NTMatrixPtr matrix = NTMatrix::createBuilder()->addDim()->create();
+    PVDoubleArray::svector value;
+    for (int r = 1; r <= 3; ++r)
+        for (int c = 1; c <= 4; ++c)
+            value.push_back(r*c);
+    matrix->getValue()->replace(freeze(value));
+    PVIntArray::svector dim;
+    dim.push_back(3);
+    dim.push_back(4);
+    matrix->getDim()->replace(freeze(dim));
+
+    PVDoubleArray::const_svector rowSums = NTMatrixMath::reduceRows(matrix, NTMatrixMath::sum);
+    testOk1(rowSums.size() == 3 && rowSums[0] == 10 && rowSums[1] == 20 && rowSums[2] == 30);
+    PVDoubleArray::const_svector rowMeans = NTMatrixMath::reduceRows(matrix, NTMatrixMath::mean);
+    testOk1(rowMeans.size() == 3 && rowMeans[0] == 2.5 && rowMeans[2] == 7.5);
+    PVDoubleArray::const_svector rowMaxima = NTMatrixMath::reduceRows(matrix, NTMatrixMath::maximum);
+    testOk1(rowMaxima.size() == 3 && rowMaxima[0] == 4 && rowMaxima[2] == 12);
+
+    PVDoubleArray::const_svector columnSums = NTMatrixMath::reduceColumns(matrix, NTMatrixMath::sum);
+    testOk1(columnSums.size() == 4 && columnSums[0] == 6 && columnSums[3] == 24);
+    PVDoubleArray::const_svector columnMeans = NTMatrixMath::reduceColumns(matrix, NTMatrixMath::mean);
+    testOk1(columnMeans.size() == 4 && columnMeans[1] == 4);
+    PVDoubleArray::const_svector columnMinima = NTMatrixMath::reduceColumns(matrix, NTMatrixMath::minimum);
+    testOk1(columnMinima.size() == 4 && columnMinima[0] == 1 && columnMinima[3] == 4);
+
+    // more columns than a block
+    NTMatrixPtr wide = createMatrix(5, 600, 1.0);
+    PVDoubleArray::const_svector maxima = NTMatrixMath::reduceColumns(wide, NTMatrixMath::maximum);
+    bool same = maxima.size() == 600;
+    for (size_t c = 0; same && c < 600; ++c)
+    {
+        double expected = at(wide, 0, c);
+        for (size_t r = 1; r < 5; ++r)
+            expected = std::max(expected, at(wide, r, c));
+        same = maxima[c] == expected;
+    }
+    testOk(same, "column maxima");
+}
+
+MAIN(testNTMatrixMath) {
+    testPlan(24);
+    test_shape();
+    test_transpose();
+    test_multiply();
+    test_reductions();
+    return testDone();
+}
@@ -0,0 +1,174 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <cmath>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntmatrixView.h>
+#include <pv/ntmatrixMath.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static const size_t rows = 6;
+static const size_t columns = 5;
+
+// element (r, c) is 10*r + c
+static NTMatrixPtr createMatrix()
+{
+    NTMatrixPtr matrix = NTMatrix::createBuilder()->addDim()->create();
+    PVDoubleArray::svector value(rows*columns);
+    for (size_t r = 0; r < rows; ++r)
+        for (size_t c = 0; c < columns; ++c)
+            value[r*columns + c] = 10.0*r + c;
+    matrix->getValue()->replace(freeze(value));
+    PVIntArray::svector dim;
+    dim.push_back(rows);
+    dim.push_back(columns);
+    matrix->getDim()->replace(freeze(dim));
+    return matrix;
+}
+
+void test_views()
+{
+    testDiag("test_views");
+
+    NTMatrixPtr matrix = createMatrix();
+    NTMatrixView view(matrix);
+    testOk1(view.getRows() == rows && view.getColumns() == columns);
+    testOk1(view.isContiguous());
+    testOk1(view(3, 4) == 34);
+    testOk(view.data() == matrix->getValue()->view().data(), "view shares the value");
+
+    NTMatrixView row = view.row(2);
+    testOk1(row.getRows() == 1 && row.getColumns() == columns);
+    testOk1(row(0, 3) == 23);
+    testOk1(row.isContiguous());
+
+    NTMatrixView column = view.column(1);
+    testOk1(column.getRows() == rows && column.getColumns() == 1);
+    testOk1(column(4, 0) == 41);
+    testOk1(!column.isContiguous());
+
+    NTMatrixView block = view.block(1, 2, 3, 2);
+    testOk1(block.getRows() == 3 && block.getColumns() == 2);
+    testOk1(block(0, 0) == 12 && block(2, 1) == 33);
+    testOk1(view.block(2, 0, 3, columns).isContiguous());
+
+    NTMatrixView transposed = block.transpose();
+    testOk1(transposed.getRows() == 2 && transposed.getColumns() == 3);
+    testOk1(transposed(1, 2) == 33);
+
+    try {
+        view.block(4, 0, 3, 1);
+        testFail("block outside the view accepted");
+    } catch (std::runtime_error &) {
+        testPass("block outside the view rejected");
+    }
+
+    try {
+        view.column(columns);
+        testFail("column outside the view accepted");
+    } catch (std::runtime_error &) {
+        testPass("column outside the view rejected");
+    }
+
+    NTMatrixPtr invalid = NTMatrix::createBuilder()->addDim()->create();
+    try {
+        NTMatrixView invalidView(invalid);
+        testFail("invalid matrix viewed");
+    } catch (std::runtime_error &) {
+        testPass("invalid matrix rejected");
+    }
+}
+
+void test_publish()
+{
+    testDiag("test_publish");
+
+    NTMatrixPtr matrix = createMatrix();
+    NTMatrixView view(matrix);
+
+    PVDoubleArray::const_svector row = view.row(3).toArray();
+    testOk(row.size() == columns && row.data() == view.data() + 3*columns,
+        "row published without copying");
+
+    PVDoubleArray::const_svector column = view.column(2).toArray();
+    bool same = column.size() == rows;
+    for (size_t r = 0; same && r < rows; ++r)
+        same = column[r] == 10.0*r + 2;
+    testOk(same, "column copied");
+
+    NTMatrixPtr transposed = view.block(1, 1, 2, 3).transpose().toMatrix();
+    testOk1(transposed->isValid());
+    PVIntArray::const_svector dim = transposed->getDim()->view();
+    testOk1(dim.size() == 2 && dim[0] == 3 && dim[1] == 2);
+    PVDoubleArray::const_svector value = transposed->getValue()->view();
+    testOk1(value.size() == 6 && value[0] == 11 && value[1] == 21 && value[5] == 23);
+
+    NTScalarArrayPtr scalarArray = view.row(1).toScalarArray();
+    PVDoubleArrayPtr pvValue = scalarArray->getValue<PVDoubleArray>();
+    testOk1(pvValue.get() && pvValue->getLength() == columns && pvValue->view()[4] == 14);
+
+    // the view keeps the storage after the matrix value is replaced
+    NTMatrixView kept = view.row(0);
+    PVDoubleArray::svector replacement(rows*columns);
+    matrix->getValue()->replace(freeze(replacement));
+    testOk1(kept(0, 4) == 4);
+
+    PVDoubleArray::svector values(4, 1.0);
+    try {
+        NTMatrixView mismatched(freeze(values), 3, 2);
+        testFail("array of the wrong size viewed");
+    } catch (std::runtime_error &) {
+        testPass("array of the wrong size rejected");
+    }
+}
+
+void test_math()
+{
+    testDiag("test_math");
+
+    NTMatrixView view(createMatrix());
+
+    // column 3 as a row vector times a block
+    NTMatrixView left = view.column(3).transpose();
+    NTMatrixPtr product = NTMatrixMath::multiply(left, view.block(0, 0, rows, 2));
+    PVDoubleArray::const_svector value = product->getValue()->view();
+    double expected0 = 0, expected1 = 0;
+    for (size_t r = 0; r < rows; ++r)
+    {
+        expected0 += (10.0*r + 3)*(10.0*r);
+        expected1 += (10.0*r + 3)*(10.0*r + 1);
+    }
+    testOk1(value.size() == 2 && value[0] == expected0 && value[1] == expected1);
+
+    PVDoubleArray::svector x(rows, 1.0);
+    PVDoubleArray::const_svector sums = NTMatrixMath::multiply(view.transpose(), freeze(x));
+    testOk1(sums.size() == columns && sums[0] == 150 && sums[4] == 174);
+
+    PVDoubleArray::const_svector means = NTMatrixMath::reduceRows(view.column(4), NTMatrixMath::mean);
+    testOk1(means.size() == rows && means[2] == 24);
+
+    PVDoubleArray::const_svector maxima =
+        NTMatrixMath::reduceColumns(view.block(0, 1, 4, 2), NTMatrixMath::maximum);
+    testOk1(maxima.size() == 2 && maxima[0] == 31 && maxima[1] == 32);
+
+    NTMatrixPtr transposed = NTMatrixMath::transpose(view.row(5));
+    PVIntArray::const_svector dim = transposed->getDim()->view();
+    testOk1(dim.size() == 2 && dim[0] == columns && dim[1] == 1);
+}
+
+MAIN(testNTMatrixView) {
+    testPlan(31);
+    test_views();
+    test_publish();
+    test_math();
+    return testDone();
+}
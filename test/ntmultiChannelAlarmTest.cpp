@@ -0,0 +1,143 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntmultiChannelAlarm.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+using std::string;
+
+typedef NTMultiChannelAlarm::Summary Summary;
+
+void test_summarize()
+{
+    testDiag("test_summarize");
+
+    size_t count = 1000;
+    shared_vector<int32> severity(count, 0);
+    shared_vector<boolean> isConnected(count, 1);
+    severity[10] = minorAlarm;
+    severity[500] = majorAlarm;
+    severity[700] = majorAlarm;
+    severity[900] = 42;
+    isConnected[600] = 0;
+    shared_vector<const int32> frozenSeverity(freeze(severity));
+    shared_vector<const boolean> frozenIsConnected(freeze(isConnected));
+
+    Summary summary = NTMultiChannelAlarm::summarize(frozenSeverity,
+        shared_vector<const boolean>());
+    testOk(summary.severity == undefinedAlarm, "out of range severity counted as undefined");
+    testOk1(summary.worstChannel == 900);
+    testOk1(summary.disconnected == 0);
+
+    summary = NTMultiChannelAlarm::summarize(frozenSeverity, frozenIsConnected, majorAlarm);
+    testOk1(summary.severity == undefinedAlarm);
+    testOk1(summary.disconnected == 1);
+    testOk1(summary.severityCount[noAlarm] == count - 5);
+    testOk1(summary.severityCount[minorAlarm] == 1);
+    testOk(summary.severityCount[majorAlarm] == 3, "disconnected channel counted as major");
+    testOk1(summary.severityCount[invalidAlarm] == 0);
+    testOk1(summary.severityCount[undefinedAlarm] == 1);
+
+    shared_vector<const int32> first(frozenSeverity);
+    shared_vector<const boolean> firstConnected(frozenIsConnected);
+    first.slice(0, 800);
+    firstConnected.slice(0, 800);
+    summary = NTMultiChannelAlarm::summarize(first, firstConnected, majorAlarm);
+    testOk(summary.severity == majorAlarm && summary.worstChannel == 500,
+        "first channel with the highest severity");
+    summary = NTMultiChannelAlarm::summarize(first, firstConnected);
+    testOk(summary.severity == invalidAlarm && summary.worstChannel == 600,
+        "disconnected channel invalid by default");
+
+    summary = NTMultiChannelAlarm::summarize(shared_vector<const int32>(),
+        shared_vector<const boolean>());
+    testOk(summary.severity == noAlarm && summary.worstChannel == -1,
+        "no channels");
+
+    try {
+        NTMultiChannelAlarm::summarize(first, frozenIsConnected);
+        testFail("no exception for different lengths");
+    } catch (std::runtime_error &) {
+        testPass("exception for different lengths");
+    }
+}
+
+void test_updateAlarm()
+{
+    testDiag("test_updateAlarm");
+
+    NTScalarMultiChannelPtr multiChannel = NTScalarMultiChannel::createBuilder()->
+        value(pvDouble)->
+        addAlarm()->
+        addSeverity()->
+        addStatus()->
+        addMessage()->
+        addIsConnected()->
+        create();
+
+    size_t count = 4;
+    PVStringArray::svector names(count);
+    PVDoubleArray::svector values(count, 0.0);
+    PVIntArray::svector severity(count, 0);
+    PVIntArray::svector status(count, 0);
+    PVStringArray::svector message(count);
+    PVBooleanArray::svector isConnected(count, 1);
+    names[0] = "A"; names[1] = "B"; names[2] = "C"; names[3] = "D";
+    severity[2] = majorAlarm;
+    status[2] = deviceStatus;
+    message[2] = "HIHI";
+    multiChannel->getChannelName()->replace(freeze(names));
+    multiChannel->getValue<PVDoubleArray>()->replace(freeze(values));
+    multiChannel->getSeverity()->replace(freeze(severity));
+    multiChannel->getStatus()->replace(freeze(status));
+    multiChannel->getMessage()->replace(freeze(message));
+    multiChannel->getIsConnected()->replace(freeze(isConnected));
+
+    PVStructurePtr pvAlarm = multiChannel->getAlarm();
+    Summary summary = NTMultiChannelAlarm::updateAlarm(multiChannel);
+    testOk1(summary.severity == majorAlarm && summary.worstChannel == 2);
+    testOk1(pvAlarm->getSubField<PVInt>("severity")->get() == majorAlarm);
+    testOk1(pvAlarm->getSubField<PVInt>("status")->get() == deviceStatus);
+    testOk1(pvAlarm->getSubField<PVString>("message")->get() == "C: HIHI");
+
+    PVBooleanArray::svector disconnected(count, 1);
+    disconnected[1] = 0;
+    multiChannel->getIsConnected()->replace(freeze(disconnected));
+    summary = NTMultiChannelAlarm::updateAlarm(multiChannel);
+    testOk1(summary.severity == invalidAlarm && summary.worstChannel == 1);
+    testOk1(pvAlarm->getSubField<PVInt>("status")->get() == clientStatus);
+    testOk1(pvAlarm->getSubField<PVString>("message")->get() == "B: disconnected");
+
+    PVIntArray::svector cleared(count, 0);
+    PVBooleanArray::svector connected(count, 1);
+    multiChannel->getSeverity()->replace(freeze(cleared));
+    multiChannel->getIsConnected()->replace(freeze(connected));
+    NTMultiChannelAlarm::updateAlarm(multiChannel);
+    testOk(pvAlarm->getSubField<PVInt>("severity")->get() == noAlarm &&
+        pvAlarm->getSubField<PVString>("message")->get().empty(), "alarm cleared");
+
+    NTMultiChannelPtr noAlarmField = NTMultiChannel::createBuilder()->
+        value(getFieldCreate()->createVariantUnion())->addSeverity()->create();
+    testOk1(NTMultiChannelAlarm::summarize(noAlarmField).severity == noAlarm);
+    try {
+        NTMultiChannelAlarm::updateAlarm(noAlarmField);
+        testFail("no exception for missing alarm field");
+    } catch (std::runtime_error &) {
+        testPass("exception for missing alarm field");
+    }
+}
+
+MAIN(testNTMultiChannelAlarm) {
+    testPlan(24);
+    test_summarize();
+    test_updateAlarm();
+    return testDone();
+}
@@ -0,0 +1,230 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <limits>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntmultiChannelDelta.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+using std::string;
+
+static NTScalarMultiChannelPtr createSnapshot(size_t count)
+{
+    NTScalarMultiChannelPtr snapshot = NTScalarMultiChannel::createBuilder()->
+        value(pvDouble)->
+        addAlarm()->
+        addSeverity()->
+        addMessage()->
+        create();
+    PVStringArray::svector names(count);
+    PVDoubleArray::svector values(count);
+    PVIntArray::svector severity(count);
+    PVStringArray::svector message(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        names[i] = "channel";
+        values[i] = static_cast<double>(i);
+        severity[i] = 0;
+    }
+    snapshot->getChannelName()->replace(freeze(names));
+    snapshot->getValue<PVDoubleArray>()->replace(freeze(values));
+    snapshot->getSeverity()->replace(freeze(severity));
+    snapshot->getMessage()->replace(freeze(message));
+    return snapshot;
+}
+
+template<typename PVT>
+static void setElement(std::tr1::shared_ptr<PVT> const & pvArray, size_t index,
+    typename PVT::value_type value)
+{
+    typename PVT::svector values(pvArray->reuse());
+    values[index] = value;
+    pvArray->replace(freeze(values));
+}
+
+void test_findChanged()
+{
+    testDiag("test_findChanged");
+
+    NTScalarMultiChannelPtr previous = createSnapshot(100);
+    NTScalarMultiChannelPtr current = createSnapshot(100);
+    testOk1(NTMultiChannelDelta::findChanged(previous, current).empty());
+
+    setElement(current->getValue<PVDoubleArray>(), 3, -1.0);
+    setElement(current->getSeverity(), 50, 2);
+    setElement(current->getMessage(), 99, string("LOLO"));
+    shared_vector<const int32> changed = NTMultiChannelDelta::findChanged(previous, current);
+    testOk1(changed.size() == 3);
+    testOk1(changed.size() == 3 && changed[0] == 3 && changed[1] == 50 && changed[2] == 99);
+
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    setElement(previous->getValue<PVDoubleArray>(), 10, nan);
+    setElement(current->getValue<PVDoubleArray>(), 10, nan);
+    testOk(NTMultiChannelDelta::findChanged(previous, current).size() == 3, "NaN values equal");
+
+    try {
+        NTMultiChannelDelta::findChanged(previous, createSnapshot(99));
+        testFail("no exception for different numbers of channels");
+    } catch (std::runtime_error &) {
+        testPass("exception for different numbers of channels");
+    }
+}
+
+void test_createDelta()
+{
+    testDiag("test_createDelta");
+
+    NTScalarMultiChannelPtr previous = createSnapshot(1000);
+    NTScalarMultiChannelPtr current = createSnapshot(1000);
+    setElement(current->getValue<PVDoubleArray>(), 7, 70.0);
+    setElement(current->getSeverity(), 7, 1);
+    setElement(current->getValue<PVDoubleArray>(), 900, 9000.0);
+    current->getAlarm()->getSubField<PVString>("message")->put("changed");
+
+    NTScalarMultiChannelPtr delta = NTMultiChannelDelta::createDelta(previous, current);
+    testOk1(delta.get() != 0);
+    testOk1(delta->isValid());
+    testOk1(NTMultiChannelDelta::isDelta(delta->getPVStructure()));
+    testOk1(!NTMultiChannelDelta::isDelta(current->getPVStructure()));
+    testOk1(NTScalarMultiChannel::isCompatible(delta->getPVStructure()));
+
+    shared_vector<const int32> changedIndex =
+        NTMultiChannelDelta::getChangedIndex(delta->getPVStructure());
+    testOk1(changedIndex.size() == 2 && changedIndex[0] == 7 && changedIndex[1] == 900);
+    PVDoubleArray::const_svector values = delta->getValue<PVDoubleArray>()->view();
+    testOk1(values.size() == 2 && values[0] == 70.0 && values[1] == 9000.0);
+    testOk1(delta->getSeverity()->view()[0] == 1);
+    testOk1(delta->getChannelName()->getLength() == 2);
+    testOk(delta->getAlarm()->getSubField<PVString>("message")->get() == "changed",
+        "alarm copied");
+
+    shared_vector<int32> outOfRange(1, 1000);
+    try {
+        NTMultiChannelDelta::createDelta(current, freeze(outOfRange));
+        testFail("no exception for index out of range");
+    } catch (std::runtime_error &) {
+        testPass("exception for index out of range");
+    }
+}
+
+void test_merge()
+{
+    testDiag("test_merge");
+
+    NTScalarMultiChannelPtr previous = createSnapshot(100);
+    NTScalarMultiChannelPtr current = createSnapshot(100);
+    setElement(current->getValue<PVDoubleArray>(), 1, 10.0);
+    setElement(current->getSeverity(), 2, 2);
+    setElement(current->getMessage(), 2, string("HIHI"));
+    NTScalarMultiChannelPtr delta = NTMultiChannelDelta::createDelta(previous, current);
+
+    NTScalarMultiChannelPtr base = createSnapshot(100);
+    NTMultiChannelDelta::merge(base, delta);
+    testOk1(base->isValid());
+    testOk(NTMultiChannelDelta::findChanged(base, current).empty(), "merged snapshot equal");
+
+    NTScalarMultiChannelPtr shorter = createSnapshot(2);
+    try {
+        NTMultiChannelDelta::merge(shorter, delta);
+        testFail("no exception for delta not fitting snapshot");
+    } catch (std::runtime_error &) {
+        testPass("exception for delta not fitting snapshot");
+    }
+    testOk(shorter->getSeverity()->view()[1] == 0, "snapshot unchanged");
+
+    try {
+        NTMultiChannelDelta::merge(base, current);
+        testFail("no exception for merging a snapshot");
+    } catch (std::runtime_error &) {
+        testPass("exception for merging a snapshot");
+    }
+}
+
+void test_ntmultiChannel()
+{
+    testDiag("test_ntmultiChannel");
+
+    UnionConstPtr u = getFieldCreate()->createVariantUnion();
+    NTMultiChannelBuilderPtr builder = NTMultiChannel::createBuilder();
+    NTMultiChannelPtr previous = builder->value(u)->addSeverity()->create();
+    NTMultiChannelPtr current = builder->value(u)->addSeverity()->create();
+
+    size_t count = 10;
+    PVStringArray::svector names(count, string("channel"));
+    PVUnionArray::svector values(count);
+    PVIntArray::svector severity(count, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        values[i] = getPVDataCreate()->createPVVariantUnion();
+        PVDoublePtr pvDouble = getPVDataCreate()->createPVScalar<PVDouble>();
+        pvDouble->put(static_cast<double>(i));
+        values[i]->set(pvDouble);
+    }
+    PVStringArray::const_svector frozenNames(freeze(names));
+    PVUnionArray::const_svector frozenValues(freeze(values));
+    PVIntArray::const_svector frozenSeverity(freeze(severity));
+    previous->getChannelName()->replace(frozenNames);
+    previous->getValue()->replace(frozenValues);
+    previous->getSeverity()->replace(frozenSeverity);
+    current->getChannelName()->replace(frozenNames);
+    current->getSeverity()->replace(frozenSeverity);
+
+    // a different PVUnion with the same value is not a change
+    PVUnionArray::svector currentValues(frozenValues.size());
+    std::copy(frozenValues.begin(), frozenValues.end(), currentValues.begin());
+    currentValues[4] = getPVDataCreate()->createPVVariantUnion();
+    PVDoublePtr same = getPVDataCreate()->createPVScalar<PVDouble>();
+    same->put(4.0);
+    currentValues[4]->set(same);
+    currentValues[6] = getPVDataCreate()->createPVVariantUnion();
+    PVStringPtr other = getPVDataCreate()->createPVScalar<PVString>();
+    other->put("six");
+    currentValues[6]->set(other);
+    current->getValue()->replace(freeze(currentValues));
+
+    NTMultiChannelPtr delta = NTMultiChannelDelta::createDelta(previous, current);
+    shared_vector<const int32> changedIndex =
+        NTMultiChannelDelta::getChangedIndex(delta->getPVStructure());
+    testOk1(changedIndex.size() == 1 && changedIndex[0] == 6);
+    testOk1(delta->getValue()->getLength() == 1);
+
+    NTMultiChannelDelta::merge(previous, delta);
+    testOk(previous->getValue()->view()[6]->get<PVString>()->get() == "six",
+        "value merged");
+    testOk1(NTMultiChannelDelta::findChanged(previous, current).empty());
+
+    // a delta of another union type does not fit the snapshot
+    UnionConstPtr restricted = getFieldCreate()->createFieldBuilder()->
+        add("doubleValue", pvDouble)->createUnion();
+    NTMultiChannelPtr otherSnapshot = NTMultiChannel::createBuilder()->value(restricted)->create();
+    PVUnionArray::svector otherValues(count);
+    for (size_t i = 0; i < count; ++i)
+        otherValues[i] = getPVDataCreate()->createPVUnion(restricted);
+    otherSnapshot->getChannelName()->replace(frozenNames);
+    otherSnapshot->getValue()->replace(freeze(otherValues));
+    shared_vector<int32> first(1, 0);
+    NTMultiChannelPtr otherDelta = NTMultiChannelDelta::createDelta(otherSnapshot, freeze(first));
+    try {
+        NTMultiChannelDelta::merge(previous, otherDelta);
+        testFail("no exception for delta of another union type");
+    } catch (std::runtime_error &) {
+        testPass("exception for delta of another union type");
+    }
+}
+
+MAIN(testNTMultiChannelDelta) {
+    testPlan(26);
+    test_findChanged();
+    test_createDelta();
+    test_merge();
+    test_ntmultiChannel();
+    return testDone();
+}
@@ -0,0 +1,102 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/ntndarrayBufferPool.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+void test_reuse()
+{
+    testDiag("test_reuse");
+
+    NTNDArrayBufferPoolPtr pool = NTNDArrayBufferPool::create(2);
+    testOk1(pool.get() != 0);
+
+    std::tr1::shared_ptr<uint8> a = pool->allocate(1000);
+    testOk1(a.get() != 0);
+    testOk1(pool->getAllocations() == 1);
+    testOk1(pool->getIdle() == 0);
+
+    uint8 * first = a.get();
+    a.reset();
+    testOk1(pool->getIdle() == 1);
+
+    std::tr1::shared_ptr<uint8> b = pool->allocate(800);
+    testOk(b.get() == first, "released buffer reused");
+    testOk1(pool->getReuses() == 1);
+    testOk1(pool->getIdle() == 0);
+    b.reset();
+
+    std::tr1::shared_ptr<uint8> c = pool->allocate(400);
+    testOk(c.get() != first, "buffer more than twice the size not reused");
+    testOk1(pool->getAllocations() == 2);
+
+    std::tr1::shared_ptr<uint8> d = pool->allocate(2000);
+    testOk1(pool->getAllocations() == 3);
+    c.reset();
+    d.reset();
+    testOk1(pool->getIdle() == 2);
+
+    std::tr1::shared_ptr<uint8> e = pool->allocate(10);
+    e.reset();
+    testOk(pool->getIdle() == 2, "idle buffers limited to maxIdle");
+
+    pool->clear();
+    testOk1(pool->getIdle() == 0);
+}
+
+void test_array()
+{
+    testDiag("test_array");
+
+    NTNDArrayBufferPoolPtr pool = NTNDArrayBufferPool::create(4);
+
+    shared_vector<uint16> data = pool->allocateArray<uint16>(100);
+    testOk1(data.size() == 100);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint16>(i);
+
+    shared_vector<const uint16> frozen = freeze(data);
+    testOk1(frozen[99] == 99);
+    testOk1(pool->getIdle() == 0);
+
+    // as held by an NTNDArray value
+    shared_vector<const uint16> copy(frozen);
+    frozen.clear();
+    testOk(pool->getIdle() == 0, "buffer in use while referenced");
+    copy.clear();
+    testOk(pool->getIdle() == 1, "buffer back in pool when unreferenced");
+
+    shared_vector<double> values = pool->allocateArray<double>(25);
+    testOk1(values.size() == 25);
+    testOk(pool->getReuses() == 1, "buffer reused for another type");
+}
+
+void test_outlive()
+{
+    testDiag("test_outlive");
+
+    NTNDArrayBufferPoolPtr pool = NTNDArrayBufferPool::create(4);
+    shared_vector<int32> data = pool->allocateArray<int32>(10);
+    pool.reset();
+
+    data[9] = 7;
+    testOk1(data[9] == 7);
+    data.clear();
+    testPass("buffer released after the pool");
+}
+
+MAIN(testNTNDArrayBufferPool) {
+    testPlan(23);
+    test_reuse();
+    test_array();
+    test_outlive();
+    return testDone();
+}
@@ -0,0 +1,131 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntndarrayChecksum.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static NTNDArrayPtr createFrame(size_t count)
+{
+    NTNDArrayPtr ntndArray = NTNDArray::createBuilder()->create();
+
+    PVUShortArray::svector pixels(count);
+    for (size_t i = 0; i < count; ++i)
+        pixels[i] = static_cast<uint16>(i*31);
+    ntndArray->getValue()->select<PVUShortArray>("ushortValue")->replace(freeze(pixels));
+
+    PVStructureArrayPtr pvAttribute = ntndArray->getAttribute();
+    PVStructurePtr attribute = getPVDataCreate()->createPVStructure(
+        pvAttribute->getStructureArray()->getStructure());
+    attribute->getSubField<PVString>("name")->put("ColorMode");
+    PVIntPtr pvValue = getPVDataCreate()->createPVScalar<PVInt>();
+    pvValue->put(0);
+    attribute->getSubField<PVUnion>("value")->set(pvValue);
+    PVStructureArray::svector attributes;
+    attributes.push_back(attribute);
+    pvAttribute->replace(freeze(attributes));
+
+    return ntndArray;
+}
+
+void test_crc32c()
+{
+    testDiag("test_crc32c");
+    testDiag("hardware accelerated: %s",
+        NTNDArrayChecksum::isHardwareAccelerated() ? "yes" : "no");
+
+    const char * check = "123456789";
+    testOk1(NTNDArrayChecksum::crc32c(check, 9) == 0xe3069283);
+    testOk1(NTNDArrayChecksum::crc32c(check, 0) == 0);
+
+    uint32 crc = NTNDArrayChecksum::crc32c(check, 4);
+    testOk(NTNDArrayChecksum::crc32c(check + 4, 5, crc) == 0xe3069283,
+        "continued checksum");
+
+    // all lengths and alignments through the 8 byte steps
+    std::vector<uint8> data(300);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8>(i*7 + 3);
+    bool consistent = true;
+    for (size_t offset = 0; offset < 8; ++offset)
+        for (size_t size = 0; size < 40; ++size)
+        {
+            uint32 whole = NTNDArrayChecksum::crc32c(&data[offset], size);
+            uint32 parts = 0;
+            for (size_t i = 0; i < size; ++i)
+                parts = NTNDArrayChecksum::crc32c(&data[offset + i], 1, parts);
+            consistent = consistent && whole == parts;
+        }
+    testOk(consistent, "checksum independent of alignment and chunking");
+}
+
+void test_compute()
+{
+    testDiag("test_compute");
+
+    NTNDArrayPtr ntndArray = NTNDArray::createBuilder()->create();
+    PVUShortArray::svector pixels(2);
+    pixels[0] = 0x0102;
+    pixels[1] = 0x0304;
+    ntndArray->getValue()->select<PVUShortArray>("ushortValue")->replace(freeze(pixels));
+
+    const uint8 littleEndian[] = { 0x02, 0x01, 0x04, 0x03 };
+    testOk(NTNDArrayChecksum::compute(ntndArray) ==
+        NTNDArrayChecksum::crc32c(littleEndian, sizeof(littleEndian)),
+        "checksum of the little-endian bytes");
+
+    NTNDArrayPtr empty = NTNDArray::createBuilder()->create();
+    try {
+        NTNDArrayChecksum::compute(empty);
+        testFail("checksum of an empty union");
+    } catch (std::runtime_error &) {
+        testPass("empty union rejected");
+    }
+}
+
+void test_attribute()
+{
+    testDiag("test_attribute");
+
+    NTNDArrayPtr ntndArray = createFrame(1000);
+    testOk1(!NTNDArrayChecksum::hasChecksum(ntndArray));
+    testOk(!NTNDArrayChecksum::verify(ntndArray), "missing checksum fails");
+
+    uint32 crc = NTNDArrayChecksum::attach(ntndArray);
+    testOk1(crc == NTNDArrayChecksum::compute(ntndArray));
+    testOk1(NTNDArrayChecksum::hasChecksum(ntndArray));
+    testOk1(NTNDArrayChecksum::verify(ntndArray));
+    testOk1(ntndArray->getAttribute()->view().size() == 2);
+    testOk1(ntndArray->getAttribute("ColorMode").get() != 0);
+
+    uint32 value = 0;
+    testOk1(ntndArray->getAttributeValue(NTNDArrayChecksum::attributeName, value) &&
+        value == crc);
+
+    // corrupt one element
+    PVUShortArrayPtr pvPixels = ntndArray->getValue()->get<PVUShortArray>();
+    PVUShortArray::svector pixels(pvPixels->reuse());
+    pixels[500] ^= 0x10;
+    pvPixels->replace(freeze(pixels));
+    testOk(!NTNDArrayChecksum::verify(ntndArray), "corruption detected");
+
+    NTNDArrayChecksum::attach(ntndArray);
+    testOk1(NTNDArrayChecksum::verify(ntndArray));
+    testOk(ntndArray->getAttribute()->view().size() == 2, "checksum replaced");
+}
+
+MAIN(testNTNDArrayChecksum) {
+    testPlan(17);
+    test_crc32c();
+    test_compute();
+    test_attribute();
+    return testDone();
+}
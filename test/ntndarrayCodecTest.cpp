@@ -0,0 +1,138 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntndarrayCodec.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static const size_t width = 64;
+static const size_t height = 32;
+
+static NTNDArrayPtr createFrame(int32 uniqueId, uint16 offset)
+{
+    NTNDArrayPtr ntndArray = NTNDArray::createBuilder()->create();
+
+    PVStructureArrayPtr pvDim = ntndArray->getDimension();
+    StructureConstPtr dimStructure = pvDim->getStructureArray()->getStructure();
+    PVStructureArray::svector dims;
+    for (int i = 0; i < 2; ++i)
+    {
+        PVStructurePtr dim = getPVDataCreate()->createPVStructure(dimStructure);
+        dim->getSubField<PVInt>("size")->put(i == 0 ? width : height);
+        dims.push_back(dim);
+    }
+    pvDim->replace(freeze(dims));
+
+    // a slowly varying image: only the first row depends on offset
+    PVUShortArray::svector pixels(width*height);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = static_cast<uint16>(i % 1000);
+    for (size_t i = 0; i < width; ++i)
+        pixels[i] += offset;
+    ntndArray->getValue()->select<PVUShortArray>("ushortValue")->replace(freeze(pixels));
+
+    int64 size = width*height*sizeof(uint16);
+    ntndArray->getCompressedDataSize()->put(size);
+    ntndArray->getUncompressedDataSize()->put(size);
+    ntndArray->getUniqueId()->put(uniqueId);
+    return ntndArray;
+}
+
+static bool sameValue(NTNDArrayPtr const & a, NTNDArrayPtr const & b)
+{
+    PVUShortArrayPtr va = a->getValue()->get<PVUShortArray>();
+    PVUShortArrayPtr vb = b->getValue()->get<PVUShortArray>();
+    if (!va.get() || !vb.get())
+        return false;
+    return va->view() == vb->view();
+}
+
+static bool isKeyFrame(NTNDArrayPtr const & ntndArray)
+{
+    PVStructurePtr parameters =
+        ntndArray->getCodec()->getSubField<PVUnion>("parameters")->get<PVStructure>();
+    return parameters.get() && parameters->getSubField<PVBoolean>("keyFrame")->get();
+}
+
+void test_roundTrip()
+{
+    testDiag("test_roundTrip");
+
+    NTNDArrayDeltaEncoderPtr encoder = NTNDArrayDeltaEncoder::create(3);
+    NTNDArrayDeltaDecoderPtr decoder = NTNDArrayDeltaDecoder::create();
+    testOk1(encoder.get() != 0);
+    testOk1(decoder.get() != 0);
+
+    for (int32 id = 1; id <= 4; ++id)
+    {
+        NTNDArrayPtr original = createFrame(id, static_cast<uint16>(id));
+        NTNDArrayPtr frame = createFrame(id, static_cast<uint16>(id));
+
+        encoder->encode(frame);
+        testOk(frame->getCodec()->getSubField<PVString>("name")->get() ==
+            NTNDArrayDeltaCodec::name, "frame %d encoded", id);
+        testOk(isKeyFrame(frame) == (id == 1 || id == 4), "frame %d key frame", id);
+        testOk1(frame->isValid());
+        if (id == 2)
+            testOk(frame->getCompressedDataSize()->get() < 512,
+                "delta frame is small (%d bytes)",
+                static_cast<int>(frame->getCompressedDataSize()->get()));
+
+        testOk(decoder->decode(frame), "frame %d decoded", id);
+        testOk1(frame->getCodec()->getSubField<PVString>("name")->get().empty());
+        testOk1(frame->isValid());
+        testOk(sameValue(frame, original), "frame %d value restored", id);
+    }
+}
+
+void test_missingReference()
+{
+    testDiag("test_missingReference");
+
+    NTNDArrayDeltaEncoderPtr encoder = NTNDArrayDeltaEncoder::create(0);
+    NTNDArrayDeltaDecoderPtr decoder = NTNDArrayDeltaDecoder::create();
+
+    NTNDArrayPtr first = createFrame(1, 0);
+    NTNDArrayPtr second = createFrame(2, 5);
+    encoder->encode(first);
+    encoder->encode(second);
+
+    // the key frame was lost
+    testOk(!decoder->decode(second), "delta frame without reference rejected");
+    testOk1(!second->getCodec()->getSubField<PVString>("name")->get().empty());
+
+    encoder->requestKeyFrame();
+    NTNDArrayPtr third = createFrame(3, 7);
+    encoder->encode(third);
+    testOk1(isKeyFrame(third));
+    testOk(decoder->decode(third), "key frame decoded");
+
+    NTNDArrayPtr uncompressed = createFrame(4, 9);
+    testOk(decoder->decode(uncompressed), "uncompressed frame accepted");
+
+    NTNDArrayPtr corrupt = createFrame(5, 0);
+    encoder->requestKeyFrame();
+    encoder->encode(corrupt);
+    corrupt->getUncompressedDataSize()->put(static_cast<int64>(1) << 40);
+    try {
+        decoder->decode(corrupt);
+        testFail("frame with uncompressedSize not matching its dimension decoded");
+    } catch (std::runtime_error &) {
+        testPass("frame with uncompressedSize not matching its dimension rejected");
+    }
+}
+
+MAIN(testNTNDArrayCodec) {
+    testPlan(37);
+    test_roundTrip();
+    test_missingReference();
+    return testDone();
+}
@@ -0,0 +1,213 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntndarrayColor.h>
+
+#include "ntndarrayTestFrame.h"
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static const size_t width = 6;
+static const size_t height = 4;
+
+static PVStructurePtr createAttribute(NTNDArrayPtr const & ntndArray,
+    std::string const & name, int32 value)
+{
+    PVStructurePtr attribute = getPVDataCreate()->createPVStructure(
+        ntndArray->getAttribute()->getStructureArray()->getStructure());
+    attribute->getSubField<PVString>("name")->put(name);
+    PVIntPtr pvValue = getPVDataCreate()->createPVScalar<PVInt>();
+    pvValue->put(value);
+    attribute->getSubField<PVUnion>("value")->set(pvValue);
+    return attribute;
+}
+
+static void setAttribute(NTNDArrayPtr const & ntndArray, std::string const & name,
+    int32 value)
+{
+    PVStructureArray::svector attributes;
+    attributes.push_back(createAttribute(ntndArray, name, value));
+    ntndArray->getAttribute()->replace(freeze(attributes));
+}
+
+// component c of pixel (x, y)
+static uint16 rgbValue(size_t c, size_t x, size_t y)
+{
+    return static_cast<uint16>(1000*c + 10*y + x);
+}
+
+static NTNDArrayPtr createRGB1()
+{
+    PVUShortArray::svector pixels(3*width*height);
+    for (size_t y = 0; y < height; ++y)
+        for (size_t x = 0; x < width; ++x)
+            for (size_t c = 0; c < 3; ++c)
+                pixels[c + 3*x + 3*width*y] = rgbValue(c, x, y);
+    return createImage(makeSizes(3, width, height), pixels);
+}
+
+static std::vector<size_t> getSizes(NTNDArrayPtr const & ntndArray)
+{
+    PVStructureArray::const_svector dims = ntndArray->getDimension()->view();
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < dims.size(); ++i)
+        sizes.push_back(dims[i]->getSubField<PVInt>("size")->get());
+    return sizes;
+}
+
+void test_colorMode()
+{
+    testDiag("test_colorMode");
+
+    PVUShortArray::svector rgb(3*width*height);
+    testOk1(NTNDArrayColor::getColorMode(createImage(makeSizes(3, width, height), rgb)) ==
+        NTNDArrayColor::rgb1);
+    PVUShortArray::svector rgb2(3*width*height);
+    testOk1(NTNDArrayColor::getColorMode(createImage(makeSizes(width, 3, height), rgb2)) ==
+        NTNDArrayColor::rgb2);
+    PVUShortArray::svector rgb3(3*width*height);
+    testOk1(NTNDArrayColor::getColorMode(createImage(makeSizes(width, height, 3), rgb3)) ==
+        NTNDArrayColor::rgb3);
+
+    PVUShortArray::svector mono(width*height);
+    NTNDArrayPtr image = createImage(makeSizes(width, height), mono);
+    testOk1(NTNDArrayColor::getColorMode(image) == NTNDArrayColor::mono);
+    testOk1(NTNDArrayColor::getBayerPattern(image) == NTNDArrayColor::rggb);
+
+    setAttribute(image, NTNDArrayColor::colorModeAttribute, NTNDArrayColor::bayer);
+    testOk1(NTNDArrayColor::getColorMode(image) == NTNDArrayColor::bayer);
+
+    setAttribute(image, NTNDArrayColor::colorModeAttribute, NTNDArrayColor::rgb1);
+    try {
+        NTNDArrayColor::getColorMode(image);
+        testFail("color mode not matching the dimensions accepted");
+    } catch (std::runtime_error &) {
+        testPass("color mode not matching the dimensions rejected");
+    }
+}
+
+void test_rearrange()
+{
+    testDiag("test_rearrange");
+
+    NTNDArrayPtr image = createRGB1();
+    testOk(NTNDArrayColor::convert(image, NTNDArrayColor::rgb1) == image,
+        "image in the requested layout returned as is");
+
+    NTNDArrayPtr rgb3 = NTNDArrayColor::convert(image, NTNDArrayColor::rgb3);
+    testOk1(getSizes(rgb3) == makeSizes(width, height, 3));
+    testOk1(NTNDArrayColor::getColorMode(rgb3) == NTNDArrayColor::rgb3);
+    int32 mode = 0;
+    testOk1(rgb3->getAttributeValue(NTNDArrayColor::colorModeAttribute, mode) &&
+        mode == NTNDArrayColor::rgb3);
+
+    PVUShortArray::const_svector planes = rgb3->getValue()->get<PVUShortArray>()->view();
+    bool planar = planes.size() == 3*width*height;
+    for (size_t c = 0; planar && c < 3; ++c)
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                planar = planar && planes[x + width*y + width*height*c] == rgbValue(c, x, y);
+    testOk(planar, "plane interleaved values");
+
+    NTNDArrayPtr rgb2 = NTNDArrayColor::convert(rgb3, NTNDArrayColor::rgb2, 1);
+    testOk1(getSizes(rgb2) == makeSizes(width, 3, height));
+    PVUShortArray::const_svector rows = rgb2->getValue()->get<PVUShortArray>()->view();
+    bool rowInterleaved = rows.size() == 3*width*height;
+    for (size_t c = 0; rowInterleaved && c < 3; ++c)
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                rowInterleaved = rowInterleaved && rows[x + width*c + 3*width*y] == rgbValue(c, x, y);
+    testOk(rowInterleaved, "row interleaved values");
+
+    NTNDArrayPtr rgb1 = NTNDArrayColor::convert(rgb2, NTNDArrayColor::rgb1);
+    PVUShortArray::const_svector original = image->getValue()->get<PVUShortArray>()->view();
+    PVUShortArray::const_svector roundTrip = rgb1->getValue()->get<PVUShortArray>()->view();
+    testOk(roundTrip.size() == original.size() &&
+        std::equal(roundTrip.begin(), roundTrip.end(), original.begin()),
+        "round trip through all layouts");
+    testOk1(getSizes(image) == makeSizes(3, width, height));
+}
+
+void test_bayer()
+{
+    testDiag("test_bayer");
+
+    // BGGR mosaic of red 100, green 50 + x and blue 10*y
+    PVUShortArray::svector pixels(width*height);
+    for (size_t y = 0; y < height; ++y)
+        for (size_t x = 0; x < width; ++x)
+        {
+            bool evenRow = y % 2 == 0, evenColumn = x % 2 == 0;
+            if (evenRow && evenColumn)
+                pixels[y*width + x] = static_cast<uint16>(10*y);
+            else if (!evenRow && !evenColumn)
+                pixels[y*width + x] = 100;
+            else
+                pixels[y*width + x] = static_cast<uint16>(50 + x);
+        }
+    NTNDArrayPtr image = createImage(makeSizes(width, height), pixels);
+
+    PVStructureArray::svector attributes;
+    attributes.push_back(createAttribute(image, NTNDArrayColor::colorModeAttribute,
+        NTNDArrayColor::bayer));
+    attributes.push_back(createAttribute(image, NTNDArrayColor::bayerPatternAttribute,
+        NTNDArrayColor::bggr));
+    image->getAttribute()->replace(freeze(attributes));
+    testOk1(NTNDArrayColor::getBayerPattern(image) == NTNDArrayColor::bggr);
+
+    NTNDArrayPtr rgb = NTNDArrayColor::convert(image, NTNDArrayColor::rgb1);
+    testOk1(getSizes(rgb) == makeSizes(3, width, height));
+    testOk1(NTNDArrayColor::getColorMode(rgb) == NTNDArrayColor::rgb1);
+
+    PVUShortArray::const_svector values = rgb->getValue()->get<PVUShortArray>()->view();
+    bool redConstant = values.size() == 3*width*height;
+    bool interior = redConstant;
+    for (size_t y = 0; redConstant && y < height; ++y)
+        for (size_t x = 0; x < width; ++x)
+        {
+            const uint16 * p = &values[3*x + 3*width*y];
+            redConstant = redConstant && p[0] == 100;
+            if (x > 0 && y > 0 && x + 1 < width && y + 1 < height)
+                interior = interior && p[1] == 50 + x && p[2] == 10*y;
+        }
+    testOk(redConstant, "constant channel reconstructed");
+    testOk(interior, "linear channels interpolated");
+}
+
+void test_invalid()
+{
+    testDiag("test_invalid");
+
+    PVUShortArray::svector mono(width*height);
+    NTNDArrayPtr image = createImage(makeSizes(width, height), mono);
+    try {
+        NTNDArrayColor::convert(image, NTNDArrayColor::rgb1);
+        testFail("mono image converted");
+    } catch (std::runtime_error &) {
+        testPass("mono image rejected");
+    }
+
+    try {
+        NTNDArrayColor::convert(createRGB1(), NTNDArrayColor::bayer);
+        testFail("conversion to Bayer accepted");
+    } catch (std::runtime_error &) {
+        testPass("conversion to Bayer rejected");
+    }
+}
+
+MAIN(testNTNDArrayColor) {
+    testPlan(23);
+    test_colorMode();
+    test_rearrange();
+    test_bayer();
+    test_invalid();
+    return testDone();
+}
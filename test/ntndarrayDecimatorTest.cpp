@@ -0,0 +1,189 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntndarrayDecimator.h>
+
+#include "ntndarrayTestFrame.h"
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static NTNDArrayPtr createFrame(size_t width, size_t height, int32 uniqueId,
+    double seconds = 0)
+{
+    // pixel (x, y) is 10*x + y + uniqueId
+    PVUShortArray::svector pixels(width*height);
+    for (size_t y = 0; y < height; ++y)
+        for (size_t x = 0; x < width; ++x)
+            pixels[y*width + x] = static_cast<uint16>(10*x + y + uniqueId);
+    NTNDArrayPtr ntndArray = createImage(makeSizes(width, height), pixels, uniqueId);
+
+    PVTimeStamp pvTimeStamp;
+    ntndArray->attachDataTimeStamp(pvTimeStamp);
+    int64 whole = static_cast<int64>(seconds);
+    pvTimeStamp.set(TimeStamp(1000 + whole,
+        static_cast<int32>((seconds - whole)*1e9 + 0.5)));
+    return ntndArray;
+}
+
+static PVUShortArray::const_svector pixels(NTNDArrayPtr const & ntndArray)
+{
+    return ntndArray->getValue()->get<PVUShortArray>()->view();
+}
+
+static int32 dimension(NTNDArrayPtr const & ntndArray, size_t index,
+    std::string const & field)
+{
+    return ntndArray->getDimension()->view()[index]->getSubField<PVInt>(field)->get();
+}
+
+void test_everyNth()
+{
+    testDiag("test_everyNth");
+
+    NTNDArrayDecimatorPtr decimator = NTNDArrayDecimator::create(3);
+    testOk1(decimator->getDecimation() == 3);
+
+    std::vector<int32> emitted;
+    bool unchanged = true;
+    for (int32 i = 0; i < 9; ++i)
+    {
+        NTNDArrayPtr frame = createFrame(4, 4, i);
+        NTNDArrayPtr result = decimator->process(frame);
+        if (result.get())
+        {
+            emitted.push_back(result->getUniqueId()->get());
+            unchanged = unchanged && result == frame;
+        }
+    }
+    testOk1(emitted.size() == 3);
+    testOk1(emitted.size() == 3 && emitted[0] == 2 && emitted[1] == 5 && emitted[2] == 8);
+    testOk(unchanged, "frames without reduction returned as is");
+}
+
+void test_minimumPeriod()
+{
+    testDiag("test_minimumPeriod");
+
+    // 200 Hz reduced to 10 Hz
+    NTNDArrayDecimatorPtr decimator = NTNDArrayDecimator::create();
+    decimator->setMinimumPeriod(0.099);
+    testOk1(decimator->getMinimumPeriod() == 0.099);
+
+    std::vector<int32> emitted;
+    for (int32 i = 0; i < 100; ++i)
+    {
+        NTNDArrayPtr result = decimator->process(createFrame(4, 4, i, i*0.005));
+        if (result.get())
+            emitted.push_back(result->getUniqueId()->get());
+    }
+    testOk1(emitted.size() == 5);
+    testOk1(emitted.size() == 5 && emitted[0] == 0 && emitted[1] == 20 && emitted[4] == 80);
+
+    decimator->reset();
+    testOk(decimator->process(createFrame(4, 4, 100, 0.42)).get() != 0,
+        "first frame after reset emitted");
+}
+
+void test_average()
+{
+    testDiag("test_average");
+
+    NTNDArrayDecimatorPtr decimator = NTNDArrayDecimator::create(4);
+    decimator->setAveraging(true);
+    testOk1(decimator->isAveraging());
+
+    NTNDArrayPtr result;
+    for (int32 i = 0; i < 4; ++i)
+    {
+        NTNDArrayPtr frame = createFrame(3, 2, 10*i);
+        result = decimator->process(frame);
+        if (i < 3 && result.get())
+            testFail("frame emitted before the group is complete");
+    }
+    testOk1(result.get() != 0);
+    if (!result.get())
+        return;
+
+    // mean of uniqueIds 0, 10, 20, 30 is 15
+    PVUShortArray::const_svector values = pixels(result);
+    bool mean = values.size() == 6;
+    for (size_t y = 0; mean && y < 2; ++y)
+        for (size_t x = 0; x < 3; ++x)
+            mean = mean && values[y*3 + x] == 10*x + y + 15;
+    testOk(mean, "value is the mean of the group");
+    testOk1(result->getUniqueId()->get() == 30);
+    testOk1(dimension(result, 0, "size") == 3);
+    testOk1(decimator->getBufferPool()->getAllocations() == 1);
+}
+
+void test_binning()
+{
+    testDiag("test_binning");
+
+    NTNDArrayDecimatorPtr decimator = NTNDArrayDecimator::create();
+    std::vector<size_t> binning;
+    binning.push_back(2);
+    binning.push_back(2);
+    decimator->setBinning(binning);
+
+    // the last column and row do not fill a block
+    NTNDArrayPtr frame = createFrame(5, 3, 0);
+    NTNDArrayPtr result = decimator->process(frame);
+    testOk1(result.get() != 0 && result != frame);
+    if (!result.get())
+        return;
+
+    testOk1(dimension(result, 0, "size") == 2);
+    testOk1(dimension(result, 1, "size") == 1);
+    testOk1(dimension(result, 0, "binning") == 2);
+    testOk1(dimension(result, 1, "fullSize") == 3);
+    testOk1(result->getCompressedDataSize()->get() == 4);
+
+    // mean of (0, 1, 10, 11) and (20, 21, 30, 31), rounded
+    PVUShortArray::const_svector values = pixels(result);
+    testOk1(values.size() == 2 && values[0] == 6 && values[1] == 26);
+    testOk(frame->getDimension()->view()[0]->getSubField<PVInt>("size")->get() == 5,
+        "input frame unchanged");
+
+    binning[0] = 8;
+    decimator->setBinning(binning);
+    try {
+        decimator->process(createFrame(5, 3, 1));
+        testFail("binning larger than the dimension accepted");
+    } catch (std::runtime_error &) {
+        testPass("binning larger than the dimension rejected");
+    }
+}
+
+void test_compressed()
+{
+    testDiag("test_compressed");
+
+    NTNDArrayDecimatorPtr decimator = NTNDArrayDecimator::create();
+    NTNDArrayPtr frame = createFrame(4, 4, 0);
+    frame->getCodec()->getSubField<PVString>("name")->put("delta");
+    try {
+        decimator->process(frame);
+        testFail("compressed frame accepted");
+    } catch (std::runtime_error &) {
+        testPass("compressed frame rejected");
+    }
+}
+
+MAIN(testNTNDArrayDecimator) {
+    testPlan(24);
+    test_everyNth();
+    test_minimumPeriod();
+    test_average();
+    test_binning();
+    test_compressed();
+    return testDone();
+}
@@ -0,0 +1,160 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntndarrayDecodePipeline.h>
+
+#include "ntndarrayTestFrame.h"
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static const size_t width = 64;
+static const size_t height = 48;
+static const size_t frameCount = 20;
+
+static NTNDArrayPtr createFrame(int32 uniqueId)
+{
+    PVUShortArray::svector pixels(width*height);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = static_cast<uint16>((i + uniqueId) % 50);
+    return createImage(makeSizes(width, height), pixels, uniqueId);
+}
+
+static bool checkFrame(NTNDArrayPtr const & ntndArray, int32 uniqueId)
+{
+    if (ntndArray->getUniqueId()->get() != uniqueId)
+        return false;
+    if (!ntndArray->getCodec()->getSubField<PVString>("name")->get().empty())
+        return false;
+
+    PVUShortArrayPtr pvPixels = ntndArray->getValue()->get<PVUShortArray>();
+    if (!pvPixels.get())
+        return false;
+    PVUShortArray::const_svector pixels = pvPixels->view();
+    if (pixels.size() != width*height)
+        return false;
+    for (size_t i = 0; i < pixels.size(); ++i)
+        if (pixels[i] != static_cast<uint16>((i + uniqueId) % 50))
+            return false;
+    return true;
+}
+
+static std::vector<size_t> tileSizes()
+{
+    std::vector<size_t> sizes;
+    sizes.push_back(16);
+    sizes.push_back(16);
+    return sizes;
+}
+
+void test_decode()
+{
+    testDiag("test_decode");
+
+    NTNDArrayDecodePipelinePtr pipeline = NTNDArrayDecodePipeline::create(4, 8);
+    testOk1(pipeline.get() != 0);
+
+    bool decoded = true;
+    size_t taken = 0;
+    for (size_t i = 0; i < frameCount; ++i)
+    {
+        NTNDArrayPtr frame = createFrame(i);
+        if (i % 2 == 0)
+            NTNDArrayTiledCodec::encode(frame, tileSizes());
+        if (!pipeline->put(frame, 1.0))
+            decoded = false;
+
+        // keep the pipeline partly filled so frames overtake each other
+        if (i >= 4)
+        {
+            NTNDArrayPtr result = pipeline->take(5.0);
+            if (!result.get() || !checkFrame(result, taken))
+                decoded = false;
+            ++taken;
+        }
+    }
+    while (taken < frameCount)
+    {
+        NTNDArrayPtr result = pipeline->take(5.0);
+        if (!result.get() || !checkFrame(result, taken))
+            decoded = false;
+        ++taken;
+    }
+    testOk(decoded, "frames decoded and taken in order");
+
+    NTNDArrayDecodePipeline::Statistics statistics = pipeline->getStatistics();
+    testOk1(statistics.frames == frameCount);
+    testOk1(statistics.failed == 0);
+    testOk1(statistics.inProgress == 0);
+    testOk1(statistics.maxDecodeTime >= statistics.meanDecodeTime);
+    testOk1(pipeline->getBufferPool()->getAllocations() > 0);
+
+    testOk(!pipeline->take(0.01).get(), "take times out when empty");
+
+    pipeline->resetStatistics();
+    testOk1(pipeline->getStatistics().frames == 0);
+}
+
+void test_failed()
+{
+    testDiag("test_failed");
+
+    NTNDArrayDecodePipelinePtr pipeline = NTNDArrayDecodePipeline::create(2, 4);
+
+    NTNDArrayPtr bad = createFrame(1);
+    bad->getCodec()->getSubField<PVString>("name")->put("unknown");
+
+    testOk1(pipeline->put(createFrame(0)));
+    testOk1(pipeline->put(bad));
+    testOk1(pipeline->put(createFrame(2)));
+
+    NTNDArrayPtr first = pipeline->take(5.0);
+    testOk1(first.get() && first->getUniqueId()->get() == 0);
+    NTNDArrayPtr second = pipeline->take(5.0);
+    testOk(second.get() && second->getUniqueId()->get() == 2,
+        "frame failing to decode dropped");
+    testOk1(pipeline->getStatistics().failed == 1);
+}
+
+void test_full()
+{
+    testDiag("test_full");
+
+    NTNDArrayDecodePipelinePtr pipeline = NTNDArrayDecodePipeline::create(1, 2);
+
+    testOk1(pipeline->put(createFrame(0)));
+    testOk1(pipeline->put(createFrame(1)));
+    testOk(!pipeline->put(createFrame(2), 0.01), "put times out when full");
+
+    testOk1(pipeline->take(5.0).get() != 0);
+    testOk(pipeline->put(createFrame(2), 1.0), "put succeeds after take");
+}
+
+void test_stop()
+{
+    testDiag("test_stop");
+
+    NTNDArrayDecodePipelinePtr pipeline = NTNDArrayDecodePipeline::create(2, 4);
+    testOk1(pipeline->put(createFrame(0)));
+    testOk1(pipeline->take(5.0).get() != 0);
+
+    pipeline->stop();
+    testOk(!pipeline->put(createFrame(1)), "put fails after stop");
+    testOk(!pipeline->take().get(), "take returns null after stop");
+}
+
+MAIN(testNTNDArrayDecodePipeline) {
+    testPlan(24);
+    test_decode();
+    test_failed();
+    test_full();
+    test_stop();
+    return testDone();
+}
@@ -0,0 +1,215 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <cstdio>
+#include <stdexcept>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntndarrayFrameStore.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static const char * fileName = "ntndarrayFrameStoreTest.dat";
+
+static NTNDArrayPtr createFrame(int32 uniqueId, TimeStamp const & dataTime)
+{
+    NTNDArrayPtr ntndArray = NTNDArray::createBuilder()->create();
+    ntndArray->getUniqueId()->put(uniqueId);
+
+    PVTimeStamp pvDataTimeStamp;
+    ntndArray->attachDataTimeStamp(pvDataTimeStamp);
+    pvDataTimeStamp.set(dataTime);
+    return ntndArray;
+}
+
+static void setDimension(NTNDArrayPtr const & ntndArray, int32 width, int32 height)
+{
+    PVStructureArrayPtr pvDim = ntndArray->getDimension();
+    StructureConstPtr dimStructure = pvDim->getStructureArray()->getStructure();
+    PVStructureArray::svector dims;
+    for (int i = 0; i < 2; ++i)
+    {
+        PVStructurePtr dim = getPVDataCreate()->createPVStructure(dimStructure);
+        dim->getSubField<PVInt>("size")->put(i == 0 ? width : height);
+        dims.push_back(dim);
+    }
+    pvDim->replace(freeze(dims));
+}
+
+static void writeFrames()
+{
+    NTNDArrayFrameWriterPtr writer = NTNDArrayFrameWriter::create(fileName);
+
+    // 100x50 ushort image with an attribute and codec parameters
+    NTNDArrayPtr image = createFrame(10, TimeStamp(1000, 500000000));
+    setDimension(image, 100, 50);
+    PVUShortArray::svector pixels(100*50);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = static_cast<uint16>(i);
+    image->getValue()->select<PVUShortArray>("ushortValue")->replace(freeze(pixels));
+    image->getCompressedDataSize()->put(100*50*2);
+    image->getUncompressedDataSize()->put(100*50*2);
+
+    PVStructureArrayPtr pvAttribute = image->getAttribute();
+    PVStructurePtr attribute = getPVDataCreate()->createPVStructure(
+        pvAttribute->getStructureArray()->getStructure());
+    attribute->getSubField<PVString>("name")->put("ExposureTime");
+    PVDoublePtr exposureTime = getPVDataCreate()->createPVScalar<PVDouble>();
+    exposureTime->put(0.25);
+    attribute->getSubField<PVUnion>("value")->set(exposureTime);
+    PVStructureArray::svector attributes;
+    attributes.push_back(attribute);
+    pvAttribute->replace(freeze(attributes));
+
+    image->getCodec()->getSubField<PVString>("name")->put("test");
+    PVIntPtr level = getPVDataCreate()->createPVScalar<PVInt>();
+    level->put(3);
+    image->getCodec()->getSubField<PVUnion>("parameters")->set(level);
+
+    writer->write(image);
+
+    // no value
+    writer->write(createFrame(11, TimeStamp(1002, 0)));
+
+    NTNDArrayPtr spectrum = createFrame(12, TimeStamp(1001, 0));
+    PVDoubleArray::svector values(3);
+    values[0] = 1.5;
+    values[1] = -2.0;
+    values[2] = 1e10;
+    spectrum->getValue()->select<PVDoubleArray>("doubleValue")->replace(freeze(values));
+    writer->write(spectrum);
+
+    testOk1(writer->getFrameCount() == 3);
+    writer->close();
+}
+
+void test_readWrite()
+{
+    testDiag("test_readWrite");
+
+    writeFrames();
+
+    NTNDArrayFrameReaderPtr reader = NTNDArrayFrameReader::create(fileName);
+    testOk1(reader->getFrameCount() == 3);
+    testDiag("memory mapped: %s", reader->isMapped() ? "yes" : "no");
+
+    NTNDArrayPtr image = reader->read(0);
+    testOk1(image->getUniqueId()->get() == 10);
+    testOk1(image->getCompressedDataSize()->get() == 100*50*2);
+    testOk1(image->isValid());
+
+    PVStructureArray::const_svector dims = image->getDimension()->view();
+    testOk1(dims.size() == 2);
+    testOk1(dims.size() == 2 && dims[0]->getSubField<PVInt>("size")->get() == 100);
+    testOk1(dims.size() == 2 && dims[1]->getSubField<PVInt>("size")->get() == 50);
+
+    double exposureTime = 0;
+    testOk1(image->getAttributeValue("ExposureTime", exposureTime));
+    testOk1(exposureTime == 0.25);
+
+    testOk1(image->getCodec()->getSubField<PVString>("name")->get() == "test");
+    PVIntPtr level = image->getCodec()->getSubField<PVUnion>("parameters")->get<PVInt>();
+    testOk1(level.get() && level->get() == 3);
+
+    PVUShortArrayPtr pixels = image->getValue()->get<PVUShortArray>();
+    testOk1(pixels.get() != 0);
+    if (pixels.get())
+    {
+        PVUShortArray::const_svector data = pixels->view();
+        bool same = data.size() == 100*50;
+        for (size_t i = 0; same && i < data.size(); ++i)
+            same = data[i] == static_cast<uint16>(i);
+        testOk(same, "image value restored");
+    }
+    else
+        testFail("image value restored");
+
+    TimeStamp dataTime;
+    PVTimeStamp pvDataTimeStamp;
+    image->attachDataTimeStamp(pvDataTimeStamp);
+    pvDataTimeStamp.get(dataTime);
+    testOk1(dataTime == TimeStamp(1000, 500000000));
+
+    NTNDArrayPtr empty = reader->read(1);
+    testOk1(empty->getUniqueId()->get() == 11);
+    testOk1(empty->getValue()->get().get() == 0);
+
+    NTNDArrayPtr spectrum = reader->read(2);
+    PVDoubleArrayPtr values = spectrum->getValue()->get<PVDoubleArray>();
+    testOk1(values.get() && values->view().size() == 3);
+    testOk1(values.get() && values->view().size() == 3 &&
+        values->view()[0] == 1.5 && values->view()[2] == 1e10);
+
+    // values may refer to the file mapping, which outlives the reader
+    reader.reset();
+    testOk1(pixels.get() && pixels->view()[4999] == 4999);
+
+    try {
+        NTNDArrayFrameReader::create(fileName)->read(3);
+        testFail("read past the last frame");
+    } catch (std::out_of_range&) {
+        testPass("read past the last frame throws");
+    }
+}
+
+void test_index()
+{
+    testDiag("test_index");
+
+    NTNDArrayFrameReaderPtr reader = NTNDArrayFrameReader::create(fileName);
+
+    size_t index = 99;
+    testOk1(reader->findUniqueId(11, index) && index == 1);
+    testOk1(reader->findUniqueId(12, index) && index == 2);
+    testOk1(!reader->findUniqueId(13, index));
+
+    testOk1(reader->findTime(TimeStamp(0, 0), index) && index == 0);
+    testOk1(reader->findTime(TimeStamp(1000, 600000000), index) && index == 2);
+    testOk1(reader->findTime(TimeStamp(1001, 1), index) && index == 1);
+    testOk1(!reader->findTime(TimeStamp(1002, 1), index));
+
+    testOk1(reader->getUniqueId(2) == 12);
+    testOk1(reader->getDataTimeStamp(1) == TimeStamp(1002, 0));
+}
+
+void test_truncated()
+{
+    testDiag("test_truncated");
+
+    // an incomplete record, as left by a crashed writer
+    FILE * file = fopen(fileName, "ab");
+    testOk1(file != 0);
+    if (file)
+    {
+        char partial[40] = { 0 };
+        fwrite(partial, 1, sizeof(partial), file);
+        fclose(file);
+    }
+
+    NTNDArrayFrameReaderPtr reader = NTNDArrayFrameReader::create(fileName);
+    testOk1(reader->getFrameCount() == 3);
+
+    remove(fileName);
+
+    try {
+        NTNDArrayFrameReader::create(fileName);
+        testFail("open missing frame store");
+    } catch (std::runtime_error&) {
+        testPass("open missing frame store throws");
+    }
+}
+
+MAIN(testNTNDArrayFrameStore) {
+    testPlan(33);
+    test_readWrite();
+    test_index();
+    test_truncated();
+    return testDone();
+}
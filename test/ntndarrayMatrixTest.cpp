@@ -0,0 +1,196 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntndarrayMatrix.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static const int32 width = 4;
+static const int32 height = 3;
+
+static void setDimensions(NTNDArrayPtr const & ntndArray, int32 w, int32 h, int32 d = 0)
+{
+    PVStructureArrayPtr pvDim = ntndArray->getDimension();
+    StructureConstPtr dimStructure = pvDim->getStructureArray()->getStructure();
+    int32 sizes[] = { w, h, d };
+    PVStructureArray::svector dims;
+    for (size_t i = 0; i < 3 && sizes[i] > 0; ++i)
+    {
+        PVStructurePtr dim = getPVDataCreate()->createPVStructure(dimStructure);
+        dim->getSubField<PVInt>("size")->put(sizes[i]);
+        dims.push_back(dim);
+    }
+    pvDim->replace(freeze(dims));
+}
+
+static NTNDArrayPtr createDoubleFrame()
+{
+    NTNDArrayPtr ntndArray = NTNDArray::createBuilder()->addDescriptor()->create();
+    PVDoubleArray::svector values(width*height);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = 0.5*i;
+    ntndArray->getValue()->select<PVDoubleArray>("doubleValue")->replace(freeze(values));
+    setDimensions(ntndArray, width, height);
+    ntndArray->getDescriptor()->put("frame");
+    ntndArray->getDataTimeStamp()->getSubField<PVLong>("secondsPastEpoch")->put(1234);
+    return ntndArray;
+}
+
+void test_sharedValue()
+{
+    testDiag("test_sharedValue");
+
+    NTNDArrayPtr frame = createDoubleFrame();
+    testOk1(NTNDArrayMatrix::isSharedValue(frame));
+
+    NTMatrixPtr matrix = NTNDArrayMatrix::toMatrix(frame);
+    testOk1(matrix->isValid());
+
+    PVDoubleArray::const_svector frameValues =
+        frame->getValue()->get<PVDoubleArray>()->view();
+    PVDoubleArray::const_svector matrixValues = matrix->getValue()->view();
+    testOk(matrixValues.data() == frameValues.data(), "value shared");
+    testOk1(matrixValues.size() == frameValues.size());
+
+    PVIntArray::const_svector dim = matrix->getDim()->view();
+    testOk(dim.size() == 2 && dim[0] == height && dim[1] == width, "dim is [rows, columns]");
+
+    testOk1(matrix->getDescriptor().get() && matrix->getDescriptor()->get() == "frame");
+    testOk1(matrix->getAlarm().get() == 0);
+    testOk1(matrix->getTimeStamp()->getSubField<PVLong>("secondsPastEpoch")->get() == 1234);
+}
+
+void test_convertedValue()
+{
+    testDiag("test_convertedValue");
+
+    NTNDArrayPtr frame = NTNDArray::createBuilder()->create();
+    PVShortArray::svector values(width*height);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = static_cast<int16>(100 - 20*static_cast<int>(i));
+    frame->getValue()->select<PVShortArray>("shortValue")->replace(freeze(values));
+    setDimensions(frame, width, height, 1);
+    testOk1(!NTNDArrayMatrix::isSharedValue(frame));
+
+    NTMatrixPtr matrix = NTNDArrayMatrix::toMatrix(frame);
+    testOk1(matrix->isValid());
+
+    PVDoubleArray::const_svector converted = matrix->getValue()->view();
+    bool same = converted.size() == static_cast<size_t>(width*height);
+    for (size_t i = 0; same && i < converted.size(); ++i)
+        same = converted[i] == 100 - 20.0*i;
+    testOk(same, "values converted to double");
+    testOk1(matrix->getDescriptor().get() == 0);
+
+    // row 1, column 2
+    testOk1(converted[width + 2] == 100 - 20.0*(width + 2));
+
+    setDimensions(frame, width*height, 0);
+    PVIntArray::const_svector dim = NTNDArrayMatrix::toMatrix(frame)->getDim()->view();
+    testOk(dim.size() == 1 && dim[0] == width*height, "one-dimensional frame");
+}
+
+void test_toNTNDArray()
+{
+    testDiag("test_toNTNDArray");
+
+    NTMatrixPtr matrix = NTMatrix::createBuilder()->addDim()->addAlarm()->addTimeStamp()->create();
+    PVDoubleArray::svector values(width*height);
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = 2.0*i;
+    matrix->getValue()->replace(freeze(values));
+    PVIntArray::svector dim;
+    dim.push_back(height);
+    dim.push_back(width);
+    matrix->getDim()->replace(freeze(dim));
+    matrix->getAlarm()->getSubField<PVInt>("severity")->put(2);
+    matrix->getTimeStamp()->getSubField<PVInt>("nanoseconds")->put(500);
+
+    NTNDArrayPtr frame = NTNDArrayMatrix::toNTNDArray(matrix);
+    testOk1(frame->isValid());
+
+    PVDoubleArrayPtr pvValue = frame->getValue()->get<PVDoubleArray>();
+    testOk(pvValue.get() && pvValue->view().data() == matrix->getValue()->view().data(),
+        "value shared");
+
+    PVStructureArray::const_svector dims = frame->getDimension()->view();
+    testOk(dims.size() == 2 &&
+        dims[0]->getSubField<PVInt>("size")->get() == width &&
+        dims[1]->getSubField<PVInt>("size")->get() == height,
+        "dimension is [columns, rows]");
+    testOk1(dims.size() == 2 && dims[0]->getSubField<PVInt>("binning")->get() == 1);
+    testOk1(frame->getUncompressedDataSize()->get() ==
+        static_cast<int64>(width*height*sizeof(double)));
+
+    testOk1(frame->getAlarm().get() && frame->getAlarm()->getSubField<PVInt>("severity")->get() == 2);
+    testOk1(frame->getDataTimeStamp()->getSubField<PVInt>("nanoseconds")->get() == 500);
+    testOk1(frame->getDescriptor().get() == 0);
+
+    NTMatrixPtr roundTrip = NTNDArrayMatrix::toMatrix(frame);
+    PVIntArray::const_svector roundTripDim = roundTrip->getDim()->view();
+    testOk(roundTripDim.size() == 2 && roundTripDim[0] == height && roundTripDim[1] == width &&
+        roundTrip->getValue()->view().data() == matrix->getValue()->view().data(),
+        "round trip");
+}
+
+void test_invalid()
+{
+    testDiag("test_invalid");
+
+    NTNDArrayPtr frame = createDoubleFrame();
+    setDimensions(frame, 2, 3, 2);
+    try {
+        NTNDArrayMatrix::toMatrix(frame);
+        testFail("three-dimensional frame converted");
+    } catch (std::runtime_error &) {
+        testPass("three-dimensional frame rejected");
+    }
+
+    setDimensions(frame, width, width);
+    try {
+        NTNDArrayMatrix::toMatrix(frame);
+        testFail("frame with mismatched value converted");
+    } catch (std::runtime_error &) {
+        testPass("frame with mismatched value rejected");
+    }
+
+    PVStructureArray::svector nullDims(2);
+    frame->getDimension()->replace(freeze(nullDims));
+    try {
+        NTNDArrayMatrix::toMatrix(frame);
+        testFail("frame with null dimension converted");
+    } catch (std::runtime_error &) {
+        testPass("frame with null dimension rejected");
+    }
+
+    NTMatrixPtr matrix = NTMatrix::createBuilder()->addDim()->create();
+    PVDoubleArray::svector values(5);
+    matrix->getValue()->replace(freeze(values));
+    PVIntArray::svector dim;
+    dim.push_back(2);
+    dim.push_back(2);
+    matrix->getDim()->replace(freeze(dim));
+    try {
+        NTNDArrayMatrix::toNTNDArray(matrix);
+        testFail("matrix with mismatched dim converted");
+    } catch (std::runtime_error &) {
+        testPass("matrix with mismatched dim rejected");
+    }
+}
+
+MAIN(testNTNDArrayMatrix) {
+    testPlan(27);
+    test_sharedValue();
+    test_convertedValue();
+    test_toNTNDArray();
+    test_invalid();
+    return testDone();
+}
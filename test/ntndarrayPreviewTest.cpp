@@ -0,0 +1,154 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntndarrayPreview.h>
+
+#include "ntndarrayTestFrame.h"
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static int32 dimension(NTNDArrayPtr const & ntndArray, size_t index,
+    std::string const & field)
+{
+    return ntndArray->getDimension()->view()[index]->getSubField<PVInt>(field)->get();
+}
+
+void test_downscale()
+{
+    testDiag("test_downscale");
+
+    // horizontal ramp from 1000 to 4990
+    PVUShortArray::svector pixels(400*300);
+    for (size_t y = 0; y < 300; ++y)
+        for (size_t x = 0; x < 400; ++x)
+            pixels[y*400 + x] = static_cast<uint16>(1000 + 10*x);
+    NTNDArrayPtr image = createImage(makeSizes(400, 300), pixels, 7);
+
+    NTNDArrayPreviewPtr generator = NTNDArrayPreview::create(100, 100);
+    NTNDArrayPtr preview = generator->generate(image);
+
+    PVUByteArrayPtr pvPreview = preview->getValue()->get<PVUByteArray>();
+    testOk1(pvPreview.get() != 0);
+    if (!pvPreview.get())
+        return;
+    PVUByteArray::const_svector values = pvPreview->view();
+
+    testOk1(dimension(preview, 0, "size") == 100);
+    testOk1(dimension(preview, 1, "size") == 75);
+    testOk1(dimension(preview, 0, "binning") == 4);
+    testOk1(dimension(preview, 1, "fullSize") == 300);
+    testOk1(values.size() == 100*75);
+    testOk1(preview->getCompressedDataSize()->get() == 100*75);
+    testOk1(values[0] == 0 && values[99] == 255);
+    testOk1(values[50] > values[49] && values[75*100 - 1] == 255);
+    testOk1(preview->getUniqueId()->get() == 7);
+
+    // blocks of 4 pixels from 1015 to 4975
+    testOk(preview->getDescriptor()->get() ==
+        "preview binning=4 type=ushort window=[1015,4975]", "descriptor");
+}
+
+void test_percentile()
+{
+    testDiag("test_percentile");
+
+    // values 0 to 99 and one hot pixel
+    PVUShortArray::svector pixels(100*10);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = static_cast<uint16>(i % 100);
+    pixels[500] = 60000;
+    NTNDArrayPtr image = createImage(makeSizes(100, 10), pixels);
+
+    NTNDArrayPreviewPtr generator = NTNDArrayPreview::create(200, 200);
+    PVUByteArray::const_svector minMax =
+        generator->generate(image)->getValue()->get<PVUByteArray>()->view();
+    testOk(minMax[99] == 0, "hot pixel compresses the min/max window");
+
+    generator->setPercentileWindow(1, 99);
+    NTNDArrayPtr preview = generator->generate(image);
+    PVUByteArray::const_svector values = preview->getValue()->get<PVUByteArray>()->view();
+    testOk(values[99] == 255 && values[50] > 100 && values[50] < 155,
+        "percentile window ignores hot pixel");
+    testOk1(values[500] == 255 && values[0] == 0);
+    testOk1(dimension(preview, 0, "binning") == 1);
+    testOk1(preview->getDescriptor()->get().find("percentile=[1,99]") != std::string::npos);
+
+    try {
+        generator->setPercentileWindow(50, 20);
+        testFail("invalid percentiles accepted");
+    } catch (std::runtime_error &) {
+        testPass("invalid percentiles rejected");
+    }
+}
+
+void test_compressed()
+{
+    testDiag("test_compressed");
+
+    PVUShortArray::svector pixels(64*64);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = static_cast<uint16>(i < 2048 ? 0 : 1000);
+    NTNDArrayPtr image = createImage(makeSizes(64, 64), pixels);
+
+    NTNDArrayPreviewPtr generator = NTNDArrayPreview::create(32, 32);
+    NTNDArrayPtr plain = generator->generate(image);
+
+    generator->setCompressed(true);
+    testOk1(generator->isCompressed());
+    NTNDArrayPtr preview = generator->generate(image);
+    testOk1(preview->getCodec()->getSubField<PVString>("name")->get() ==
+        NTNDArrayTiledCodec::name);
+    testOk1(preview->getCompressedDataSize()->get() <
+        preview->getUncompressedDataSize()->get());
+
+    NTNDArrayTiledCodec::decode(preview);
+    PVUByteArray::const_svector expected = plain->getValue()->get<PVUByteArray>()->view();
+    PVUByteArray::const_svector decoded = preview->getValue()->get<PVUByteArray>()->view();
+    testOk(decoded.size() == expected.size() &&
+        std::equal(decoded.begin(), decoded.end(), expected.begin()),
+        "compressed preview decodes to the uncompressed one");
+}
+
+void test_invalid()
+{
+    testDiag("test_invalid");
+
+    NTNDArrayPreviewPtr generator = NTNDArrayPreview::create(32, 32);
+
+    PVUShortArray::svector pixels(4*4*3);
+    std::vector<size_t> sizes = makeSizes(4, 4);
+    sizes.push_back(3);
+    try {
+        generator->generate(createImage(sizes, pixels));
+        testFail("three-dimensional image accepted");
+    } catch (std::runtime_error &) {
+        testPass("three-dimensional image rejected");
+    }
+
+    PVUShortArray::svector more(16);
+    NTNDArrayPtr image = createImage(makeSizes(4, 4), more);
+    image->getCodec()->getSubField<PVString>("name")->put("tiled");
+    try {
+        generator->generate(image);
+        testFail("compressed image accepted");
+    } catch (std::runtime_error &) {
+        testPass("compressed image rejected");
+    }
+}
+
+MAIN(testNTNDArrayPreview) {
+    testPlan(23);
+    test_downscale();
+    test_percentile();
+    test_compressed();
+    test_invalid();
+    return testDone();
+}
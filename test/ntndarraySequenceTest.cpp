@@ -0,0 +1,143 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+typedef NTNDArraySequenceTracker Tracker;
+
+void test_sequence()
+{
+    testDiag("test_sequence");
+
+    Tracker::shared_pointer tracker = Tracker::create();
+    testOk(tracker.get() != 0, "Got tracker");
+
+    TimeStamp now;
+    now.getCurrent();
+
+    testOk1(tracker->update(100, now, now) == Tracker::first);
+    testOk1(tracker->update(101, now, now) == Tracker::inOrder);
+    testOk1(tracker->update(104, now, now) == Tracker::dropped);
+    testOk1(tracker->getDropped() == 2);
+
+    testOk1(tracker->update(102, now, now) == Tracker::reordered);
+    testOk1(tracker->getReordered() == 1);
+    testOk1(tracker->getDropped() == 1);
+
+    testOk1(tracker->update(102, now, now) == Tracker::duplicate);
+    testOk1(tracker->update(104, now, now) == Tracker::duplicate);
+    testOk1(tracker->getDuplicated() == 2);
+
+    testOk1(tracker->update(105, now, now) == Tracker::inOrder);
+
+    // far behind the reorder window
+    testOk1(tracker->update(1, now, now) == Tracker::first);
+    testOk1(tracker->getRestarts() == 1);
+
+    testOk1(tracker->getFrames() == 8);
+
+    tracker->reset();
+    testOk1(tracker->getFrames() == 0);
+    testOk1(tracker->getDropped() == 0);
+}
+
+void test_lateFrame()
+{
+    testDiag("test_lateFrame");
+
+    Tracker::shared_pointer tracker = Tracker::create();
+
+    TimeStamp now;
+    now.getCurrent();
+
+    for (int32 id = 1000; id <= 1100; ++id)
+        tracker->update(id, now, now);
+
+    // far behind the reorder window, but not near 0
+    testOk1(tracker->update(1000, now, now) == Tracker::reordered);
+    testOk1(tracker->update(1101, now, now) == Tracker::inOrder);
+    testOk1(tracker->getDropped() == 0);
+    testOk1(tracker->getRestarts() == 0);
+    testOk1(tracker->getReordered() == 1);
+}
+
+void test_wrapAround()
+{
+    testDiag("test_wrapAround");
+
+    Tracker::shared_pointer tracker = Tracker::create();
+
+    TimeStamp now;
+    now.getCurrent();
+
+    const int32 maxId = 0x7fffffff;
+    testOk1(tracker->update(maxId - 1, now, now) == Tracker::first);
+    testOk1(tracker->update(maxId, now, now) == Tracker::inOrder);
+    int32 wrapped = static_cast<int32>(static_cast<uint32>(maxId) + 1);
+    testOk1(tracker->update(wrapped, now, now) == Tracker::inOrder);
+    testOk1(tracker->getDropped() == 0);
+}
+
+void test_latency()
+{
+    testDiag("test_latency");
+
+    Tracker::shared_pointer tracker = Tracker::create();
+
+    TimeStamp dataTime(1000, 0);
+    TimeStamp receiveTime(1000, 5000000);
+
+    tracker->update(1, dataTime, receiveTime);
+    testOk1(tracker->getLastLatency() == 5000);
+
+    receiveTime.put(1000, 2000000);
+    tracker->update(2, dataTime, receiveTime);
+    testOk1(tracker->getLastLatency() == 2000);
+    testOk1(tracker->getMinLatency() == 2000);
+    testOk1(tracker->getMaxLatency() == 5000);
+
+    // clock skew
+    receiveTime.put(999, 0);
+    tracker->update(3, dataTime, receiveTime);
+    testOk1(tracker->getLastLatency() == 0);
+}
+
+void test_ntndarray()
+{
+    testDiag("test_ntndarray");
+
+    NTNDArrayPtr ntndArray = NTNDArray::createBuilder()->create();
+    Tracker::shared_pointer tracker = Tracker::create();
+
+    PVTimeStamp pvDataTimeStamp;
+    ntndArray->attachDataTimeStamp(pvDataTimeStamp);
+    TimeStamp dataTime(1000, 0);
+    pvDataTimeStamp.set(dataTime);
+
+    ntndArray->getUniqueId()->put(7);
+    testOk1(tracker->update(ntndArray, TimeStamp(1001, 0)) == Tracker::first);
+    testOk1(tracker->getLastLatency() == 1000000);
+
+    ntndArray->getUniqueId()->put(9);
+    testOk1(tracker->update(ntndArray) == Tracker::dropped);
+    testOk1(tracker->getDropped() == 1);
+}
+
+MAIN(testNTNDArraySequence) {
+    testPlan(35);
+    test_sequence();
+    test_lateFrame();
+    test_wrapAround();
+    test_latency();
+    test_ntndarray();
+    return testDone();
+}
@@ -112,13 +112,181 @@ void test_wrap()
     testOk(ptr.get() != 0, "wrapUnsafe OK");
 }
 
+void test_isValid()
+{
+    testDiag("test_isValid");
+
+    NTNDArrayPtr ntndArray = NTNDArray::createBuilder()->create();
+    testOk1(ntndArray.get() != 0);
+    if (!ntndArray)
+        return;
+
+    PVStructureArrayPtr pvDim = ntndArray->getDimension();
+    StructureConstPtr dimStructure = pvDim->getStructureArray()->getStructure();
+
+    PVStructureArray::svector dims;
+    for (int i = 0; i < 2; ++i)
+    {
+        PVStructurePtr dim = getPVDataCreate()->createPVStructure(dimStructure);
+        dim->getSubField<PVInt>("size")->put(i == 0 ? 4 : 3);
+        dims.push_back(dim);
+    }
+    pvDim->replace(freeze(dims));
+
+    PVUByteArray::svector bytes(12);
+    PVUByteArrayPtr byteValue = ntndArray->getValue()->select<PVUByteArray>("ubyteValue");
+    byteValue->replace(freeze(bytes));
+
+    ntndArray->getCompressedDataSize()->put(12);
+    ntndArray->getUncompressedDataSize()->put(12);
+    testOk(ntndArray->isValid(), "valid ubyte frame");
+
+    ntndArray->getUncompressedDataSize()->put(24);
+    testOk(!ntndArray->isValid(), "uncompressedSize mismatch detected");
+
+    // same element count, wider element type
+    PVUShortArray::svector shorts(12);
+    ntndArray->getValue()->select<PVUShortArray>("ushortValue")->replace(freeze(shorts));
+    testOk(!ntndArray->isValid(), "compressedSize mismatch detected");
+
+    ntndArray->getCompressedDataSize()->put(24);
+    testOk(ntndArray->isValid(), "valid ushort frame");
+
+    // new dimension array of a different shape
+    PVStructureArray::svector newDims;
+    PVStructurePtr dim = getPVDataCreate()->createPVStructure(dimStructure);
+    dim->getSubField<PVInt>("size")->put(6);
+    newDims.push_back(dim);
+    pvDim->replace(freeze(newDims));
+    testOk(!ntndArray->isValid(), "dimension change detected");
+
+    // value shorter than uncompressedSize requires a codec
+    ntndArray->getUncompressedDataSize()->put(12);
+    ntndArray->getCompressedDataSize()->put(6);
+    PVUShortArray::svector threeShorts(3);
+    ntndArray->getValue()->select<PVUShortArray>("ushortValue")->replace(freeze(threeShorts));
+    testOk(!ntndArray->isValid(), "compressed value without codec rejected");
+
+    ntndArray->getCodec()->getSubField<PVString>("name")->put("lz4");
+    testOk(ntndArray->isValid(), "compressed value with codec");
+
+    // the delta codec gives the element type of the decoded value
+    ntndArray->getCodec()->getSubField<PVString>("name")->put("");
+    PVUShortArray::svector sixShorts(6, 1);
+    ntndArray->getValue()->select<PVUShortArray>("ushortValue")->replace(freeze(sixShorts));
+    ntndArray->getCompressedDataSize()->put(12);
+    NTNDArrayDeltaEncoder::create(0)->encode(ntndArray);
+    testOk(ntndArray->isValid(), "valid encoded frame");
+
+    ntndArray->getUncompressedDataSize()->put(24);
+    testOk(!ntndArray->isValid(), "uncompressedSize mismatch of encoded frame detected");
+
+    // areaDetector codecs give the ScalarType of the decoded value as an int
+    ntndArray->getCodec()->getSubField<PVString>("name")->put("lz4");
+    PVIntPtr dataType = getPVDataCreate()->createPVScalar<PVInt>();
+    dataType->put(pvUShort);
+    ntndArray->getCodec()->getSubField<PVUnion>("parameters")->set(dataType);
+    ntndArray->getUncompressedDataSize()->put(12);
+    testOk(ntndArray->isValid(), "valid frame with ScalarType codec parameters");
+
+    ntndArray->getUncompressedDataSize()->put(14);
+    testOk(!ntndArray->isValid(), "uncompressedSize mismatch with ScalarType codec parameters detected");
+}
+
+static PVStructurePtr createAttribute(NTNDArrayPtr const & ntndArray,
+    std::string const & name, PVScalarPtr const & value)
+{
+    StructureConstPtr attributeStructure =
+        ntndArray->getAttribute()->getStructureArray()->getStructure();
+    PVStructurePtr attribute = getPVDataCreate()->createPVStructure(attributeStructure);
+    attribute->getSubField<PVString>("name")->put(name);
+    attribute->getSubField<PVUnion>("value")->set(value);
+    return attribute;
+}
+
+void test_attributes()
+{
+    testDiag("test_attributes");
+
+    NTNDArrayPtr ntndArray = NTNDArray::createBuilder()->create();
+    testOk1(ntndArray.get() != 0);
+    if (!ntndArray)
+        return;
+
+    PVDataCreatePtr pvDataCreate = getPVDataCreate();
+
+    PVIntPtr colorMode = pvDataCreate->createPVScalar<PVInt>();
+    colorMode->put(2);
+    PVDoublePtr exposureTime = pvDataCreate->createPVScalar<PVDouble>();
+    exposureTime->put(0.5);
+    PVStringPtr camera = pvDataCreate->createPVScalar<PVString>();
+    camera->put("cam1");
+
+    PVStructureArray::svector attributes;
+    attributes.push_back(createAttribute(ntndArray, "ColorMode", colorMode));
+    attributes.push_back(createAttribute(ntndArray, "ExposureTime", exposureTime));
+    attributes.push_back(createAttribute(ntndArray, "Camera", camera));
+    ntndArray->getAttribute()->replace(freeze(attributes));
+
+    PVStructurePtr attribute = ntndArray->getAttribute("ExposureTime");
+    testOk1(attribute.get() != 0);
+    testOk1(attribute.get() && attribute->getSubField<PVString>("name")->get() == "ExposureTime");
+    testOk1(ntndArray->getAttribute("Gain").get() == 0);
+    testOk1(ntndArray->getAttributeValue("Camera").get() != 0);
+
+    double exposure = 0;
+    testOk1(ntndArray->getAttributeValue("ExposureTime", exposure));
+    testOk1(exposure == 0.5);
+
+    int32 mode = 0;
+    testOk1(ntndArray->getAttributeValue("ColorMode", mode));
+    testOk1(mode == 2);
+
+    std::string cameraName;
+    testOk1(ntndArray->getAttributeValue("Camera", cameraName));
+    testOk1(cameraName == "cam1");
+
+    double gain = 1.0;
+    testOk1(!ntndArray->getAttributeValue("Gain", gain));
+    testOk1(gain == 1.0);
+
+    double cameraNumber = 1.0;
+    testOk(!ntndArray->getAttributeValue("Camera", cameraNumber) && cameraNumber == 1.0,
+        "non-numeric string not converted");
+
+    // renaming requires the attribute array to be replaced
+    attribute->getSubField<PVString>("name")->put("Exposure");
+    testOk1(ntndArray->getAttribute("ExposureTime").get() == 0);
+    PVStructureArray::const_svector renamed(ntndArray->getAttribute()->view());
+    PVStructureArray::svector copy(thaw(renamed));
+    ntndArray->getAttribute()->replace(freeze(copy));
+    testOk1(ntndArray->getAttribute("Exposure") == attribute);
+    attribute->getSubField<PVString>("name")->put("ExposureTime");
+    renamed = ntndArray->getAttribute()->view();
+    copy = thaw(renamed);
+    ntndArray->getAttribute()->replace(freeze(copy));
+
+    // index is rebuilt when the attribute array is replaced
+    PVDoublePtr newGain = pvDataCreate->createPVScalar<PVDouble>();
+    newGain->put(4.0);
+    PVStructureArray::svector newAttributes;
+    newAttributes.push_back(createAttribute(ntndArray, "Gain", newGain));
+    ntndArray->getAttribute()->replace(freeze(newAttributes));
+
+    testOk1(ntndArray->getAttributeValue("Gain", gain));
+    testOk1(gain == 4.0);
+    testOk1(ntndArray->getAttribute("ExposureTime").get() == 0);
+}
+
 MAIN(testNTNDArray) {
-    testPlan(59);
+    testPlan(90);
     test_builder(true);
     test_builder(false);
     test_builder(false); // called twice to test caching
     test_all();
     test_wrap();
+    test_isValid();
+    test_attributes();
     return testDone();
 }
 
@@ -0,0 +1,59 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+#ifndef NTNDARRAYTESTFRAME_H
+#define NTNDARRAYTESTFRAME_H
+
+/*
+ * Frame factory shared by the NTNDArray processing tests.
+ */
+
+#include <vector>
+
+#include <pv/nt.h>
+
+static std::vector<size_t> makeSizes(size_t x, size_t y, size_t z = 0)
+{
+    std::vector<size_t> sizes;
+    sizes.push_back(x);
+    sizes.push_back(y);
+    if (z)
+        sizes.push_back(z);
+    return sizes;
+}
+
+/*
+ * Creates an uncompressed NTNDArray of ushort pixels with the specified
+ * dimension sizes, unbinned. pixels is moved into the frame.
+ */
+static epics::nt::NTNDArrayPtr createImage(std::vector<size_t> const & sizes,
+    epics::pvData::PVUShortArray::svector & pixels, epics::pvData::int32 uniqueId = 0)
+{
+    using namespace epics::pvData;
+
+    epics::nt::NTNDArrayPtr ntndArray = epics::nt::NTNDArray::createBuilder()->create();
+
+    PVStructureArrayPtr pvDim = ntndArray->getDimension();
+    StructureConstPtr dimStructure = pvDim->getStructureArray()->getStructure();
+    PVStructureArray::svector dims;
+    for (size_t i = 0; i < sizes.size(); ++i)
+    {
+        PVStructurePtr dim = getPVDataCreate()->createPVStructure(dimStructure);
+        dim->getSubField<PVInt>("size")->put(sizes[i]);
+        dim->getSubField<PVInt>("fullSize")->put(sizes[i]);
+        dim->getSubField<PVInt>("binning")->put(1);
+        dims.push_back(dim);
+    }
+    pvDim->replace(freeze(dims));
+
+    int64 size = pixels.size()*sizeof(uint16);
+    ntndArray->getValue()->select<PVUShortArray>("ushortValue")->replace(freeze(pixels));
+    ntndArray->getCompressedDataSize()->put(size);
+    ntndArray->getUncompressedDataSize()->put(size);
+    ntndArray->getUniqueId()->put(uniqueId);
+    return ntndArray;
+}
+
+#endif  /* NTNDARRAYTESTFRAME_H */
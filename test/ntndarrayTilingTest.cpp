@@ -0,0 +1,125 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntndarrayTiling.h>
+
+#include "ntndarrayTestFrame.h"
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static const size_t width = 100;
+static const size_t height = 60;
+
+static NTNDArrayPtr createImage()
+{
+    // a dark image with a few bright pixels
+    PVUShortArray::svector pixels(width*height);
+    for (size_t i = 0; i < pixels.size(); ++i)
+        pixels[i] = static_cast<uint16>((i*i) % 13);
+    pixels[width*10 + 10] = 4000;
+    pixels[width*50 + 90] = 60000;
+    return createImage(makeSizes(width, height), pixels, 42);
+}
+
+void test_tiling()
+{
+    testDiag("test_tiling");
+
+    NTNDArrayTilingPtr tiling = NTNDArrayTiling::create(
+        makeSizes(width, height), makeSizes(32, 16));
+    testOk1(tiling->getElementCount() == width*height);
+    testOk1(tiling->getTileCount() == 4*4);
+
+    // last tile of the first row of tiles
+    std::vector<size_t> offset, size;
+    tiling->getTile(3, offset, size);
+    testOk1(offset[0] == 96 && offset[1] == 0);
+    testOk1(size[0] == 4 && size[1] == 16);
+    testOk1(tiling->getTileElementCount(15) == 4*12);
+
+    std::vector<int32> array(width*height), copy(width*height, -1);
+    for (size_t i = 0; i < array.size(); ++i)
+        array[i] = static_cast<int32>(i);
+
+    bool firstElements = true;
+    for (size_t t = 0; t < tiling->getTileCount(); ++t)
+    {
+        std::vector<int32> tile(tiling->getTileElementCount(t));
+        tiling->extract(&array[0], sizeof(int32), t, &tile[0]);
+        tiling->getTile(t, offset, size);
+        firstElements = firstElements &&
+            tile[0] == static_cast<int32>(offset[1]*width + offset[0]);
+        tiling->insert(&tile[0], sizeof(int32), t, &copy[0]);
+    }
+    testOk(firstElements, "tiles extracted at their offsets");
+    testOk(array == copy, "tiles reassembled");
+
+    // unspecified and oversized tile sizes span the dimension
+    NTNDArrayTilingPtr planes = NTNDArrayTiling::create(
+        makeSizes(8, 8, 3), makeSizes(0, 100));
+    testOk1(planes->getTileCount() == 3);
+    testOk1(planes->getTileSizes()[0] == 8 && planes->getTileSizes()[2] == 1);
+
+    NTNDArrayTilingPtr fromFrame = NTNDArrayTiling::create(createImage(), makeSizes(50, 50));
+    testOk1(fromFrame->getTileCount() == 2*2);
+}
+
+void test_codec()
+{
+    testDiag("test_codec");
+
+    NTNDArrayPtr original = createImage();
+    NTNDArrayPtr frame = createImage();
+
+    NTNDArrayTiledCodec::encode(frame, makeSizes(32, 16));
+    testOk1(frame->getCodec()->getSubField<PVString>("name")->get() ==
+        NTNDArrayTiledCodec::name);
+    testOk1(frame->isValid());
+    testOk(frame->getCompressedDataSize()->get() < frame->getUncompressedDataSize()->get(),
+        "compressed %d of %d bytes",
+        static_cast<int>(frame->getCompressedDataSize()->get()),
+        static_cast<int>(frame->getUncompressedDataSize()->get()));
+    testOk1(NTNDArrayTiledCodec::getTiling(frame)->getTileCount() == 16);
+
+    // partial decode of the tile holding pixel (90, 50)
+    NTNDArrayPtr tile = NTNDArrayTiledCodec::decodeTile(frame, 2 + 3*4);
+    PVStructureArray::const_svector dims = tile->getDimension()->view();
+    testOk1(dims.size() == 2);
+    testOk1(dims[0]->getSubField<PVInt>("size")->get() == 32);
+    testOk1(dims[0]->getSubField<PVInt>("offset")->get() == 64);
+    testOk1(dims[1]->getSubField<PVInt>("offset")->get() == 48);
+    testOk1(dims[1]->getSubField<PVInt>("fullSize")->get() == static_cast<int32>(height));
+    testOk1(tile->getUniqueId()->get() == 42);
+    testOk1(tile->isValid());
+    PVUShortArrayPtr tileValue = tile->getValue()->get<PVUShortArray>();
+    testOk1(tileValue.get() && tileValue->view()[(50 - 48)*32 + (90 - 64)] == 60000);
+
+    NTNDArrayTiledCodec::decode(frame, 2);
+    testOk1(frame->getCodec()->getSubField<PVString>("name")->get().empty());
+    testOk1(frame->isValid());
+    PVUShortArrayPtr decoded = frame->getValue()->get<PVUShortArray>();
+    PVUShortArrayPtr expected = original->getValue()->get<PVUShortArray>();
+    testOk(decoded.get() && decoded->view() == expected->view(), "frame restored");
+
+    try {
+        NTNDArrayTiledCodec::decodeTile(frame, 0);
+        testFail("decodeTile of an unencoded frame");
+    } catch (std::runtime_error &) {
+        testPass("decodeTile of an unencoded frame throws");
+    }
+}
+
+MAIN(testNTNDArrayTiling) {
+    testPlan(26);
+    test_tiling();
+    test_codec();
+    return testDone();
+}
@@ -0,0 +1,133 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <vector>
+#include <stdexcept>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+#include <epicsAtomic.h>
+
+#include <pv/ntparallel.h>
+
+using namespace epics::nt;
+
+class CountTask : public NTParallel::Task
+{
+public:
+    CountTask(size_t count) : counts(count, 0) {}
+
+    virtual void run(size_t index)
+    {
+        epics::atomic::increment(counts[index]);
+    }
+
+    bool eachOnce() const
+    {
+        for (size_t i = 0; i < counts.size(); ++i)
+            if (counts[i] != 1)
+                return false;
+        return true;
+    }
+
+    std::vector<size_t> counts;
+};
+
+class NestedTask : public NTParallel::Task
+{
+public:
+    NestedTask() : total(0) {}
+
+    virtual void run(size_t)
+    {
+        CountTask inner(10);
+        NTParallel::forEach(10, inner);
+        if (inner.eachOnce())
+            epics::atomic::add(total, 10);
+    }
+
+    size_t total;
+};
+
+class ThrowingTask : public NTParallel::Task
+{
+public:
+    virtual void run(size_t index)
+    {
+        if (index == 17)
+            throw std::out_of_range("item 17");
+    }
+};
+
+class ThrowingIntTask : public NTParallel::Task
+{
+public:
+    virtual void run(size_t index)
+    {
+        if (index == 3)
+            throw 3;
+    }
+};
+
+void test_forEach()
+{
+    testDiag("test_forEach");
+
+    testOk1(NTParallel::getConcurrency() >= 1);
+
+    CountTask task(1000);
+    NTParallel::forEach(1000, task);
+    testOk(task.eachOnce(), "each item run once");
+
+    CountTask single(100);
+    NTParallel::forEach(100, single, 1);
+    testOk(single.eachOnce(), "each item run once on one thread");
+
+    CountTask few(3);
+    NTParallel::forEach(3, few);
+    testOk(few.eachOnce(), "fewer items than threads");
+
+    CountTask none(0);
+    NTParallel::forEach(0, none);
+    testPass("no items");
+
+    NestedTask nested;
+    NTParallel::forEach(20, nested);
+    testOk(nested.total == 200, "nested forEach");
+}
+
+void test_exception()
+{
+    testDiag("test_exception");
+
+    ThrowingTask task;
+    try {
+        NTParallel::forEach(100, task);
+        testFail("exception not propagated");
+    } catch (std::runtime_error & e) {
+        testOk(std::string(e.what()) == "item 17", "exception propagated");
+    }
+
+    ThrowingIntTask intTask;
+    try {
+        NTParallel::forEach(10, intTask, 1);
+        testFail("exception not propagated on one thread");
+    } catch (std::runtime_error & e) {
+        testOk(std::string(e.what()) == "unknown exception",
+            "unknown exception propagated on one thread");
+    }
+
+    CountTask after(100);
+    NTParallel::forEach(100, after);
+    testOk(after.eachOnce(), "pool usable after an exception");
+}
+
+MAIN(testNTParallel) {
+    testPlan(9);
+    test_forEach();
+    test_exception();
+    return testDone();
+}
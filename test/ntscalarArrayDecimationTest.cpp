@@ -0,0 +1,157 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <cmath>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntscalarArrayDecimation.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+template<typename PVT>
+static NTScalarArrayPtr createWaveform(typename PVT::svector & value)
+{
+    NTScalarArrayPtr waveform = NTScalarArray::createBuilder()->
+        value(PVT::typeCode)->
+        addDescriptor()->
+        addTimeStamp()->
+        create();
+    waveform->getValue<PVT>()->replace(freeze(value));
+    waveform->getDescriptor()->put("waveform");
+    return waveform;
+}
+
+// 0, 1, ..., 9, 0, 1, ... with a spike of -50 at 25 and 90 at 72
+static NTScalarArrayPtr createSawtooth(size_t count)
+{
+    PVIntArray::svector value(count);
+    for (size_t i = 0; i < count; ++i)
+        value[i] = static_cast<int32>(i % 10);
+    value[25] = -50;
+    value[72] = 90;
+    return createWaveform<PVIntArray>(value);
+}
+
+void test_envelope()
+{
+    testDiag("test_envelope");
+
+    NTTablePtr table = NTScalarArrayDecimation::envelope(createSawtooth(100), 4);
+    PVDoubleArrayPtr x = table->getColumn<PVDoubleArray>("x");
+    PVDoubleArrayPtr min = table->getColumn<PVDoubleArray>("min");
+    PVDoubleArrayPtr max = table->getColumn<PVDoubleArray>("max");
+    testOk1(x.get() && min.get() && max.get());
+    testOk1(x->getLength() == 4 && min->getLength() == 4 && max->getLength() == 4);
+    testOk1(x->view()[0] == 12 && x->view()[3] == 87);
+    testOk1(min->view()[1] == -50 && max->view()[1] == 9);
+    testOk1(min->view()[2] == 0 && max->view()[2] == 90);
+    testOk1(table->getDescriptor().get() && table->getDescriptor()->get() == "waveform");
+    testOk1(table->getTimeStamp().get() != 0);
+
+    // more buckets than elements
+    table = NTScalarArrayDecimation::envelope(createSawtooth(30), 100);
+    testOk1(table->getColumn<PVDoubleArray>("x")->getLength() == 30);
+}
+
+void test_minMax()
+{
+    testDiag("test_minMax");
+
+    NTScalarArrayPtr source = createSawtooth(100);
+    NTScalarArrayPtr result = NTScalarArrayDecimation::minMax(source, 4);
+    PVIntArrayPtr pvValue = result->getValue<PVIntArray>();
+    testOk(pvValue.get() != 0, "element type kept");
+    PVIntArray::const_svector value = pvValue->view();
+    testOk1(value.size() == 8);
+    testOk(value[2] == -50 && value[3] == 9, "minimum first when it occurs first");
+    testOk(value[4] == 0 && value[5] == 90, "maximum last when it occurs last");
+
+    PVDoubleArray::svector ramp(10);
+    for (size_t i = 0; i < ramp.size(); ++i)
+        ramp[i] = 10.0 - i;
+    NTScalarArrayPtr falling = createWaveform<PVDoubleArray>(ramp);
+    PVDoubleArray::const_svector decimated =
+        NTScalarArrayDecimation::minMax(falling, 2)->getValue<PVDoubleArray>()->view();
+    testOk(decimated.size() == 4 && decimated[0] == 10 && decimated[1] == 6,
+        "maximum first when it occurs first");
+
+    result = NTScalarArrayDecimation::minMax(falling, 5);
+    testOk(result->getValue<PVDoubleArray>()->view().data() ==
+        falling->getValue<PVDoubleArray>()->view().data(), "short waveform not copied");
+
+    NTScalarArrayPtr strings = NTScalarArray::createBuilder()->value(pvString)->create();
+    try {
+        NTScalarArrayDecimation::minMax(strings, 4);
+        testFail("string array decimated");
+    } catch (std::runtime_error &) {
+        testPass("string array rejected");
+    }
+}
+
+void test_lttb()
+{
+    testDiag("test_lttb");
+
+    NTTablePtr table = NTScalarArrayDecimation::lttb(createSawtooth(100), 6);
+    PVDoubleArray::const_svector x = table->getColumn<PVDoubleArray>("x")->view();
+    PVDoubleArray::const_svector y = table->getColumn<PVDoubleArray>("y")->view();
+    testOk1(x.size() == 6 && y.size() == 6);
+    testOk(x[0] == 0 && x[5] == 99, "first and last selected");
+    testOk(x[2] == 25 && y[2] == -50 && x[3] == 72 && y[3] == 90, "spikes selected");
+    bool ordered = true;
+    for (size_t i = 1; i < 6; ++i)
+        ordered = ordered && x[i] > x[i - 1];
+    testOk1(ordered);
+
+    table = NTScalarArrayDecimation::lttb(createSawtooth(100), 200);
+    testOk(table->getColumn<PVDoubleArray>("x")->getLength() == 100, "all samples of a short waveform");
+
+    try {
+        NTScalarArrayDecimation::lttb(createSawtooth(100), 2);
+        testFail("2 points accepted");
+    } catch (std::runtime_error &) {
+        testPass("2 points rejected");
+    }
+}
+
+void test_resample()
+{
+    testDiag("test_resample");
+
+    PVDoubleArray::svector square(6);
+    for (size_t i = 0; i < square.size(); ++i)
+        square[i] = double(i*i);
+    NTScalarArrayPtr source = createWaveform<PVDoubleArray>(square);
+
+    NTScalarArrayPtr result = NTScalarArrayDecimation::resample(source, 11);
+    PVDoubleArray::const_svector value = result->getValue<PVDoubleArray>()->view();
+    testOk1(value.size() == 11);
+    testOk1(value[0] == 0 && value[4] == 4 && value[10] == 25);
+    testOk(value[5] == 6.5, "linear between elements");
+    testOk1(result->getDescriptor().get() && result->getDescriptor()->get() == "waveform");
+
+    result = NTScalarArrayDecimation::resample(source, 11, NTScalarArrayDecimation::cubic);
+    value = result->getValue<PVDoubleArray>()->view();
+    testOk(std::fabs(value[5] - 6.25) < 1e-12, "cubic between elements");
+    testOk1(value[4] == 4 && value[10] == 25);
+
+    PVDoubleArray::svector empty;
+    result = NTScalarArrayDecimation::resample(createWaveform<PVDoubleArray>(empty), 10);
+    testOk1(result->getValue<PVDoubleArray>()->getLength() == 0);
+}
+
+MAIN(testNTScalarArrayDecimation) {
+    testPlan(28);
+    test_envelope();
+    test_minMax();
+    test_lttb();
+    test_resample();
+    return testDone();
+}
@@ -0,0 +1,135 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntscalarArrayHistory.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+typedef NTScalarArrayHistory<PVDoubleArray> DoubleHistory;
+typedef NTScalarArrayHistory<PVIntArray> IntHistory;
+
+static bool hasValues(PVDoubleArray::const_svector const & values,
+    double firstValue, size_t count)
+{
+    if (values.size() != count)
+        return false;
+    for (size_t i = 0; i < count; ++i)
+        if (values[i] != firstValue + i)
+            return false;
+    return true;
+}
+
+void test_push()
+{
+    testDiag("test_push");
+
+    DoubleHistory::shared_pointer history = DoubleHistory::create(4);
+    testOk1(history->getCapacity() == 4 && history->getSize() == 0);
+    testOk1(history->getValues().empty());
+
+    for (int i = 0; i < 3; ++i)
+        history->push(i);
+    testOk1(history->getSize() == 3);
+    testOk1(hasValues(history->getValues(), 0, 3));
+
+    // wraps several times
+    for (int i = 3; i < 23; ++i)
+        history->push(i);
+    testOk1(history->getSize() == 4);
+    testOk1(hasValues(history->getValues(), 19, 4));
+
+    history->clear();
+    testOk1(history->getSize() == 0 && history->getValues().empty());
+    history->push(7);
+    testOk1(hasValues(history->getValues(), 7, 1));
+
+    try {
+        DoubleHistory::create(0);
+        testFail("history of capacity 0 created");
+    } catch (std::runtime_error &) {
+        testPass("history of capacity 0 rejected");
+    }
+}
+
+void test_publish()
+{
+    testDiag("test_publish");
+
+    DoubleHistory::shared_pointer history = DoubleHistory::create(3);
+    NTScalarArrayPtr ntScalarArray = history->createNTScalarArray();
+    testOk1(ntScalarArray->getValue<PVDoubleArray>().get() != 0);
+    testOk1(ntScalarArray->getTimeStamp().get() != 0);
+
+    for (int i = 0; i < 5; ++i)
+        history->push(i);
+    history->publish(ntScalarArray);
+    PVDoubleArray::const_svector published = ntScalarArray->getValue<PVDoubleArray>()->view();
+    testOk1(hasValues(published, 2, 3));
+    testOk(published.data() == history->getValues().data(), "published without copying");
+
+    // pushes after publishing leave the published array unchanged
+    for (int i = 5; i < 12; ++i)
+        history->push(i);
+    testOk1(hasValues(published, 2, 3));
+    testOk1(hasValues(history->getValues(), 9, 3));
+
+    history->clear();
+    testOk1(hasValues(published, 2, 3));
+
+    IntHistory::shared_pointer ints = IntHistory::create(3);
+    try {
+        ints->publish(ntScalarArray);
+        testFail("value of another type published");
+    } catch (std::runtime_error &) {
+        testPass("value of another type rejected");
+    }
+}
+
+void test_timeStamps()
+{
+    testDiag("test_timeStamps");
+
+    IntHistory::shared_pointer history = IntHistory::create(2, true);
+    testOk1(history->isTrackingTimeStamps());
+
+    for (int i = 0; i < 5; ++i)
+        history->push(i, TimeStamp(1000 + i, 10*i));
+    PVIntArray::const_svector values = history->getValues();
+    PVLongArray::const_svector seconds = history->getSecondsPastEpoch();
+    PVIntArray::const_svector nanoseconds = history->getNanoseconds();
+    testOk1(values.size() == 2 && values[0] == 3 && values[1] == 4);
+    testOk1(seconds.size() == 2 && seconds[0] == 1003 && seconds[1] == 1004);
+    testOk1(nanoseconds.size() == 2 && nanoseconds[0] == 30 && nanoseconds[1] == 40);
+
+    NTScalarArrayPtr ntScalarArray = history->createNTScalarArray();
+    history->publish(ntScalarArray);
+    PVTimeStamp pvTimeStamp;
+    TimeStamp timeStamp;
+    testOk1(ntScalarArray->attachTimeStamp(pvTimeStamp));
+    pvTimeStamp.get(timeStamp);
+    testOk1(timeStamp.getSecondsPastEpoch() == 1004 && timeStamp.getNanoseconds() == 40);
+
+    history->push(5);
+    seconds = history->getSecondsPastEpoch();
+    testOk(seconds.size() == 2 && seconds[1] > 1004, "sample stamped with the current time");
+
+    DoubleHistory::shared_pointer untracked = DoubleHistory::create(2);
+    untracked->push(1, TimeStamp(1000));
+    testOk1(untracked->getSecondsPastEpoch().empty() && untracked->getNanoseconds().empty());
+}
+
+MAIN(testNTScalarArrayHistory) {
+    testPlan(25);
+    test_push();
+    test_publish();
+    test_timeStamps();
+    return testDone();
+}
@@ -0,0 +1,194 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntscalarArrayMath.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static NTScalarArrayPtr createArray(const double * values, size_t count)
+{
+    NTScalarArrayPtr array = NTScalarArray::createBuilder()->
+        value(pvDouble)->
+        addDescriptor()->
+        addDisplay()->
+        create();
+    PVDoubleArray::svector value(count);
+    std::copy(values, values + count, value.begin());
+    array->getValue<PVDoubleArray>()->replace(freeze(value));
+    array->getDescriptor()->put("raw counts");
+    array->getDisplay()->getSubField<PVDouble>("limitLow")->put(0);
+    array->getDisplay()->getSubField<PVDouble>("limitHigh")->put(100);
+    return array;
+}
+
+static NTScalarArrayPtr createEmpty()
+{
+    return NTScalarArray::createBuilder()->value(pvInt)->create();
+}
+
+static const double values[] = { -2.5, 0, 1.25, 100, 42, 300 };
+static const size_t count = sizeof(values)/sizeof(values[0]);
+
+void test_linear()
+{
+    testDiag("test_linear");
+
+    NTScalarArrayPtr source = createArray(values, count);
+
+    NTScalarArrayPtr result = NTScalarArrayMath::linear(source, 2, 1, pvDouble);
+    PVDoubleArrayPtr pvResult = result->getValue<PVDoubleArray>();
+    testOk1(pvResult.get() && pvResult->getLength() == count);
+    PVDoubleArray::const_svector doubles = pvResult->view();
+    testOk1(doubles[0] == -4 && doubles[2] == 3.5 && doubles[5] == 601);
+
+    testOk1(result->getDescriptor().get() && result->getDescriptor()->get() == "raw counts");
+    testOk1(result->getDisplay().get() &&
+        result->getDisplay()->getSubField<PVDouble>("limitLow")->get() == 1 &&
+        result->getDisplay()->getSubField<PVDouble>("limitHigh")->get() == 201);
+
+    // a negative scale swaps the limits
+    result = NTScalarArrayMath::linear(source, -1, 0, pvDouble);
+    testOk1(result->getDisplay()->getSubField<PVDouble>("limitLow")->get() == -100 &&
+        result->getDisplay()->getSubField<PVDouble>("limitHigh")->get() == 0);
+
+    // rounded and saturated to the range of the type
+    result = NTScalarArrayMath::linear(source, 1, 0, pvUByte);
+    PVUByteArrayPtr pvBytes = result->getValue<PVUByteArray>();
+    testOk1(pvBytes.get() && pvBytes->getLength() == count);
+    PVUByteArray::const_svector bytes = pvBytes->view();
+    testOk1(bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 1 && bytes[3] == 100);
+    testOk1(bytes[5] == 255);
+
+    result = NTScalarArrayMath::linear(source, 1, 0, pvInt);
+    PVIntArray::const_svector ints = result->getValue<PVIntArray>()->view();
+    testOk(ints[0] == -3, "rounded half away from zero");
+
+    NTScalarArrayPtr strings = NTScalarArray::createBuilder()->value(pvString)->create();
+    try {
+        NTScalarArrayMath::linear(strings, 1, 0, pvDouble);
+        testFail("string array transformed");
+    } catch (std::runtime_error &) {
+        testPass("string array rejected");
+    }
+
+    try {
+        NTScalarArrayMath::linear(source, 1, 0, pvString);
+        testFail("string result created");
+    } catch (std::runtime_error &) {
+        testPass("string result rejected");
+    }
+}
+
+void test_clamp_cast()
+{
+    testDiag("test_clamp_cast");
+
+    NTScalarArrayPtr source = createArray(values, count);
+
+    NTScalarArrayPtr result = NTScalarArrayMath::clamp(source, 0, 50);
+    PVDoubleArray::const_svector doubles = result->getValue<PVDoubleArray>()->view();
+    testOk1(doubles[0] == 0 && doubles[2] == 1.25 && doubles[3] == 50 && doubles[5] == 50);
+    testOk1(result->getDisplay()->getSubField<PVDouble>("limitHigh")->get() == 50);
+
+    NTScalarArrayPtr ints = NTScalarArrayMath::cast(source, pvInt);
+    result = NTScalarArrayMath::clamp(ints, 0.5, 99.5);
+    PVIntArray::const_svector clamped = result->getValue<PVIntArray>()->view();
+    testOk(clamped[1] == 1 && clamped[3] == 99, "integer clamp stays within the range");
+
+    try {
+        NTScalarArrayMath::clamp(ints, 1.25, 1.75);
+        testFail("integer clamp to an empty range accepted");
+    } catch (std::runtime_error &) {
+        testPass("integer clamp to an empty range rejected");
+    }
+
+    try {
+        NTScalarArrayMath::clamp(source, 2, 1);
+        testFail("clamp with high < low accepted");
+    } catch (std::runtime_error &) {
+        testPass("clamp with high < low rejected");
+    }
+
+    NTScalarArrayPtr floats = NTScalarArrayMath::cast(ints, pvFloat);
+    PVFloatArray::const_svector converted = floats->getValue<PVFloatArray>()->view();
+    testOk1(converted.size() == count && converted[0] == -3 && converted[5] == 300);
+
+    NTScalarArrayPtr booleans = NTScalarArrayMath::cast(source, pvBoolean);
+    PVBooleanArray::const_svector flags = booleans->getValue<PVBooleanArray>()->view();
+    testOk(flags.size() == count && flags[0] == 1 && flags[1] == 0 &&
+        flags[3] == 1 && flags[5] == 1, "cast to boolean gives 0 or 1");
+}
+
+void test_recycle()
+{
+    testDiag("test_recycle");
+
+    NTScalarArrayPtr source = createArray(values, count);
+    NTScalarArrayPtr target = NTScalarArrayMath::cast(source, pvShort);
+    PVShortArrayPtr pvTarget = target->getValue<PVShortArray>();
+
+    NTScalarArrayPtr result = NTScalarArrayMath::linear(source, 10, 0, pvShort, target);
+    testOk1(result == target);
+    testOk1(pvTarget->view()[3] == 1000 && pvTarget->view()[5] == 3000);
+
+    // in place
+    result = NTScalarArrayMath::linear(source, 0.5, 0, pvDouble, source);
+    testOk1(result == source);
+    testOk1(source->getValue<PVDoubleArray>()->view()[3] == 50);
+    testOk1(source->getDisplay()->getSubField<PVDouble>("limitHigh")->get() == 50);
+
+    try {
+        NTScalarArrayMath::linear(source, 1, 0, pvDouble, target);
+        testFail("result of another element type accepted");
+    } catch (std::runtime_error &) {
+        testPass("result of another element type rejected");
+    }
+}
+
+void test_reductions()
+{
+    testDiag("test_reductions");
+
+    NTScalarArrayPtr source = createArray(values, count);
+    testOk1(NTScalarArrayMath::sum(source) == 440.75);
+    testOk1(std::fabs(NTScalarArrayMath::mean(source) - 440.75/count) < 1e-12);
+    testOk1(NTScalarArrayMath::minimum(source) == -2.5);
+    testOk1(NTScalarArrayMath::maximum(source) == 300);
+    testOk1(NTScalarArrayMath::argmax(source) == 5);
+
+    NTScalarArrayPtr bytes = NTScalarArrayMath::cast(source, pvUByte);
+    testOk1(NTScalarArrayMath::sum(bytes) == 0 + 0 + 1 + 100 + 42 + 255);
+    testOk1(NTScalarArrayMath::argmax(bytes) == 5);
+
+    NTScalarArrayPtr empty = createEmpty();
+    testOk1(NTScalarArrayMath::sum(empty) == 0);
+    double mean = NTScalarArrayMath::mean(empty);
+    double minimum = NTScalarArrayMath::minimum(empty);
+    testOk(mean != mean && minimum != minimum, "NaN for an empty array");
+    try {
+        NTScalarArrayMath::argmax(empty);
+        testFail("argmax of an empty array returned");
+    } catch (std::runtime_error &) {
+        testPass("argmax of an empty array rejected");
+    }
+}
+
+MAIN(testNTScalarArrayMath) {
+    testPlan(34);
+    test_linear();
+    test_clamp_cast();
+    test_recycle();
+    test_reductions();
+    return testDone();
+}
@@ -234,11 +234,34 @@ void test_wrap()
     testOk(ptr.get() != 0, "wrapUnsafe OK");
 }
 
+void test_batch()
+{
+    testDiag("test_batch");
+
+    std::vector<NTScalarArrayPtr> instances = NTScalarArray::createBuilder()->
+            value(pvDouble)->
+            addAlarm()->
+            addTimeStamp()->
+            create(100);
+    testOk1(instances.size() == 100);
+
+    bool valid = true;
+    for (size_t i = 0; valid && i < instances.size(); ++i)
+        valid = instances[i].get() && instances[i]->getValue<PVDoubleArray>().get() &&
+            instances[i]->getAlarm().get() && instances[i]->getTimeStamp().get();
+    testOk(valid, "all instances valid");
+    testOk(instances[0]->getPVStructure()->getStructure() ==
+           instances[99]->getPVStructure()->getStructure(), "type shared");
+    testOk(instances[0]->getPVStructure() != instances[1]->getPVStructure(),
+           "separate instances");
+}
+
 MAIN(testNTScalarArray) {
-    testPlan(38);
+    testPlan(42);
     test_builder();
     test_ntscalarArray();
     test_wrap();
+    test_batch();
     return testDone();
 }
 
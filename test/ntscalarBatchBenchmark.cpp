@@ -0,0 +1,104 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+/*
+ * Measures the creation of NTScalar and NTScalarArray instances one at a
+ * time and in batches. Built with the tests but not run by runtests, since
+ * the result depends on the host.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+static const size_t count = 100000;
+
+// creation time of count PVs must be below this
+static const double targetSeconds = 1.0;
+
+static double secondsSince(TimeStamp const & start)
+{
+    TimeStamp now;
+    now.getCurrent();
+    return TimeStamp::diff(now, start);
+}
+
+// the builders are reset by each create
+static NTScalarBuilderPtr configure(NTScalarBuilderPtr const & builder)
+{
+    return builder->
+            value(pvDouble)->
+            addDescriptor()->
+            addAlarm()->
+            addTimeStamp()->
+            addDisplay()->
+            addControl();
+}
+
+static NTScalarArrayBuilderPtr configure(NTScalarArrayBuilderPtr const & builder)
+{
+    return builder->
+            value(pvDouble)->
+            addAlarm()->
+            addTimeStamp();
+}
+
+void benchmark_ntscalar()
+{
+    testDiag("benchmark_ntscalar");
+
+    std::vector<NTScalarPtr> single;
+    single.reserve(count);
+    NTScalarBuilderPtr builder = NTScalar::createBuilder();
+    TimeStamp start;
+    start.getCurrent();
+    for (size_t i = 0; i < count; ++i)
+        single.push_back(configure(builder)->create());
+    double singleSeconds = secondsSince(start);
+
+    start.getCurrent();
+    std::vector<NTScalarPtr> batch = configure(builder)->create(count);
+    double batchSeconds = secondsSince(start);
+
+    testDiag("%lu NTScalars: %.3f s one at a time, %.3f s in a batch",
+        (unsigned long)count, singleSeconds, batchSeconds);
+    testOk1(batch.size() == count);
+    testOk(batchSeconds < targetSeconds, "batch creation within %.1f s", targetSeconds);
+}
+
+void benchmark_ntscalarArray()
+{
+    testDiag("benchmark_ntscalarArray");
+
+    std::vector<NTScalarArrayPtr> single;
+    single.reserve(count);
+    NTScalarArrayBuilderPtr builder = NTScalarArray::createBuilder();
+    TimeStamp start;
+    start.getCurrent();
+    for (size_t i = 0; i < count; ++i)
+        single.push_back(configure(builder)->create());
+    double singleSeconds = secondsSince(start);
+
+    start.getCurrent();
+    std::vector<NTScalarArrayPtr> batch = configure(builder)->create(count);
+    double batchSeconds = secondsSince(start);
+
+    testDiag("%lu NTScalarArrays: %.3f s one at a time, %.3f s in a batch",
+        (unsigned long)count, singleSeconds, batchSeconds);
+    testOk1(batch.size() == count);
+    testOk(batchSeconds < targetSeconds, "batch creation within %.1f s", targetSeconds);
+}
+
+MAIN(ntscalarBatchBenchmark) {
+    testPlan(4);
+    benchmark_ntscalar();
+    benchmark_ntscalarArray();
+    return testDone();
+}
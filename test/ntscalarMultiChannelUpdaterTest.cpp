@@ -0,0 +1,151 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntscalarMultiChannelUpdater.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+using std::string;
+
+typedef NTScalarMultiChannelUpdater<PVDoubleArray> Updater;
+
+static NTScalarMultiChannelPtr createMultiChannel(size_t count)
+{
+    NTScalarMultiChannelPtr multiChannel = NTScalarMultiChannel::createBuilder()->
+        value(pvDouble)->
+        addSeverity()->
+        addStatus()->
+        addMessage()->
+        addSecondsPastEpoch()->
+        addNanoseconds()->
+        addIsConnected()->
+        create();
+    PVStringArray::svector names(count);
+    for (size_t i = 0; i < count; ++i)
+        names[i] = "channel";
+    multiChannel->getChannelName()->replace(freeze(names));
+    return multiChannel;
+}
+
+void test_update()
+{
+    testDiag("test_update");
+
+    NTScalarMultiChannelPtr multiChannel = createMultiChannel(4);
+    Updater::shared_pointer updater = Updater::create(multiChannel);
+    testOk1(updater.get() != 0 && updater->getCount() == 4);
+
+    Alarm alarm;
+    alarm.setSeverity(minorAlarm);
+    alarm.setStatus(deviceStatus);
+    alarm.setMessage("HIGH");
+    updater->update(2, 1.5, alarm, TimeStamp(100, 200));
+    updater->setConnected(2, true);
+    updater->setValue(3, 2.5);
+    testOk(multiChannel->getValue()->getLength() == 0, "not published before commit");
+
+    updater->commit();
+    testOk1(multiChannel->isValid());
+    PVDoubleArray::const_svector values = multiChannel->getValue<PVDoubleArray>()->view();
+    testOk1(values.size() == 4 && values[0] == 0.0 && values[2] == 1.5 && values[3] == 2.5);
+    testOk1(multiChannel->getSeverity()->view()[2] == minorAlarm);
+    testOk1(multiChannel->getStatus()->view()[2] == deviceStatus);
+    testOk1(multiChannel->getMessage()->view()[2] == "HIGH");
+    testOk1(multiChannel->getSecondsPastEpoch()->view()[2] == 100);
+    testOk1(multiChannel->getNanoseconds()->view()[2] == 200);
+    testOk1(multiChannel->getIsConnected()->view()[2] && !multiChannel->getIsConnected()->view()[1]);
+
+    updater->setValue(0, 9.0);
+    testOk(values[0] == 0.0, "published value unchanged by update");
+    updater->commit();
+    values = multiChannel->getValue<PVDoubleArray>()->view();
+    testOk(values[0] == 9.0 && values[2] == 1.5, "channels kept across commits");
+}
+
+void test_reuse()
+{
+    testDiag("test_reuse");
+
+    NTScalarMultiChannelPtr multiChannel = createMultiChannel(8);
+    Updater::shared_pointer updater = Updater::create(multiChannel);
+    PVDoubleArrayPtr pvValue = multiChannel->getValue<PVDoubleArray>();
+
+    updater->commit();
+    const double * first = pvValue->view().data();
+    updater->commit();
+    const double * second = pvValue->view().data();
+    testOk1(first != second);
+    updater->commit();
+    testOk(pvValue->view().data() == first, "buffer reused after two commits");
+
+    // a buffer still referenced is not reused
+    PVDoubleArray::const_svector kept = pvValue->view();
+    updater->setValue(0, 1.0);
+    updater->commit();
+    updater->setValue(0, 2.0);
+    updater->commit();
+    testOk1(pvValue->view().data() != kept.data());
+    testOk(kept[0] == 0.0, "referenced buffer unchanged");
+}
+
+struct UpdateTask : public NTParallel::Task
+{
+    Updater & updater;
+
+    UpdateTask(Updater & updater) : updater(updater) {}
+
+    virtual void run(size_t index)
+    {
+        Alarm alarm;
+        updater.update(index, static_cast<double>(index), alarm,
+            TimeStamp(static_cast<int64>(index), 0));
+    }
+};
+
+void test_parallel()
+{
+    testDiag("test_parallel");
+
+    size_t count = 20000;
+    NTScalarMultiChannelPtr multiChannel = createMultiChannel(count);
+    Updater::shared_pointer updater = Updater::create(multiChannel);
+    UpdateTask task(*updater);
+    NTParallel::forEach(count, task);
+    updater->commit();
+
+    PVDoubleArray::const_svector values = multiChannel->getValue<PVDoubleArray>()->view();
+    PVLongArray::const_svector seconds = multiChannel->getSecondsPastEpoch()->view();
+    bool ok = multiChannel->isValid() && values.size() == count;
+    for (size_t i = 0; ok && i < count; ++i)
+        ok = values[i] == static_cast<double>(i) && seconds[i] == static_cast<int64>(i);
+    testOk(ok, "channels updated by several threads");
+}
+
+void test_mismatch()
+{
+    testDiag("test_mismatch");
+
+    NTScalarMultiChannelPtr multiChannel = createMultiChannel(2);
+    try {
+        NTScalarMultiChannelUpdater<PVIntArray>::create(multiChannel);
+        testFail("no exception for value of another type");
+    } catch (std::runtime_error &) {
+        testPass("exception for value of another type");
+    }
+}
+
+MAIN(testNTScalarMultiChannelUpdater) {
+    testPlan(18);
+    test_update();
+    test_reuse();
+    test_parallel();
+    test_mismatch();
+    return testDone();
+}
@@ -0,0 +1,101 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntscalarTyped.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+template<typename T>
+static void test_type(T value, const char * name)
+{
+    typename NTScalarT<T>::shared_pointer scalar = NTScalarT<T>::create();
+    scalar->put(value);
+    testOk(scalar.get() && scalar->get() == value &&
+        scalar->getNTScalar()->template getValue<PVScalarValue<T> >()->get() == value,
+        "NTScalarT<%s>", name);
+
+    typename NTScalarArrayT<T>::shared_pointer array = NTScalarArrayT<T>::create();
+    typename NTScalarArrayT<T>::svector values(3, value);
+    array->put(freeze(values));
+    testOk(array.get() && array->get().size() == 3 && array->get()[2] == value,
+        "NTScalarArrayT<%s>", name);
+}
+
+void test_types()
+{
+    testDiag("test_types");
+
+    test_type<boolean>(true, "boolean");
+    test_type<int8>(-8, "int8");
+    test_type<int16>(-16, "int16");
+    test_type<int32>(-32, "int32");
+    test_type<int64>(-64, "int64");
+    test_type<uint8>(8, "uint8");
+    test_type<uint16>(16, "uint16");
+    test_type<uint32>(32, "uint32");
+    test_type<uint64>(64, "uint64");
+    test_type<float>(1.5f, "float");
+    test_type<double>(2.5, "double");
+    test_type<std::string>("text", "string");
+}
+
+void test_ntscalar()
+{
+    testDiag("test_ntscalar");
+
+    NTScalarT<double>::shared_pointer scalar = NTScalarT<double>::create(
+        NTScalar::createBuilder()->addAlarm()->addTimeStamp());
+    testOk1(scalar.get() != 0);
+    testOk1(scalar->getNTScalar()->getAlarm().get() != 0);
+    testOk1(scalar->getPVStructure() == scalar->getNTScalar()->getPVStructure());
+
+    scalar->put(12.5);
+    testOk1(scalar->getValue()->get() == 12.5);
+
+    NTScalarPtr ntScalar = NTScalar::createBuilder()->value(pvInt)->create();
+    testOk(!NTScalarT<double>::wrap(ntScalar).get(), "value of another type not wrapped");
+    NTScalarT<int32>::shared_pointer wrapped = NTScalarT<int32>::wrap(ntScalar);
+    testOk1(wrapped.get() != 0);
+    wrapped->put(7);
+    testOk(ntScalar->getValue<PVInt>()->get() == 7, "wrapped NTScalar updated");
+
+    testOk(!NTScalarT<int32>::wrap(NTScalarPtr()).get(), "null not wrapped");
+    testOk(!NTScalarT<int32>::wrap(NTScalarArray::createBuilder()->
+        value(pvInt)->createPVStructure()).get(), "NTScalarArray not wrapped");
+}
+
+void test_ntscalarArray()
+{
+    testDiag("test_ntscalarArray");
+
+    NTScalarArrayPtr ntScalarArray = NTScalarArray::createBuilder()->
+        value(pvDouble)->addDescriptor()->create();
+    testOk(!NTScalarArrayT<float>::wrap(ntScalarArray).get(), "value of another type not wrapped");
+
+    NTScalarArrayT<double>::shared_pointer array =
+        NTScalarArrayT<double>::wrap(ntScalarArray->getPVStructure());
+    testOk1(array.get() != 0);
+
+    PVDoubleArray::svector values(4, 1.0);
+    PVDoubleArray::const_svector frozen = freeze(values);
+    array->put(frozen);
+    testOk(array->get().data() == frozen.data(), "value put without copying");
+    testOk1(ntScalarArray->getValue<PVDoubleArray>()->getLength() == 4);
+    testOk1(array->getNTScalarArray()->getDescriptor().get() != 0);
+}
+
+MAIN(testNTScalarTyped) {
+    testPlan(38);
+    test_types();
+    test_ntscalar();
+    test_ntscalarArray();
+    return testDone();
+}
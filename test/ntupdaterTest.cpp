@@ -0,0 +1,115 @@
+/**
+ * Copyright - See the COPYRIGHT that is included with this distribution.
+ * This software is distributed subject to a Software License Agreement found
+ * in file LICENSE that is included with this distribution.
+ */
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include <pv/nt.h>
+#include <pv/ntupdater.h>
+
+using namespace epics::nt;
+using namespace epics::pvData;
+
+void test_ntscalar()
+{
+    testDiag("test_ntscalar");
+
+    NTScalarPtr ntScalar = NTScalar::createBuilder()->
+        value(pvDouble)->addAlarm()->addTimeStamp()->create();
+    NTUpdaterPtr updater = NTUpdater::create(ntScalar);
+    testOk1(updater.get() != 0);
+    testOk1(updater->hasValue() && updater->hasAlarm() && updater->hasTimeStamp());
+    testOk1(updater->getChanged()->isEmpty());
+
+    PVStructurePtr pvStructure = ntScalar->getPVStructure();
+    PVStructurePtr pvAlarm = ntScalar->getAlarm();
+    PVStructurePtr pvTimeStamp = ntScalar->getTimeStamp();
+
+    Alarm alarm;
+    alarm.setSeverity(majorAlarm);
+    alarm.setStatus(deviceStatus);
+    alarm.setMessage("HIHI");
+    TimeStamp timeStamp(1000, 500);
+
+    BitSet const & changed = updater->update(1.5, alarm, timeStamp);
+    testOk1(ntScalar->getValue<PVDouble>()->get() == 1.5);
+    testOk1(changed.get(pvStructure->getSubField("value")->getFieldOffset()));
+    testOk1(pvAlarm->getSubField<PVInt>("severity")->get() == majorAlarm);
+    testOk1(pvAlarm->getSubField<PVString>("message")->get() == "HIHI");
+    testOk1(changed.get(pvAlarm->getSubField("message")->getFieldOffset()));
+    testOk1(pvTimeStamp->getSubField<PVLong>("secondsPastEpoch")->get() == 1000);
+    testOk1(pvTimeStamp->getSubField<PVInt>("nanoseconds")->get() == 500);
+    testOk(!changed.get(pvTimeStamp->getSubField("userTag")->getFieldOffset()),
+        "unchanged userTag not marked");
+
+    // only the nanoseconds differ
+    updater->clearChanged();
+    testOk1(updater->getChanged()->isEmpty());
+    updater->update(2.5, alarm, TimeStamp(1000, 600));
+    testOk1(changed.get(pvStructure->getSubField("value")->getFieldOffset()));
+    testOk1(changed.get(pvTimeStamp->getSubField("nanoseconds")->getFieldOffset()));
+    testOk(changed.cardinality() == 2, "unchanged alarm and seconds not marked");
+
+    updater->clearChanged();
+    testOk1(updater->setAlarm(noAlarm, noStatus, ""));
+    testOk1(changed.get(pvAlarm->getSubField("severity")->getFieldOffset()));
+    testOk1(changed.get(pvAlarm->getSubField("status")->getFieldOffset()));
+    testOk1(changed.get(pvAlarm->getSubField("message")->getFieldOffset()));
+    testOk1(!changed.get(pvStructure->getSubField("value")->getFieldOffset()));
+
+    testOk(updater->putValue<int32>(3), "value converted");
+    testOk1(ntScalar->getValue<PVDouble>()->get() == 3.0);
+}
+
+void test_ntscalarArray()
+{
+    testDiag("test_ntscalarArray");
+
+    NTScalarArrayPtr ntScalarArray = NTScalarArray::createBuilder()->
+        value(pvDouble)->addTimeStamp()->create();
+    NTUpdaterPtr updater = NTUpdater::create(ntScalarArray->getPVStructure());
+    testOk1(updater->hasValue() && !updater->hasAlarm() && updater->hasTimeStamp());
+
+    PVDoubleArray::svector values(10, 1.0);
+    PVDoubleArray::const_svector frozen = freeze(values);
+    Alarm alarm;
+    BitSet const & changed = updater->update(frozen, alarm, TimeStamp(1, 2));
+    PVDoubleArrayPtr pvValue = ntScalarArray->getValue<PVDoubleArray>();
+    testOk(pvValue->view().data() == frozen.data(), "value put without copying");
+    testOk1(changed.get(pvValue->getFieldOffset()));
+    testOk(!updater->setAlarm(alarm), "no alarm to set");
+    testOk(!updater->putValue(1.0), "no scalar value to put");
+
+    PVIntArray::svector ints(4, 7);
+    testOk1(updater->putValue(PVIntArray::const_svector(freeze(ints))));
+    testOk(pvValue->getLength() == 4 && pvValue->view()[3] == 7.0, "value converted");
+}
+
+void test_other()
+{
+    testDiag("test_other");
+
+    NTEnumPtr ntEnum = NTEnum::createBuilder()->addTimeStamp()->create();
+    NTUpdaterPtr updater = NTUpdater::create(ntEnum);
+    testOk(!updater->hasValue(), "enum value not updated");
+    testOk1(updater->setTimeStamp(TimeStamp(5, 0)));
+    testOk1(ntEnum->getTimeStamp()->getSubField<PVLong>("secondsPastEpoch")->get() == 5);
+
+    try {
+        NTUpdater::create(PVStructurePtr());
+        testFail("no exception for null PVStructure");
+    } catch (std::runtime_error &) {
+        testPass("exception for null PVStructure");
+    }
+}
+
+MAIN(testNTUpdater) {
+    testPlan(32);
+    test_ntscalar();
+    test_ntscalarArray();
+    test_other();
+    return testDone();
+}